@@ -0,0 +1,261 @@
+/* Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+ *
+ * Shared spectrum ring: mapping and reading, see wac_shared_spectrum.h.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "wac_shared_spectrum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* Torn reads retried by wac_shm_read_latest before giving up */
+#define WAC_SHM_READ_ATTEMPTS 16
+
+struct wac_shm {
+    wac_shm_header* header;
+    size_t size;
+    int writable;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+};
+
+static void wac_shm_full_name(const char* name, char* out, size_t out_size)
+{
+#ifdef _WIN32
+    snprintf(out, out_size, "Local\\%s", name ? name : WAC_SHM_DEFAULT_NAME);
+#else
+    snprintf(out, out_size, "/%s", name ? name : WAC_SHM_DEFAULT_NAME);
+#endif
+}
+
+static int wac_shm_map(const char* name, int create, wac_shm** out_shm)
+{
+    char full_name[256];
+    wac_shm* shm;
+    void* data;
+
+    *out_shm = NULL;
+    wac_shm_full_name(name, full_name, sizeof(full_name));
+
+#ifdef _WIN32
+    HANDLE mapping = create
+        ? CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)WAC_SHM_REGION_SIZE, full_name)
+        : OpenFileMappingA(FILE_MAP_READ, FALSE, full_name);
+    if (mapping == NULL) {
+        return WAC_SHM_ERROR_NOT_FOUND;
+    }
+
+    data = MapViewOfFile(mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, WAC_SHM_REGION_SIZE);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        return WAC_SHM_ERROR_MAP;
+    }
+#else
+    int fd = shm_open(full_name, create ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    struct stat info;
+    if (fd < 0) {
+        return WAC_SHM_ERROR_NOT_FOUND;
+    }
+
+    if ((create && ftruncate(fd, (off_t)WAC_SHM_REGION_SIZE) != 0) || fstat(fd, &info) != 0 || (size_t)info.st_size < WAC_SHM_REGION_SIZE) {
+        close(fd);
+        return create ? WAC_SHM_ERROR_MAP : WAC_SHM_ERROR_LAYOUT;
+    }
+
+    data = mmap(NULL, WAC_SHM_REGION_SIZE, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return WAC_SHM_ERROR_MAP;
+    }
+#endif
+
+    shm = (wac_shm*)calloc(1, sizeof(wac_shm));
+    if (shm == NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+#else
+        munmap(data, WAC_SHM_REGION_SIZE);
+#endif
+        return WAC_SHM_ERROR_MAP;
+    }
+
+    shm->header = (wac_shm_header*)data;
+    shm->size = WAC_SHM_REGION_SIZE;
+    shm->writable = create;
+#ifdef _WIN32
+    shm->mapping = mapping;
+#endif
+    *out_shm = shm;
+    return WAC_SHM_OK;
+}
+
+int wac_shm_open(const char* name, wac_shm** out_shm)
+{
+    const wac_shm_header* header;
+    int result = wac_shm_map(name, 0, out_shm);
+    if (result != WAC_SHM_OK) {
+        return result;
+    }
+
+    header = (*out_shm)->header;
+    if (wac_shm_load_acquire_u32(&header->magic) != WAC_SHM_MAGIC || header->version != WAC_SHM_VERSION
+        || header->header_size != sizeof(wac_shm_header) || header->slot_size != sizeof(wac_shm_frame)
+        || header->num_slots != WAC_SHM_NUM_SLOTS || header->max_bins != WAC_SHM_MAX_BINS || header->max_bands != WAC_SHM_MAX_BANDS) {
+        wac_shm_close(*out_shm);
+        *out_shm = NULL;
+        return WAC_SHM_ERROR_LAYOUT;
+    }
+
+    return WAC_SHM_OK;
+}
+
+int wac_shm_create(const char* name, wac_shm** out_shm)
+{
+    int result = wac_shm_map(name, 1, out_shm);
+    if (result != WAC_SHM_OK) {
+        return result;
+    }
+
+#ifdef _WIN32
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        wac_shm_init_header((*out_shm)->header, frequency.QuadPart, (uint32_t)GetCurrentProcessId());
+    }
+#else
+    wac_shm_init_header((*out_shm)->header, 1000000000, (uint32_t)getpid());
+#endif
+    return WAC_SHM_OK;
+}
+
+void wac_shm_close(wac_shm* shm)
+{
+    if (shm == NULL) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(shm->header);
+    CloseHandle(shm->mapping);
+#else
+    munmap(shm->header, shm->size);
+#endif
+    free(shm);
+}
+
+void wac_shm_remove(const char* name)
+{
+#ifdef _WIN32
+    /* The mapping goes away with its last handle */
+    (void)name;
+#else
+    char full_name[256];
+    wac_shm_full_name(name, full_name, sizeof(full_name));
+    shm_unlink(full_name);
+#endif
+}
+
+const wac_shm_header* wac_shm_get_header(const wac_shm* shm)
+{
+    return shm->header;
+}
+
+wac_shm_header* wac_shm_get_writable_header(wac_shm* shm)
+{
+    return shm->writable ? shm->header : NULL;
+}
+
+int wac_shm_acquire_latest(const wac_shm* shm, wac_shm_view* out_view)
+{
+    const uint64_t published = wac_shm_load_acquire_u64(&shm->header->published);
+    const wac_shm_frame* frame;
+
+    out_view->frame = NULL;
+    out_view->sequence = 0;
+
+    if (published == 0) {
+        return WAC_SHM_ERROR_NO_FRAME;
+    }
+
+    frame = wac_shm_slot(shm->header, published - 1);
+    out_view->sequence = wac_shm_load_acquire_u32(&frame->sequence);
+
+    /* Odd: the publisher has lapped the ring and is rewriting this slot right now */
+    if (out_view->sequence & 1u) {
+        return WAC_SHM_ERROR_NO_FRAME;
+    }
+
+    out_view->frame = frame;
+    return WAC_SHM_OK;
+}
+
+int wac_shm_view_valid(const wac_shm_view* view)
+{
+    if (view->frame == NULL) {
+        return 0;
+    }
+
+    /* Everything read from the slot has to be done before the sequence is sampled again */
+    WAC_SHM_ACQUIRE_FENCE();
+    return *(const volatile uint32_t*)&view->frame->sequence == view->sequence;
+}
+
+int wac_shm_read_latest(const wac_shm* shm, wac_shm_frame* out_frame)
+{
+    for (int attempt = 0; attempt < WAC_SHM_READ_ATTEMPTS; ++attempt) {
+        wac_shm_view view;
+        uint32_t num_bins;
+        uint32_t num_bands;
+
+        if (wac_shm_acquire_latest(shm, &view) != WAC_SHM_OK) {
+            if (wac_shm_load_acquire_u64(&shm->header->published) == 0) {
+                return WAC_SHM_ERROR_NO_FRAME;
+            }
+            continue;
+        }
+
+        memcpy(out_frame, view.frame, offsetof(wac_shm_frame, magnitudes));
+
+        /* Torn counts would overrun the arrays, clamp them before the copy and validate after */
+        num_bins = out_frame->num_bins < WAC_SHM_MAX_BINS ? out_frame->num_bins : WAC_SHM_MAX_BINS;
+        num_bands = out_frame->num_bands < WAC_SHM_MAX_BANDS ? out_frame->num_bands : WAC_SHM_MAX_BANDS;
+        memcpy(out_frame->magnitudes, view.frame->magnitudes, num_bins * sizeof(float));
+        memcpy(out_frame->bands, view.frame->bands, num_bands * sizeof(float));
+
+        if (wac_shm_view_valid(&view)) {
+            return WAC_SHM_OK;
+        }
+    }
+
+    return WAC_SHM_ERROR_NO_FRAME;
+}
+
+int64_t wac_shm_now_ticks(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
@@ -0,0 +1,259 @@
+/* Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+ *
+ * Shared spectrum ring: layout and reader API.
+ *
+ * After the console command `WAC.ShareSpectrum [name]` the capture worker copies every frame it
+ * publishes into a named shared-memory region (WAC_SHM_DEFAULT_NAME when no name is given), until
+ * `WAC.StopShareSpectrum`. Any number of local processes can map that region and read the latest
+ * frame without a syscall, a lock or a copy. The publisher never waits for readers.
+ *
+ * The region starts with a wac_shm_header. It is followed by num_slots frames of slot_size bytes
+ * each. The header's `published` counter is the number of frames written so far. The newest frame is
+ * in slot (published - 1) % num_slots.
+ *
+ * Every slot is guarded by its own seqlock. The publisher makes `sequence` odd, writes the slot, then
+ * makes it even again. A reader samples the sequence, reads what it needs in place and samples it
+ * again. The read is good when both samples are equal and even. Since the ring holds several frames,
+ * a reader that is slower than one frame period still gets a consistent view. It just does not
+ * always get the newest one.
+ *
+ * Plain C99, no dependencies beyond the OS. Build wac_shared_spectrum.c into the reader. The UE
+ * module only uses the layout and the inline write helpers from this header.
+ */
+#ifndef WAC_SHARED_SPECTRUM_H
+#define WAC_SHARED_SPECTRUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* "WACS" */
+#define WAC_SHM_MAGIC 0x53434157u
+
+/* Bumped whenever the layout changes; readers refuse other versions */
+#define WAC_SHM_VERSION 1u
+
+/* Win32: "Local\\" + name; POSIX: "/" + name */
+#define WAC_SHM_DEFAULT_NAME "WindowsAudioCapture_Spectrum"
+
+#define WAC_SHM_NUM_SLOTS 8u
+#define WAC_SHM_MAX_BINS 2048u
+#define WAC_SHM_MAX_BANDS 128u
+
+enum {
+    /* The audio behind this frame does not follow on from the previous frame (device switch) */
+    WAC_SHM_FRAME_DISCONTINUITY = 1u << 0,
+    /* The silence gate was closed: magnitudes and bands are all zero */
+    WAC_SHM_FRAME_SILENT = 1u << 1,
+    /* magnitudes holds num_bins values; otherwise num_bins is 0 */
+    WAC_SHM_FRAME_HAS_SPECTRUM = 1u << 2,
+    /* bands holds num_bands values; otherwise num_bands is 0 */
+    WAC_SHM_FRAME_HAS_BANDS = 1u << 3
+};
+
+typedef struct wac_shm_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t slot_size;
+    uint32_t num_slots;
+    uint32_t max_bins;
+    uint32_t max_bands;
+
+    /* Sample rate of the newest frame. 0 until the first frame is published */
+    uint32_t sample_rate;
+
+    /* Unit of wac_shm_frame::publish_ticks (QueryPerformanceFrequency on Windows) */
+    int64_t ticks_per_second;
+
+    /* Frames published so far. Written last with release semantics. */
+    uint64_t published;
+
+    /* Band layout, log spaced between the two frequencies (Hz) */
+    float band_min_frequency;
+    float band_max_frequency;
+
+    /* Process id of the publisher */
+    uint32_t publisher_pid;
+
+    uint32_t reserved;
+} wac_shm_header;
+
+typedef struct wac_shm_frame {
+    /* Seqlock, odd while the publisher writes the slot */
+    uint32_t sequence;
+    uint32_t flags;
+
+    /* FAudioSpectrumFrame::FrameIndex, increases by one per published frame */
+    uint64_t frame_index;
+
+    /* Publisher clock when the frame was published. Compare with wac_shm_now_ticks() */
+    int64_t publish_ticks;
+
+    /* Linear FFT magnitude per bin, averaged over the channels. DC is dropped, so magnitudes[i] is
+     * at (i + 1) * bin_width_hz. */
+    uint32_t num_bins;
+    float bin_width_hz;
+
+    /* Peak magnitude per log-spaced band, in int16 units */
+    uint32_t num_bands;
+
+    /* Time-domain levels, always filled. Largest channel value, full scale = 1 */
+    float momentary_lufs;
+    float short_term_lufs;
+    float rms;
+    float peak;
+
+    uint32_t reserved[3];
+
+    float magnitudes[WAC_SHM_MAX_BINS];
+    float bands[WAC_SHM_MAX_BANDS];
+} wac_shm_frame;
+
+#if defined(__cplusplus)
+static_assert(sizeof(wac_shm_header) == 64, "wac_shm_header is shared between processes");
+static_assert(sizeof(wac_shm_frame) % 64 == 0, "wac_shm_frame slots should not share cache lines");
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+_Static_assert(sizeof(wac_shm_header) == 64, "wac_shm_header is shared between processes");
+_Static_assert(sizeof(wac_shm_frame) % 64 == 0, "wac_shm_frame slots should not share cache lines");
+#endif
+
+#define WAC_SHM_REGION_SIZE (sizeof(wac_shm_header) + WAC_SHM_NUM_SLOTS * sizeof(wac_shm_frame))
+
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define WAC_SHM_INLINE static __inline
+#else
+#define WAC_SHM_INLINE static inline
+#endif
+
+/* Memory ordering. On x86/x64 the hardware already gives acquire loads and release stores, so
+ * MSVC only needs a compiler barrier there. */
+#if defined(_MSC_VER) && !defined(__clang__)
+#if defined(_M_ARM64) || defined(_M_ARM)
+#define WAC_SHM_FENCE() __dmb(_ARM64_BARRIER_ISH)
+#else
+#define WAC_SHM_FENCE() _ReadWriteBarrier()
+#endif
+WAC_SHM_INLINE uint32_t wac_shm_load_acquire_u32(const volatile uint32_t* p) { uint32_t v = *p; WAC_SHM_FENCE(); return v; }
+WAC_SHM_INLINE uint64_t wac_shm_load_acquire_u64(const volatile uint64_t* p) { uint64_t v = *p; WAC_SHM_FENCE(); return v; }
+WAC_SHM_INLINE void wac_shm_store_release_u32(volatile uint32_t* p, uint32_t v) { WAC_SHM_FENCE(); *p = v; }
+WAC_SHM_INLINE void wac_shm_store_release_u64(volatile uint64_t* p, uint64_t v) { WAC_SHM_FENCE(); *p = v; }
+#define WAC_SHM_ACQUIRE_FENCE() WAC_SHM_FENCE()
+#define WAC_SHM_RELEASE_FENCE() WAC_SHM_FENCE()
+#else
+WAC_SHM_INLINE uint32_t wac_shm_load_acquire_u32(const volatile uint32_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+WAC_SHM_INLINE uint64_t wac_shm_load_acquire_u64(const volatile uint64_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+WAC_SHM_INLINE void wac_shm_store_release_u32(volatile uint32_t* p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+WAC_SHM_INLINE void wac_shm_store_release_u64(volatile uint64_t* p, uint64_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+#define WAC_SHM_ACQUIRE_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define WAC_SHM_RELEASE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+WAC_SHM_INLINE wac_shm_frame* wac_shm_slot(wac_shm_header* header, uint64_t index)
+{
+    return (wac_shm_frame*)((uint8_t*)header + header->header_size + (size_t)(index % header->num_slots) * header->slot_size);
+}
+
+/* ---- Publisher side. Single writer, never blocks. ---- */
+
+WAC_SHM_INLINE void wac_shm_init_header(wac_shm_header* header, int64_t ticks_per_second, uint32_t publisher_pid)
+{
+    header->version = WAC_SHM_VERSION;
+    header->header_size = (uint32_t)sizeof(wac_shm_header);
+    header->slot_size = (uint32_t)sizeof(wac_shm_frame);
+    header->num_slots = WAC_SHM_NUM_SLOTS;
+    header->max_bins = WAC_SHM_MAX_BINS;
+    header->max_bands = WAC_SHM_MAX_BANDS;
+    header->ticks_per_second = ticks_per_second;
+    header->publisher_pid = publisher_pid;
+
+    /* A publisher that died mid-write left its slot odd; readers would skip that slot forever */
+    for (uint32_t slot = 0; slot < header->num_slots; ++slot) {
+        wac_shm_frame* frame = wac_shm_slot(header, slot);
+        if (frame->sequence & 1u) {
+            wac_shm_store_release_u32(&frame->sequence, frame->sequence + 1);
+        }
+    }
+
+    /* Readers check the magic last, so they never see a half-initialised header */
+    wac_shm_store_release_u32(&header->magic, WAC_SHM_MAGIC);
+}
+
+/* Opens the next slot for writing. Fill it in, then call wac_shm_end_write. */
+WAC_SHM_INLINE wac_shm_frame* wac_shm_begin_write(wac_shm_header* header)
+{
+    wac_shm_frame* frame = wac_shm_slot(header, header->published);
+    frame->sequence = frame->sequence + 1;
+    /* The odd sequence has to be visible before any of the slot's data changes */
+    WAC_SHM_RELEASE_FENCE();
+    return frame;
+}
+
+WAC_SHM_INLINE void wac_shm_end_write(wac_shm_header* header, wac_shm_frame* frame)
+{
+    wac_shm_store_release_u32(&frame->sequence, frame->sequence + 1);
+    wac_shm_store_release_u64(&header->published, header->published + 1);
+}
+
+/* ---- Reader side ---- */
+
+typedef struct wac_shm wac_shm;
+
+enum {
+    WAC_SHM_OK = 0,
+    /* No region with that name: WAC.ShareSpectrum was not run with that name, or WAC.StopShareSpectrum was */
+    WAC_SHM_ERROR_NOT_FOUND = -1,
+    WAC_SHM_ERROR_MAP = -2,
+    /* Magic, version or sizes do not match this header */
+    WAC_SHM_ERROR_LAYOUT = -3,
+    /* Nothing published yet, or the publisher kept overwriting the slot during every attempt */
+    WAC_SHM_ERROR_NO_FRAME = -4
+};
+
+/* Maps an existing region read-only. Pass NULL for WAC_SHM_DEFAULT_NAME. */
+int wac_shm_open(const char* name, wac_shm** out_shm);
+
+/* Creates (or reopens) a region for writing, for publishers other than the UE module and for tests */
+int wac_shm_create(const char* name, wac_shm** out_shm);
+
+void wac_shm_close(wac_shm* shm);
+
+/* POSIX regions outlive their processes until removed. No-op on Windows. */
+void wac_shm_remove(const char* name);
+
+const wac_shm_header* wac_shm_get_header(const wac_shm* shm);
+
+/* Writable header of a region opened with wac_shm_create, NULL otherwise */
+wac_shm_header* wac_shm_get_writable_header(wac_shm* shm);
+
+/* Zero-copy access to the newest frame. The view points into shared memory and may be overwritten
+ * at any time. Read what you need, then call wac_shm_view_valid. If it returns 0, discard what you
+ * read and acquire again. */
+typedef struct wac_shm_view {
+    const wac_shm_frame* frame;
+    uint32_t sequence;
+} wac_shm_view;
+
+int wac_shm_acquire_latest(const wac_shm* shm, wac_shm_view* out_view);
+
+int wac_shm_view_valid(const wac_shm_view* view);
+
+/* Copying convenience on top of the view. Copies the fixed fields and the used part of the arrays,
+ * retrying torn reads a few times. */
+int wac_shm_read_latest(const wac_shm* shm, wac_shm_frame* out_frame);
+
+/* Same clock as wac_shm_frame::publish_ticks */
+int64_t wac_shm_now_ticks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAC_SHARED_SPECTRUM_H */
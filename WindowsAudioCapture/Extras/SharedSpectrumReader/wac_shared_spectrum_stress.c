@@ -0,0 +1,306 @@
+/* Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+ *
+ * Multi-reader stress test for the shared spectrum ring.
+ *
+ * One publisher thread writes frames into a private region, as fast as it can or at a fixed rate.
+ * N reader threads each map the region on their own and spin on the newest frame. Every reader
+ * reads all bins in place and checks them against the frame index the publisher stamped into them.
+ * A frame that passes the seqlock but holds mixed data is counted as corrupt, and that count must
+ * stay zero.
+ *
+ *   wac_shared_spectrum_stress [readers] [seconds] [rate_hz] [bins]
+ *
+ * rate_hz 0 publishes back to back (throughput); 100 matches 10 ms WASAPI packets (latency).
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "wac_shared_spectrum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef HANDLE wac_thread;
+#define WAC_THREAD_RETURN DWORD WINAPI
+static void wac_thread_start(wac_thread* thread, LPTHREAD_START_ROUTINE entry, void* arg) { *thread = CreateThread(NULL, 0, entry, arg, 0, NULL); }
+static void wac_thread_join(wac_thread thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+static void wac_yield(void) { SwitchToThread(); }
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+typedef pthread_t wac_thread;
+#define WAC_THREAD_RETURN void*
+static void wac_thread_start(wac_thread* thread, void* (*entry)(void*), void* arg) { pthread_create(thread, NULL, entry, arg); }
+static void wac_thread_join(wac_thread thread) { pthread_join(thread, NULL); }
+static void wac_yield(void) { sched_yield(); }
+#endif
+
+#define STRESS_REGION_NAME "WindowsAudioCapture_Stress"
+
+/* Latency histogram: 100 ns buckets up to 10 ms, the last bucket collects everything above */
+#define LATENCY_BUCKET_NS 100
+#define LATENCY_BUCKETS 100001
+
+typedef struct stress_shared {
+    volatile int stop;
+    volatile int publisher_done;
+    int64_t ticks_per_second;
+    uint32_t bins;
+} stress_shared;
+
+typedef struct stress_reader {
+    stress_shared* shared;
+    int index;
+
+    uint64_t frames;
+    uint64_t missed;
+    uint64_t torn;
+    uint64_t corrupt;
+    uint64_t polls;
+    uint32_t* histogram;
+} stress_reader;
+
+typedef struct stress_publisher {
+    stress_shared* shared;
+    wac_shm* shm;
+    uint32_t rate_hz;
+    uint64_t frames;
+    double seconds;
+} stress_publisher;
+
+static WAC_THREAD_RETURN publisher_main(void* arg)
+{
+    stress_publisher* publisher = (stress_publisher*)arg;
+    wac_shm_header* header = wac_shm_get_writable_header(publisher->shm);
+    const int64_t tps = publisher->shared->ticks_per_second;
+    const int64_t period = publisher->rate_hz > 0 ? tps / publisher->rate_hz : 0;
+    const int64_t start = wac_shm_now_ticks();
+    int64_t next = start;
+
+    while (!publisher->shared->stop) {
+        wac_shm_frame* frame;
+        float stamp;
+
+        if (period > 0) {
+            while (wac_shm_now_ticks() < next && !publisher->shared->stop) {
+                wac_yield();
+            }
+            next += period;
+        }
+
+        frame = wac_shm_begin_write(header);
+        frame->frame_index = publisher->frames + 1;
+        frame->flags = WAC_SHM_FRAME_HAS_SPECTRUM;
+        frame->num_bins = publisher->shared->bins;
+        frame->num_bands = 0;
+        frame->bin_width_hz = 48000.0f / (2.0f * (publisher->shared->bins + 1));
+
+        /* Exact in a float up to 2^24 */
+        stamp = (float)(frame->frame_index & 0xFFFFFF);
+        for (uint32_t bin = 0; bin < publisher->shared->bins; ++bin) {
+            frame->magnitudes[bin] = stamp;
+        }
+
+        frame->publish_ticks = wac_shm_now_ticks();
+        wac_shm_end_write(header, frame);
+        ++publisher->frames;
+    }
+
+    publisher->seconds = (double)(wac_shm_now_ticks() - start) / tps;
+    publisher->shared->publisher_done = 1;
+    return 0;
+}
+
+static WAC_THREAD_RETURN reader_main(void* arg)
+{
+    stress_reader* reader = (stress_reader*)arg;
+    const int64_t tps = reader->shared->ticks_per_second;
+    uint64_t last_index = 0;
+    wac_shm* shm = NULL;
+
+    /* Every reader maps the region on its own, like a separate process would */
+    if (wac_shm_open(STRESS_REGION_NAME, &shm) != WAC_SHM_OK) {
+        fprintf(stderr, "reader %d: cannot open the region\n", reader->index);
+        return 0;
+    }
+
+    while (!reader->shared->publisher_done) {
+        wac_shm_view view;
+        uint64_t index;
+        float expected;
+        int mismatch = 0;
+
+        ++reader->polls;
+        if (wac_shm_acquire_latest(shm, &view) != WAC_SHM_OK) {
+            wac_yield();
+            continue;
+        }
+
+        /* Nothing new: give the core away, the publisher may be sharing it */
+        index = view.frame->frame_index;
+        if (index == last_index) {
+            wac_yield();
+            continue;
+        }
+
+        expected = (float)(index & 0xFFFFFF);
+        for (uint32_t bin = 0; bin < reader->shared->bins; ++bin) {
+            mismatch |= view.frame->magnitudes[bin] != expected;
+        }
+
+        {
+            const int64_t published = view.frame->publish_ticks;
+            const int64_t now = wac_shm_now_ticks();
+
+            if (!wac_shm_view_valid(&view)) {
+                ++reader->torn;
+                continue;
+            }
+
+            if (mismatch) {
+                ++reader->corrupt;
+            }
+
+            if (last_index != 0 && index > last_index + 1) {
+                reader->missed += index - last_index - 1;
+            }
+            last_index = index;
+            ++reader->frames;
+
+            {
+                int64_t bucket = (now - published) * 1000000000 / tps / LATENCY_BUCKET_NS;
+                if (bucket < 0) {
+                    bucket = 0;
+                }
+                if (bucket >= LATENCY_BUCKETS) {
+                    bucket = LATENCY_BUCKETS - 1;
+                }
+                ++reader->histogram[bucket];
+            }
+        }
+    }
+
+    wac_shm_close(shm);
+    return 0;
+}
+
+static double percentile_us(const uint32_t* histogram, uint64_t count, double fraction)
+{
+    const uint64_t target = fraction >= 1.0 && count > 0 ? count - 1 : (uint64_t)(fraction * (double)count);
+    uint64_t seen = 0;
+
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        seen += histogram[bucket];
+        if (seen > target) {
+            return (bucket + 1) * LATENCY_BUCKET_NS / 1000.0;
+        }
+    }
+    return LATENCY_BUCKETS * LATENCY_BUCKET_NS / 1000.0;
+}
+
+static void sleep_seconds(int seconds)
+{
+#ifdef _WIN32
+    Sleep((DWORD)seconds * 1000);
+#else
+    sleep((unsigned)seconds);
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    const int num_readers = argc > 1 ? atoi(argv[1]) : 4;
+    const int seconds = argc > 2 ? atoi(argv[2]) : 5;
+    const uint32_t rate_hz = argc > 3 ? (uint32_t)atoi(argv[3]) : 0;
+    const uint32_t bins = argc > 4 ? (uint32_t)atoi(argv[4]) : 511;
+
+    stress_shared shared;
+    stress_publisher publisher;
+    stress_reader* readers;
+    wac_thread publisher_thread;
+    wac_thread* reader_threads;
+    uint32_t* total_histogram;
+    uint64_t total_frames = 0;
+
+    if (num_readers < 1 || seconds < 1 || bins < 1 || bins > WAC_SHM_MAX_BINS) {
+        fprintf(stderr, "usage: %s [readers >= 1] [seconds >= 1] [rate_hz, 0 = unthrottled] [bins 1..%u]\n", argv[0], WAC_SHM_MAX_BINS);
+        return 1;
+    }
+
+    memset(&shared, 0, sizeof(shared));
+    memset(&publisher, 0, sizeof(publisher));
+    shared.bins = bins;
+
+    wac_shm_remove(STRESS_REGION_NAME);
+    if (wac_shm_create(STRESS_REGION_NAME, &publisher.shm) != WAC_SHM_OK) {
+        fprintf(stderr, "cannot create the region\n");
+        return 1;
+    }
+    shared.ticks_per_second = wac_shm_get_header(publisher.shm)->ticks_per_second;
+    publisher.shared = &shared;
+    publisher.rate_hz = rate_hz;
+
+    readers = (stress_reader*)calloc((size_t)num_readers, sizeof(stress_reader));
+    reader_threads = (wac_thread*)calloc((size_t)num_readers, sizeof(wac_thread));
+    total_histogram = (uint32_t*)calloc(LATENCY_BUCKETS, sizeof(uint32_t));
+
+    for (int i = 0; i < num_readers; ++i) {
+        readers[i].shared = &shared;
+        readers[i].index = i;
+        readers[i].histogram = (uint32_t*)calloc(LATENCY_BUCKETS, sizeof(uint32_t));
+        wac_thread_start(&reader_threads[i], reader_main, &readers[i]);
+    }
+
+    wac_thread_start(&publisher_thread, publisher_main, &publisher);
+    sleep_seconds(seconds);
+    shared.stop = 1;
+
+    wac_thread_join(publisher_thread);
+    for (int i = 0; i < num_readers; ++i) {
+        wac_thread_join(reader_threads[i]);
+    }
+
+    printf("publisher: %llu frames in %.2f s, %.0f frames/s, %.1f MB/s of bins (%u bins, %s)\n",
+        (unsigned long long)publisher.frames, publisher.seconds, publisher.frames / publisher.seconds,
+        publisher.frames * (double)bins * sizeof(float) / publisher.seconds / (1024.0 * 1024.0), bins,
+        rate_hz > 0 ? "paced" : "unthrottled");
+
+    for (int i = 0; i < num_readers; ++i) {
+        const stress_reader* reader = &readers[i];
+        printf("reader %d: %llu frames (%.1f%%), %llu missed, %llu torn, %llu corrupt, %.0f polls/s, latency p50 %.1f us p99 %.1f us p99.9 %.1f us\n",
+            i, (unsigned long long)reader->frames, 100.0 * reader->frames / (publisher.frames ? publisher.frames : 1),
+            (unsigned long long)reader->missed, (unsigned long long)reader->torn, (unsigned long long)reader->corrupt,
+            reader->polls / publisher.seconds,
+            percentile_us(reader->histogram, reader->frames, 0.5), percentile_us(reader->histogram, reader->frames, 0.99),
+            percentile_us(reader->histogram, reader->frames, 0.999));
+
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+            total_histogram[bucket] += reader->histogram[bucket];
+        }
+        total_frames += reader->frames;
+    }
+
+    printf("all readers: latency p50 %.1f us p99 %.1f us p99.9 %.1f us max <= %.1f us\n",
+        percentile_us(total_histogram, total_frames, 0.5), percentile_us(total_histogram, total_frames, 0.99),
+        percentile_us(total_histogram, total_frames, 0.999), percentile_us(total_histogram, total_frames, 1.0));
+
+    {
+        int failed = 0;
+        for (int i = 0; i < num_readers; ++i) {
+            failed |= readers[i].corrupt != 0;
+            free(readers[i].histogram);
+        }
+        free(readers);
+        free(reader_threads);
+        free(total_histogram);
+        wac_shm_close(publisher.shm);
+        wac_shm_remove(STRESS_REGION_NAME);
+        return failed;
+    }
+}
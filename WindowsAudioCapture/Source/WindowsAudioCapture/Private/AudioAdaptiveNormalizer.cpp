@@ -0,0 +1,116 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioAdaptiveNormalizer.h"
+
+namespace {
+constexpr int32 FloatMantissaBits = 23;
+constexpr int32 FloatExponentBias = 127;
+
+// Piecewise linear log2 from the float bits, within 0.09 octave (0.5 dB). Exact at powers of two and
+// monotonic, which is all the quantiles need
+inline float FastLog2(float Value)
+{
+    int32 Bits;
+    FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+    return float(Bits - (FloatExponentBias << FloatMantissaBits)) * (1.0f / float(1 << FloatMantissaBits));
+}
+}
+
+FAudioAdaptiveNormalizer::FAudioAdaptiveNormalizer()
+{
+}
+
+void FAudioAdaptiveNormalizer::Configure(const FAudioAdaptiveNormalizerSettings& InSettings)
+{
+    if (InSettings == RequestedSettings) {
+        return;
+    }
+
+    RequestedSettings = InSettings;
+    Settings = InSettings;
+    Settings.FloorQuantile = FMath::Clamp(Settings.FloorQuantile, 0.0f, 1.0f);
+    Settings.CeilingQuantile = FMath::Clamp(Settings.CeilingQuantile, Settings.FloorQuantile, 1.0f);
+    Settings.AdaptFrames = FMath::Max(Settings.AdaptFrames, 1);
+    Settings.MinRangeOctaves = FMath::Max(Settings.MinRangeOctaves, 0.01f);
+    Settings.SilenceThreshold = FMath::Max(Settings.SilenceThreshold, TNumericLimits<float>::Min());
+    Reset();
+}
+
+void FAudioAdaptiveNormalizer::Reset()
+{
+    Floor.Reset();
+    Ceiling.Reset();
+    Initialized.Reset();
+}
+
+void FAudioAdaptiveNormalizer::Process(const float* In, float* Out, int32 Num, bool bTrain)
+{
+    if (Num != Floor.Num()) {
+        Floor.SetNumZeroed(Num);
+        Ceiling.SetNumZeroed(Num);
+        Initialized.SetNumZeroed(Num);
+    }
+    LogValues.SetNumUninitialized(Num);
+
+    float* FloorData = Floor.GetData();
+    float* CeilingData = Ceiling.GetData();
+    float* InitializedData = Initialized.GetData();
+    float* LogData = LogValues.GetData();
+
+    const float Threshold = Settings.SilenceThreshold;
+    const float MinRange = Settings.MinRangeOctaves;
+    // Steps are divided by the smaller of Q and 1 - Q so that even the slow direction of an estimate
+    // (up for the floor, down for the ceiling) crosses one range in about AdaptFrames frames when every
+    // value is on the same side of it, e.g. after a level change
+    const float FloorSlow = FMath::Max(FMath::Min(Settings.FloorQuantile, 1.0f - Settings.FloorQuantile), 0.01f);
+    const float CeilingSlow = FMath::Max(FMath::Min(Settings.CeilingQuantile, 1.0f - Settings.CeilingQuantile), 0.01f);
+    const float FloorUp = Settings.FloorQuantile / FloorSlow;
+    const float FloorDown = (Settings.FloorQuantile - 1.0f) / FloorSlow;
+    const float CeilingUp = Settings.CeilingQuantile / CeilingSlow;
+    const float CeilingDown = (Settings.CeilingQuantile - 1.0f) / CeilingSlow;
+
+    const float StepScale = bTrain ? 1.0f / Settings.AdaptFrames : 0.0f;
+
+    for (int32 Band = 0; Band < Num; ++Band) {
+        const float Value = In[Band];
+        const float Active = Value >= Threshold ? 1.0f : 0.0f;
+        const float LogValue = FastLog2(Value >= Threshold ? Value : Threshold);
+        LogData[Band] = LogValue;
+
+        // First value of a band: start with it at the ceiling, one minimum range above the floor
+        const float StartMask = Active * (1.0f - InitializedData[Band]) * (bTrain ? 1.0f : 0.0f);
+        float BandFloor = StartMask > 0.0f ? LogValue - MinRange : FloorData[Band];
+        float BandCeiling = StartMask > 0.0f ? LogValue : CeilingData[Band];
+        InitializedData[Band] = FMath::Max(InitializedData[Band], StartMask);
+
+        const float Range = FMath::Max(BandCeiling - BandFloor, MinRange);
+        const float Step = Range * StepScale * Active * InitializedData[Band];
+
+        BandFloor += Step * (LogValue >= BandFloor ? FloorUp : FloorDown);
+        BandCeiling += Step * (LogValue >= BandCeiling ? CeilingUp : CeilingDown);
+
+        // The two estimates never cross
+        BandCeiling = FMath::Max(BandCeiling, BandFloor);
+
+        FloorData[Band] = BandFloor;
+        CeilingData[Band] = BandCeiling;
+    }
+
+    for (int32 Band = 0; Band < Num; ++Band) {
+        const float Active = In[Band] >= Threshold ? InitializedData[Band] : 0.0f;
+        const float Range = FMath::Max(CeilingData[Band] - FloorData[Band], MinRange);
+
+        // The floor stays put and the range grows upwards when the band is narrower than MinRange
+        const float Normalized = (LogData[Band] - FloorData[Band]) / Range;
+        Out[Band] = FMath::Clamp(Normalized, 0.0f, 1.0f) * Active;
+    }
+}
+
+float FAudioAdaptiveNormalizer::GetFloor(int32 Band) const
+{
+    return Initialized.IsValidIndex(Band) && Initialized[Band] > 0.0f ? FMath::Pow(2.0f, Floor[Band]) : 0.0f;
+}
+
+float FAudioAdaptiveNormalizer::GetCeiling(int32 Band) const
+{
+    return Initialized.IsValidIndex(Band) && Initialized[Band] > 0.0f ? FMath::Pow(2.0f, Ceiling[Band]) : 0.0f;
+}
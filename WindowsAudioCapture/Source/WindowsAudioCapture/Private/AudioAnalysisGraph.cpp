@@ -0,0 +1,146 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioAnalysisGraph.h"
+#include "WindowsAudioCaptureStats.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/App.h"
+
+DECLARE_CYCLE_STAT(TEXT("Analysis Graph Stage"), STAT_WAC_AnalysisGraphStage, STATGROUP_WindowsAudioCapture);
+
+namespace {
+// Weight of a new timing in FAudioAnalysisStageStats::RecentSeconds, follows an FFT size change in a few dozen frames
+constexpr double RecentTimingWeight = 1.0 / 32.0;
+}
+
+FAudioAnalysisGraph::FAudioAnalysisGraph()
+    : MinParallelSeconds(0.0)
+    , bParallelEnabled(true)
+{
+}
+
+void FAudioAnalysisGraph::Reset()
+{
+    // Keeps the allocations of the stage list, the frames all have about the same shape
+    Stages.Reset();
+}
+
+int32 FAudioAnalysisGraph::AddStage(FName Name, TFunction<void()> Work, const TArray<int32>& Prerequisites)
+{
+    const int32 Index = Stages.Num();
+
+    FStage& Stage = Stages.AddDefaulted_GetRef();
+    Stage.Name = Name;
+    Stage.Work = MoveTemp(Work);
+    Stage.Prerequisites.Append(Prerequisites);
+
+    for (int32 Prerequisite : Stage.Prerequisites) {
+        check(Prerequisite >= 0 && Prerequisite < Index);
+    }
+
+    // Only the capture thread adds stats entries, readers take the lock
+    Stage.StatsIndex = Stats.Stages.IndexOfByPredicate([&](const FAudioAnalysisStageStats& Entry) {
+        return Entry.Name == Name;
+    });
+
+    if (Stage.StatsIndex == INDEX_NONE) {
+        FScopeLock Lock(&StatsLock);
+        Stage.StatsIndex = Stats.Stages.Num();
+        Stats.Stages.AddDefaulted_GetRef().Name = Name;
+    }
+
+    return Index;
+}
+
+bool FAudioAnalysisGraph::ShouldRunParallel() const
+{
+    if (!bParallelEnabled || Stages.Num() < 2 || !FApp::ShouldUseThreadingForPerformance() || !FTaskGraphInterface::IsRunning()) {
+        return false;
+    }
+
+    // Stages are in a valid order, so one pass gives the end of every stage on an unlimited number of threads
+    TArray<double, TInlineAllocator<32>> Finish;
+    Finish.SetNumUninitialized(Stages.Num());
+
+    double TotalWork = 0.0;
+    double CriticalPath = 0.0;
+
+    for (int32 Index = 0; Index < Stages.Num(); ++Index) {
+        const FStage& Stage = Stages[Index];
+
+        double Start = 0.0;
+        for (int32 Prerequisite : Stage.Prerequisites) {
+            Start = FMath::Max(Start, Finish[Prerequisite]);
+        }
+
+        const double Cost = Stats.Stages[Stage.StatsIndex].RecentSeconds;
+        Finish[Index] = Start + Cost;
+
+        TotalWork += Cost;
+        CriticalPath = FMath::Max(CriticalPath, Finish[Index]);
+    }
+
+    return TotalWork - CriticalPath >= MinParallelSeconds;
+}
+
+void FAudioAnalysisGraph::RunStage(FStage& Stage)
+{
+    SCOPE_CYCLE_COUNTER(STAT_WAC_AnalysisGraphStage);
+
+    const double Start = FPlatformTime::Seconds();
+    Stage.Work();
+    Stage.Seconds = FPlatformTime::Seconds() - Start;
+}
+
+void FAudioAnalysisGraph::Run()
+{
+    if (Stages.Num() == 0) {
+        return;
+    }
+
+    const double Start = FPlatformTime::Seconds();
+    const bool bParallel = ShouldRunParallel();
+
+    if (bParallel) {
+        FGraphEventArray Events;
+        Events.Reserve(Stages.Num());
+
+        for (FStage& Stage : Stages) {
+            FGraphEventArray Prerequisites;
+            for (int32 Prerequisite : Stage.Prerequisites) {
+                Prerequisites.Add(Events[Prerequisite]);
+            }
+
+            FStage* StagePtr = &Stage;
+            Events.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([StagePtr]() {
+                RunStage(*StagePtr);
+            }, GET_STATID(STAT_WAC_AnalysisGraphStage), &Prerequisites));
+        }
+
+        // The capture thread is not a task graph thread, it sleeps here until the last stage is done
+        FTaskGraphInterface::Get().WaitUntilTasksComplete(Events);
+    } else {
+        for (FStage& Stage : Stages) {
+            RunStage(Stage);
+        }
+    }
+
+    const double Seconds = FPlatformTime::Seconds() - Start;
+
+    FScopeLock Lock(&StatsLock);
+
+    (bParallel ? Stats.ParallelRuns : Stats.InlineRuns)++;
+    Stats.TotalSeconds += Seconds;
+
+    for (FStage& Stage : Stages) {
+        FAudioAnalysisStageStats& Entry = Stats.Stages[Stage.StatsIndex];
+        Entry.RecentSeconds = Entry.Runs > 0 ? FMath::Lerp(Entry.RecentSeconds, Stage.Seconds, RecentTimingWeight) : Stage.Seconds;
+        Entry.Runs++;
+        Entry.TotalSeconds += Stage.Seconds;
+        Entry.LastSeconds = Stage.Seconds;
+    }
+}
+
+FAudioAnalysisGraphStats FAudioAnalysisGraph::GetStats() const
+{
+    FScopeLock Lock(&StatsLock);
+    return Stats;
+}
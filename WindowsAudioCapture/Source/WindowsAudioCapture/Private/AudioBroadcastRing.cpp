@@ -0,0 +1,163 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioBroadcastRing.h"
+#include "WindowsAudioCapture.h"
+
+FAudioBroadcastRing::FAudioBroadcastRing(int32 InPacketCapacity, int32 InSampleCapacity)
+    : ReservedSamples(0)
+    , WrittenPackets(0)
+    , Memory(EWACMemory::CaptureHistory)
+{
+    WAC_LLM_SCOPE();
+
+    const int32 packetCapacity = (int32)FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(InPacketCapacity, 2));
+    int32 sampleCapacity = (int32)FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(InSampleCapacity, 1024));
+
+    // A shorter history only makes slow readers overrun sooner, the capture itself needs the minimum
+    const int32 minSampleCapacity = FMath::Min(sampleCapacity, MinSampleCapacity);
+    while (!Memory.TrySet((int64)packetCapacity * sizeof(FDescriptor) + (int64)sampleCapacity * sizeof(int16))) {
+        if (sampleCapacity <= minSampleCapacity) {
+            Memory.Set((int64)packetCapacity * sizeof(FDescriptor) + (int64)sampleCapacity * sizeof(int16));
+            break;
+        }
+        sampleCapacity /= 2;
+    }
+
+    if (sampleCapacity < InSampleCapacity) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioBroadcastRing: memory budget leaves room for %d samples of capture history instead of %d"),
+            sampleCapacity, InSampleCapacity);
+    }
+
+    Descriptors = MakeUnique<FDescriptor[]>(packetCapacity);
+    for (int32 index = 0; index < packetCapacity; ++index) {
+        Descriptors[index].Sequence.store(0, std::memory_order_relaxed);
+        Descriptors[index].SampleOffset = 0;
+        Descriptors[index].NumSamples = 0;
+    }
+    PacketMask = packetCapacity - 1;
+
+    Samples.SetNumZeroed(sampleCapacity);
+    SampleMask = (uint64)sampleCapacity - 1;
+}
+
+void FAudioBroadcastRing::Write(const int16* InSamples, int32 NumFrames, int32 NumChannels, int32 SampleRate, uint32 Flags)
+{
+    const int32 maxFrames = GetSampleCapacity() / FMath::Max(NumChannels, 1);
+    if (InSamples != nullptr && NumFrames > maxFrames) {
+        InSamples += (NumFrames - maxFrames) * NumChannels;
+        NumFrames = maxFrames;
+    }
+
+    const int32 numSamples = InSamples != nullptr ? NumFrames * NumChannels : 0;
+    const uint64 packetIndex = WrittenPackets.load(std::memory_order_relaxed);
+    const uint64 offset = ReservedSamples.load(std::memory_order_relaxed);
+    FDescriptor& descriptor = Descriptors[(int32)(packetIndex & PacketMask)];
+
+    // Readers of the packet this slot held, or of the samples about to be overwritten, must see
+    // these two stores before any of the new data
+    descriptor.Sequence.store(0, std::memory_order_relaxed);
+    ReservedSamples.store(offset + numSamples, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (numSamples > 0) {
+        const int32 start = (int32)(offset & SampleMask);
+        const int32 firstPart = FMath::Min(numSamples, GetSampleCapacity() - start);
+        FMemory::Memcpy(Samples.GetData() + start, InSamples, firstPart * sizeof(int16));
+        FMemory::Memcpy(Samples.GetData(), InSamples + firstPart, (numSamples - firstPart) * sizeof(int16));
+    }
+
+    descriptor.SampleOffset = offset;
+    descriptor.NumSamples = numSamples;
+    descriptor.Packet.PacketIndex = packetIndex;
+    descriptor.Packet.NumFrames = NumFrames;
+    descriptor.Packet.NumChannels = NumChannels;
+    descriptor.Packet.SampleRate = SampleRate;
+    descriptor.Packet.Flags = Flags;
+
+    descriptor.Sequence.store(packetIndex + 1, std::memory_order_release);
+    WrittenPackets.store(packetIndex + 1, std::memory_order_release);
+}
+
+FAudioRingCursor FAudioBroadcastRing::MakeCursor() const
+{
+    FAudioRingCursor cursor;
+    cursor.NextPacket = WrittenPackets.load(std::memory_order_acquire);
+    return cursor;
+}
+
+void FAudioBroadcastRing::SkipLostPackets(FAudioRingCursor& Cursor, uint64 OldestReadable) const
+{
+    Cursor.LostPackets += OldestReadable - Cursor.NextPacket;
+    Cursor.Overruns++;
+    Cursor.NextPacket = OldestReadable;
+}
+
+EAudioRingRead FAudioBroadcastRing::Read(FAudioRingCursor& Cursor, FAudioRingPacket& OutPacket, TArray<int16>& OutSamples) const
+{
+    const uint64 packetCapacity = (uint64)PacketMask + 1;
+    const uint64 sampleCapacity = SampleMask + 1;
+    uint64 next = Cursor.NextPacket;
+
+    for (;;) {
+        const uint64 written = WrittenPackets.load(std::memory_order_acquire);
+        if (next >= written) {
+            break;
+        }
+
+        // A whole ring behind, the descriptor was reused
+        if (written - next > packetCapacity) {
+            next = written - packetCapacity;
+            continue;
+        }
+
+        const FDescriptor& descriptor = Descriptors[(int32)(next & PacketMask)];
+        const uint64 sequence = descriptor.Sequence.load(std::memory_order_acquire);
+        const uint64 sampleOffset = descriptor.SampleOffset;
+        const int32 numSamples = descriptor.NumSamples;
+        const FAudioRingPacket packet = descriptor.Packet;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence != next + 1 || descriptor.Sequence.load(std::memory_order_relaxed) != sequence) {
+            // Being rewritten by the writer right now
+            ++next;
+            continue;
+        }
+
+        // Samples already overwritten, no point copying them
+        if (ReservedSamples.load(std::memory_order_acquire) - sampleOffset > sampleCapacity) {
+            ++next;
+            continue;
+        }
+
+        // Report the gap before handing out anything after it
+        if (next != Cursor.NextPacket) {
+            SkipLostPackets(Cursor, next);
+            return EAudioRingRead::Overrun;
+        }
+
+        OutSamples.SetNumUninitialized(numSamples, false);
+        if (numSamples > 0) {
+            const int32 start = (int32)(sampleOffset & SampleMask);
+            const int32 firstPart = FMath::Min(numSamples, GetSampleCapacity() - start);
+            FMemory::Memcpy(OutSamples.GetData(), Samples.GetData() + start, firstPart * sizeof(int16));
+            FMemory::Memcpy(OutSamples.GetData() + firstPart, Samples.GetData(), (numSamples - firstPart) * sizeof(int16));
+        }
+
+        // Validate the copy: the writer raises ReservedSamples before it overwrites anything
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ReservedSamples.load(std::memory_order_relaxed) - sampleOffset > sampleCapacity) {
+            ++next;
+            continue;
+        }
+
+        OutPacket = packet;
+        Cursor.NextPacket = next + 1;
+        return EAudioRingRead::Packet;
+    }
+
+    if (next != Cursor.NextPacket) {
+        SkipLostPackets(Cursor, next);
+        return EAudioRingRead::Overrun;
+    }
+
+    return EAudioRingRead::Empty;
+}
@@ -0,0 +1,305 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioCaptureBenchmarks.h"
+#include "AudioChannelSpectrumAnalyzer.h"
+#include "AudioCompactSpectrum.h"
+#include "AudioGoertzelBank.h"
+#include "AudioHarmonicPercussive.h"
+#include "AudioSilenceGate.h"
+#include "AudioSpectrumScaling.h"
+#include "WindowsAudioCapture.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+double FAudioCaptureBenchmarks::TimePerCall(int32 NumCalls, TFunctionRef<void(int32 Call)> Body)
+{
+    NumCalls = FMath::Max(NumCalls, 1);
+
+    const double Start = FPlatformTime::Seconds();
+    for (int32 Call = 0; Call < NumCalls; ++Call) {
+        Body(Call);
+    }
+    return (FPlatformTime::Seconds() - Start) / NumCalls;
+}
+
+TArray<int16> FAudioCaptureBenchmarks::MakeNoise(int32 NumFrames, int32 NumChannels)
+{
+    TArray<int16> Samples;
+    Samples.SetNumUninitialized(NumFrames * NumChannels);
+
+    FRandomStream Random(Seed);
+    for (int16& Sample : Samples) {
+        Sample = (int16)Random.RandRange(-8000, 8000);
+    }
+    return Samples;
+}
+
+int32 FAudioCaptureBenchmarks::TargetAnalysis(int32 NumFrames)
+{
+    NumFrames = FMath::Clamp(NumFrames, 64, 65536);
+    const TArray<int16> Samples = MakeNoise(NumFrames, 2);
+
+    TArray<float> Output;
+    FAudioChannelSpectra Spectra;
+    FAudioChannelSpectrumAnalyzer Analyzer;
+
+    const double FftSeconds = TimePerCall(DefaultCalls, [&](int32) {
+        Analyzer.Analyze(Samples.GetData(), NumFrames, 2, 48000, Spectra, Output);
+    });
+
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC benchmark: %d stereo frames, FFT %.2f us"), NumFrames, FftSeconds * 1000000.0);
+
+    FAudioGoertzelBank Bank;
+    double PerTargetSeconds = 0.0;
+
+    for (int32 NumTargets = 1; NumTargets <= 256; NumTargets *= 2) {
+        TArray<int32> Frequencies;
+        for (int32 Target = 0; Target < NumTargets; ++Target) {
+            Frequencies.Add(50 + Target * 20000 / NumTargets);
+        }
+        Bank.Configure(48000, Frequencies);
+
+        const double BankSeconds = TimePerCall(DefaultCalls, [&](int32) {
+            Bank.Process(Samples.GetData(), NumFrames, 2, Output);
+        });
+        PerTargetSeconds = BankSeconds / NumTargets;
+
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC benchmark: %3d target(s), Goertzel %.2f us (%.0f%% of the FFT)"),
+            NumTargets, BankSeconds * 1000000.0, BankSeconds / FMath::Max(FftSeconds, 1e-9) * 100.0);
+    }
+
+    // The bank grows linearly with the number of targets, the largest run gives the steadiest per-target cost
+    const int32 Crossover = PerTargetSeconds > 0.0 ? (int32)(FftSeconds / PerTargetSeconds) : 0;
+
+    static const auto CVarMaxTargetFrequencies = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("WAC.MaxTargetFrequencies"));
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC benchmark: crossover at ~%d target frequencies (WAC.MaxTargetFrequencies is %d)"),
+        Crossover, CVarMaxTargetFrequencies ? CVarMaxTargetFrequencies->GetValueOnAnyThread() : 0);
+
+    return Crossover;
+}
+
+void FAudioCaptureBenchmarks::CompactSpectrum(int32 NumBins)
+{
+    NumBins = FMath::Clamp(NumBins, 16, 4095);
+    const int32 NumCalls = 2000;
+    const int32 NumFrames = 8192;
+
+    // A few tones over noise, scaled with the default profile like GetFrequencyArray
+    TArray<int16> Samples = MakeNoise(NumFrames, 2);
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        const float Time = Frame / 48000.0f;
+        const float Tones = 6000.0f * FMath::Sin(2.0f * PI * 55.0f * Time) + 3000.0f * FMath::Sin(2.0f * PI * 440.0f * Time) + 800.0f * FMath::Sin(2.0f * PI * 3520.0f * Time);
+        Samples[Frame * 2] = Samples[Frame * 2 + 1] = (int16)(Tones + Samples[Frame * 2] * (300.0f / 8000.0f));
+    }
+
+    TArray<float> Magnitudes;
+    FAudioChannelSpectra Spectra;
+    FAudioChannelSpectrumAnalyzer Analyzer;
+    Analyzer.Analyze(Samples.GetData(), NumFrames, 2, 48000, Spectra, Magnitudes);
+
+    NumBins = FMath::Min(NumBins, Magnitudes.Num());
+    TArray<float> Values;
+    Values.SetNumUninitialized(NumBins);
+    FAudioSpectrumScalingTable(FAudioSpectrumScalingProfile()).Apply(Magnitudes.GetData(), Values.GetData(), NumBins);
+
+    // What every float consumer pays today: one copy of the array
+    TArray<float> Copy;
+    const double CopySeconds = TimePerCall(NumCalls, [&](int32) {
+        Copy = Values;
+    });
+
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC compact benchmark: %d bins, float copy %.3f us, %d bytes"),
+        NumBins, CopySeconds * 1000000.0, NumBins * (int32)sizeof(float));
+
+    for (EAudioCompactPrecision Precision : { EAudioCompactPrecision::Bits8, EAudioCompactPrecision::Bits16 }) {
+        FAudioCompactSpectrum Compact;
+        TArray<float> Decoded;
+
+        const double EncodeSeconds = TimePerCall(NumCalls, [&](int32) {
+            Compact.Encode(Values.GetData(), NumBins, Precision);
+        });
+        const double DecodeSeconds = TimePerCall(NumCalls, [&](int32) {
+            Compact.Decode(Decoded);
+        });
+
+        // Relative error inside the coded range, absolute error (as a fraction of the scale) below it
+        const float Floor = Compact.Scale * FMath::Pow(10.0f, -Compact.RangeDb / 20.0f);
+        double MaxRelative = 0.0;
+        double SumRelative = 0.0;
+        double MaxBelowFloor = 0.0;
+        int32 NumInRange = 0;
+        for (int32 Bin = 0; Bin < NumBins; ++Bin) {
+            if (Values[Bin] >= Floor) {
+                const double Relative = FMath::Abs(Decoded[Bin] - Values[Bin]) / Values[Bin];
+                MaxRelative = FMath::Max(MaxRelative, Relative);
+                SumRelative += Relative;
+                NumInRange++;
+            } else {
+                MaxBelowFloor = FMath::Max(MaxBelowFloor, (double)FMath::Abs(Decoded[Bin] - Values[Bin]));
+            }
+        }
+
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC compact benchmark: %2d bit over %.0f dB, encode %.3f us, decode %.3f us, %d bytes (%.0f%% of float)"),
+            FAudioCompactSpectrum::GetBytesPerBin(Precision) * 8, Compact.RangeDb, EncodeSeconds * 1000000.0, DecodeSeconds * 1000000.0,
+            Compact.GetNumBytes(), Compact.GetNumBytes() * 100.0 / (NumBins * sizeof(float)));
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC compact benchmark:   %d bins in range, relative error max %.4f%% mean %.4f%% (bound %.4f%%), below range max %.2g x scale"),
+            NumInRange, MaxRelative * 100.0, NumInRange > 0 ? SumRelative / NumInRange * 100.0 : 0.0,
+            FAudioCompactSpectrum::GetMaxRelativeError(Precision, Compact.RangeDb) * 100.0, Compact.Scale > 0.0f ? MaxBelowFloor / Compact.Scale : 0.0);
+    }
+}
+
+void FAudioCaptureBenchmarks::AnalysisKernels(int32 NumFrames)
+{
+    NumFrames = FMath::Clamp(NumFrames, 64, 65536);
+
+    for (int32 NumChannels : { 1, 2, 6, 8 }) {
+        const TArray<int16> Samples = MakeNoise(NumFrames, NumChannels);
+        TArray<float> FloatSamples;
+        FloatSamples.SetNumUninitialized(Samples.Num());
+        for (int32 Index = 0; Index < Samples.Num(); ++Index) {
+            FloatSamples[Index] = Samples[Index] / 32768.0f;
+        }
+
+        FAudioChannelSpectrumAnalyzer Specialized;
+        FAudioChannelSpectrumAnalyzer Generic;
+        Generic.SetUseGenericKernels(true);
+
+        FAudioChannelSpectra Spectra;
+        TArray<float> SpecializedOutput;
+        TArray<float> GenericOutput;
+
+        for (EAudioSampleFormat Format : { EAudioSampleFormat::Int16, EAudioSampleFormat::Float }) {
+            auto Time = [&](FAudioChannelSpectrumAnalyzer& Analyzer, TArray<float>& Output) {
+                return TimePerCall(DefaultCalls, [&](int32) {
+                    if (Format == EAudioSampleFormat::Int16) {
+                        Analyzer.Analyze(Samples.GetData(), NumFrames, NumChannels, 48000, Spectra, Output);
+                    } else {
+                        Analyzer.Analyze(FloatSamples.GetData(), NumFrames, NumChannels, 48000, Spectra, Output);
+                    }
+                });
+            };
+
+            const double GenericSeconds = Time(Generic, GenericOutput);
+            const double SpecializedSeconds = Time(Specialized, SpecializedOutput);
+
+            // Both kernels do the same arithmetic in the same order, the outputs should match exactly
+            float MaxDifference = 0.0f;
+            for (int32 Index = 0; Index < SpecializedOutput.Num(); ++Index) {
+                MaxDifference = FMath::Max(MaxDifference, FMath::Abs(SpecializedOutput[Index] - GenericOutput[Index]));
+            }
+
+            UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC kernel benchmark: %d frames, %d channel(s), %s: generic %.2f us, specialized %.2f us (%.0f%%), max difference %g"),
+                NumFrames, NumChannels, Format == EAudioSampleFormat::Int16 ? TEXT("int16") : TEXT("float"),
+                GenericSeconds * 1000000.0, SpecializedSeconds * 1000000.0, SpecializedSeconds / FMath::Max(GenericSeconds, 1e-9) * 100.0, MaxDifference);
+        }
+    }
+}
+
+void FAudioCaptureBenchmarks::HarmonicPercussive(int32 NumBins)
+{
+    NumBins = FMath::Clamp(NumBins, 16, 8191);
+    const int32 NumFrames = 1000;
+    const int32 ClickPeriod = 25;
+
+    // Spectrogram of three steady tones over low noise, with a broadband click every ClickPeriod frames
+    TArray<float> Spectrogram;
+    Spectrogram.SetNumUninitialized(NumFrames * NumBins);
+    FRandomStream Random(Seed);
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        float* Magnitudes = Spectrogram.GetData() + Frame * NumBins;
+        for (int32 Bin = 0; Bin < NumBins; ++Bin) {
+            Magnitudes[Bin] = Random.FRandRange(0.0f, 100.0f);
+        }
+        for (int32 Tone : { NumBins / 50, NumBins / 12, NumBins / 4 }) {
+            Magnitudes[Tone] += 10000.0f;
+        }
+        if (Frame % ClickPeriod == 0) {
+            for (int32 Bin = 0; Bin < NumBins; ++Bin) {
+                Magnitudes[Bin] += 8000.0f;
+            }
+        }
+    }
+
+    for (int32 Decimation = 1; Decimation <= FAudioHarmonicPercussiveSeparator::MaxDecimation; Decimation *= 2) {
+        FAudioHarmonicPercussiveSeparator Separator;
+        Separator.SetFixedDecimation(Decimation);
+
+        FAudioHarmonicPercussiveBands Bands;
+        double ClickRatio = 0.0;
+        double ToneRatio = 0.0;
+        int32 NumClicks = 0;
+
+        const double Seconds = TimePerCall(NumFrames, [&](int32 Frame) {
+            Separator.Process(Spectrogram.GetData() + Frame * NumBins, NumBins, 48000, Bands);
+
+            // Skip the frames where the time median is still filling up
+            if (Frame >= FAudioHarmonicPercussiveSeparator::TimeMedianLength) {
+                if (Frame % ClickPeriod == 0) {
+                    ClickRatio += Bands.PercussiveRatio;
+                    NumClicks++;
+                } else {
+                    ToneRatio += Bands.PercussiveRatio;
+                }
+            }
+        });
+        const int32 NumToneFrames = NumFrames - FAudioHarmonicPercussiveSeparator::TimeMedianLength - NumClicks;
+
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC harmonic/percussive benchmark: %d bins, decimation %d: %.2f us per frame, percussive ratio %.3f on clicks, %.3f on tones"),
+            NumBins, Decimation, Seconds * 1000000.0, NumClicks > 0 ? ClickRatio / NumClicks : 0.0, NumToneFrames > 0 ? ToneRatio / NumToneFrames : 0.0);
+    }
+
+    static const auto CVarBudgetMs = IConsoleManager::Get().FindTConsoleVariableDataFloat(TEXT("WAC.HarmonicPercussiveBudgetMs"));
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC harmonic/percussive benchmark: WAC.HarmonicPercussiveBudgetMs is %.3f"),
+        CVarBudgetMs ? CVarBudgetMs->GetValueOnAnyThread() : 0.0f);
+}
+
+void FAudioCaptureBenchmarks::SilenceGate(int32 NumFrames)
+{
+    NumFrames = FMath::Clamp(NumFrames, 64, 65536);
+    const int32 NumChannels = 2;
+    const int32 SampleRate = 48000;
+    const int32 NumPasses = 5;
+
+    // One second of signal, one second of a quiet room (+-2 LSB, about -87 dBFS), twice over
+    const int32 BlocksPerSecond = FMath::Max(SampleRate / NumFrames, 1);
+    const int32 NumBlocks = BlocksPerSecond * 4;
+    const int32 BlockSamples = NumFrames * NumChannels;
+
+    TArray<int16> Samples = MakeNoise(NumBlocks * NumFrames, NumChannels);
+    FRandomStream Random(Seed);
+    for (int32 Block = 0; Block < NumBlocks; ++Block) {
+        if ((Block / BlocksPerSecond) % 2 == 1) {
+            for (int32 Index = Block * BlockSamples; Index < (Block + 1) * BlockSamples; ++Index) {
+                Samples[Index] = (int16)Random.RandRange(-2, 2);
+            }
+        }
+    }
+
+    FAudioChannelSpectra Spectra;
+    TArray<float> Output;
+    FAudioChannelSpectrumAnalyzer Analyzer;
+    const int32 NumCalls = NumBlocks * NumPasses;
+
+    const double UngatedSeconds = TimePerCall(NumCalls, [&](int32 Call) {
+        Analyzer.Analyze(Samples.GetData() + (Call % NumBlocks) * BlockSamples, NumFrames, NumChannels, SampleRate, Spectra, Output);
+    });
+
+    // The gate costs what the sink pays for it: one level pass and the decision, on every block
+    FAudioSilenceGate Gate;
+    int32 NumAnalyzed = 0;
+    const double GatedSeconds = TimePerCall(NumCalls, [&](int32 Call) {
+        const int16* Block = Samples.GetData() + (Call % NumBlocks) * BlockSamples;
+        if (Gate.Process(FAudioSilenceGate::MeasureInt16(Block, BlockSamples), NumFrames, SampleRate)) {
+            Analyzer.Analyze(Block, NumFrames, NumChannels, SampleRate, Spectra, Output);
+            NumAnalyzed++;
+        }
+    });
+
+    // WAC.Stats prices every skipped block at the average analysis and leaves the gate itself out
+    const double MeasuredSaving = 1.0 - GatedSeconds / FMath::Max(UngatedSeconds, 1e-12);
+    const double EstimatedSaving = double(NumCalls - NumAnalyzed) / NumCalls;
+
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC silence gate benchmark: %d blocks of %d stereo frames, half of them silent: gate off %.2f us per block, gate on %.2f us per block (%d%% of the blocks analysed)"),
+        NumBlocks, NumFrames, UngatedSeconds * 1000000.0, GatedSeconds * 1000000.0, NumAnalyzed * 100 / NumCalls);
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC silence gate benchmark: measured saving %.1f%% of the analysis time, WAC.Stats would estimate %.1f%%"),
+        MeasuredSaving * 100.0, EstimatedSaving * 100.0);
+}
@@ -0,0 +1,285 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioCaptureDeadlineMonitor.h"
+#include "WindowsAudioCapture.h"
+#include "HAL/RunnableThread.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include <avrt.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+namespace {
+// Bucket widths: 50 us of lateness, one packet, 5% of the buffer, 1 us in the sink, 10 us of work
+constexpr double WakeLatenessWidthUs = 50.0;
+constexpr double PacketsWidth = 1.0;
+constexpr double BufferFillWidthPercent = 5.0;
+constexpr double SinkTimeWidthUs = 1.0;
+constexpr double IterationTimeWidthUs = 10.0;
+
+void StoreMax(std::atomic<double>& Max, double Value)
+{
+    // Single writer, no compare-exchange needed
+    if (Value > Max.load(std::memory_order_relaxed)) {
+        Max.store(Value, std::memory_order_relaxed);
+    }
+}
+}
+
+double FAudioDeadlineHistogramSnapshot::GetQuantile(double Quantile) const
+{
+    if (Count == 0) {
+        return 0.0;
+    }
+
+    const uint64 Target = FMath::Max<uint64>(1, (uint64)FMath::CeilToDouble(FMath::Clamp(Quantile, 0.0, 1.0) * Count));
+
+    uint64 Seen = 0;
+    for (int32 Bucket = 0; Bucket < NumBuckets - 1; ++Bucket) {
+        Seen += Counts[Bucket];
+        if (Seen >= Target) {
+            return FMath::Min(BucketEdges[Bucket], Max);
+        }
+    }
+    return Max;
+}
+
+FAudioDeadlineHistogram::FAudioDeadlineHistogram(EScale InScale, double InWidth)
+    : Scale(InScale)
+    , Width(FMath::Max(InWidth, DBL_MIN))
+{
+    Reset();
+}
+
+int32 FAudioDeadlineHistogram::GetBucket(double Value) const
+{
+    const double Ratio = Value / Width;
+
+    if (Scale == EScale::Linear) {
+        return Ratio < NumBuckets - 1 ? FMath::Max(0, (int32)Ratio) : NumBuckets - 1;
+    }
+
+    // [0, Width) is bucket 0, [Width * 2^(b-1), Width * 2^b) bucket b
+    if (Ratio < 1.0) {
+        return 0;
+    }
+    return FMath::Min(1 + (int32)FMath::FloorLog2((uint32)FMath::Min(Ratio, (double)MAX_uint32)), NumBuckets - 1);
+}
+
+double FAudioDeadlineHistogram::GetBucketEdge(int32 Bucket) const
+{
+    return Scale == EScale::Linear ? Width * (Bucket + 1) : Width * double(1ull << Bucket);
+}
+
+void FAudioDeadlineHistogram::Add(double Value)
+{
+    Counts[GetBucket(Value)].fetch_add(1, std::memory_order_relaxed);
+    Sum.store(Sum.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+    StoreMax(Max, Value);
+}
+
+void FAudioDeadlineHistogram::Reset()
+{
+    for (std::atomic<uint64>& Bucket : Counts) {
+        Bucket.store(0, std::memory_order_relaxed);
+    }
+    Sum.store(0.0, std::memory_order_relaxed);
+    Max.store(0.0, std::memory_order_relaxed);
+}
+
+FAudioDeadlineHistogramSnapshot FAudioDeadlineHistogram::GetSnapshot() const
+{
+    FAudioDeadlineHistogramSnapshot Snapshot;
+
+    for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket) {
+        Snapshot.BucketEdges[Bucket] = GetBucketEdge(Bucket);
+        Snapshot.Counts[Bucket] = Counts[Bucket].load(std::memory_order_relaxed);
+        Snapshot.Count += Snapshot.Counts[Bucket];
+    }
+    Snapshot.Sum = Sum.load(std::memory_order_relaxed);
+    Snapshot.Max = Max.load(std::memory_order_relaxed);
+    return Snapshot;
+}
+
+FAudioCaptureDeadlineMonitor::FAudioCaptureDeadlineMonitor()
+    : WakeLateness(FAudioDeadlineHistogram::EScale::Log2, WakeLatenessWidthUs)
+    , PacketsPerWake(FAudioDeadlineHistogram::EScale::Linear, PacketsWidth)
+    , BufferFill(FAudioDeadlineHistogram::EScale::Linear, BufferFillWidthPercent)
+    , SinkTime(FAudioDeadlineHistogram::EScale::Log2, SinkTimeWidthUs)
+    , IterationTime(FAudioDeadlineHistogram::EScale::Log2, IterationTimeWidthUs)
+    , WaitDeadlineSeconds(0.0)
+    , IterationStartSeconds(0.0)
+    , LastCaptureSeconds(0.0)
+    , IterationPackets(0)
+    , IterationSinkSeconds(0.0)
+    , bCapturedThisIteration(false)
+{
+    Reset();
+}
+
+void FAudioCaptureDeadlineMonitor::BeginWait(double TimeoutSeconds)
+{
+    WaitDeadlineSeconds = FPlatformTime::Seconds() + TimeoutSeconds;
+}
+
+void FAudioCaptureDeadlineMonitor::EndWait(bool bTriggered)
+{
+    if (!bTriggered && WaitDeadlineSeconds > 0.0) {
+        WakeLateness.Add(FMath::Max(FPlatformTime::Seconds() - WaitDeadlineSeconds, 0.0) * 1000000.0);
+    }
+    WaitDeadlineSeconds = 0.0;
+}
+
+void FAudioCaptureDeadlineMonitor::BeginIteration()
+{
+    IterationStartSeconds = FPlatformTime::Seconds();
+    IterationPackets = 0;
+    IterationSinkSeconds = 0.0;
+    bCapturedThisIteration = false;
+}
+
+void FAudioCaptureDeadlineMonitor::EndIteration()
+{
+    Iterations.fetch_add(1, std::memory_order_relaxed);
+    IterationTime.Add((FPlatformTime::Seconds() - IterationStartSeconds) * 1000000.0);
+
+    if (bCapturedThisIteration) {
+        PacketsPerWake.Add(IterationPackets);
+        SinkTime.Add(IterationSinkSeconds * 1000000.0);
+    }
+}
+
+void FAudioCaptureDeadlineMonitor::Suspend()
+{
+    LastCaptureSeconds = 0.0;
+}
+
+void FAudioCaptureDeadlineMonitor::BeginCapture(uint32 QueuedFrames, uint32 BufferFrames, int32 SampleRate)
+{
+    const double Now = FPlatformTime::Seconds();
+    const double Buffer = SampleRate > 0 ? double(BufferFrames) / SampleRate : 0.0;
+
+    Captures.fetch_add(1, std::memory_order_relaxed);
+    BufferSeconds.store(Buffer, std::memory_order_relaxed);
+    bCapturedThisIteration = true;
+
+    if (BufferFrames > 0) {
+        BufferFill.Add(100.0 * QueuedFrames / BufferFrames);
+    }
+
+    bool bMissed = BufferFrames > 0 && QueuedFrames >= BufferFrames;
+    if (LastCaptureSeconds > 0.0) {
+        const double Gap = Now - LastCaptureSeconds;
+        StoreMax(MaxCaptureGapSeconds, Gap);
+        bMissed |= Buffer > 0.0 && Gap > Buffer;
+    }
+    LastCaptureSeconds = Now;
+
+    if (bMissed) {
+        DeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FAudioCaptureDeadlineMonitor::AddPacket(bool bDiscontinuity, bool bTimestampError, double SinkSeconds)
+{
+    IterationPackets++;
+    IterationSinkSeconds += SinkSeconds;
+
+    if (bDiscontinuity) {
+        Discontinuities.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (bTimestampError) {
+        TimestampErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FAudioCaptureDeadlineMonitor::Reset()
+{
+    Iterations.store(0, std::memory_order_relaxed);
+    Captures.store(0, std::memory_order_relaxed);
+    DeadlineMisses.store(0, std::memory_order_relaxed);
+    Discontinuities.store(0, std::memory_order_relaxed);
+    TimestampErrors.store(0, std::memory_order_relaxed);
+    MaxCaptureGapSeconds.store(0.0, std::memory_order_relaxed);
+    BufferSeconds.store(0.0, std::memory_order_relaxed);
+
+    WakeLateness.Reset();
+    PacketsPerWake.Reset();
+    BufferFill.Reset();
+    SinkTime.Reset();
+    IterationTime.Reset();
+}
+
+FAudioCaptureDeadlineStats FAudioCaptureDeadlineMonitor::GetStats() const
+{
+    FAudioCaptureDeadlineStats Stats;
+    Stats.Iterations = Iterations.load(std::memory_order_relaxed);
+    Stats.Captures = Captures.load(std::memory_order_relaxed);
+    Stats.DeadlineMisses = DeadlineMisses.load(std::memory_order_relaxed);
+    Stats.Discontinuities = Discontinuities.load(std::memory_order_relaxed);
+    Stats.TimestampErrors = TimestampErrors.load(std::memory_order_relaxed);
+    Stats.MaxCaptureGapSeconds = MaxCaptureGapSeconds.load(std::memory_order_relaxed);
+    Stats.BufferSeconds = BufferSeconds.load(std::memory_order_relaxed);
+    Stats.WakeLateness = WakeLateness.GetSnapshot();
+    Stats.PacketsPerWake = PacketsPerWake.GetSnapshot();
+    Stats.BufferFill = BufferFill.GetSnapshot();
+    Stats.SinkTime = SinkTime.GetSnapshot();
+    Stats.IterationTime = IterationTime.GetSnapshot();
+    return Stats;
+}
+
+FAudioCaptureThreadScheduling::FAudioCaptureThreadScheduling()
+    : MmcssHandle(nullptr)
+    , AppliedPriority(INDEX_NONE)
+    , AppliedAffinity(0)
+{
+}
+
+void FAudioCaptureThreadScheduling::Apply(const FString& MmcssTask, int32 Priority, uint64 AffinityMask)
+{
+    if (MmcssTask != AppliedTask) {
+        Revert();
+        AppliedTask = MmcssTask;
+
+        if (!MmcssTask.IsEmpty()) {
+            DWORD taskIndex = 0;
+            MmcssHandle = AvSetMmThreadCharacteristicsW(*MmcssTask, &taskIndex);
+
+            if (MmcssHandle == nullptr) {
+                UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioCaptureThreadScheduling: MMCSS task \"%s\" failed (error %u), keeping the thread priority"),
+                    *MmcssTask, ::GetLastError());
+            } else {
+                UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioCaptureThreadScheduling: capture thread registered as MMCSS \"%s\""), *MmcssTask);
+            }
+        }
+    }
+
+    // MMCSS owns the priority while registered; whatever it left behind is set again once it lets go
+    if (MmcssHandle != nullptr) {
+        AppliedPriority = INDEX_NONE;
+    } else {
+        const int32 NewPriority = Priority >= 0 && Priority < TPri_Num ? Priority : (int32)TPri_Normal;
+        FRunnableThread* Thread = FRunnableThread::GetRunnableThread();
+
+        if (NewPriority != AppliedPriority && Thread != nullptr) {
+            Thread->SetThreadPriority((EThreadPriority)NewPriority);
+            AppliedPriority = NewPriority;
+        }
+    }
+
+    if (AffinityMask != AppliedAffinity) {
+        FPlatformProcess::SetThreadAffinityMask(AffinityMask != 0 ? AffinityMask : FPlatformAffinity::GetNoAffinityMask());
+        AppliedAffinity = AffinityMask;
+    }
+}
+
+void FAudioCaptureThreadScheduling::Revert()
+{
+    if (MmcssHandle != nullptr) {
+        AvRevertMmThreadCharacteristics(MmcssHandle);
+        MmcssHandle = nullptr;
+    }
+
+    // The next Apply registers again and sets the priority
+    AppliedTask.Empty();
+    AppliedPriority = INDEX_NONE;
+}
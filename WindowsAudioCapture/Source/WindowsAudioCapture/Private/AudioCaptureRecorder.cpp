@@ -0,0 +1,451 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioCaptureRecorder.h"
+#include "WindowsAudioCapture.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarWACRecorderMaxQueuedMB(
+    TEXT("WAC.RecorderMaxQueuedMB"),
+    32,
+    TEXT("Memory the capture recorder may hold while the writer catches up, in MB. Past it packets and frames are dropped and counted.\n")
+    TEXT("Read when a recording starts."));
+
+namespace {
+// Distance between two keyframes (Format chunk + Pcm chunk) in the index
+constexpr double KeyframeIntervalSeconds = 1.0;
+
+// The writer polls the queue at this rate, the capture thread never signals it
+constexpr uint32 WriterWakeMs = 50;
+}
+
+FAudioCaptureRecorder::FAudioCaptureRecorder(IAudioSink& InDownstream)
+    : Downstream(InDownstream)
+    , bRecording(false)
+    , ProducersInFlight(0)
+    , Session(0)
+    , QueuedBytes(0)
+    , MaxQueuedBytes(0)
+    , PeakQueuedBytes(0)
+    , DroppedPcmFrames(0)
+    , DroppedPcmPackets(0)
+    , DroppedSpectrumFrames(0)
+    , RecordingStartSeconds(0.0)
+    , ProducerSession(0)
+    , CurrentFormat()
+    , StreamFrame(0)
+    , PendingDroppedFrames(0)
+    , PendingDroppedSpectrumFrames(0)
+    , bPendingDiscontinuity(false)
+    , FileHeader()
+    , WriterFormat()
+    , bFormatPending(false)
+    , bWriteFailed(false)
+    , LastKeyframeSeconds(0.0)
+    , LastChunkSeconds(0.0)
+    , WriterThread(nullptr)
+    , WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , bStopWriter(false)
+{
+}
+
+FAudioCaptureRecorder::~FAudioCaptureRecorder()
+{
+    StopRecording();
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    WakeEvent = nullptr;
+}
+
+bool FAudioCaptureRecorder::StartRecording(const FString& Path, FString& OutError)
+{
+    StopRecording();
+
+    IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+    platformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+
+    File.Reset(platformFile.OpenWrite(*Path));
+    if (!File.IsValid()) {
+        OutError = FString::Printf(TEXT("cannot create %s"), *Path);
+        return false;
+    }
+
+    RecordingStartSeconds = FPlatformTime::Seconds();
+
+    FileHeader = FAudioRecordingFileHeader();
+    FileHeader.Magic = FAudioRecordingFileHeader::ExpectedMagic;
+    FileHeader.Version = FAudioRecordingFileHeader::CurrentVersion;
+    FileHeader.StartSeconds = RecordingStartSeconds;
+    FileHeader.IndexOffset = 0;
+    bWriteFailed = !File->Write(reinterpret_cast<const uint8*>(&FileHeader), sizeof(FileHeader));
+
+    WriterFormat = FAudioRecordingFormat();
+    bFormatPending = false;
+    LastKeyframeSeconds = -KeyframeIntervalSeconds;
+    LastChunkSeconds = 0.0;
+    Keyframes.Reset();
+
+    MaxQueuedBytes = (int64)FMath::Max(1, CVarWACRecorderMaxQueuedMB.GetValueOnAnyThread()) * 1024 * 1024;
+    PeakQueuedBytes = 0;
+    DroppedPcmFrames = 0;
+    DroppedPcmPackets = 0;
+    DroppedSpectrumFrames = 0;
+
+    {
+        FScopeLock lock(&StatsLock);
+        Stats = FAudioRecorderStats();
+        Stats.bRecording = true;
+        Stats.Path = Path;
+        Stats.WrittenBytes = sizeof(FileHeader);
+    }
+
+    bStopWriter = false;
+    WriterThread = FRunnableThread::Create(this, TEXT("FAudioCaptureRecorder"), 0, EThreadPriority::TPri_BelowNormal);
+
+    // The capture thread starts a new stream (format, frame count) on its next call
+    Session.fetch_add(1);
+    bRecording = true;
+
+    UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioCaptureRecorder: recording to %s"), *Path);
+    return true;
+}
+
+void FAudioCaptureRecorder::StopRecording()
+{
+    if (WriterThread == nullptr) {
+        return;
+    }
+
+    // Once no producer is inside CopyData/RecordFrame nothing else can be queued for this recording
+    bRecording = false;
+    while (ProducersInFlight.load() != 0) {
+        FPlatformProcess::Sleep(0.0f);
+    }
+
+    bStopWriter = true;
+    WakeEvent->Trigger();
+    WriterThread->WaitForCompletion();
+    delete WriterThread;
+    WriterThread = nullptr;
+
+    FScopeLock lock(&StatsLock);
+    Stats.bRecording = false;
+
+    UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioCaptureRecorder: %s closed, %lld bytes, %lld frame(s) dropped in %d packet(s), %d spectrum frame(s) dropped"),
+        *Stats.Path, Stats.WrittenBytes, DroppedPcmFrames.load(), DroppedPcmPackets.load(), DroppedSpectrumFrames.load());
+}
+
+FAudioRecorderStats FAudioCaptureRecorder::GetStats() const
+{
+    FScopeLock lock(&StatsLock);
+
+    FAudioRecorderStats stats = Stats;
+    stats.QueuedBytes = QueuedBytes.load();
+    stats.PeakQueuedBytes = PeakQueuedBytes.load();
+    stats.DroppedPcmFrames = DroppedPcmFrames.load();
+    stats.DroppedPcmPackets = DroppedPcmPackets.load();
+    stats.DroppedSpectrumFrames = DroppedSpectrumFrames.load();
+    return stats;
+}
+
+bool FAudioCaptureRecorder::ReserveQueueBytes(int64 Bytes)
+{
+    // Only the capture thread adds, so the check cannot be overtaken
+    const int64 queued = QueuedBytes.load() + Bytes;
+    if (queued > MaxQueuedBytes) {
+        return false;
+    }
+
+    // The queue also shares WAC.MemoryBudgetMB with the capture histories
+    if (!FWindowsAudioCaptureMemory::TryAllocate(EWACMemory::RecorderQueue, Bytes)) {
+        return false;
+    }
+
+    QueuedBytes.fetch_add(Bytes);
+    if (queued > PeakQueuedBytes.load(std::memory_order_relaxed)) {
+        PeakQueuedBytes.store(queued, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void FAudioCaptureRecorder::BeginProducerSession()
+{
+    const uint32 session = Session.load();
+    if (ProducerSession == session) {
+        return;
+    }
+
+    ProducerSession = session;
+    StreamFrame = 0;
+    PendingDroppedFrames = 0;
+    PendingDroppedSpectrumFrames = 0;
+    bPendingDiscontinuity = false;
+
+    if (CurrentFormat.SampleRate != 0) {
+        FQueuedItem item;
+        item.Chunk.Type = EAudioRecordingChunk::Format;
+        item.Chunk.Seconds = FPlatformTime::Seconds() - RecordingStartSeconds;
+        item.Format = CurrentFormat;
+        item.Bytes = sizeof(item);
+
+        if (ReserveQueueBytes(item.Bytes)) {
+            Queue.Enqueue(MoveTemp(item));
+        }
+    }
+}
+
+int FAudioCaptureRecorder::CopyData(const BYTE* Data, const int NumFramesAvailable)
+{
+    // Downstream first, recording never delays the analysis
+    const int result = Downstream.CopyData(Data, NumFramesAvailable);
+
+    ProducersInFlight.fetch_add(1);
+
+    if (bRecording.load()) {
+        BeginProducerSession();
+
+        const int32 numBytes = Data != NULL ? NumFramesAvailable * CurrentFormat.GetBytesPerFrame() : 0;
+
+        if (ReserveQueueBytes(sizeof(FQueuedItem) + numBytes)) {
+            FQueuedItem item;
+            item.Chunk.Type = EAudioRecordingChunk::Pcm;
+            item.Chunk.Seconds = FPlatformTime::Seconds() - RecordingStartSeconds;
+            item.Pcm.StreamFrame = StreamFrame;
+            item.Pcm.NumFrames = NumFramesAvailable;
+            item.Pcm.Flags = (bPendingDiscontinuity || PendingDroppedFrames > 0 ? FAudioRecordingPcmHeader::Discontinuity : 0)
+                | (Data == NULL ? FAudioRecordingPcmHeader::Silent : 0);
+            item.Pcm.DroppedFramesBefore = PendingDroppedFrames;
+            item.Samples.Append(Data, numBytes);
+            item.Bytes = sizeof(FQueuedItem) + numBytes;
+
+            Queue.Enqueue(MoveTemp(item));
+
+            bPendingDiscontinuity = false;
+            PendingDroppedFrames = 0;
+        }
+        else {
+            PendingDroppedFrames += NumFramesAvailable;
+            DroppedPcmFrames.fetch_add(NumFramesAvailable, std::memory_order_relaxed);
+            DroppedPcmPackets.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        StreamFrame += NumFramesAvailable;
+    }
+
+    ProducersInFlight.fetch_sub(1);
+
+    return result;
+}
+
+void FAudioCaptureRecorder::MarkDiscontinuity()
+{
+    Downstream.MarkDiscontinuity();
+
+    bPendingDiscontinuity = true;
+}
+
+void FAudioCaptureRecorder::SetFormat(int SampleRate, int NumChannels, int BitsPerSample)
+{
+    Downstream.SetFormat(SampleRate, NumChannels, BitsPerSample);
+
+    CurrentFormat.SampleRate = SampleRate;
+    CurrentFormat.NumChannels = NumChannels;
+    CurrentFormat.BitsPerSample = BitsPerSample;
+    CurrentFormat.Reserved = 0;
+
+    ProducersInFlight.fetch_add(1);
+
+    // A new session queues the format itself
+    if (bRecording.load() && ProducerSession == Session.load()) {
+        FQueuedItem item;
+        item.Chunk.Type = EAudioRecordingChunk::Format;
+        item.Chunk.Seconds = FPlatformTime::Seconds() - RecordingStartSeconds;
+        item.Format = CurrentFormat;
+        item.Bytes = sizeof(item);
+
+        if (ReserveQueueBytes(item.Bytes)) {
+            Queue.Enqueue(MoveTemp(item));
+        }
+        else {
+            // Without it the following packets cannot be decoded, the next keyframe carries the format again
+            bPendingDiscontinuity = true;
+        }
+    }
+
+    ProducersInFlight.fetch_sub(1);
+}
+
+void FAudioCaptureRecorder::RecordFrame(const FAudioSpectrumFramePtr& Frame)
+{
+    ProducersInFlight.fetch_add(1);
+
+    if (bRecording.load() && Frame.IsValid()) {
+        BeginProducerSession();
+
+        // The frame is shared, not copied, but it stays alive until written so it counts against the budget
+        const int64 numBytes = sizeof(FQueuedItem) + (Frame->Magnitudes.Num() + Frame->BandMagnitudes.Num()) * sizeof(float);
+
+        if (ReserveQueueBytes(numBytes)) {
+            FQueuedItem item;
+            item.Chunk.Type = EAudioRecordingChunk::Frame;
+            item.Chunk.Seconds = Frame->Timestamp - RecordingStartSeconds;
+            item.Frame = Frame;
+            item.DroppedFramesBefore = PendingDroppedSpectrumFrames;
+            item.Bytes = numBytes;
+
+            Queue.Enqueue(MoveTemp(item));
+            PendingDroppedSpectrumFrames = 0;
+        }
+        else {
+            PendingDroppedSpectrumFrames++;
+            DroppedSpectrumFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ProducersInFlight.fetch_sub(1);
+}
+
+uint32 FAudioCaptureRecorder::Run()
+{
+    WAC_LLM_SCOPE();
+
+    while (!bStopWriter) {
+        WakeEvent->Wait(WriterWakeMs);
+        DrainQueue();
+    }
+
+    // StopRecording waited for the producers, this is everything
+    DrainQueue();
+    FinishFile();
+
+    return 0;
+}
+
+void FAudioCaptureRecorder::DrainQueue()
+{
+    FQueuedItem item;
+    while (Queue.Dequeue(item)) {
+        WriteItem(item);
+        QueuedBytes.fetch_sub(item.Bytes);
+        FWindowsAudioCaptureMemory::Free(EWACMemory::RecorderQueue, item.Bytes);
+
+        // Release the frame reference now rather than when the next item overwrites it
+        item.Frame.Reset();
+    }
+}
+
+void FAudioCaptureRecorder::WriteItem(const FQueuedItem& Item)
+{
+    switch (Item.Chunk.Type) {
+    case EAudioRecordingChunk::Format:
+        // Written as the keyframe of the next packet
+        WriterFormat = Item.Format;
+        bFormatPending = true;
+        break;
+
+    case EAudioRecordingChunk::Pcm: {
+        if (WriterFormat.SampleRate == 0) {
+            // Packets from before the first known format cannot be decoded
+            break;
+        }
+
+        if (bFormatPending || Item.Chunk.Seconds - LastKeyframeSeconds >= KeyframeIntervalSeconds) {
+            FAudioRecordingIndexEntry& entry = Keyframes.AddDefaulted_GetRef();
+            entry.Seconds = Item.Chunk.Seconds;
+            entry.StreamFrame = Item.Pcm.StreamFrame;
+            entry.Offset = File->Tell();
+
+            WriteChunk(EAudioRecordingChunk::Format, Item.Chunk.Seconds, &WriterFormat, sizeof(WriterFormat));
+            LastKeyframeSeconds = Item.Chunk.Seconds;
+            bFormatPending = false;
+        }
+
+        WriteChunk(EAudioRecordingChunk::Pcm, Item.Chunk.Seconds, &Item.Pcm, sizeof(Item.Pcm), Item.Samples.GetData(), Item.Samples.Num());
+
+        FScopeLock lock(&StatsLock);
+        Stats.RecordedPcmFrames += Item.Pcm.NumFrames;
+        break;
+    }
+
+    case EAudioRecordingChunk::Frame: {
+        const FAudioSpectrumFrame& frame = *Item.Frame;
+
+        FAudioRecordingFrameHeader header;
+        header.FrameIndex = frame.FrameIndex;
+        header.Timestamp = Item.Chunk.Seconds;
+        header.Flags = (frame.bDiscontinuity ? FAudioRecordingFrameHeader::Discontinuity : 0)
+            | (frame.bSilent ? FAudioRecordingFrameHeader::Silent : 0)
+            | (frame.bHasSpectrum ? FAudioRecordingFrameHeader::HasSpectrum : 0);
+        header.NumMagnitudes = frame.Magnitudes.Num();
+        header.NumBands = frame.BandMagnitudes.Num();
+        header.DroppedFramesBefore = Item.DroppedFramesBefore;
+        header.MomentaryLufs = frame.Levels.MomentaryLufs;
+        header.ShortTermLufs = frame.Levels.ShortTermLufs;
+        header.Rms = frame.Levels.GetMaxRms();
+        header.Peak = frame.Levels.GetMaxPeak();
+
+        WriteChunk(EAudioRecordingChunk::Frame, Item.Chunk.Seconds, &header, sizeof(header),
+            frame.Magnitudes.GetData(), frame.Magnitudes.Num() * sizeof(float),
+            frame.BandMagnitudes.GetData(), frame.BandMagnitudes.Num() * sizeof(float));
+
+        FScopeLock lock(&StatsLock);
+        Stats.RecordedSpectrumFrames++;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void FAudioCaptureRecorder::WriteChunk(EAudioRecordingChunk Type, double Seconds, const void* First, uint32 FirstSize, const void* Second, uint32 SecondSize, const void* Third, uint32 ThirdSize)
+{
+    if (bWriteFailed) {
+        return;
+    }
+
+    FAudioRecordingChunkHeader chunk;
+    chunk.Type = Type;
+    chunk.PayloadSize = FirstSize + SecondSize + ThirdSize;
+    chunk.Seconds = Seconds;
+
+    bool bWritten = File->Write(reinterpret_cast<const uint8*>(&chunk), sizeof(chunk));
+    bWritten = bWritten && (FirstSize == 0 || File->Write(static_cast<const uint8*>(First), FirstSize));
+    bWritten = bWritten && (SecondSize == 0 || File->Write(static_cast<const uint8*>(Second), SecondSize));
+    bWritten = bWritten && (ThirdSize == 0 || File->Write(static_cast<const uint8*>(Third), ThirdSize));
+
+    if (!bWritten) {
+        // Keep draining so the capture side is unaffected, the file ends at the last whole chunk
+        UE_LOG(WindowsAudioCaptureLog, Error, TEXT("FAudioCaptureRecorder: write failed, the rest of the recording is discarded"));
+        bWriteFailed = true;
+        return;
+    }
+
+    LastChunkSeconds = FMath::Max(LastChunkSeconds, Seconds);
+
+    FScopeLock lock(&StatsLock);
+    Stats.WrittenBytes += sizeof(chunk) + chunk.PayloadSize;
+}
+
+void FAudioCaptureRecorder::FinishFile()
+{
+    if (!File.IsValid()) {
+        return;
+    }
+
+    if (!bWriteFailed) {
+        const int64 indexOffset = File->Tell();
+        WriteChunk(EAudioRecordingChunk::Index, LastChunkSeconds, Keyframes.GetData(), Keyframes.Num() * sizeof(FAudioRecordingIndexEntry));
+
+        if (!bWriteFailed) {
+            FileHeader.IndexOffset = indexOffset;
+            File->Seek(0);
+            File->Write(reinterpret_cast<const uint8*>(&FileHeader), sizeof(FileHeader));
+        }
+    }
+
+    File->Flush();
+    File.Reset();
+}
@@ -0,0 +1,140 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioCaptureRecording.h"
+#include "HAL/PlatformFilemanager.h"
+
+FAudioRecordingReader::FAudioRecordingReader()
+    : Header()
+    , Duration(0.0)
+{
+}
+
+FAudioRecordingReader::~FAudioRecordingReader()
+{
+    Close();
+}
+
+bool FAudioRecordingReader::Open(const FString& Path, FString& OutError)
+{
+    Close();
+
+    File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path));
+    if (!File.IsValid()) {
+        OutError = FString::Printf(TEXT("cannot open %s"), *Path);
+        return false;
+    }
+
+    if (!File->Read(reinterpret_cast<uint8*>(&Header), sizeof(Header)) || Header.Magic != FAudioRecordingFileHeader::ExpectedMagic) {
+        OutError = FString::Printf(TEXT("%s is not a capture recording"), *Path);
+        Close();
+        return false;
+    }
+
+    if (Header.Version != FAudioRecordingFileHeader::CurrentVersion) {
+        OutError = FString::Printf(TEXT("%s: version %u, this build reads version %u"), *Path, Header.Version, FAudioRecordingFileHeader::CurrentVersion);
+        Close();
+        return false;
+    }
+
+    FAudioRecordingChunkHeader indexHeader;
+    const int64 indexOffset = (int64)Header.IndexOffset;
+    const bool bHasIndex = indexOffset >= (int64)sizeof(Header) && indexOffset + (int64)sizeof(indexHeader) <= File->Size()
+        && File->Seek(indexOffset) && File->Read(reinterpret_cast<uint8*>(&indexHeader), sizeof(indexHeader))
+        && indexHeader.Type == EAudioRecordingChunk::Index && indexHeader.PayloadSize % sizeof(FAudioRecordingIndexEntry) == 0
+        && indexOffset + (int64)sizeof(indexHeader) + indexHeader.PayloadSize <= File->Size();
+
+    if (bHasIndex) {
+        Keyframes.SetNumUninitialized(indexHeader.PayloadSize / sizeof(FAudioRecordingIndexEntry));
+        File->Read(reinterpret_cast<uint8*>(Keyframes.GetData()), indexHeader.PayloadSize);
+        Duration = indexHeader.Seconds;
+    }
+    else {
+        File->Seek(sizeof(Header));
+        RebuildKeyframes();
+    }
+
+    File->Seek(sizeof(Header));
+    return true;
+}
+
+void FAudioRecordingReader::Close()
+{
+    File.Reset();
+    Keyframes.Empty();
+    Header = FAudioRecordingFileHeader();
+    Duration = 0.0;
+}
+
+void FAudioRecordingReader::RebuildKeyframes()
+{
+    const int64 fileSize = File->Size();
+    int64 pendingFormatOffset = INDEX_NONE;
+
+    for (;;) {
+        const int64 offset = File->Tell();
+        FAudioRecordingChunkHeader chunk;
+
+        if (offset + (int64)sizeof(chunk) > fileSize || !File->Read(reinterpret_cast<uint8*>(&chunk), sizeof(chunk))
+            || offset + (int64)sizeof(chunk) + chunk.PayloadSize > fileSize || chunk.Type == EAudioRecordingChunk::Index) {
+            break;
+        }
+
+        Duration = FMath::Max(Duration, chunk.Seconds);
+
+        if (chunk.Type == EAudioRecordingChunk::Pcm && pendingFormatOffset != INDEX_NONE) {
+            FAudioRecordingPcmHeader pcm;
+            if (chunk.PayloadSize < sizeof(pcm) || !File->Read(reinterpret_cast<uint8*>(&pcm), sizeof(pcm))) {
+                break;
+            }
+
+            FAudioRecordingIndexEntry& entry = Keyframes.AddDefaulted_GetRef();
+            entry.Seconds = chunk.Seconds;
+            entry.StreamFrame = pcm.StreamFrame;
+            entry.Offset = pendingFormatOffset;
+        }
+
+        pendingFormatOffset = chunk.Type == EAudioRecordingChunk::Format ? offset : INDEX_NONE;
+
+        if (!File->Seek(offset + sizeof(chunk) + chunk.PayloadSize)) {
+            break;
+        }
+    }
+}
+
+bool FAudioRecordingReader::Seek(double Seconds)
+{
+    if (!IsOpen() || Keyframes.Num() == 0) {
+        return false;
+    }
+
+    // Last keyframe at or before Seconds
+    int32 low = 0;
+    int32 high = Keyframes.Num() - 1;
+    while (low < high) {
+        const int32 middle = (low + high + 1) / 2;
+        if (Keyframes[middle].Seconds <= Seconds) {
+            low = middle;
+        }
+        else {
+            high = middle - 1;
+        }
+    }
+
+    return File->Seek(Keyframes[low].Offset);
+}
+
+bool FAudioRecordingReader::ReadChunk(FAudioRecordingChunkHeader& OutHeader, TArray<uint8>& OutPayload)
+{
+    if (!IsOpen()) {
+        return false;
+    }
+
+    const int64 offset = File->Tell();
+
+    if (offset + (int64)sizeof(OutHeader) > File->Size() || !File->Read(reinterpret_cast<uint8*>(&OutHeader), sizeof(OutHeader))
+        || OutHeader.Type == EAudioRecordingChunk::Index || offset + (int64)sizeof(OutHeader) + OutHeader.PayloadSize > File->Size()) {
+        return false;
+    }
+
+    OutPayload.SetNumUninitialized(OutHeader.PayloadSize, false);
+    return OutHeader.PayloadSize == 0 || File->Read(OutPayload.GetData(), OutHeader.PayloadSize);
+}
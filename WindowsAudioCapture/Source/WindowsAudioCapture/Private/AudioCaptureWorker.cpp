@@ -1,17 +1,113 @@
 //Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
 #include "AudioCaptureWorker.h"
 #include "WindowsAudioCapture.h"
+#include "WindowsAudioCaptureStats.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Analyze Captured Audio"), STAT_WAC_AnalyzeCapturedAudio, STATGROUP_WindowsAudioCapture);
+DECLARE_CYCLE_STAT(TEXT("Analyze Target Frequencies"), STAT_WAC_AnalyzeTargetFrequencies, STATGROUP_WindowsAudioCapture);
+DECLARE_CYCLE_STAT(TEXT("Analyze Bands"), STAT_WAC_AnalyzeBands, STATGROUP_WindowsAudioCapture);
+DECLARE_CYCLE_STAT(TEXT("Analyze Music Features"), STAT_WAC_AnalyzeMusicFeatures, STATGROUP_WindowsAudioCapture);
+DECLARE_CYCLE_STAT(TEXT("Analyze Harmonic/Percussive"), STAT_WAC_AnalyzeHarmonicPercussive, STATGROUP_WindowsAudioCapture);
+DECLARE_CYCLE_STAT(TEXT("Update Waveform Envelope"), STAT_WAC_UpdateWaveform, STATGROUP_WindowsAudioCapture);
+DECLARE_CYCLE_STAT(TEXT("Normalize Frame"), STAT_WAC_NormalizeFrame, STATGROUP_WindowsAudioCapture);
+
+static TAutoConsoleVariable<int32> CVarWACMaxTargetFrequencies(
+	TEXT("WAC.MaxTargetFrequencies"),
+	24,
+	TEXT("Largest number of registered target frequencies evaluated with the Goertzel bank instead of the FFT.\n")
+	TEXT("Run WAC.BenchmarkTargets to measure the crossover on this machine. 0 always uses the FFT."));
+
+static TAutoConsoleVariable<float> CVarWACHarmonicPercussiveBudgetMs(
+	TEXT("WAC.HarmonicPercussiveBudgetMs"),
+	0.25f,
+	TEXT("CPU time per frame (ms) the harmonic/percussive separation should stay under. Past it, adjacent bins are\n")
+	TEXT("merged before the median filters. Run WAC.BenchmarkHarmonicPercussive for the cost on this machine. 0 disables the budget."));
+
+static TAutoConsoleVariable<int32> CVarWACAnalysisGraph(
+	TEXT("WAC.AnalysisGraph"),
+	1,
+	TEXT("Run the stages of the frame analysis (channel FFTs, channel mix, feature stages, bands) on the task graph\n")
+	TEXT("when enough of their work can overlap. 0 always runs them one after the other on the capture thread."));
+
+static TAutoConsoleVariable<float> CVarWACAnalysisGraphMinParallelMs(
+	TEXT("WAC.AnalysisGraphMinParallelMs"),
+	0.1f,
+	TEXT("CPU time per frame (ms) the analysis stages have to be able to run side by side before they go to the task graph.\n")
+	TEXT("Below it a task dispatch costs more than it saves. The stage timings are in WAC.Stats."));
+
+static const FName StageBands(TEXT("Bands"));
+static const FName StageTargetFrequencies(TEXT("Target Frequencies"));
+static const FName StageChannelFft(TEXT("Channel FFT"));
+static const FName StageChannelMix(TEXT("Channel Mix"));
+static const FName StageConstantQ(TEXT("Constant Q"));
+static const FName StageMusicFeatures(TEXT("Music Features"));
+static const FName StageHarmonicPercussive(TEXT("Harmonic/Percussive"));
+
+static TAutoConsoleVariable<float> CVarWACNormalizeFloorQuantile(
+	TEXT("WAC.NormalizeFloorQuantile"),
+	0.1f,
+	TEXT("Share of its recent values a bin of the normalized spectrum has to be above to read more than 0."));
+
+static TAutoConsoleVariable<float> CVarWACNormalizeCeilingQuantile(
+	TEXT("WAC.NormalizeCeilingQuantile"),
+	0.95f,
+	TEXT("Share of its recent values a bin of the normalized spectrum has to be above to read 1."));
+
+static TAutoConsoleVariable<int32> CVarWACNormalizeAdaptFrames(
+	TEXT("WAC.NormalizeAdaptFrames"),
+	200,
+	TEXT("Frames the normalized spectrum takes to follow a change of volume, about 2 seconds at the default 200."));
+
+static TAutoConsoleVariable<FString> CVarWACCaptureThreadMMCSS(
+	TEXT("WAC.CaptureThreadMMCSS"),
+	TEXT(""),
+	TEXT("MMCSS task the capture thread registers with, e.g. \"Audio\" or \"Pro Audio\", so Windows schedules it ahead\n")
+	TEXT("of normal threads. Empty leaves MMCSS. Check WAC.Deadlines for late wakes before and after."));
+
+static TAutoConsoleVariable<int32> CVarWACCaptureThreadPriority(
+	TEXT("WAC.CaptureThreadPriority"),
+	-1,
+	TEXT("EThreadPriority of the capture thread while it is not registered with MMCSS. -1 keeps TPri_Normal."));
+
+static TAutoConsoleVariable<int32> CVarWACCaptureThreadAffinity(
+	TEXT("WAC.CaptureThreadAffinity"),
+	0,
+	TEXT("Affinity mask of the capture thread, e.g. 4 for the third core only. 0 allows every core."));
 
 
 
-FAudioCaptureWorker* FAudioCaptureWorker::Runnable = NULL;
 int32 FAudioCaptureWorker::ThreadCounter = 0;
 
 FAudioCaptureWorker::FAudioCaptureWorker()
 	: Thread(NULL)
-	, m_listener(16, WAVE_FORMAT_PCM, 4, 0)
+	, bIsFinished(false)
+	, bCaptureEnabled(false)
+	, WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, LastSpectrumRequestSeconds(-SpectrumDemandTimeout)
+	, NextFrameIndex(1)
+	, LastConstantQRequestSeconds(-SpectrumDemandTimeout)
+	, LastMusicRequestSeconds(-SpectrumDemandTimeout)
+	, LastHarmonicPercussiveRequestSeconds(-SpectrumDemandTimeout)
+	, LastNormalizedRequestSeconds(-SpectrumDemandTimeout)
+	, LastBandRequestSeconds(-SpectrumDemandTimeout)
+	, LastWaveformRequestSeconds(-SpectrumDemandTimeout)
+	, bWaveformFed(false)
+	, m_listener(16, WAVE_FORMAT_PCM, 0)
 	, m_sink()
+	, LostSinkPackets(0)
+	, m_deviceState(m_listener)
+	, m_recorder(m_sink)
+	, m_replayState(m_replay)
+	, bPendingReplayLoop(false)
+	, bReplayChangePending(false)
+	, bReplaying(false)
+	, bSharedSpectrumChangePending(false)
 {
+	OnsetDetector.Configure(BandSettings);
+	m_listener.SetDeadlineMonitor(&DeadlineMonitor);
+
 	// Higher overall ThreadCounter to avoid duplicated names
 	FAudioCaptureWorker::ThreadCounter++;
 
@@ -20,18 +116,16 @@ FAudioCaptureWorker::FAudioCaptureWorker()
 
 FAudioCaptureWorker::~FAudioCaptureWorker()
 {
-	// Make sure to mark Thread as finished
-	bIsFinished = true;
+	EnsureCompletion();
+
+	// No frame will come any more, nobody should wait for one
+	FrameNotifier.Shutdown();
 
 	delete Thread;
 	Thread = NULL;
-}
 
-FAudioCaptureWorker* FAudioCaptureWorker::InitializeWorker()
-{
-	Runnable = new FAudioCaptureWorker();
-
-	return Runnable;
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = NULL;
 }
 
 bool FAudioCaptureWorker::Init()
@@ -39,12 +133,65 @@ bool FAudioCaptureWorker::Init()
 	// Make sure the Worker is marked is not finished
 	bIsFinished = false;
 
+	// The listener and all its COM objects live on this thread
+	FPlatformMisc::CoInitialize();
+
 	return true;
 }
 
 uint32 FAudioCaptureWorker::Run()
 {
-	m_listener.RecordAudioStream(&m_sink, bIsFinished);
+	WAC_LLM_SCOPE();
+
+	while (StopTaskCounter.GetValue() == 0)
+	{
+		const bool bWantRunning = bCaptureEnabled;
+
+		// Cheap when nothing changed, so a cvar edit applies on the next wake
+		ThreadScheduling.Apply(CVarWACCaptureThreadMMCSS.GetValueOnAnyThread(), CVarWACCaptureThreadPriority.GetValueOnAnyThread(),
+			uint64(uint32(CVarWACCaptureThreadAffinity.GetValueOnAnyThread())));
+
+		DeadlineMonitor.BeginIteration();
+
+		ApplyPendingReplay();
+		ApplyPendingSharedSpectrum();
+
+		// Opens, restarts, parks or reconnects the device as needed, then drains it into the sink
+		if (bReplaying)
+		{
+			m_deviceState.Update(false, &m_recorder);
+			m_replayState.Update(bWantRunning, &m_recorder);
+		}
+		else
+		{
+			m_deviceState.Update(bWantRunning, &m_recorder);
+		}
+
+		if (!bWantRunning)
+		{
+			// Parked: nothing to poll until SetCaptureEnabled or Stop wakes us up
+			DeadlineMonitor.Suspend();
+			WakeEvent->Wait();
+			continue;
+		}
+
+		// Analyse once per wake, so every consumer shares the same FFT
+		AnalyzeCapturedAudio();
+
+		DeadlineMonitor.EndIteration();
+
+		// Sleep for half the buffer duration, Stop() cuts the wait short
+		const uint32 waitMs = bReplaying ? ReplayPollIntervalMs : m_listener.GetPollIntervalMs();
+		DeadlineMonitor.BeginWait(waitMs / 1000.0);
+		DeadlineMonitor.EndWait(WakeEvent->Wait(waitMs));
+	}
+
+	ThreadScheduling.Revert();
+
+	m_replayState.Shutdown();
+	m_deviceState.Shutdown();
+	m_listener.Shutdown();
+	m_sharedSpectrum.Close();
 
 	return 0;
 }
@@ -52,202 +199,905 @@ uint32 FAudioCaptureWorker::Run()
 void FAudioCaptureWorker::Stop()
 {
 	StopTaskCounter.Increment();
+	WakeEvent->Trigger();
 }
 
-void FAudioCaptureWorker::ShutdownWorker()
+void FAudioCaptureWorker::SetCaptureEnabled(bool bEnabled)
 {
-	if (Runnable) {
-		Runnable->EnsureCompletion();
-		delete Runnable;
-		Runnable = NULL;
+	if (bCaptureEnabled != bEnabled)
+	{
+		bCaptureEnabled = bEnabled;
+		WakeEvent->Trigger();
+	}
+}
+
+void FAudioCaptureWorker::StartReplay(const FString& Path, bool bLoop)
+{
+	{
+		FScopeLock lock(&ReplayLock);
+		PendingReplayPath = Path;
+		bPendingReplayLoop = bLoop;
+		bReplayChangePending = true;
+	}
+
+	WakeEvent->Trigger();
+}
+
+void FAudioCaptureWorker::ApplyPendingReplay()
+{
+	FString path;
+	bool bLoop;
+	{
+		FScopeLock lock(&ReplayLock);
+		if (!bReplayChangePending) {
+			return;
+		}
+		bReplayChangePending = false;
+		path = PendingReplayPath;
+		bLoop = bPendingReplayLoop;
+	}
+
+	m_replayState.Shutdown();
+
+	if (!path.IsEmpty()) {
+		m_replay.SetRecording(path, bLoop);
+	}
+	else if (bReplaying) {
+		// Reopen the listener so the sink gets the device format back with the first live packet
+		m_deviceState.Shutdown();
+	}
+
+	bReplaying = !path.IsEmpty();
+
+	// Whatever was analysed before does not line up with what comes next
+	m_recorder.MarkDiscontinuity();
+
+	UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioCaptureWorker: %s%s"), bReplaying ? TEXT("replaying ") : TEXT("back to live capture"), *path);
+}
+
+void FAudioCaptureWorker::StartSharedSpectrum(const FString& Name)
+{
+	{
+		FScopeLock lock(&SharedSpectrumLock);
+		PendingSharedSpectrumName = Name;
+		bSharedSpectrumChangePending = true;
+	}
+
+	WakeEvent->Trigger();
+}
+
+void FAudioCaptureWorker::ApplyPendingSharedSpectrum()
+{
+	FString name;
+	{
+		FScopeLock lock(&SharedSpectrumLock);
+		if (!bSharedSpectrumChangePending) {
+			return;
+		}
+		bSharedSpectrumChangePending = false;
+		name = PendingSharedSpectrumName;
+	}
+
+	if (name.IsEmpty()) {
+		m_sharedSpectrum.Close();
+	}
+	else {
+		m_sharedSpectrum.Open(name, BandSettings);
 	}
 }
 
 void FAudioCaptureWorker::Exit()
 {
+	FPlatformMisc::CoUninitialize();
+
 	// Make sure to mark Thread as finished
 	bIsFinished = true;
 }
 
 void FAudioCaptureWorker::EnsureCompletion()
 {
-	Stop();
-	// Make sure to mark Thread as finished
-	bIsFinished = true;
+	if (Thread == NULL || bIsFinished)
+	{
+		return;
+	}
 
-	if (Thread != NULL) {
+	const double StartTime = FPlatformTime::Seconds();
 
-		Thread->WaitForCompletion();
-	}
+	Stop();
+	Thread->WaitForCompletion();
+
+	UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioCaptureWorker: capture thread stopped in %.2f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
-TArray<float> FAudioCaptureWorker::GetFrequencyArray(float FreqLogBase, float FreqMultiplier, float FreqPower, float FreqOffset)
+void FAudioCaptureWorker::AnalyzeCapturedAudio()
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("FAudioCaptureWorker::GetFrequencyArray"));
-	TArray<float> freqs;
+	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("FAudioCaptureWorker::AnalyzeCapturedAudio"));
+	SCOPE_CYCLE_COUNTER(STAT_WAC_AnalyzeCapturedAudio);
 	AudioChunk chunk;
+	AudioChunk latest;
+	bool bGotChunk = false;
+	bool bDiscontinuity = false;
+	const bool bBandsRequested = IsBandSpectrumRequested();
+	const bool bMusicRequested = IsMusicFeaturesRequested();
+	const bool bHarmonicPercussiveRequested = IsHarmonicPercussiveRequested();
+	const bool bWaveformRequested = IsWaveformRequested();
+
+	if (!bWaveformRequested) {
+		bWaveformFed = false;
+	}
+
+	// Only the newest chunk goes through the FFT, older ones would be stale by the time anyone reads them.
+	// The band analyzer keeps its own history and sees every chunk.
+	for (;;) {
+		const EAudioRingRead result = m_sink.Read(SinkCursor, chunk, ChunkSamples);
+
+		if (result == EAudioRingRead::Empty) {
+			break;
+		}
 
-	if (m_sink.Dequeue(chunk)) {
-		if (chunk.size <= 0) {
-			return freqs;
+		if (result == EAudioRingRead::Overrun) {
+			LostSinkPackets.store(SinkCursor.LostPackets, std::memory_order_relaxed);
+			bDiscontinuity = true;
+			continue;
 		}
 
-		//Calculate Frequency Values
-		CalculateFrequencySpectrum(chunk.chunk, 2, chunk.size, FreqLogBase, FreqMultiplier, FreqPower, FreqOffset, freqs);
+		bDiscontinuity |= chunk.bDiscontinuity;
+		bGotChunk = true;
 
-		//Empty chunk's trash
-		m_sink.EmptyQueue(chunk);
+		if (bBandsRequested) {
+			FeedBandAnalyzer(chunk);
+		}
+
+		if (bMusicRequested) {
+			FeedPitchDetector(chunk);
+		}
+
+		if (bWaveformRequested) {
+			FeedWaveform(chunk);
+		}
+
+		// Keep the newest samples, the next read goes into the other buffer
+		Swap(ChunkSamples, LatestSamples);
+		latest = chunk;
+		latest.chunk = LatestSamples.Num() > 0 ? LatestSamples.GetData() : nullptr;
 	}
 
-	TArray<float> resultFloats;
-	float count = freqs.Num() / 2 - 1;
+	if (!bGotChunk) {
+		return;
+	}
+
+	TSharedPtr<FAudioSpectrumFrame, ESPMode::ThreadSafe> frame = MakeShared<FAudioSpectrumFrame, ESPMode::ThreadSafe>();
+	// The rate the packet was written at, WAC.AnalysisSampleRate may have changed since
+	frame->SampleRate = latest.sampleRate;
 
-	resultFloats.Reserve(count);
+	// Levels cover every chunk received since the last wake, the spectrum only the newest one
+	frame->Levels = m_sink.ConsumeLevels();
 
-	for (float i = 1; i < freqs.Num() / 2; i++) {
-		if (freqs[i] < 0) {
-			freqs[i] = 0;
+	if (latest.bSilent || latest.size <= 0) {
+		{
+			FScopeLock lock(&AnalysisStatsLock);
+			AnalysisStats.SkippedSilentAnalyses++;
 		}
 
-		resultFloats.Add(freqs[i]);
+		// One silent frame when the gate closes, after that only while the meter still sees something below the gate
+		FAudioSpectrumFramePtr previous = GetLatestFrame();
+		if (previous.IsValid() && previous->bSilent && !bDiscontinuity && frame->Levels.GetMaxPeak() <= 0.0f) {
+			return;
+		}
+
+		frame->bSilent = true;
+
+		// Sound coming back after the gate is an onset
+		OnsetDetector.Reset();
+
+		frame->Magnitudes.SetNumZeroed(previous.IsValid() ? previous->Magnitudes.Num() : 0);
+		frame->bHasSpectrum = frame->Magnitudes.Num() > 0;
+		if (previous.IsValid()) {
+			frame->TargetFrequencies = previous->TargetFrequencies;
+			frame->TargetMagnitudes.SetNumZeroed(previous->TargetFrequencies.Num());
+			frame->BandMagnitudes.SetNumZeroed(previous->BandMagnitudes.Num());
+			frame->Onsets.bValid = previous->Onsets.bValid;
+			FMemory::Memcpy(frame->Onsets.OnsetCount, previous->Onsets.OnsetCount, sizeof(frame->Onsets.OnsetCount));
+			frame->ConstantQMagnitudes.SetNumZeroed(previous->ConstantQMagnitudes.Num());
+			frame->ConstantQSettings = previous->ConstantQSettings;
+			frame->Music.bValid = previous->Music.bValid;
+			frame->HarmonicPercussive.bValid = previous->HarmonicPercussive.bValid;
+			frame->Channels.NumChannels = previous->Channels.NumChannels;
+			frame->Channels.NumBins = previous->Channels.NumBins;
+			frame->Channels.Magnitudes.SetNumZeroed(previous->Channels.Magnitudes.Num());
+		}
+		PublishFrame(frame, bDiscontinuity);
+		return;
+	}
+
+	// Stages for this frame, run at the end of whichever path the frame takes
+	AnalysisGraph.Reset();
+	AnalysisGraph.SetParallelEnabled(CVarWACAnalysisGraph.GetValueOnAnyThread() != 0);
+	AnalysisGraph.SetMinParallelSeconds(CVarWACAnalysisGraphMinParallelMs.GetValueOnAnyThread() / 1000.0);
+
+	// The band analyzer has its own history and needs nothing from the FFT
+	if (bBandsRequested) {
+		AnalysisGraph.AddStage(StageBands, [this, &frame]() {
+			AnalyzeBands(*frame);
+		});
+	}
+
+	TArray<int32> targets;
+	GatherTargetFrequencies(targets);
+
+	FAudioConstantQSettings constantQSettings;
+	const bool bConstantQRequested = GetRequestedConstantQ(constantQSettings);
+	const bool bSpectrumRequested = IsSpectrumRequested() || bConstantQRequested || bMusicRequested || bHarmonicPercussiveRequested;
+
+	// A few fixed frequencies are cheaper to evaluate one by one than through the whole FFT
+	if (!bSpectrumRequested && targets.Num() > 0 && targets.Num() <= CVarWACMaxTargetFrequencies.GetValueOnAnyThread()) {
+		AnalysisGraph.AddStage(StageTargetFrequencies, [this, &latest, &targets, &frame]() {
+			AnalyzeTargetFrequencies(latest, targets, *frame);
+		});
+		AnalysisGraph.Run();
+
+		PublishFrame(frame, bDiscontinuity);
+		return;
 	}
 
-	return resultFloats;
+	if (!bSpectrumRequested && targets.Num() == 0) {
+		AnalysisGraph.Run();
+
+		{
+			FScopeLock lock(&AnalysisStatsLock);
+			AnalysisStats.SkippedUnrequestedAnalyses++;
+		}
+
+		PublishFrame(frame, bDiscontinuity);
+		return;
+	}
+
+	const double analysisStart = FPlatformTime::Seconds();
+
+	// Every channel separately, Magnitudes gets their average
+	const int32 numChannels = latest.numFrames > 0 ? latest.size / latest.numFrames : 2;
+	const int32 numAnalyzed = ChannelAnalyzer.BeginBlock(latest.chunk, latest.numFrames, numChannels, frame->SampleRate, frame->Channels);
+
+	if (numAnalyzed < 1 || frame->Channels.NumBins < 1) {
+		// No spectrum, the bands and levels of the frame still go out
+		AnalysisGraph.Run();
+		PublishFrame(frame, bDiscontinuity);
+		return;
+	}
+
+	TArray<int32> channelStages;
+	for (int32 channel = 0; channel < numAnalyzed; ++channel) {
+		channelStages.Add(AnalysisGraph.AddStage(StageChannelFft, [this, channel, &frame]() {
+			ChannelAnalyzer.AnalyzeBlockChannel(channel, frame->Channels);
+		}));
+	}
+
+	const TArray<int32> mixStage = { AnalysisGraph.AddStage(StageChannelMix, [this, &frame]() {
+		ChannelAnalyzer.EndBlock(frame->Channels, frame->Magnitudes);
+	}, channelStages) };
+
+	// Feature stages only read the mixed spectrum. The kernel cache is not thread safe, so the
+	// kernels they need are looked up (or built) here, before any of them runs
+	FAudioConstantQKernel* constantQKernel = nullptr;
+	int32 constantQStage = INDEX_NONE;
+
+	if (bConstantQRequested) {
+		constantQKernel = &ConstantQKernels.FindOrBuild(constantQSettings, frame->SampleRate, frame->Channels.NumBins);
+		constantQStage = AnalysisGraph.AddStage(StageConstantQ, [constantQKernel, &constantQSettings, &frame]() {
+			frame->ConstantQMagnitudes.SetNumUninitialized(constantQSettings.GetNumBins());
+			constantQKernel->Apply(frame->Magnitudes.GetData(), frame->ConstantQMagnitudes.GetData());
+			frame->ConstantQSettings = constantQSettings;
+		}, mixStage);
+	}
+
+	if (bMusicRequested) {
+		FAudioConstantQKernel* chromaKernel = &ConstantQKernels.FindOrBuild(FAudioMusicFeatures::GetChromaLayout(), frame->SampleRate, frame->Channels.NumBins);
+
+		// A kernel has scratch buffers, a constant-Q request on the chroma layout shares it and goes first
+		const TArray<int32> musicPrerequisites = chromaKernel == constantQKernel ? TArray<int32>({ constantQStage }) : mixStage;
+		AnalysisGraph.AddStage(StageMusicFeatures, [this, chromaKernel, &frame]() {
+			AnalyzeMusicFeatures(*frame, *chromaKernel);
+		}, musicPrerequisites);
+	}
+
+	if (bHarmonicPercussiveRequested) {
+		const int32 sampleRate = frame->SampleRate;
+		AnalysisGraph.AddStage(StageHarmonicPercussive, [this, sampleRate, bDiscontinuity, &frame]() {
+			AnalyzeHarmonicPercussive(*frame, sampleRate, bDiscontinuity);
+		}, mixStage);
+	}
+
+	AnalysisGraph.Run();
+
+	frame->bHasSpectrum = true;
+
+	{
+		FScopeLock lock(&AnalysisStatsLock);
+		AnalysisStats.AnalyzedFrames++;
+		AnalysisStats.ConstantQKernelsBuilt = ConstantQKernels.GetNumBuilt();
+		AnalysisStats.TotalAnalysisSeconds += FPlatformTime::Seconds() - analysisStart;
+	}
+
+	PublishFrame(frame, bDiscontinuity);
 }
 
-float GetTheFFTInValue(const int16 InSampleValue, const int16 InSampleIndex, const int16 InSampleCount)
+void FAudioCaptureWorker::AnalyzeTargetFrequencies(const AudioChunk& Chunk, const TArray<int32>& Frequencies, FAudioSpectrumFrame& Frame)
 {
-	float FFTValue = InSampleValue;
+	SCOPE_CYCLE_COUNTER(STAT_WAC_AnalyzeTargetFrequencies);
+	const double analysisStart = FPlatformTime::Seconds();
 
-	FFTValue *= 0.5f * (1 - FMath::Cos(2 * PI * InSampleIndex / (InSampleCount - 1)));
+	if (TargetBank.GetSampleRate() != Chunk.sampleRate || TargetBank.GetFrequencies() != Frequencies) {
+		TargetBank.Configure(Chunk.sampleRate, Frequencies);
+	}
+
+	const int32 numChannels = Chunk.numFrames > 0 ? Chunk.size / Chunk.numFrames : 2;
+	TargetBank.Process(Chunk.chunk, Chunk.numFrames, numChannels, Frame.TargetMagnitudes);
+	Frame.TargetFrequencies = Frequencies;
 
-	return FFTValue;
+	FScopeLock lock(&AnalysisStatsLock);
+	AnalysisStats.AnalyzedTargetFrames++;
+	AnalysisStats.TotalTargetAnalysisSeconds += FPlatformTime::Seconds() - analysisStart;
 }
 
-void FAudioCaptureWorker::CalculateFrequencySpectrum(
-	int16* SamplePointer,
-	const int32 NumChannels,
-	const int32 NumAvailableSamples,
-	float FreqLogBase,
-	float FreqMultiplier,
-	float FreqPower,
-	float FreqOffset,
-	TArray<float>& OutFrequencies)
+void FAudioCaptureWorker::FeedBandAnalyzer(const AudioChunk& Chunk)
 {
-	// Clear the Array before continuing
-	OutFrequencies.Empty();
+	const int32 numChannels = Chunk.size > 0 && Chunk.numFrames > 0 ? Chunk.size / Chunk.numFrames : FMath::Max(BandAnalyzer.GetNumChannels(), 2);
 
-	// Make sure the Number of Channels is correct
-	if (NumChannels > 0 && NumChannels <= 2) {
-		// Check if we actually have a Buffer to work with
-		if (SamplePointer != NULL && SamplePointer != nullptr) {
+	if (!BandAnalyzer.IsConfigured() || BandAnalyzer.GetSampleRate() != Chunk.sampleRate || BandAnalyzer.GetNumChannels() != numChannels) {
+		BandAnalyzer.Configure(Chunk.sampleRate, numChannels, BandSettings);
+	}
 
-			// Get Maximum amount of samples in this Sound
-			const int32 SampleCount = NumAvailableSamples;
+	BandAnalyzer.PushInt16(Chunk.size > 0 ? Chunk.chunk : nullptr, Chunk.numFrames);
+}
 
-			// An early check if we can create a Sample window
-			int32 FirstSample = 0;
-			int32 LastSample = SampleCount;
+void FAudioCaptureWorker::FeedWaveform(const AudioChunk& Chunk)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WAC_UpdateWaveform);
+	const int32 numChannels = Chunk.size > 0 && Chunk.numFrames > 0 ? Chunk.size / Chunk.numFrames : FMath::Max(Waveform.GetNumChannels(), 2);
 
-			// Actual amount of samples we gonna read
-			int32 SamplesToRead = LastSample - FirstSample;
+	FScopeLock lock(&WaveformLock);
 
-			if (SamplesToRead < 0) {
-				GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("CalculateFrequencySpectrum: Number of SamplesToRead is < 0!")));
-				return;
-			}
+	if (!Waveform.IsConfigured() || Waveform.GetSampleRate() != Chunk.sampleRate || Waveform.GetNumChannels() != numChannels) {
+		Waveform.Configure(Chunk.sampleRate, numChannels);
+	} else if (!bWaveformFed) {
+		// Whatever is left from the last request is seconds old
+		Waveform.Reset();
+	}
+	bWaveformFed = true;
 
-			//Shift the window enough so that we get a PowerOfTwo. FFT works better with that
-			int32 PoT = 2;
+	Waveform.PushInt16(Chunk.size > 0 ? Chunk.chunk : nullptr, Chunk.numFrames);
+}
 
-			while (SamplesToRead > PoT) {
-				PoT *= 2;
-			}
+void FAudioCaptureWorker::FeedPitchDetector(const AudioChunk& Chunk)
+{
+	const int32 numChannels = Chunk.size > 0 && Chunk.numFrames > 0 ? Chunk.size / Chunk.numFrames : FMath::Max(PitchDetector.GetNumChannels(), 2);
+
+	if (!PitchDetector.IsConfigured() || PitchDetector.GetSampleRate() != Chunk.sampleRate || PitchDetector.GetNumChannels() != numChannels) {
+		PitchDetector.Configure(Chunk.sampleRate, numChannels);
+	}
 
-			// Now we have a good PowerOfTwo to work with
-			SamplesToRead = PoT;
+	PitchDetector.PushInt16(Chunk.size > 0 ? Chunk.chunk : nullptr, Chunk.numFrames);
+}
 
-			// Create two 2-dim Arrays for complex numbers | Buffer and Output
-			kiss_fft_cpx* Buffer[2] = { 0 };
-			kiss_fft_cpx* Output[2] = { 0 };
+void FAudioCaptureWorker::AnalyzeMusicFeatures(FAudioSpectrumFrame& Frame, FAudioConstantQKernel& ChromaKernel)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WAC_AnalyzeMusicFeatures);
+	const double analysisStart = FPlatformTime::Seconds();
 
-			// Create 1-dim Array with one slot for SamplesToRead
-			int32 Dims[1] = { SamplesToRead };
+	ChromaBins.SetNumUninitialized(FAudioMusicFeatures::GetChromaLayout().GetNumBins());
+	ChromaKernel.Apply(Frame.Magnitudes.GetData(), ChromaBins.GetData());
 
-			kiss_fftnd_cfg STF = kiss_fftnd_alloc(Dims, 1, 0, nullptr, nullptr);
+	Frame.Music.FoldChroma(ChromaBins.GetData(), ChromaBins.Num());
+	PitchDetector.Detect(Frame.Music);
+	Frame.Music.bValid = true;
 
-			int16* SamplePtr = SamplePointer;
+	FScopeLock lock(&AnalysisStatsLock);
+	AnalysisStats.AnalyzedMusicFrames++;
+	AnalysisStats.TotalMusicAnalysisSeconds += FPlatformTime::Seconds() - analysisStart;
+}
 
-			// Allocate space in the Buffer and Output Arrays for all the data that FFT returns
-			for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++) {
-				Buffer[ChannelIndex] = (kiss_fft_cpx*)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * SamplesToRead);
-				Output[ChannelIndex] = (kiss_fft_cpx*)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * SamplesToRead);
-			}
+void FAudioCaptureWorker::AnalyzeHarmonicPercussive(FAudioSpectrumFrame& Frame, int32 SampleRate, bool bDiscontinuity)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WAC_AnalyzeHarmonicPercussive);
 
-			// Shift our SamplePointer to the Current "FirstSample"
-			SamplePtr += FirstSample * NumChannels;
-
-			for (int32 SampleIndex = 0; SampleIndex < SamplesToRead; SampleIndex++) {
-
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++) {
-					// Make sure the Point is Valid and we don't go out of bounds
-					if (SamplePtr != NULL && SamplePtr != nullptr && (SampleIndex + FirstSample < SampleCount)) {
-						// Use Window function to get a better result for the Data (Hann Window)
-						Buffer[ChannelIndex][SampleIndex].r = GetTheFFTInValue(*SamplePtr, SampleIndex, SamplesToRead);
-						Buffer[ChannelIndex][SampleIndex].i = 0.f;
-					}
-					else {
-						// Use Window function to get a better result for the Data (Hann Window)
-						Buffer[ChannelIndex][SampleIndex].r = 0.f;
-						Buffer[ChannelIndex][SampleIndex].i = 0.f;
-					}
-
-					// Take the next Sample - Halfed Causes SamplePtr Exception
-					if (SamplePtr != NULL && SamplePtr != nullptr && (SampleIndex + FirstSample < SampleCount / 2)) {
-						SamplePtr++;
-					}
-					else {
-						SamplePtr = 0;
-					}
-				}
-			}
+	// The medians would compare the new audio with the old
+	if (bDiscontinuity) {
+		HarmonicPercussive.Reset();
+	}
 
-			// Now that the Buffer is filled, use the FFT
-			for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ChannelIndex++) {
-				if (Buffer[ChannelIndex]) {
-					kiss_fftnd(STF, Buffer[ChannelIndex], Output[ChannelIndex]);
-				}
-			}
+	HarmonicPercussive.SetBudgetSeconds(CVarWACHarmonicPercussiveBudgetMs.GetValueOnAnyThread() / 1000.0);
+	HarmonicPercussive.Process(Frame.Magnitudes.GetData(), Frame.Magnitudes.Num(), SampleRate, Frame.HarmonicPercussive);
 
-			OutFrequencies.AddZeroed(SamplesToRead);
+	const FAudioHarmonicPercussiveStats& separatorStats = HarmonicPercussive.GetStats();
 
-			for (int32 SampleIndex = 0; SampleIndex < SamplesToRead; ++SampleIndex) {
+	FScopeLock lock(&AnalysisStatsLock);
+	AnalysisStats.AnalyzedHarmonicPercussiveFrames = separatorStats.ProcessedFrames;
+	AnalysisStats.TotalHarmonicPercussiveSeconds = separatorStats.TotalSeconds;
+	AnalysisStats.HarmonicPercussiveOverBudgetFrames = separatorStats.OverBudgetFrames;
+	AnalysisStats.HarmonicPercussiveDecimation = separatorStats.Decimation;
+}
 
-				double ChannelSum = 0.0f;
+void FAudioCaptureWorker::AnalyzeBands(FAudioSpectrumFrame& Frame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WAC_AnalyzeBands);
+	const double analysisStart = FPlatformTime::Seconds();
 
-				for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex) {
-					if (Output[ChannelIndex]) {
-						// With this we get the actual Frequency value for the frequencies from 0hz to ~22000hz
-						ChannelSum += FMath::Sqrt(FMath::Square(Output[ChannelIndex][SampleIndex].r) + FMath::Square(Output[ChannelIndex][SampleIndex].i));
-					}
-				}
+	BandAnalyzer.Analyze(Frame.BandMagnitudes);
+	OnsetDetector.Process(Frame.BandMagnitudes.GetData(), Frame.BandMagnitudes.Num(), Frame.Onsets);
 
-				OutFrequencies[SampleIndex] = FMath::Pow((FMath::LogX(FreqLogBase, ChannelSum / NumChannels) * FreqMultiplier), FreqPower) + FreqOffset;
-			}
+	FScopeLock lock(&AnalysisStatsLock);
+	AnalysisStats.AnalyzedBandFrames++;
+	AnalysisStats.TotalBandAnalysisSeconds += FPlatformTime::Seconds() - analysisStart;
+}
 
-			// Make sure to free up the FFT stuff
-			KISS_FFT_FREE(STF);
+void FAudioCaptureWorker::GatherTargetFrequencies(TArray<int32>& OutFrequencies)
+{
+	const double now = FPlatformTime::Seconds();
 
-			for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex) {
-				KISS_FFT_FREE(Buffer[ChannelIndex]);
-				KISS_FFT_FREE(Output[ChannelIndex]);
-			}
+	FScopeLock lock(&TargetLock);
+
+	for (auto It = TargetRequests.CreateIterator(); It; ++It) {
+		if (now - It.Value() >= SpectrumDemandTimeout) {
+			It.RemoveCurrent();
+		} else {
+			OutFrequencies.Add(It.Key());
 		}
-		else {
-			GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("InSoundVisData.PCMData is a nullptr!")));
+	}
+
+	OutFrequencies.Sort();
+}
+
+void FAudioCaptureWorker::NormalizeFrame(FAudioSpectrumFrame& Frame)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WAC_NormalizeFrame);
+
+	FAudioAdaptiveNormalizerSettings settings;
+	settings.FloorQuantile = CVarWACNormalizeFloorQuantile.GetValueOnAnyThread();
+	settings.CeilingQuantile = CVarWACNormalizeCeilingQuantile.GetValueOnAnyThread();
+	settings.AdaptFrames = CVarWACNormalizeAdaptFrames.GetValueOnAnyThread();
+
+	auto normalize = [&settings, &Frame](FAudioAdaptiveNormalizer& normalizer, const TArray<float>& in, TArray<float>& out) {
+		// Only a change of the console variables starts the estimates over
+		normalizer.Configure(settings);
+
+		// An empty array is a stage that did not run, not a new layout: keep the estimates for when it does
+		if (in.Num() == 0) {
+			return;
 		}
+
+		out.SetNumUninitialized(in.Num());
+		normalizer.Process(in.GetData(), out.GetData(), in.Num(), !Frame.bSilent);
+	};
+
+	normalize(SpectrumNormalizer, Frame.Magnitudes, Frame.NormalizedMagnitudes);
+	normalize(BandNormalizer, Frame.BandMagnitudes, Frame.NormalizedBandMagnitudes);
+}
+
+void FAudioCaptureWorker::PublishFrame(TSharedPtr<FAudioSpectrumFrame, ESPMode::ThreadSafe> Frame, bool bDiscontinuity)
+{
+	// Every path of the analysis ends here, silent frames included
+	if (IsNormalizedRequested()) {
+		NormalizeFrame(*Frame);
 	}
-	else {
-		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, FString::Printf(TEXT("Number of Channels is < 0!")));
+
+	Frame->bDiscontinuity = bDiscontinuity;
+	Frame->Timestamp = FPlatformTime::Seconds();
+	Frame->FrameIndex = NextFrameIndex++;
+
+	if (bDiscontinuity) {
+		DiscontinuityCounter.Increment();
+	}
+
+	{
+		FScopeLock lock(&FrameLock);
+		LatestFrame = Frame;
+	}
+
+	m_recorder.RecordFrame(Frame);
+
+	if (m_sharedSpectrum.IsOpen()) {
+		m_sharedSpectrum.Publish(*Frame, Frame->SampleRate);
 	}
+
+	FrameNotifier.OnFramePublished(Frame);
+}
+
+FAudioAnalysisStats FAudioCaptureWorker::GetAnalysisStats() const
+{
+	FScopeLock lock(&AnalysisStatsLock);
+
+	FAudioAnalysisStats stats = AnalysisStats;
+	stats.NoiseFloorDb = m_sink.GetNoiseFloorDb();
+	stats.LostPackets = LostSinkPackets.load(std::memory_order_relaxed);
+	return stats;
+}
+
+FAudioSpectrumFramePtr FAudioCaptureWorker::GetLatestFrame() const
+{
+	FScopeLock lock(&FrameLock);
+	return LatestFrame;
+}
+
+uint64 FAudioCaptureWorker::GetLatestFrameIndex() const
+{
+	FScopeLock lock(&FrameLock);
+	return LatestFrame.IsValid() ? LatestFrame->FrameIndex : 0;
+}
+
+FAudioLevelMetrics FAudioCaptureWorker::GetLatestLevels() const
+{
+	FScopeLock lock(&FrameLock);
+	return LatestFrame.IsValid() ? LatestFrame->Levels : FAudioLevelMetrics();
+}
+
+void FAudioCaptureWorker::RequestSpectrum()
+{
+	LastSpectrumRequestSeconds = FPlatformTime::Seconds();
+}
+
+bool FAudioCaptureWorker::IsSpectrumRequested() const
+{
+	// Readers of the shared ring cannot make requests, so publishing counts as one
+	return m_sharedSpectrum.IsOpen() || FrameNotifier.HasWaiters(EAudioFrameWaitKind::Spectrum)
+		|| FPlatformTime::Seconds() - LastSpectrumRequestSeconds < SpectrumDemandTimeout;
+}
+
+bool FAudioCaptureWorker::IsBandSpectrumRequested() const
+{
+	return m_sharedSpectrum.IsOpen() || FrameNotifier.HasWaiters(EAudioFrameWaitKind::Onset)
+		|| FPlatformTime::Seconds() - LastBandRequestSeconds < SpectrumDemandTimeout;
+}
+
+TFuture<FAudioSpectrumFramePtr> FAudioCaptureWorker::WaitForNextSpectrum()
+{
+	RequestSpectrum();
+	return FrameNotifier.Wait(EAudioFrameWaitKind::Spectrum, INDEX_NONE, GetLatestFrame());
+}
+
+void FAudioCaptureWorker::WaitForNextSpectrum(FAudioFrameCallback Callback)
+{
+	RequestSpectrum();
+	FrameNotifier.Wait(EAudioFrameWaitKind::Spectrum, INDEX_NONE, GetLatestFrame(), MoveTemp(Callback));
+}
+
+TFuture<FAudioSpectrumFramePtr> FAudioCaptureWorker::WaitForOnset(int32 Band)
+{
+	LastBandRequestSeconds = FPlatformTime::Seconds();
+	return FrameNotifier.Wait(EAudioFrameWaitKind::Onset, Band, GetLatestFrame());
+}
+
+void FAudioCaptureWorker::WaitForOnset(int32 Band, FAudioFrameCallback Callback)
+{
+	LastBandRequestSeconds = FPlatformTime::Seconds();
+	FrameNotifier.Wait(EAudioFrameWaitKind::Onset, Band, GetLatestFrame(), MoveTemp(Callback));
+}
+
+TArray<float> FAudioCaptureWorker::GetBandSpectrum(const FAudioSpectrumScalingProfile& Profile)
+{
+	LastBandRequestSeconds = FPlatformTime::Seconds();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid() || frame->BandMagnitudes.Num() == 0) {
+		return TArray<float>();
+	}
+
+	TArray<float> values;
+	values.SetNumZeroed(frame->BandMagnitudes.Num());
+
+	if (!frame->bSilent) {
+		FScopeLock lock(&ScalingCacheLock);
+		FindOrAddScalingEntry(Profile, frame->FrameIndex).Table->Apply(frame->BandMagnitudes.GetData(), values.GetData(), values.Num());
+	}
+
+	return values;
+}
+
+FAudioBandOnsets FAudioCaptureWorker::GetBandOnsets(const FAudioSpectrumScalingProfile& Profile)
+{
+	LastBandRequestSeconds = FPlatformTime::Seconds();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid()) {
+		return FAudioBandOnsets();
+	}
+
+	FAudioBandOnsets onsets = frame->Onsets;
+
+	if (onsets.bValid && !frame->bSilent) {
+		FScopeLock lock(&ScalingCacheLock);
+		FindOrAddScalingEntry(Profile, frame->FrameIndex).Table->Apply(onsets.Energy, onsets.Energy, FAudioBandOnsets::NumBands);
+	}
+
+	return onsets;
+}
+
+bool FAudioCaptureWorker::IsNormalizedRequested() const
+{
+	return FPlatformTime::Seconds() - LastNormalizedRequestSeconds < SpectrumDemandTimeout;
+}
+
+TArray<float> FAudioCaptureWorker::GetNormalizedSpectrum()
+{
+	RequestSpectrum();
+	LastNormalizedRequestSeconds = FPlatformTime::Seconds();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+	return frame.IsValid() ? frame->NormalizedMagnitudes : TArray<float>();
+}
+
+TArray<float> FAudioCaptureWorker::GetNormalizedBandSpectrum()
+{
+	LastBandRequestSeconds = FPlatformTime::Seconds();
+	LastNormalizedRequestSeconds = LastBandRequestSeconds.load();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+	return frame.IsValid() ? frame->NormalizedBandMagnitudes : TArray<float>();
+}
+
+bool FAudioCaptureWorker::IsMusicFeaturesRequested() const
+{
+	return FPlatformTime::Seconds() - LastMusicRequestSeconds < SpectrumDemandTimeout;
+}
+
+FAudioMusicFeatures FAudioCaptureWorker::GetMusicFeatures()
+{
+	LastMusicRequestSeconds = FPlatformTime::Seconds();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+	return frame.IsValid() ? frame->Music : FAudioMusicFeatures();
+}
+
+bool FAudioCaptureWorker::IsHarmonicPercussiveRequested() const
+{
+	return FPlatformTime::Seconds() - LastHarmonicPercussiveRequestSeconds < SpectrumDemandTimeout;
+}
+
+FAudioHarmonicPercussiveBands FAudioCaptureWorker::GetHarmonicPercussive(const FAudioSpectrumScalingProfile& Profile)
+{
+	LastHarmonicPercussiveRequestSeconds = FPlatformTime::Seconds();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid()) {
+		return FAudioHarmonicPercussiveBands();
+	}
+
+	FAudioHarmonicPercussiveBands bands = frame->HarmonicPercussive;
+
+	if (bands.bValid && !frame->bSilent) {
+		FScopeLock lock(&ScalingCacheLock);
+		const FAudioSpectrumScalingTable& table = *FindOrAddScalingEntry(Profile, frame->FrameIndex).Table;
+		table.Apply(bands.Harmonic, bands.Harmonic, FAudioHarmonicPercussiveBands::NumBands);
+		table.Apply(bands.Percussive, bands.Percussive, FAudioHarmonicPercussiveBands::NumBands);
+	}
+
+	return bands;
+}
+
+bool FAudioCaptureWorker::GetRequestedConstantQ(FAudioConstantQSettings& OutSettings) const
+{
+	FScopeLock lock(&ConstantQLock);
+
+	OutSettings = RequestedConstantQSettings;
+	return FPlatformTime::Seconds() - LastConstantQRequestSeconds < SpectrumDemandTimeout;
+}
+
+TArray<float> FAudioCaptureWorker::GetConstantQSpectrum(const FAudioConstantQSettings& Settings, const FAudioSpectrumScalingProfile& Profile)
+{
+	{
+		FScopeLock lock(&ConstantQLock);
+		RequestedConstantQSettings = Settings;
+		LastConstantQRequestSeconds = FPlatformTime::Seconds();
+	}
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid() || frame->ConstantQMagnitudes.Num() == 0 || frame->ConstantQSettings != Settings) {
+		return TArray<float>();
+	}
+
+	TArray<float> values;
+	values.SetNumZeroed(frame->ConstantQMagnitudes.Num());
+
+	if (!frame->bSilent) {
+		FScopeLock lock(&ScalingCacheLock);
+		FindOrAddScalingEntry(Profile, frame->FrameIndex).Table->Apply(frame->ConstantQMagnitudes.GetData(), values.GetData(), values.Num());
+	}
+
+	return values;
+}
+
+TArray<float> FAudioCaptureWorker::GetChannelSpectrum(int32 Channel, const FAudioSpectrumScalingProfile& Profile)
+{
+	RequestSpectrum();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid() || Channel < 0 || Channel >= frame->Channels.NumChannels) {
+		return TArray<float>();
+	}
+
+	TArray<float> values;
+	values.SetNumZeroed(frame->Channels.NumBins);
+
+	if (!frame->bSilent) {
+		FScopeLock lock(&ScalingCacheLock);
+		FindOrAddScalingEntry(Profile, frame->FrameIndex).Table->Apply(frame->Channels.GetChannel(Channel), values.GetData(), values.Num());
+	}
+
+	return values;
+}
+
+bool FAudioCaptureWorker::IsWaveformRequested() const
+{
+	return FPlatformTime::Seconds() - LastWaveformRequestSeconds < SpectrumDemandTimeout;
+}
+
+void FAudioCaptureWorker::GetWaveformEnvelope(float WindowSeconds, int32 NumPoints, TArray<float>& OutMin, TArray<float>& OutMax, TArray<float>& OutRms)
+{
+	LastWaveformRequestSeconds = FPlatformTime::Seconds();
+
+	NumPoints = FMath::Max(NumPoints, 0);
+	OutMin.SetNumUninitialized(NumPoints);
+	OutMax.SetNumUninitialized(NumPoints);
+	OutRms.SetNumUninitialized(NumPoints);
+
+	FScopeLock lock(&WaveformLock);
+
+	const int32 numSamples = FMath::Clamp((int32)(WindowSeconds * Waveform.GetSampleRate()), 1, Waveform.GetCapacity());
+	Waveform.GetEnvelope(numSamples, NumPoints, OutMin.GetData(), OutMax.GetData(), OutRms.GetData());
+}
+
+TArray<float> FAudioCaptureWorker::GetBandFrequencies() const
+{
+	TArray<float> frequencies;
+	frequencies.SetNumUninitialized(BandSettings.NumBands);
+
+	for (int32 i = 0; i < BandSettings.NumBands; i++) {
+		frequencies[i] = BandSettings.GetBandFrequency(i);
+	}
+
+	return frequencies;
+}
+
+TArray<float> FAudioCaptureWorker::GetTargetFrequencyValues(const TArray<int32>& Frequencies, const FAudioSpectrumScalingProfile& Profile)
+{
+	{
+		const double now = FPlatformTime::Seconds();
+
+		FScopeLock lock(&TargetLock);
+		for (int32 frequency : Frequencies) {
+			TargetRequests.Add(frequency, now);
+		}
+	}
+
+	TArray<float> values;
+	values.SetNumZeroed(Frequencies.Num());
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid() || frame->bSilent) {
+		return values;
+	}
+
+	FScopeLock lock(&ScalingCacheLock);
+	const FAudioSpectrumScalingTable& table = *FindOrAddScalingEntry(Profile, frame->FrameIndex).Table;
+
+	for (int32 i = 0; i < Frequencies.Num(); i++) {
+		float magnitude;
+
+		const int32 targetIndex = frame->TargetFrequencies.Find(Frequencies[i]);
+		if (targetIndex != INDEX_NONE) {
+			magnitude = frame->TargetMagnitudes[targetIndex];
+		} else if (frame->bHasSpectrum) {
+			// Same bin lookup as UWindowsAudioCaptureComponent::BP_GetSpecificFrequencyValue
+			const int32 bin = (int32)(Frequencies[i] * frame->Magnitudes.Num() * 2 / FMath::Max(frame->SampleRate, 1));
+			if (bin < 0 || bin >= frame->Magnitudes.Num()) {
+				continue;
+			}
+			magnitude = frame->Magnitudes[bin];
+		} else {
+			// Registered after this frame was analysed, picked up with the next one
+			continue;
+		}
+
+		values[i] = table.Evaluate(magnitude);
+	}
+
+	return values;
+}
+
+TArray<float> FAudioCaptureWorker::GetFrequencyArray(float FreqLogBase, float FreqMultiplier, float FreqPower, float FreqOffset)
+{
+	return GetScaledSpectrum(FAudioSpectrumScalingProfile(FreqLogBase, FreqMultiplier, FreqPower, FreqOffset));
+}
+
+TArray<float> FAudioCaptureWorker::GetScaledSpectrum(const FAudioSpectrumScalingProfile& Profile)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("FAudioCaptureWorker::GetScaledSpectrum"));
+	RequestSpectrum();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid() || !frame->bHasSpectrum) {
+		return TArray<float>();
+	}
+
+	FScopeLock lock(&ScalingCacheLock);
+
+	FScaledSpectrumCacheEntry& entry = FindOrAddScalingEntry(Profile, frame->FrameIndex);
+	UpdateScaledValues(entry, *frame);
+
+	return entry.Values;
+}
+
+FAudioCompactSpectrumPtr FAudioCaptureWorker::GetCompactSpectrum(const FAudioSpectrumScalingProfile& Profile, EAudioCompactPrecision Precision)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("FAudioCaptureWorker::GetCompactSpectrum"));
+	RequestSpectrum();
+
+	FAudioSpectrumFramePtr frame = GetLatestFrame();
+
+	if (!frame.IsValid() || !frame->bHasSpectrum) {
+		return nullptr;
+	}
+
+	FScopeLock lock(&ScalingCacheLock);
+
+	FScaledSpectrumCacheEntry& entry = FindOrAddScalingEntry(Profile, frame->FrameIndex);
+	UpdateScaledValues(entry, *frame);
+
+	FAudioCompactSpectrumPtr& compact = entry.Compact[Precision == EAudioCompactPrecision::Bits8 ? 0 : 1];
+
+	// Published spectra are never modified, consumers may keep them as history
+	if (!compact.IsValid() || compact->FrameIndex != frame->FrameIndex) {
+		TSharedPtr<FAudioCompactSpectrum, ESPMode::ThreadSafe> encoded = MakeShared<FAudioCompactSpectrum, ESPMode::ThreadSafe>();
+		encoded->Encode(entry.Values.GetData(), entry.Values.Num(), Precision);
+		encoded->FrameIndex = frame->FrameIndex;
+		compact = encoded;
+	}
+
+	return compact;
+}
+
+void FAudioCaptureWorker::UpdateScaledValues(FScaledSpectrumCacheEntry& Entry, const FAudioSpectrumFrame& Frame)
+{
+	if (Entry.FrameIndex == Frame.FrameIndex) {
+		return;
+	}
+
+	if (Frame.bSilent) {
+		Entry.Values.SetNumZeroed(Frame.Magnitudes.Num());
+	} else {
+		Entry.Values.SetNumUninitialized(Frame.Magnitudes.Num());
+		Entry.Table->Apply(Frame.Magnitudes.GetData(), Entry.Values.GetData(), Frame.Magnitudes.Num());
+	}
+	Entry.FrameIndex = Frame.FrameIndex;
+}
+
+FAudioCaptureWorker::FScaledSpectrumCacheEntry& FAudioCaptureWorker::FindOrAddScalingEntry(const FAudioSpectrumScalingProfile& Profile, uint64 FrameIndex)
+{
+	FScaledSpectrumCacheEntry* entry = ScalingCache.FindByPredicate([&Profile](const FScaledSpectrumCacheEntry& Entry) {
+		return Entry.Table->GetProfile() == Profile;
+	});
+
+	if (entry == nullptr) {
+		if (ScalingCache.Num() >= MaxCachedScalingProfiles) {
+			int32 oldest = 0;
+			for (int32 i = 1; i < ScalingCache.Num(); i++) {
+				if (ScalingCache[i].LastUseFrameIndex < ScalingCache[oldest].LastUseFrameIndex) {
+					oldest = i;
+				}
+			}
+			ScalingCache.RemoveAtSwap(oldest);
+		}
+
+		entry = &ScalingCache.AddDefaulted_GetRef();
+		entry->Table = MakeShared<FAudioSpectrumScalingTable>(Profile);
+	}
+
+	entry->LastUseFrameIndex = FrameIndex;
+	return *entry;
 }
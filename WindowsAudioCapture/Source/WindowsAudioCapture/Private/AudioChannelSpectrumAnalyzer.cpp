@@ -0,0 +1,369 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioChannelSpectrumAnalyzer.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "Async/ParallelFor.h"
+
+namespace {
+const float PanBandEdges[FAudioChannelSpectra::NumPanBands + 1] = { 20.0f, 60.0f, 150.0f, 400.0f, 1000.0f, 2500.0f, 6000.0f, 12000.0f, 20000.0f };
+
+// Frames summed in float before the stereo energies are added to the double totals
+constexpr int32 EnergyBlockSize = 256;
+
+constexpr bool IsLeft(int32 Channel, int32 NumChannels)
+{
+    return Channel == 0 || (NumChannels >= 6 && (Channel == 4 || Channel == 6));
+}
+
+constexpr bool IsRight(int32 Channel, int32 NumChannels)
+{
+    return (Channel == 1 && NumChannels >= 2) || (NumChannels >= 6 && (Channel == 5 || Channel == 7));
+}
+
+template <typename SampleType>
+struct FSampleTraits;
+
+template <>
+struct FSampleTraits<int16> {
+    static float ToFloat(int16 Sample) { return float(Sample); }
+};
+
+template <>
+struct FSampleTraits<float> {
+    static float ToFloat(float Sample) { return Sample * 32768.0f; }
+};
+
+// NumChannels > 0 is the compile-time stride, 0 is the generic kernel that uses RuntimeChannels
+template <typename SampleType, int32 NumChannels>
+void WindowChannelKernel(const void* InSamples, int32 NumFrames, int32 RuntimeChannels, int32 Channel, const float* Window, float* Out)
+{
+    const int32 Stride = NumChannels > 0 ? NumChannels : RuntimeChannels;
+    const SampleType* Samples = static_cast<const SampleType*>(InSamples) + Channel;
+
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        Out[Frame] = FSampleTraits<SampleType>::ToFloat(Samples[Frame * Stride]) * Window[Frame];
+    }
+}
+
+template <typename SampleType, int32 NumChannels>
+void StereoEnergyKernel(const void* InSamples, int32 NumFrames, int32 RuntimeChannels, double* OutEnergies)
+{
+    const int32 Stride = NumChannels > 0 ? NumChannels : RuntimeChannels;
+    const int32 NumAnalyzed = FMath::Min(Stride, FAudioChannelSpectra::MaxChannels);
+    const SampleType* Samples = static_cast<const SampleType*>(InSamples);
+
+    // Constants once the channel loop is unrolled for a fixed channel count
+    float LeftWeight[FAudioChannelSpectra::MaxChannels];
+    float RightWeight[FAudioChannelSpectra::MaxChannels];
+    for (int32 Channel = 0; Channel < FAudioChannelSpectra::MaxChannels; ++Channel) {
+        LeftWeight[Channel] = IsLeft(Channel, Stride) ? 1.0f : 0.0f;
+        RightWeight[Channel] = IsRight(Channel, Stride) ? 1.0f : 0.0f;
+    }
+
+    double Mid = 0.0;
+    double Side = 0.0;
+    double Left = 0.0;
+    double Right = 0.0;
+
+    for (int32 Start = 0; Start < NumFrames; Start += EnergyBlockSize) {
+        const int32 End = FMath::Min(Start + EnergyBlockSize, NumFrames);
+        float BlockMid = 0.0f;
+        float BlockSide = 0.0f;
+        float BlockLeft = 0.0f;
+        float BlockRight = 0.0f;
+
+        for (int32 Frame = Start; Frame < End; ++Frame) {
+            const SampleType* FrameSamples = Samples + Frame * Stride;
+            float FrameLeft = 0.0f;
+            float FrameRight = 0.0f;
+            for (int32 Channel = 0; Channel < NumAnalyzed; ++Channel) {
+                const float Sample = FSampleTraits<SampleType>::ToFloat(FrameSamples[Channel]);
+                FrameLeft += Sample * LeftWeight[Channel];
+                FrameRight += Sample * RightWeight[Channel];
+            }
+
+            const float FrameMid = 0.5f * (FrameLeft + FrameRight);
+            const float FrameSide = 0.5f * (FrameLeft - FrameRight);
+            BlockMid += FrameMid * FrameMid;
+            BlockSide += FrameSide * FrameSide;
+            BlockLeft += FrameLeft * FrameLeft;
+            BlockRight += FrameRight * FrameRight;
+        }
+
+        Mid += BlockMid;
+        Side += BlockSide;
+        Left += BlockLeft;
+        Right += BlockRight;
+    }
+
+    OutEnergies[0] = Mid;
+    OutEnergies[1] = Side;
+    OutEnergies[2] = Left;
+    OutEnergies[3] = Right;
+}
+}
+
+float FAudioChannelSpectra::GetPanBandEdge(int32 Band)
+{
+    return PanBandEdges[FMath::Clamp(Band, 0, NumPanBands)];
+}
+
+bool FAudioChannelSpectra::IsLeftChannel(int32 Channel, int32 NumChannels)
+{
+    return IsLeft(Channel, NumChannels);
+}
+
+bool FAudioChannelSpectra::IsRightChannel(int32 Channel, int32 NumChannels)
+{
+    return IsRight(Channel, NumChannels);
+}
+
+FAudioChannelSpectrumAnalyzer::FAudioChannelSpectrumAnalyzer()
+    : KernelFormat(EAudioSampleFormat::Int16)
+    , KernelChannels(0)
+    , bUseGenericKernels(false)
+    , FftSize(0)
+    , BlockSamples(nullptr)
+    , BlockFrames(0)
+    , BlockChannels(0)
+    , BlockSampleRate(0)
+{
+    Kernels = SelectKernels(KernelFormat, KernelChannels, bUseGenericKernels);
+}
+
+FAudioChannelSpectrumAnalyzer::~FAudioChannelSpectrumAnalyzer()
+{
+    Release();
+}
+
+int32 FAudioChannelSpectrumAnalyzer::GetFftSize(int32 NumFrames)
+{
+    // The original analysis padded the interleaved stereo block to a power of two
+    int32 Size = 2;
+    while (NumFrames * 2 > Size) {
+        Size *= 2;
+    }
+    return Size;
+}
+
+FAudioChannelSpectrumAnalyzer::FKernels FAudioChannelSpectrumAnalyzer::SelectKernels(EAudioSampleFormat Format, int32 NumChannels, bool bGeneric)
+{
+    // Index 0 is the generic kernel, 1 .. MaxChannels the fixed channel counts
+    static const FKernels Int16Kernels[FAudioChannelSpectra::MaxChannels + 1] = {
+        { &WindowChannelKernel<int16, 0>, &StereoEnergyKernel<int16, 0> },
+        { &WindowChannelKernel<int16, 1>, &StereoEnergyKernel<int16, 1> },
+        { &WindowChannelKernel<int16, 2>, &StereoEnergyKernel<int16, 2> },
+        { &WindowChannelKernel<int16, 3>, &StereoEnergyKernel<int16, 3> },
+        { &WindowChannelKernel<int16, 4>, &StereoEnergyKernel<int16, 4> },
+        { &WindowChannelKernel<int16, 5>, &StereoEnergyKernel<int16, 5> },
+        { &WindowChannelKernel<int16, 6>, &StereoEnergyKernel<int16, 6> },
+        { &WindowChannelKernel<int16, 7>, &StereoEnergyKernel<int16, 7> },
+        { &WindowChannelKernel<int16, 8>, &StereoEnergyKernel<int16, 8> },
+    };
+    static const FKernels FloatKernels[FAudioChannelSpectra::MaxChannels + 1] = {
+        { &WindowChannelKernel<float, 0>, &StereoEnergyKernel<float, 0> },
+        { &WindowChannelKernel<float, 1>, &StereoEnergyKernel<float, 1> },
+        { &WindowChannelKernel<float, 2>, &StereoEnergyKernel<float, 2> },
+        { &WindowChannelKernel<float, 3>, &StereoEnergyKernel<float, 3> },
+        { &WindowChannelKernel<float, 4>, &StereoEnergyKernel<float, 4> },
+        { &WindowChannelKernel<float, 5>, &StereoEnergyKernel<float, 5> },
+        { &WindowChannelKernel<float, 6>, &StereoEnergyKernel<float, 6> },
+        { &WindowChannelKernel<float, 7>, &StereoEnergyKernel<float, 7> },
+        { &WindowChannelKernel<float, 8>, &StereoEnergyKernel<float, 8> },
+    };
+
+    const int32 Index = !bGeneric && NumChannels >= 1 && NumChannels <= FAudioChannelSpectra::MaxChannels ? NumChannels : 0;
+    return Format == EAudioSampleFormat::Float ? FloatKernels[Index] : Int16Kernels[Index];
+}
+
+void FAudioChannelSpectrumAnalyzer::SetUseGenericKernels(bool bInUseGenericKernels)
+{
+    bUseGenericKernels = bInUseGenericKernels;
+    Kernels = SelectKernels(KernelFormat, KernelChannels, bUseGenericKernels);
+}
+
+void FAudioChannelSpectrumAnalyzer::Release()
+{
+    for (FChannelScratch& Channel : Scratch) {
+        if (Channel.Config != nullptr) {
+            FWindowsAudioCaptureMemory::FreeFftr(Channel.Config);
+            Channel.Config = nullptr;
+        }
+    }
+    Scratch.Reset();
+}
+
+void FAudioChannelSpectrumAnalyzer::Prepare(int32 InFftSize, int32 NumChannels)
+{
+    if (InFftSize != FftSize) {
+        Release();
+        FftSize = InFftSize;
+
+        Window.SetNumUninitialized(FftSize);
+        for (int32 Index = 0; Index < FftSize; ++Index) {
+            Window[Index] = 0.5f * (1.0f - FMath::Cos(2.0f * PI * Index / (FftSize - 1)));
+        }
+    }
+
+    while (Scratch.Num() < NumChannels) {
+        FChannelScratch& Channel = Scratch.AddDefaulted_GetRef();
+        Channel.Config = FWindowsAudioCaptureMemory::AllocFftr(FftSize, false);
+        Channel.Input.SetNumZeroed(FftSize);
+        Channel.Output.SetNumUninitialized(FftSize / 2 + 1);
+    }
+}
+
+void FAudioChannelSpectrumAnalyzer::Analyze(const int16* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage)
+{
+    AnalyzeInterleaved(Samples, EAudioSampleFormat::Int16, NumFrames, NumChannels, SampleRate, OutSpectra, OutAverage);
+}
+
+void FAudioChannelSpectrumAnalyzer::Analyze(const float* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage)
+{
+    AnalyzeInterleaved(Samples, EAudioSampleFormat::Float, NumFrames, NumChannels, SampleRate, OutSpectra, OutAverage);
+}
+
+int32 FAudioChannelSpectrumAnalyzer::BeginBlock(const int16* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra)
+{
+    return BeginInterleaved(Samples, EAudioSampleFormat::Int16, NumFrames, NumChannels, SampleRate, OutSpectra);
+}
+
+void FAudioChannelSpectrumAnalyzer::AnalyzeInterleaved(const void* Samples, EAudioSampleFormat Format, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage)
+{
+    OutAverage.Reset();
+
+    const int32 NumAnalyzed = BeginInterleaved(Samples, Format, NumFrames, NumChannels, SampleRate, OutSpectra);
+    if (NumAnalyzed == 0) {
+        return;
+    }
+
+    // A stereo FFT is too short to be worth the task overhead
+    ParallelFor(NumAnalyzed, [&](int32 Channel) {
+        AnalyzeBlockChannel(Channel, OutSpectra);
+    }, NumAnalyzed <= 2);
+
+    EndBlock(OutSpectra, OutAverage);
+}
+
+int32 FAudioChannelSpectrumAnalyzer::BeginInterleaved(const void* Samples, EAudioSampleFormat Format, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra)
+{
+    BlockSamples = nullptr;
+
+    if (Samples == nullptr || NumFrames <= 0 || NumChannels <= 0) {
+        OutSpectra = FAudioChannelSpectra();
+        return 0;
+    }
+
+    // Picked once per stream format, never per block
+    if (Format != KernelFormat || NumChannels != KernelChannels) {
+        KernelFormat = Format;
+        KernelChannels = NumChannels;
+        Kernels = SelectKernels(KernelFormat, KernelChannels, bUseGenericKernels);
+    }
+
+    const int32 NumAnalyzed = FMath::Min(NumChannels, FAudioChannelSpectra::MaxChannels);
+    Prepare(GetFftSize(NumFrames), NumAnalyzed);
+
+    // Bins 1 .. N/2-1, DC and Nyquist are dropped
+    OutSpectra.NumChannels = NumAnalyzed;
+    OutSpectra.NumBins = FftSize / 2 - 1;
+    OutSpectra.Magnitudes.SetNumUninitialized(NumAnalyzed * OutSpectra.NumBins, false);
+
+    BlockSamples = Samples;
+    BlockFrames = NumFrames;
+    BlockChannels = NumChannels;
+    BlockSampleRate = SampleRate;
+    return NumAnalyzed;
+}
+
+void FAudioChannelSpectrumAnalyzer::AnalyzeBlockChannel(int32 Channel, FAudioChannelSpectra& OutSpectra)
+{
+    check(BlockSamples != nullptr && Channel >= 0 && Channel < OutSpectra.NumChannels);
+    AnalyzeChannel(Channel, BlockSamples, BlockFrames, BlockChannels, OutSpectra);
+}
+
+void FAudioChannelSpectrumAnalyzer::EndBlock(FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage)
+{
+    check(BlockSamples != nullptr);
+
+    OutAverage.SetNumZeroed(OutSpectra.NumBins);
+    const float ChannelScale = 1.0f / OutSpectra.NumChannels;
+    for (int32 Channel = 0; Channel < OutSpectra.NumChannels; ++Channel) {
+        const float* Magnitudes = OutSpectra.GetChannel(Channel);
+        for (int32 Bin = 0; Bin < OutSpectra.NumBins; ++Bin) {
+            OutAverage[Bin] += Magnitudes[Bin] * ChannelScale;
+        }
+    }
+
+    ComputeStereoImage(BlockSamples, BlockFrames, BlockChannels, BlockSampleRate, OutSpectra);
+    BlockSamples = nullptr;
+}
+
+void FAudioChannelSpectrumAnalyzer::AnalyzeChannel(int32 Channel, const void* Samples, int32 NumFrames, int32 NumChannels, FAudioChannelSpectra& OutSpectra)
+{
+    FChannelScratch& Work = Scratch[Channel];
+
+    float* Input = Work.Input.GetData();
+    Kernels.WindowChannel(Samples, NumFrames, NumChannels, Channel, Window.GetData(), Input);
+    FMemory::Memzero(Input + NumFrames, (FftSize - NumFrames) * sizeof(float));
+
+    kiss_fftr(Work.Config, Input, Work.Output.GetData());
+
+    float* Out = OutSpectra.Magnitudes.GetData() + Channel * OutSpectra.NumBins;
+    for (int32 Bin = 0; Bin < OutSpectra.NumBins; ++Bin) {
+        const kiss_fft_cpx& Value = Work.Output[Bin + 1];
+        Out[Bin] = FMath::Sqrt(Value.r * Value.r + Value.i * Value.i);
+    }
+}
+
+void FAudioChannelSpectrumAnalyzer::ComputeStereoImage(const void* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra) const
+{
+    OutSpectra.StereoWidth = 0.0f;
+    OutSpectra.Balance = 0.0f;
+    FMemory::Memzero(OutSpectra.BandPan, sizeof(OutSpectra.BandPan));
+
+    if (NumChannels < 2) {
+        return;
+    }
+
+    // Mid/side energy of the summed left and right groups, in the time domain so phase counts
+    double Energies[4];
+    Kernels.StereoEnergy(Samples, NumFrames, NumChannels, Energies);
+
+    const double MidEnergy = Energies[0];
+    const double SideEnergy = Energies[1];
+    const double LeftEnergy = Energies[2];
+    const double RightEnergy = Energies[3];
+
+    if (MidEnergy + SideEnergy > 0.0) {
+        OutSpectra.StereoWidth = float(SideEnergy / (MidEnergy + SideEnergy));
+    }
+    if (LeftEnergy + RightEnergy > 0.0) {
+        OutSpectra.Balance = float((RightEnergy - LeftEnergy) / (RightEnergy + LeftEnergy));
+    }
+
+    // Per band pan from the spectra, bin b (0-based) sits at (b + 1) * SampleRate / FftSize
+    const float BinWidth = float(FMath::Max(SampleRate, 1)) / FftSize;
+    for (int32 Band = 0; Band < FAudioChannelSpectra::NumPanBands; ++Band) {
+        const int32 FirstBin = FMath::Clamp(FMath::CeilToInt(FAudioChannelSpectra::GetPanBandEdge(Band) / BinWidth) - 1, 0, OutSpectra.NumBins);
+        const int32 EndBin = FMath::Clamp(FMath::CeilToInt(FAudioChannelSpectra::GetPanBandEdge(Band + 1) / BinWidth) - 1, 0, OutSpectra.NumBins);
+
+        double Left = 0.0;
+        double Right = 0.0;
+        for (int32 Channel = 0; Channel < OutSpectra.NumChannels; ++Channel) {
+            const bool bLeft = FAudioChannelSpectra::IsLeftChannel(Channel, NumChannels);
+            const bool bRight = FAudioChannelSpectra::IsRightChannel(Channel, NumChannels);
+            if (!bLeft && !bRight) {
+                continue;
+            }
+
+            const float* Magnitudes = OutSpectra.GetChannel(Channel);
+            double Energy = 0.0;
+            for (int32 Bin = FirstBin; Bin < EndBin; ++Bin) {
+                Energy += Magnitudes[Bin] * Magnitudes[Bin];
+            }
+            (bLeft ? Left : Right) += Energy;
+        }
+
+        OutSpectra.BandPan[Band] = Left + Right > 0.0 ? float((Right - Left) / (Right + Left)) : 0.0f;
+    }
+}
@@ -0,0 +1,167 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioCompactSpectrum.h"
+#include "AudioVectorMath.h"
+
+namespace {
+constexpr float OctavesPerDb = 0.166096404f; // 1 / (20 * log10(2))
+
+// Bins are processed in blocks so the temporaries stay in registers and the loops vectorize
+constexpr int32 BlockSize = 64;
+
+float BitsToFloat(uint32 Bits)
+{
+    float Value;
+    FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+    return Value;
+}
+
+uint32 FloatToBits(float Value)
+{
+    uint32 Bits;
+    FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+    return Bits;
+}
+
+// log2(Value) within 5e-8. Zero and denormals read as about -127, below any range.
+float FastLog2(float Value)
+{
+    const uint32 Bits = FloatToBits(Value);
+    const uint32 MantissaBits = Bits & 0x007FFFFF;
+
+    // Centre the mantissa on [sqrt(1/2), sqrt(2)) so the series converges fast
+    const uint32 Upper = MantissaBits > 0x003504F3 ? 1 : 0;
+    const int32 Exponent = int32(Bits >> 23) - 127 + int32(Upper);
+    const float Mantissa = BitsToFloat(MantissaBits | ((127 - Upper) << 23));
+
+    // log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1)), |t| <= 0.172
+    const float T = (Mantissa - 1.0f) / (Mantissa + 1.0f);
+    const float T2 = T * T;
+    const float Series = T * (2.88539008f + T2 * (0.961796694f + T2 * (0.577078016f + T2 * 0.412198583f)));
+
+    return float(Exponent) + Series;
+}
+
+// 2^Value within 2e-7 for Value in [-64, 64)
+float FastExp2(float Value)
+{
+    // Round to the nearest integer through a positive offset, the fraction is in [-0.5, 0.5]
+    const int32 Whole = int32(Value + 64.5f) - 64;
+    const float Fraction = Value - float(Whole);
+
+    const float Poly = 1.0f + Fraction * (0.693147181f + Fraction * (0.240226507f + Fraction * (0.0555041087f
+        + Fraction * (0.00961812911f + Fraction * (0.00133335581f + Fraction * 0.000154035304f)))));
+
+    return Poly * BitsToFloat(uint32(Whole + 127) << 23);
+}
+
+template <typename CodeType>
+void EncodeCodes(const float* Values, int32 Num, float LogScale, float MaxCode, float InvStep, CodeType* OutCodes)
+{
+    // Code = MaxCode + (log2(v) - log2(Scale)) / Step, rounded. Anything that rounds below 1 is silence.
+    const float Offset = MaxCode - LogScale * InvStep + 0.5f;
+
+    float Block[BlockSize];
+    for (int32 Start = 0; Start < Num; Start += BlockSize) {
+        const int32 Count = FMath::Min(BlockSize, Num - Start);
+
+        for (int32 Index = 0; Index < Count; ++Index) {
+            const float Code = FastLog2(Values[Start + Index]) * InvStep + Offset;
+            Block[Index] = Code < 0.0f ? 0.0f : (Code > MaxCode ? MaxCode : Code);
+        }
+
+        for (int32 Index = 0; Index < Count; ++Index) {
+            OutCodes[Start + Index] = (CodeType)(int32)Block[Index];
+        }
+    }
+}
+
+template <typename CodeType>
+void DecodeCodes(const CodeType* Codes, int32 Num, float Scale, float MaxCode, float Step, float* Out)
+{
+    for (int32 Index = 0; Index < Num; ++Index) {
+        // Code 0 is silence: multiply by 0 rather than branch
+        const float Audible = float(Codes[Index] != 0);
+        Out[Index] = Scale * FastExp2((float(Codes[Index]) - MaxCode) * Step) * Audible;
+    }
+}
+
+// 8 bit codes at the default range are decoded through a table, the common case for fan-out
+struct FDefaultDecodeTable8 {
+    float Table[256];
+
+    FDefaultDecodeTable8()
+    {
+        const float Step = FAudioCompactSpectrum::DefaultRangeDb8 * OctavesPerDb / 254.0f;
+        Table[0] = 0.0f;
+        for (int32 Code = 1; Code < 256; ++Code) {
+            Table[Code] = FMath::Pow(2.0f, (Code - 255) * Step);
+        }
+    }
+};
+}
+
+float FAudioCompactSpectrum::GetMaxRelativeError(EAudioCompactPrecision InPrecision, float InRangeDb)
+{
+    const float Step = InRangeDb * OctavesPerDb / float(GetMaxCode(InPrecision) - 1);
+    // Plus the error of FastLog2 / FastExp2 and of the float arithmetic around them
+    return FMath::Pow(2.0f, Step * 0.5f) - 1.0f + 1e-5f;
+}
+
+void FAudioCompactSpectrum::Encode(const float* Values, int32 Num, EAudioCompactPrecision InPrecision, float InRangeDb)
+{
+    Precision = InPrecision;
+    NumBins = Num;
+    // The bottom of the range has to stay well inside FastExp2
+    RangeDb = InRangeDb > 0.0f ? FMath::Clamp(InRangeDb, 6.0f, 240.0f) : GetDefaultRangeDb(InPrecision);
+    Codes.SetNumUninitialized(Num * GetBytesPerBin(InPrecision), false);
+
+    float SumOfSquares;
+    FAudioVectorMath::SumOfSquaresAndPeak(Values, Num, SumOfSquares, Scale);
+
+    if (!(Scale > 0.0f)) {
+        Scale = 0.0f;
+        FMemory::Memzero(Codes.GetData(), Codes.Num());
+        return;
+    }
+
+    const float MaxCode = float(GetMaxCode(InPrecision));
+    const float InvStep = (MaxCode - 1.0f) / (RangeDb * OctavesPerDb);
+    const float LogScale = FastLog2(Scale);
+
+    if (InPrecision == EAudioCompactPrecision::Bits8) {
+        EncodeCodes(Values, Num, LogScale, MaxCode, InvStep, Codes.GetData());
+    } else {
+        EncodeCodes(Values, Num, LogScale, MaxCode, InvStep, reinterpret_cast<uint16*>(Codes.GetData()));
+    }
+}
+
+void FAudioCompactSpectrum::Decode(float* Out, int32 FirstBin, int32 Num) const
+{
+    const int32 Available = FMath::Clamp(NumBins - FirstBin, 0, Num);
+
+    if (Available < Num) {
+        FMemory::Memzero(Out + Available, (Num - Available) * sizeof(float));
+    }
+
+    if (Available == 0) {
+        return;
+    }
+
+    const float MaxCode = float(GetMaxCode(Precision));
+    const float Step = RangeDb * OctavesPerDb / (MaxCode - 1.0f);
+
+    if (Precision == EAudioCompactPrecision::Bits8) {
+        const uint8* Source = GetCodes8() + FirstBin;
+
+        if (RangeDb == DefaultRangeDb8) {
+            static const FDefaultDecodeTable8 DefaultTable;
+            for (int32 Index = 0; Index < Available; ++Index) {
+                Out[Index] = DefaultTable.Table[Source[Index]] * Scale;
+            }
+        } else {
+            DecodeCodes(Source, Available, Scale, MaxCode, Step, Out);
+        }
+    } else {
+        DecodeCodes(GetCodes16() + FirstBin, Available, Scale, MaxCode, Step, Out);
+    }
+}
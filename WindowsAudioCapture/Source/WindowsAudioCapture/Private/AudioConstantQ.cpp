@@ -0,0 +1,109 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioConstantQ.h"
+#include "AudioVectorMath.h"
+
+int32 FAudioConstantQSettings::GetNumBins() const
+{
+    return FMath::FloorToInt(BinsPerOctave * FMath::Log2(MaxFrequency / MinFrequency) + 1e-3f) + 1;
+}
+
+float FAudioConstantQSettings::GetBinFrequency(int32 Bin) const
+{
+    return MinFrequency * FMath::Pow(2.0f, float(Bin) / BinsPerOctave);
+}
+
+float FAudioConstantQSettings::GetQ() const
+{
+    return 1.0f / (FMath::Pow(2.0f, 1.0f / BinsPerOctave) - 1.0f);
+}
+
+FAudioConstantQKernel::FAudioConstantQKernel(const FAudioConstantQSettings& InSettings, int32 InSampleRate, int32 InNumLinearBins)
+    : Settings(InSettings)
+    , SampleRate(InSampleRate)
+    , NumLinearBins(InNumLinearBins)
+{
+    const int32 NumBins = Settings.GetNumBins();
+    Rows.SetNum(NumBins);
+
+    if (NumLinearBins < 2 || SampleRate <= 0) {
+        return;
+    }
+
+    // Magnitudes[i] is bin i + 1 of an FFT of 2 * (NumLinearBins + 1) points
+    const float BinWidth = SampleRate / (2.0f * (NumLinearBins + 1));
+    const float Q = Settings.GetQ();
+
+    for (int32 Bin = 0; Bin < NumBins; ++Bin) {
+        FRow& Row = Rows[Bin];
+        Row.WeightOffset = Weights.Num();
+
+        const float Centre = Settings.GetBinFrequency(Bin);
+        const float Bandwidth = Centre / Q;
+
+        // Position of the centre in Magnitudes index space
+        const float Position = Centre / BinWidth - 1.0f;
+        if (Position < 0.0f || Position > NumLinearBins - 1) {
+            continue;
+        }
+
+        const int32 First = FMath::Max(FMath::CeilToInt((Centre - Bandwidth) / BinWidth - 1.0f), 0);
+        const int32 Last = FMath::Min(FMath::FloorToInt((Centre + Bandwidth) / BinWidth - 1.0f), NumLinearBins - 1);
+
+        if (Last - First + 1 >= 3) {
+            for (int32 Linear = First; Linear <= Last; ++Linear) {
+                const float Distance = ((Linear + 1) * BinWidth - Centre) / Bandwidth;
+                Weights.Add(0.5f * (1.0f + FMath::Cos(PI * FMath::Clamp(Distance, -1.0f, 1.0f))));
+            }
+            Row.FirstLinearBin = First;
+            Row.NumWeights = Last - First + 1;
+        } else {
+            // Narrower than the linear resolution
+            const int32 Below = FMath::Min(FMath::FloorToInt(Position), NumLinearBins - 2);
+            const float Alpha = Position - Below;
+            Weights.Add(1.0f - Alpha);
+            Weights.Add(Alpha);
+            Row.FirstLinearBin = Below;
+            Row.NumWeights = 2;
+        }
+    }
+}
+
+void FAudioConstantQKernel::Apply(const float* LinearMagnitudes, float* Out)
+{
+    LinearPower.SetNumUninitialized(NumLinearBins, false);
+    for (int32 Linear = 0; Linear < NumLinearBins; ++Linear) {
+        LinearPower[Linear] = LinearMagnitudes[Linear] * LinearMagnitudes[Linear];
+    }
+
+    const float* PowerData = LinearPower.GetData();
+    const float* WeightData = Weights.GetData();
+
+    for (int32 Bin = 0; Bin < Rows.Num(); ++Bin) {
+        const FRow& Row = Rows[Bin];
+        Out[Bin] = Row.NumWeights > 0
+            ? FMath::Sqrt(FAudioVectorMath::DotProduct(PowerData + Row.FirstLinearBin, WeightData + Row.WeightOffset, Row.NumWeights))
+            : 0.0f;
+    }
+}
+
+FAudioConstantQKernel& FAudioConstantQKernelCache::FindOrBuild(const FAudioConstantQSettings& Settings, int32 SampleRate, int32 NumLinearBins)
+{
+    const int32 Found = Kernels.IndexOfByPredicate([&](const TSharedPtr<FAudioConstantQKernel>& Kernel) {
+        return Kernel->GetSettings() == Settings && Kernel->GetSampleRate() == SampleRate && Kernel->GetNumLinearBins() == NumLinearBins;
+    });
+
+    TSharedPtr<FAudioConstantQKernel> Kernel;
+    if (Found != INDEX_NONE) {
+        Kernel = Kernels[Found];
+        Kernels.RemoveAt(Found);
+    } else {
+        if (Kernels.Num() >= MaxKernels) {
+            Kernels.RemoveAt(0);
+        }
+        Kernel = MakeShared<FAudioConstantQKernel>(Settings, SampleRate, NumLinearBins);
+        NumBuilt++;
+    }
+
+    Kernels.Add(Kernel);
+    return *Kernel;
+}
@@ -0,0 +1,138 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioDeviceStateMachine.h"
+#include "WindowsAudioCapture.h"
+
+FAudioDeviceStateMachine::FAudioDeviceStateMachine(IAudioCaptureDevice& InDevice, TFunction<double()> InClock, double InRetryIntervalSeconds,
+    double InMaxRetryIntervalSeconds)
+    : Device(InDevice)
+    , Clock(InClock ? MoveTemp(InClock) : TFunction<double()>([]() { return FPlatformTime::Seconds(); }))
+    , State(EAudioDeviceState::Closed)
+    , RetryIntervalSeconds(InRetryIntervalSeconds)
+    , MaxRetryIntervalSeconds(FMath::Max(InMaxRetryIntervalSeconds, InRetryIntervalSeconds))
+    , LostAtSeconds(0.0)
+    , NextRetrySeconds(0.0)
+    , bReconnecting(false)
+    , ReconnectCount(0)
+    , FailedReconnectAttempts(0)
+    , LastReconnectSeconds(0.0)
+{
+}
+
+EAudioDeviceState FAudioDeviceStateMachine::Update(bool bWantRunning, IAudioSink* Sink)
+{
+    const double NowSeconds = Clock();
+
+    // A default-device change is handled like a loss: drop the old endpoint, bind the new default
+    if (Device.ConsumeDeviceChanged() && State != EAudioDeviceState::Closed) {
+        UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioDeviceStateMachine: default render device changed, reconnecting"));
+        EnterLost(NowSeconds);
+    }
+
+    if ((State == EAudioDeviceState::Closed || State == EAudioDeviceState::Lost) && NowSeconds >= NextRetrySeconds) {
+        TryOpen(Sink, NowSeconds);
+    }
+
+    if (State == EAudioDeviceState::Stopped && bWantRunning) {
+        if (Device.Start()) {
+            FScopeLock Lock(&StatsLock);
+            State = EAudioDeviceState::Running;
+            FailedReconnectAttempts = 0;
+
+            if (bReconnecting) {
+                bReconnecting = false;
+                ReconnectCount++;
+                // Measured after Open/Start so the time spent in WASAPI is included
+                LastReconnectSeconds = Clock() - LostAtSeconds;
+                UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioDeviceStateMachine: reconnected in %.1f ms"), LastReconnectSeconds * 1000.0);
+            }
+        } else {
+            // The endpoint opens but does not stream. Back off like a failed open, or every update reopens it
+            UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioDeviceStateMachine: the render device opened but the capture did not start"));
+            EnterLost(NowSeconds);
+            ScheduleRetry(NowSeconds);
+        }
+    } else if (State == EAudioDeviceState::Running && !bWantRunning) {
+        Device.Stop();
+        FScopeLock Lock(&StatsLock);
+        State = EAudioDeviceState::Stopped;
+    }
+
+    if (State == EAudioDeviceState::Running) {
+        if (!Device.CapturePackets(Sink)) {
+            UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioDeviceStateMachine: capture failed, the render device was probably removed"));
+            EnterLost(NowSeconds);
+        }
+    }
+
+    return State;
+}
+
+bool FAudioDeviceStateMachine::TryOpen(IAudioSink* Sink, double NowSeconds)
+{
+    if (Device.Open()) {
+        FScopeLock Lock(&StatsLock);
+        State = EAudioDeviceState::Stopped;
+
+        // Whatever was captured before the gap does not line up with what comes next
+        if (bReconnecting && Sink != nullptr) {
+            Sink->MarkDiscontinuity();
+        }
+        return true;
+    }
+
+    ScheduleRetry(NowSeconds);
+    return false;
+}
+
+void FAudioDeviceStateMachine::ScheduleRetry(double NowSeconds)
+{
+    FScopeLock Lock(&StatsLock);
+    if (++FailedReconnectAttempts == 1) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioDeviceStateMachine: no usable render device to capture from, retrying in %.2f s, backing off to every %.2f s"),
+            RetryIntervalSeconds, MaxRetryIntervalSeconds);
+    }
+
+    // Doubles with every failed attempt
+    const int32 Doublings = FMath::Min(FailedReconnectAttempts - 1, 16);
+    NextRetrySeconds = NowSeconds + FMath::Min(RetryIntervalSeconds * (double)(1 << Doublings), MaxRetryIntervalSeconds);
+}
+
+void FAudioDeviceStateMachine::EnterLost(double NowSeconds)
+{
+    Device.Stop();
+    Device.Close();
+
+    FScopeLock Lock(&StatsLock);
+    if (!bReconnecting) {
+        bReconnecting = true;
+        LostAtSeconds = NowSeconds;
+    }
+    State = EAudioDeviceState::Lost;
+    // Retry right away, the new default is usually available by the time we are notified. A failed
+    // start pushes this back with ScheduleRetry
+    NextRetrySeconds = NowSeconds;
+}
+
+void FAudioDeviceStateMachine::Shutdown()
+{
+    if (State == EAudioDeviceState::Running) {
+        Device.Stop();
+    }
+    Device.Close();
+
+    FScopeLock Lock(&StatsLock);
+    State = EAudioDeviceState::Closed;
+    bReconnecting = false;
+}
+
+FAudioDeviceStats FAudioDeviceStateMachine::GetStats() const
+{
+    FScopeLock Lock(&StatsLock);
+
+    FAudioDeviceStats Stats;
+    Stats.State = State;
+    Stats.ReconnectCount = ReconnectCount;
+    Stats.FailedReconnectAttempts = FailedReconnectAttempts;
+    Stats.LastReconnectSeconds = LastReconnectSeconds;
+    return Stats;
+}
@@ -0,0 +1,340 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioFeatureFile.h"
+#include "AudioChannelSpectrumAnalyzer.h"
+#include "AudioLevelMeter.h"
+#include "Audio.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+namespace {
+// Band magnitudes are int16 units; below about -60 dBFS the log compression flattens them out so
+// noise does not produce flux
+constexpr float FluxCompression = 1.0f / 32.0f;
+}
+
+bool FAudioFeatureFileWriter::Analyze(const int16* Samples, int64 NumFrames, int32 NumChannels, int32 SampleRate, const FAudioFeatureFileSettings& Settings, TArray<uint8>& OutData)
+{
+    OutData.Reset();
+
+    if (Samples == nullptr || NumFrames <= 0 || NumChannels <= 0 || SampleRate <= 0 || Settings.HopFrames <= 0 || Settings.Bands.NumBands <= 0) {
+        return false;
+    }
+
+    const int32 hopFrames = Settings.HopFrames;
+    const int64 numHops = (NumFrames + hopFrames - 1) / hopFrames;
+    const int32 fftSize = FAudioChannelSpectrumAnalyzer::GetFftSize(hopFrames);
+    const int32 numBins = fftSize / 2 - 1;
+    const int32 numBands = Settings.Bands.NumBands;
+    const int32 recordStride = Align<int32>(sizeof(FAudioFeatureRecord) + (numBins + numBands) * sizeof(float), 16);
+    const int64 recordOffset = Align<int64>(sizeof(FAudioFeatureFileHeader), 16);
+    const int64 totalSize = recordOffset + numHops * recordStride;
+
+    if (totalSize > MAX_int32) {
+        return false;
+    }
+
+    OutData.SetNumZeroed((int32)totalSize);
+
+    FAudioFeatureFileHeader* header = reinterpret_cast<FAudioFeatureFileHeader*>(OutData.GetData());
+    header->Magic = FAudioFeatureFileHeader::ExpectedMagic;
+    header->Version = FAudioFeatureFileHeader::CurrentVersion;
+    header->SampleRate = SampleRate;
+    header->NumChannels = NumChannels;
+    header->HopFrames = hopFrames;
+    header->NumHops = (uint32)numHops;
+    header->FftSize = fftSize;
+    header->NumSpectrumBins = numBins;
+    header->NumBands = numBands;
+    header->BandMinFrequency = Settings.Bands.MinFrequency;
+    header->BandMaxFrequency = Settings.Bands.MaxFrequency;
+    header->RecordStride = recordStride;
+    header->RecordOffset = recordOffset;
+    header->SourceFrames = NumFrames;
+
+    FAudioChannelSpectrumAnalyzer spectrumAnalyzer;
+    FAudioChannelSpectra spectra;
+    TArray<float> spectrum;
+
+    FAudioMultiResolutionAnalyzer bandAnalyzer;
+    bandAnalyzer.Configure(SampleRate, NumChannels, Settings.Bands);
+    TArray<float> bands;
+
+    FAudioLevelMeter meter;
+    meter.Configure(SampleRate, NumChannels);
+
+    // The last hop is zero padded so every stage sees full blocks
+    TArray<int16> tail;
+
+    TArray<float> previousLogBands;
+    previousLogBands.SetNumZeroed(numBands);
+    TArray<float> flux;
+    flux.SetNumZeroed((int32)numHops);
+
+    for (int32 hop = 0; hop < numHops; ++hop) {
+        const int64 firstFrame = (int64)hop * hopFrames;
+        const int32 numValid = (int32)FMath::Min<int64>(hopFrames, NumFrames - firstFrame);
+        const int16* block = Samples + firstFrame * NumChannels;
+
+        if (numValid < hopFrames) {
+            tail.SetNumZeroed(hopFrames * NumChannels);
+            FMemory::Memcpy(tail.GetData(), block, numValid * NumChannels * sizeof(int16));
+            block = tail.GetData();
+        }
+
+        uint8* recordData = OutData.GetData() + recordOffset + (int64)hop * recordStride;
+        FAudioFeatureRecord* record = reinterpret_cast<FAudioFeatureRecord*>(recordData);
+        float* recordSpectrum = reinterpret_cast<float*>(recordData + sizeof(FAudioFeatureRecord));
+        float* recordBands = recordSpectrum + numBins;
+
+        meter.ProcessInt16(block, hopFrames);
+        const FAudioLevelMetrics levels = meter.ConsumeMetrics();
+
+        record->MomentaryLufs = levels.MomentaryLufs;
+        record->ShortTermLufs = levels.ShortTermLufs;
+        record->Rms = levels.GetMaxRms();
+        record->Peak = levels.GetMaxPeak();
+        record->TruePeak = levels.GetMaxTruePeak();
+        record->bSilent = record->Peak <= 0.0f ? 1 : 0;
+
+        // The band analyzer keeps its history through silence, exactly like the capture stream
+        bandAnalyzer.PushInt16(block, hopFrames);
+
+        if (record->bSilent) {
+            FMemory::Memzero(previousLogBands.GetData(), numBands * sizeof(float));
+            continue;
+        }
+
+        spectrumAnalyzer.Analyze(block, hopFrames, NumChannels, SampleRate, spectra, spectrum);
+        FMemory::Memcpy(recordSpectrum, spectrum.GetData(), FMath::Min(spectrum.Num(), numBins) * sizeof(float));
+
+        bandAnalyzer.Analyze(bands);
+        FMemory::Memcpy(recordBands, bands.GetData(), FMath::Min(bands.Num(), numBands) * sizeof(float));
+
+        float bandFlux = 0.0f;
+        for (int32 band = 0; band < numBands; ++band) {
+            const float logBand = FMath::Loge(1.0f + recordBands[band] * FluxCompression);
+            bandFlux += FMath::Max(0.0f, logBand - previousLogBands[band]);
+            previousLogBands[band] = logBand;
+        }
+        flux[hop] = bandFlux / numBands;
+    }
+
+    TArray<bool> onsets;
+    PickOnsets(flux, Settings, onsets);
+
+    for (int32 hop = 0; hop < numHops; ++hop) {
+        FAudioFeatureRecord* record = reinterpret_cast<FAudioFeatureRecord*>(OutData.GetData() + recordOffset + (int64)hop * recordStride);
+        record->OnsetStrength = flux[hop];
+        record->bOnset = onsets[hop] ? 1 : 0;
+    }
+
+    return true;
+}
+
+void FAudioFeatureFileWriter::PickOnsets(const TArray<float>& Flux, const FAudioFeatureFileSettings& Settings, TArray<bool>& OutOnsets)
+{
+    const int32 numHops = Flux.Num();
+    OutOnsets.SetNumZeroed(numHops);
+
+    // Prefix sums for the local mean
+    TArray<double> sums;
+    sums.SetNumUninitialized(numHops + 1);
+    sums[0] = 0.0;
+    for (int32 hop = 0; hop < numHops; ++hop) {
+        sums[hop + 1] = sums[hop] + Flux[hop];
+    }
+
+    int32 lastOnset = -Settings.OnsetMinIntervalHops - 1;
+
+    for (int32 hop = 0; hop < numHops; ++hop) {
+        if (Flux[hop] <= 0.0f || hop - lastOnset <= Settings.OnsetMinIntervalHops) {
+            continue;
+        }
+
+        const int32 peakFirst = FMath::Max(0, hop - Settings.OnsetPeakHops);
+        const int32 peakLast = FMath::Min(numHops - 1, hop + Settings.OnsetPeakHops);
+        bool bIsPeak = true;
+        for (int32 other = peakFirst; other <= peakLast && bIsPeak; ++other) {
+            // Ties go to the earliest hop of a plateau
+            bIsPeak = other < hop ? Flux[other] < Flux[hop] : Flux[other] <= Flux[hop];
+        }
+        if (!bIsPeak) {
+            continue;
+        }
+
+        const int32 meanFirst = FMath::Max(0, hop - Settings.OnsetMeanHops);
+        const int32 meanLast = FMath::Min(numHops - 1, hop + Settings.OnsetMeanHops);
+        const float mean = float((sums[meanLast + 1] - sums[meanFirst]) / (meanLast - meanFirst + 1));
+
+        if (Flux[hop] >= mean * Settings.OnsetThreshold + Settings.OnsetDelta) {
+            OutOnsets[hop] = true;
+            lastOnset = hop;
+        }
+    }
+}
+
+bool FAudioFeatureFileWriter::AnalyzeWaveFile(const FString& WavePath, const FString& OutputPath, const FAudioFeatureFileSettings& Settings, FString& OutError)
+{
+    TArray<uint8> waveData;
+    if (!FFileHelper::LoadFileToArray(waveData, *WavePath)) {
+        OutError = FString::Printf(TEXT("cannot read %s"), *WavePath);
+        return false;
+    }
+
+    FWaveModInfo waveInfo;
+    FString waveError;
+    if (!waveInfo.ReadWaveInfo(waveData.GetData(), waveData.Num(), &waveError)) {
+        OutError = FString::Printf(TEXT("%s is not a valid WAV file: %s"), *WavePath, *waveError);
+        return false;
+    }
+
+    if (*waveInfo.pBitsPerSample != 16) {
+        OutError = FString::Printf(TEXT("%s has %d bits per sample, only 16-bit PCM is supported"), *WavePath, (int32)*waveInfo.pBitsPerSample);
+        return false;
+    }
+
+    const int32 numChannels = *waveInfo.pChannels;
+    const int32 sampleRate = *waveInfo.pSamplesPerSec;
+    const int64 numFrames = numChannels > 0 ? waveInfo.SampleDataSize / (numChannels * sizeof(int16)) : 0;
+
+    TArray<uint8> featureData;
+    if (!Analyze(reinterpret_cast<const int16*>(waveInfo.SampleDataStart), numFrames, numChannels, sampleRate, Settings, featureData)) {
+        OutError = FString::Printf(TEXT("%s: nothing to analyse, or the track is too long for one feature file"), *WavePath);
+        return false;
+    }
+
+    if (!FFileHelper::SaveArrayToFile(featureData, *OutputPath)) {
+        OutError = FString::Printf(TEXT("cannot write %s"), *OutputPath);
+        return false;
+    }
+
+    return true;
+}
+
+FAudioFeatureFile::FAudioFeatureFile()
+    : Data(nullptr)
+    , DataSize(0)
+{
+}
+
+FAudioFeatureFile::~FAudioFeatureFile()
+{
+    Close();
+}
+
+bool FAudioFeatureFile::Open(const FString& Path, FString& OutError)
+{
+    Close();
+
+    IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+    MappedFile.Reset(platformFile.OpenMapped(*Path));
+    if (MappedFile.IsValid()) {
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+
+    if (MappedRegion.IsValid()) {
+        Data = MappedRegion->GetMappedPtr();
+        DataSize = MappedRegion->GetMappedSize();
+    }
+    else {
+        MappedFile.Reset();
+
+        if (!FFileHelper::LoadFileToArray(LoadedData, *Path)) {
+            OutError = FString::Printf(TEXT("cannot read %s"), *Path);
+            return false;
+        }
+
+        Data = LoadedData.GetData();
+        DataSize = LoadedData.Num();
+    }
+
+    FString headerError = TEXT("file is too small for a header");
+    if (DataSize < (int64)sizeof(FAudioFeatureFileHeader) || !ValidateHeader(GetHeader(), DataSize, headerError)) {
+        OutError = FString::Printf(TEXT("%s: %s"), *Path, *headerError);
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void FAudioFeatureFile::Close()
+{
+    // The region has to go before the file it maps
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    LoadedData.Empty();
+
+    Data = nullptr;
+    DataSize = 0;
+}
+
+bool FAudioFeatureFile::ValidateHeader(const FAudioFeatureFileHeader& Header, int64 Size, FString& OutError)
+{
+    if (Header.Magic != FAudioFeatureFileHeader::ExpectedMagic) {
+        OutError = TEXT("not a feature file");
+        return false;
+    }
+
+    if (Header.Version != FAudioFeatureFileHeader::CurrentVersion) {
+        OutError = FString::Printf(TEXT("version %u, this build reads version %u, analyse the track again"), Header.Version, FAudioFeatureFileHeader::CurrentVersion);
+        return false;
+    }
+
+    const uint64 minimumStride = sizeof(FAudioFeatureRecord) + ((uint64)Header.NumSpectrumBins + Header.NumBands) * sizeof(float);
+
+    if (Header.SampleRate == 0 || Header.HopFrames == 0 || Header.RecordStride < minimumStride || Header.RecordStride % 4 != 0
+        || Header.RecordOffset < sizeof(FAudioFeatureFileHeader) || Header.RecordOffset % 4 != 0) {
+        OutError = TEXT("corrupt header");
+        return false;
+    }
+
+    if (Header.RecordOffset + (uint64)Header.NumHops * Header.RecordStride > (uint64)Size) {
+        OutError = TEXT("truncated file");
+        return false;
+    }
+
+    return true;
+}
+
+double FAudioFeatureFile::GetHopSeconds() const
+{
+    return IsOpen() ? double(GetHeader().HopFrames) / GetHeader().SampleRate : 0.0;
+}
+
+double FAudioFeatureFile::GetDuration() const
+{
+    return IsOpen() ? double(GetHeader().SourceFrames) / GetHeader().SampleRate : 0.0;
+}
+
+int32 FAudioFeatureFile::GetHopIndex(double Seconds) const
+{
+    if (!IsOpen() || Seconds < 0.0) {
+        return INDEX_NONE;
+    }
+
+    const int64 hop = (int64)(Seconds * GetHeader().SampleRate) / GetHeader().HopFrames;
+    return hop < GetHeader().NumHops ? (int32)hop : INDEX_NONE;
+}
+
+FAudioFeatureFrameView FAudioFeatureFile::GetFrame(int32 HopIndex) const
+{
+    FAudioFeatureFrameView view;
+
+    if (!IsOpen() || HopIndex < 0 || HopIndex >= GetNumHops()) {
+        return view;
+    }
+
+    const FAudioFeatureFileHeader& header = GetHeader();
+    const uint8* recordData = Data + header.RecordOffset + (uint64)HopIndex * header.RecordStride;
+
+    view.HopIndex = HopIndex;
+    view.Record = reinterpret_cast<const FAudioFeatureRecord*>(recordData);
+    view.Spectrum = reinterpret_cast<const float*>(recordData + sizeof(FAudioFeatureRecord));
+    view.NumSpectrumBins = header.NumSpectrumBins;
+    view.Bands = view.Spectrum + header.NumSpectrumBins;
+    view.NumBands = header.NumBands;
+
+    return view;
+}
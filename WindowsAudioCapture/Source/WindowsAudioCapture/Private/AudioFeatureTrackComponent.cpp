@@ -0,0 +1,204 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioFeatureTrackComponent.h"
+#include "AudioLevelMeter.h"
+#include "WindowsAudioCapture.h"
+#include "Components/AudioComponent.h"
+#include "Misc/Paths.h"
+#include "Sound/SoundWave.h"
+
+
+// Sets default values for this component's properties
+UAudioFeatureTrackComponent::UAudioFeatureTrackComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+// Called when the game starts
+void UAudioFeatureTrackComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!FeatureFile.FilePath.IsEmpty())
+	{
+		BP_OpenFeatureFile(FeatureFile.FilePath);
+	}
+}
+
+void UAudioFeatureTrackComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	BP_SyncToAudioComponent(nullptr);
+	Track.Close();
+	CurrentHop = INDEX_NONE;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+// Called every frame
+void UAudioFeatureTrackComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Between two playback percent callbacks the synced clock runs on its own too, the callback corrects it
+	if (bPlaying)
+	{
+		PlaybackSeconds += DeltaTime;
+	}
+
+	UpdateCurrentHop();
+}
+
+void UAudioFeatureTrackComponent::UpdateCurrentHop()
+{
+	const int32 PreviousHop = CurrentHop;
+	CurrentHop = Track.GetHopIndex(PlaybackSeconds);
+
+	bOnsetSinceLastTick = false;
+
+	if (CurrentHop == INDEX_NONE)
+	{
+		return;
+	}
+
+	// A seek backwards only looks at the hop it landed on
+	const int32 FirstHop = (PreviousHop != INDEX_NONE && PreviousHop < CurrentHop) ? PreviousHop + 1 : CurrentHop;
+
+	for (int32 Hop = FirstHop; Hop <= CurrentHop && !bOnsetSinceLastTick; ++Hop)
+	{
+		bOnsetSinceLastTick = Track.GetFrame(Hop).Record->bOnset != 0;
+	}
+}
+
+bool UAudioFeatureTrackComponent::BP_OpenFeatureFile(const FString& InPath)
+{
+	BP_StopTrack();
+	PlaybackSeconds = 0.0;
+	CurrentHop = INDEX_NONE;
+
+	const FString FullPath = FPaths::IsRelative(InPath) ? FPaths::Combine(FPaths::ProjectDir(), InPath) : InPath;
+
+	FString Error;
+	if (!Track.Open(FullPath, Error))
+	{
+		UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("UAudioFeatureTrackComponent: %s"), *Error);
+		return false;
+	}
+
+	return true;
+}
+
+void UAudioFeatureTrackComponent::BP_PlayTrack(float InStartTime)
+{
+	PlaybackSeconds = InStartTime;
+	bPlaying = true;
+	CurrentHop = INDEX_NONE;
+
+	UpdateCurrentHop();
+}
+
+void UAudioFeatureTrackComponent::BP_StopTrack()
+{
+	bPlaying = false;
+}
+
+void UAudioFeatureTrackComponent::BP_SyncToAudioComponent(UAudioComponent* InAudioComponent)
+{
+	if (SyncAudioComponent)
+	{
+		SyncAudioComponent->OnAudioPlaybackPercent.RemoveDynamic(this, &UAudioFeatureTrackComponent::OnAudioPlaybackPercent);
+		SyncAudioComponent->OnAudioFinished.RemoveDynamic(this, &UAudioFeatureTrackComponent::OnAudioFinished);
+	}
+
+	SyncAudioComponent = InAudioComponent;
+
+	if (SyncAudioComponent)
+	{
+		SyncAudioComponent->OnAudioPlaybackPercent.AddDynamic(this, &UAudioFeatureTrackComponent::OnAudioPlaybackPercent);
+		SyncAudioComponent->OnAudioFinished.AddDynamic(this, &UAudioFeatureTrackComponent::OnAudioFinished);
+		bPlaying = SyncAudioComponent->IsPlaying();
+	}
+}
+
+void UAudioFeatureTrackComponent::OnAudioPlaybackPercent(const USoundWave* PlayingSoundWave, const float PlaybackPercent)
+{
+	if (PlayingSoundWave)
+	{
+		PlaybackSeconds = PlaybackPercent * PlayingSoundWave->Duration;
+		bPlaying = true;
+	}
+}
+
+void UAudioFeatureTrackComponent::OnAudioFinished()
+{
+	bPlaying = false;
+}
+
+// This function will return the Frequency Array of the track.
+TArray<float> UAudioFeatureTrackComponent::BP_GetTrackFrequencyArray(float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	TArray<float> FrequencyArray;
+
+	const FAudioFeatureFrameView Frame = GetCurrentFrame();
+
+	if (Frame.IsValid())
+	{
+		const FAudioSpectrumScalingProfile Profile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset);
+
+		if (!ScalingTable.IsValid() || !(ScalingTable->GetProfile() == Profile))
+		{
+			ScalingTable = MakeUnique<FAudioSpectrumScalingTable>(Profile);
+		}
+
+		FrequencyArray.SetNumUninitialized(Frame.NumSpectrumBins);
+		ScalingTable->Apply(Frame.Spectrum, FrequencyArray.GetData(), Frame.NumSpectrumBins);
+	}
+
+	return FrequencyArray;
+}
+
+// This function will return the band spectrum of the track.
+void UAudioFeatureTrackComponent::BP_GetTrackBandSpectrum(TArray<float>& OutBands, TArray<float>& OutFrequencies) const
+{
+	OutBands.Reset();
+	OutFrequencies.Reset();
+
+	const FAudioFeatureFrameView Frame = GetCurrentFrame();
+
+	if (Frame.IsValid())
+	{
+		const FAudioFeatureFileHeader& Header = Track.GetHeader();
+
+		FAudioMultiResolutionSettings Settings;
+		Settings.MinFrequency = Header.BandMinFrequency;
+		Settings.MaxFrequency = Header.BandMaxFrequency;
+		Settings.NumBands = Header.NumBands;
+
+		OutBands.Append(Frame.Bands, Frame.NumBands);
+		for (int32 Band = 0; Band < Frame.NumBands; ++Band)
+		{
+			OutFrequencies.Add(Settings.GetBandFrequency(Band));
+		}
+	}
+}
+
+// This function will return the levels of the track.
+void UAudioFeatureTrackComponent::BP_GetTrackLevels(float& OutRms, float& OutPeak, float& OutMomentaryLufs, float& OutShortTermLufs) const
+{
+	const FAudioFeatureFrameView Frame = GetCurrentFrame();
+
+	OutRms = Frame.IsValid() ? Frame.Record->Rms : 0.0f;
+	OutPeak = Frame.IsValid() ? Frame.Record->Peak : 0.0f;
+	OutMomentaryLufs = Frame.IsValid() ? Frame.Record->MomentaryLufs : FAudioLevelMetrics::MinLoudnessLufs;
+	OutShortTermLufs = Frame.IsValid() ? Frame.Record->ShortTermLufs : FAudioLevelMetrics::MinLoudnessLufs;
+}
+
+// This function will tell if an onset was passed since the previous tick.
+bool UAudioFeatureTrackComponent::BP_GetTrackOnset(float& OutOnsetStrength) const
+{
+	const FAudioFeatureFrameView Frame = GetCurrentFrame();
+
+	OutOnsetStrength = Frame.IsValid() ? Frame.Record->OnsetStrength : 0.0f;
+
+	return bOnsetSinceLastTick;
+}
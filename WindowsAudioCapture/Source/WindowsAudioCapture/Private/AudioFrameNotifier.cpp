@@ -0,0 +1,217 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioFrameNotifier.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "Async/Async.h"
+
+FAudioFrameNotifier::FAudioFrameNotifier()
+    : State(MakeShared<FState, ESPMode::ThreadSafe>())
+{
+}
+
+FAudioFrameNotifier::~FAudioFrameNotifier()
+{
+    Shutdown();
+}
+
+bool FAudioFrameNotifier::FWaiter::IsSatisfiedBy(const FAudioSpectrumFrame& InFrame)
+{
+    if (Kind == EAudioFrameWaitKind::Spectrum) {
+        return InFrame.bHasSpectrum;
+    }
+
+    if (!InFrame.Onsets.bValid) {
+        return false;
+    }
+
+    // Counts never go back, so the first valid frame is a safe baseline even if the bands stopped in between
+    if (!bHasBaseline) {
+        FMemory::Memcpy(BaselineOnsetCount, InFrame.Onsets.OnsetCount, sizeof(BaselineOnsetCount));
+        bHasBaseline = true;
+        return false;
+    }
+
+    for (int32 Index = 0; Index < FAudioBandOnsets::NumBands; ++Index) {
+        if ((Band == INDEX_NONE || Band == Index) && InFrame.Onsets.OnsetCount[Index] != BaselineOnsetCount[Index]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TFuture<FAudioSpectrumFramePtr> FAudioFrameNotifier::Wait(EAudioFrameWaitKind Kind, int32 Band, const FAudioSpectrumFramePtr& LatestFrame)
+{
+    FWaiter Waiter;
+    Waiter.Kind = Kind;
+    Waiter.Band = Band;
+    Waiter.Promise = MakeShared<TPromise<FAudioSpectrumFramePtr>, ESPMode::ThreadSafe>();
+
+    TFuture<FAudioSpectrumFramePtr> Future = Waiter.Promise->GetFuture();
+    AddWaiter(MoveTemp(Waiter), LatestFrame);
+    return Future;
+}
+
+void FAudioFrameNotifier::Wait(EAudioFrameWaitKind Kind, int32 Band, const FAudioSpectrumFramePtr& LatestFrame, FAudioFrameCallback Callback)
+{
+    FWaiter Waiter;
+    Waiter.Kind = Kind;
+    Waiter.Band = Band;
+    Waiter.Callback = MoveTemp(Callback);
+
+    AddWaiter(MoveTemp(Waiter), LatestFrame);
+}
+
+void FAudioFrameNotifier::AddWaiter(FWaiter&& Waiter, const FAudioSpectrumFramePtr& LatestFrame)
+{
+    if (Waiter.Band < INDEX_NONE || Waiter.Band >= FAudioBandOnsets::NumBands) {
+        Waiter.Band = INDEX_NONE;
+    }
+
+    // The wait is for a frame after LatestFrame, its onsets are where counting starts
+    if (Waiter.Kind == EAudioFrameWaitKind::Onset && LatestFrame.IsValid() && LatestFrame->Onsets.bValid) {
+        FMemory::Memcpy(Waiter.BaselineOnsetCount, LatestFrame->Onsets.OnsetCount, sizeof(Waiter.BaselineOnsetCount));
+        Waiter.bHasBaseline = true;
+    }
+
+    FScopeLock Lock(&State->Lock);
+
+    if (State->bShutdown) {
+        // Still completed through the dispatch, callers never see their callback run inside Wait
+        State->Ready.Add(MoveTemp(Waiter));
+        QueueDispatch(State);
+        return;
+    }
+
+    State->NumWaiters[(int32)Waiter.Kind]++;
+    State->Pending.Add(MoveTemp(Waiter));
+    State->Stats.Waits++;
+}
+
+FDelegateHandle FAudioFrameNotifier::AddListener(FAudioFramePublishedEvent::FDelegate Delegate)
+{
+    check(IsInGameThread());
+
+    State->NumListeners++;
+    return State->Listeners.Add(Delegate);
+}
+
+void FAudioFrameNotifier::RemoveListener(FDelegateHandle Handle)
+{
+    check(IsInGameThread());
+
+    if (State->Listeners.Remove(Handle)) {
+        State->NumListeners--;
+    }
+}
+
+bool FAudioFrameNotifier::HasWaiters(EAudioFrameWaitKind Kind) const
+{
+    return State->NumWaiters[(int32)Kind].load(std::memory_order_relaxed) > 0;
+}
+
+void FAudioFrameNotifier::OnFramePublished(const FAudioSpectrumFramePtr& Frame)
+{
+    // Nothing to do for most frames: no waits and no listeners costs two atomic loads
+    const bool bListening = State->NumListeners.load(std::memory_order_relaxed) > 0;
+    if (!bListening && !HasWaiters(EAudioFrameWaitKind::Spectrum) && !HasWaiters(EAudioFrameWaitKind::Onset)) {
+        return;
+    }
+
+    FScopeLock Lock(&State->Lock);
+
+    for (int32 Index = 0; Index < State->Pending.Num();) {
+        FWaiter& Waiter = State->Pending[Index];
+
+        if (Waiter.IsSatisfiedBy(*Frame)) {
+            Waiter.Frame = Frame;
+            State->NumWaiters[(int32)Waiter.Kind]--;
+            State->Ready.Add(MoveTemp(Waiter));
+            State->Pending.RemoveAtSwap(Index, 1, false);
+        } else {
+            ++Index;
+        }
+    }
+
+    State->LatestFrame = Frame;
+
+    if (State->Ready.Num() > 0 || bListening) {
+        QueueDispatch(State);
+    }
+}
+
+void FAudioFrameNotifier::QueueDispatch(const FStateRef& InState)
+{
+    // One task in flight at a time, it picks up whatever is ready when it runs
+    if (InState->bDispatchQueued) {
+        return;
+    }
+    InState->bDispatchQueued = true;
+
+    AsyncTask(ENamedThreads::GameThread, [InState]() {
+        Dispatch(InState);
+    });
+}
+
+void FAudioFrameNotifier::Dispatch(const FStateRef& InState)
+{
+    check(IsInGameThread());
+    WAC_LLM_SCOPE();
+
+    TArray<FWaiter> Ready;
+    FAudioSpectrumFramePtr LatestFrame;
+    {
+        FScopeLock Lock(&InState->Lock);
+        Swap(Ready, InState->Ready);
+        LatestFrame = MoveTemp(InState->LatestFrame);
+        InState->bDispatchQueued = false;
+        InState->Stats.Dispatches++;
+        InState->Stats.CompletedWaits += Ready.Num();
+    }
+
+    for (FWaiter& Waiter : Ready) {
+        Complete(Waiter);
+    }
+
+    if (LatestFrame.IsValid() && InState->Listeners.IsBound()) {
+        InState->Listeners.Broadcast(LatestFrame);
+    }
+}
+
+void FAudioFrameNotifier::Complete(FWaiter& Waiter)
+{
+    if (Waiter.Promise.IsValid()) {
+        Waiter.Promise->SetValue(Waiter.Frame);
+    } else if (Waiter.Callback) {
+        Waiter.Callback(Waiter.Frame);
+    }
+}
+
+void FAudioFrameNotifier::Shutdown()
+{
+    TArray<FWaiter> Cancelled;
+    {
+        FScopeLock Lock(&State->Lock);
+        if (State->bShutdown) {
+            return;
+        }
+        State->bShutdown = true;
+
+        Swap(Cancelled, State->Pending);
+        State->NumWaiters[0] = 0;
+        State->NumWaiters[1] = 0;
+    }
+
+    // A dispatch still queued completes the ready ones; the pending ones will never see a frame
+    for (FWaiter& Waiter : Cancelled) {
+        Waiter.Frame.Reset();
+        Complete(Waiter);
+    }
+
+    State->Listeners.Clear();
+    State->NumListeners = 0;
+}
+
+FAudioFrameNotifierStats FAudioFrameNotifier::GetStats() const
+{
+    FScopeLock Lock(&State->Lock);
+    return State->Stats;
+}
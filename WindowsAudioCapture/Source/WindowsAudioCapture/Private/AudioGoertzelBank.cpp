@@ -0,0 +1,99 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioGoertzelBank.h"
+#include "AudioVectorMath.h"
+#include "AudioChannelSpectrumAnalyzer.h"
+#include "Math/VectorRegister.h"
+
+FAudioGoertzelBank::FAudioGoertzelBank()
+    : SampleRate(0)
+    , WindowFrames(0)
+    , WindowChannels(0)
+{
+}
+
+void FAudioGoertzelBank::Configure(int32 InSampleRate, const TArray<int32>& InFrequencies)
+{
+    SampleRate = FMath::Max(InSampleRate, 1);
+    Frequencies = InFrequencies;
+
+    const int32 NumLanes = Align(FMath::Max(Frequencies.Num(), 1), 4);
+    Coefficients.SetNumZeroed(NumLanes);
+    Cosines.SetNumZeroed(NumLanes);
+    Sines.SetNumZeroed(NumLanes);
+
+    for (int32 Index = 0; Index < Frequencies.Num(); ++Index) {
+        const float Omega = 2.0f * PI * Frequencies[Index] / SampleRate;
+        Cosines[Index] = FMath::Cos(Omega);
+        Sines[Index] = FMath::Sin(Omega);
+        Coefficients[Index] = 2.0f * Cosines[Index];
+    }
+}
+
+void FAudioGoertzelBank::UpdateWindow(int32 NumFrames, int32 NumChannels)
+{
+    if (NumFrames == WindowFrames && NumChannels == WindowChannels) {
+        return;
+    }
+
+    // The FFT path spreads its window over the whole (padded) FFT length
+    const int32 WindowLength = FAudioChannelSpectrumAnalyzer::GetFftSize(NumFrames);
+
+    Window.SetNumUninitialized(NumFrames);
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        Window[Frame] = 32768.0f * 0.5f * (1.0f - FMath::Cos(2.0f * PI * Frame / (WindowLength - 1)));
+    }
+
+    WindowFrames = NumFrames;
+    WindowChannels = NumChannels;
+}
+
+void FAudioGoertzelBank::Process(const int16* Samples, int32 NumFrames, int32 NumChannels, TArray<float>& OutMagnitudes)
+{
+    OutMagnitudes.SetNumZeroed(Frequencies.Num());
+
+    if (Samples == nullptr || NumFrames <= 0 || NumChannels <= 0 || Frequencies.Num() == 0) {
+        return;
+    }
+
+    UpdateWindow(NumFrames, NumChannels);
+
+    DeinterleaveBuffer.SetNumUninitialized(NumFrames * NumChannels, false);
+    ChannelBuffers.SetNumUninitialized(NumChannels, false);
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        ChannelBuffers[Channel] = DeinterleaveBuffer.GetData() + Channel * NumFrames;
+    }
+    FAudioVectorMath::DeinterleaveInt16(Samples, NumFrames, NumChannels, ChannelBuffers.GetData());
+
+    const float ChannelScale = 1.0f / NumChannels;
+
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        float* Buffer = ChannelBuffers[Channel];
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            Buffer[Frame] *= Window[Frame];
+        }
+
+        for (int32 Lane = 0; Lane < Coefficients.Num(); Lane += 4) {
+            const VectorRegister Coefficient = VectorLoad(&Coefficients[Lane]);
+            VectorRegister S1 = VectorZero();
+            VectorRegister S2 = VectorZero();
+
+            for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+                const VectorRegister S0 = VectorMultiplyAdd(Coefficient, S1, VectorSubtract(VectorSetFloat1(Buffer[Frame]), S2));
+                S2 = S1;
+                S1 = S0;
+            }
+
+            float S1Lanes[4];
+            float S2Lanes[4];
+            VectorStore(S1, S1Lanes);
+            VectorStore(S2, S2Lanes);
+
+            const int32 NumValid = FMath::Min(4, Frequencies.Num() - Lane);
+            for (int32 Index = 0; Index < NumValid; ++Index) {
+                const float Real = S1Lanes[Index] - S2Lanes[Index] * Cosines[Lane + Index];
+                const float Imaginary = S2Lanes[Index] * Sines[Lane + Index];
+                OutMagnitudes[Lane + Index] += FMath::Sqrt(Real * Real + Imaginary * Imaginary) * ChannelScale;
+            }
+        }
+    }
+}
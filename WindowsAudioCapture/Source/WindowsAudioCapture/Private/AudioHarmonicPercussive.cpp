@@ -0,0 +1,262 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioHarmonicPercussive.h"
+
+namespace {
+const float BandEdges[FAudioHarmonicPercussiveBands::NumBands + 1] = { 20.0f, 60.0f, 150.0f, 400.0f, 1000.0f, 2500.0f, 6000.0f, 12000.0f, 20000.0f };
+
+// Keeps the masks defined in silence
+constexpr float MaskEpsilon = 1e-12f;
+
+// First index whose value is not below Value
+int32 LowerBound(const float* Sorted, int32 Num, float Value)
+{
+    int32 First = 0;
+    while (Num > 0) {
+        const int32 Half = Num / 2;
+        if (Sorted[First + Half] < Value) {
+            First += Half + 1;
+            Num -= Half + 1;
+        } else {
+            Num = Half;
+        }
+    }
+    return First;
+}
+
+// Sorted holds Num ascending values, one of which is Old. Swaps it for New and moves New into place.
+void SortedReplace(float* Sorted, int32 Num, float Old, float New)
+{
+    int32 Index = LowerBound(Sorted, Num, Old);
+
+    if (New > Old) {
+        while (Index + 1 < Num && Sorted[Index + 1] < New) {
+            Sorted[Index] = Sorted[Index + 1];
+            ++Index;
+        }
+    } else {
+        while (Index > 0 && Sorted[Index - 1] > New) {
+            Sorted[Index] = Sorted[Index - 1];
+            --Index;
+        }
+    }
+    Sorted[Index] = New;
+}
+
+// Sorted has room for Num + 1 values
+void SortedInsert(float* Sorted, int32 Num, float Value)
+{
+    int32 Index = Num;
+    while (Index > 0 && Sorted[Index - 1] > Value) {
+        Sorted[Index] = Sorted[Index - 1];
+        --Index;
+    }
+    Sorted[Index] = Value;
+}
+
+// Value must be one of the Num values
+void SortedRemove(float* Sorted, int32 Num, float Value)
+{
+    for (int32 Index = LowerBound(Sorted, Num, Value); Index + 1 < Num; ++Index) {
+        Sorted[Index] = Sorted[Index + 1];
+    }
+}
+}
+
+float FAudioHarmonicPercussiveBands::GetBandEdge(int32 Band)
+{
+    return BandEdges[FMath::Clamp(Band, 0, NumBands)];
+}
+
+FAudioHarmonicPercussiveSeparator::FAudioHarmonicPercussiveSeparator()
+    : NumBins(0)
+    , SampleRate(0)
+    , Decimation(1)
+    , FixedDecimation(0)
+    , NumWorkBins(0)
+    , BudgetSeconds(0.0)
+    , SmoothedSeconds(0.0)
+    , HistoryWrite(0)
+{
+    FMemory::Memzero(BinsPerBand, sizeof(BinsPerBand));
+}
+
+void FAudioHarmonicPercussiveSeparator::Reset()
+{
+    FMemory::Memzero(TimeHistory.GetData(), TimeHistory.Num() * sizeof(float));
+    FMemory::Memzero(TimeSorted.GetData(), TimeSorted.Num() * sizeof(float));
+    HistoryWrite = 0;
+}
+
+void FAudioHarmonicPercussiveSeparator::SetFixedDecimation(int32 InDecimation)
+{
+    FixedDecimation = InDecimation > 0 ? FMath::Clamp((int32)FMath::RoundUpToPowerOfTwo((uint32)InDecimation), 1, MaxDecimation) : 0;
+
+    if (FixedDecimation > 0 && NumBins > 0) {
+        Configure(NumBins, SampleRate, FixedDecimation);
+    }
+}
+
+void FAudioHarmonicPercussiveSeparator::Configure(int32 InNumBins, int32 InSampleRate, int32 InDecimation)
+{
+    NumBins = InNumBins;
+    SampleRate = InSampleRate;
+    Decimation = InDecimation;
+    NumWorkBins = (NumBins + Decimation - 1) / Decimation;
+
+    Work.SetNumUninitialized(NumWorkBins);
+    HarmonicMask.SetNumUninitialized(NumWorkBins);
+    FrequencySorted.SetNumUninitialized(FrequencyMedianLength + 1);
+    TimeHistory.SetNumUninitialized(NumWorkBins * TimeMedianLength);
+    TimeSorted.SetNumUninitialized(NumWorkBins * TimeMedianLength);
+    Reset();
+
+    // Magnitudes drop DC, so N bins come from a 2 * (N + 1) point FFT
+    const float BinWidth = SampleRate / (2.0f * (NumBins + 1));
+    WorkBand.SetNumUninitialized(NumWorkBins);
+    FMemory::Memzero(BinsPerBand, sizeof(BinsPerBand));
+
+    for (int32 WorkBin = 0; WorkBin < NumWorkBins; ++WorkBin) {
+        const int32 First = WorkBin * Decimation;
+        const int32 Last = FMath::Min(First + Decimation, NumBins) - 1;
+        const float Frequency = ((First + Last) * 0.5f + 1.0f) * BinWidth;
+
+        int32 Band = -1;
+        for (int32 Candidate = 0; Candidate < FAudioHarmonicPercussiveBands::NumBands; ++Candidate) {
+            if (Frequency >= BandEdges[Candidate] && Frequency < BandEdges[Candidate + 1]) {
+                Band = Candidate;
+                break;
+            }
+        }
+
+        WorkBand[WorkBin] = Band;
+        if (Band >= 0) {
+            BinsPerBand[Band] += Last - First + 1;
+        }
+    }
+
+    Stats.Decimation = Decimation;
+}
+
+void FAudioHarmonicPercussiveSeparator::Process(const float* Magnitudes, int32 InNumBins, int32 InSampleRate, FAudioHarmonicPercussiveBands& OutBands)
+{
+    OutBands = FAudioHarmonicPercussiveBands();
+
+    if (Magnitudes == nullptr || InNumBins <= 0 || InSampleRate <= 0) {
+        return;
+    }
+
+    const double Start = FPlatformTime::Seconds();
+
+    if (InNumBins != NumBins || InSampleRate != SampleRate) {
+        Configure(InNumBins, InSampleRate, FixedDecimation > 0 ? FixedDecimation : Decimation);
+    }
+
+    Separate(Magnitudes, OutBands);
+
+    UpdateBudget(FPlatformTime::Seconds() - Start);
+}
+
+void FAudioHarmonicPercussiveSeparator::Separate(const float* Magnitudes, FAudioHarmonicPercussiveBands& OutBands)
+{
+    // Working spectrum, the RMS of each group of bins keeps the energy of the group
+    const float GroupScale = 1.0f / Decimation;
+    for (int32 WorkBin = 0; WorkBin < NumWorkBins; ++WorkBin) {
+        const int32 First = WorkBin * Decimation;
+        const int32 Last = FMath::Min(First + Decimation, NumBins);
+        float Energy = 0.0f;
+        for (int32 Bin = First; Bin < Last; ++Bin) {
+            Energy += Magnitudes[Bin] * Magnitudes[Bin];
+        }
+        Work[WorkBin] = FMath::Sqrt(Energy * GroupScale);
+    }
+
+    // Harmonic estimate: median of each bin over its last TimeMedianLength frames, newest included
+    const int32 HistoryOffset = HistoryWrite * NumWorkBins;
+    for (int32 WorkBin = 0; WorkBin < NumWorkBins; ++WorkBin) {
+        float& Oldest = TimeHistory[HistoryOffset + WorkBin];
+        float* Sorted = TimeSorted.GetData() + WorkBin * TimeMedianLength;
+
+        SortedReplace(Sorted, TimeMedianLength, Oldest, Work[WorkBin]);
+        Oldest = Work[WorkBin];
+
+        // Stash the harmonic median in the mask, it becomes the mask below
+        HarmonicMask[WorkBin] = Sorted[TimeMedianLength / 2];
+    }
+    HistoryWrite = (HistoryWrite + 1) % TimeMedianLength;
+
+    // Percussive estimate: median over FrequencyMedianLength bins centred on each bin, shorter at the edges
+    const int32 Radius = FrequencyMedianLength / 2;
+    float* Window = FrequencySorted.GetData();
+    int32 Count = 0;
+    for (int32 WorkBin = 0; WorkBin < FMath::Min(Radius, NumWorkBins); ++WorkBin) {
+        SortedInsert(Window, Count++, Work[WorkBin]);
+    }
+
+    double HarmonicEnergy[FAudioHarmonicPercussiveBands::NumBands] = {};
+    double PercussiveEnergy[FAudioHarmonicPercussiveBands::NumBands] = {};
+
+    for (int32 WorkBin = 0; WorkBin < NumWorkBins; ++WorkBin) {
+        const int32 Enter = WorkBin + Radius;
+        const int32 Leave = WorkBin - Radius - 1;
+
+        if (Enter < NumWorkBins && Leave >= 0) {
+            SortedReplace(Window, Count, Work[Leave], Work[Enter]);
+        } else if (Enter < NumWorkBins) {
+            SortedInsert(Window, Count++, Work[Enter]);
+        } else if (Leave >= 0) {
+            SortedRemove(Window, Count--, Work[Leave]);
+        }
+
+        const float Percussive = Window[Count / 2];
+        const float Harmonic = HarmonicMask[WorkBin];
+
+        // Soft masks, the two parts add up to the bin
+        const float HarmonicPower = Harmonic * Harmonic;
+        const float Mask = HarmonicPower / (HarmonicPower + Percussive * Percussive + MaskEpsilon);
+        HarmonicMask[WorkBin] = Mask;
+
+        const int32 Band = WorkBand[WorkBin];
+        if (Band >= 0) {
+            // Energy of the whole group: Work is its RMS
+            const float Energy = Work[WorkBin] * Work[WorkBin] * FMath::Min(Decimation, NumBins - WorkBin * Decimation);
+            HarmonicEnergy[Band] += Energy * Mask * Mask;
+            PercussiveEnergy[Band] += Energy * (1.0f - Mask) * (1.0f - Mask);
+        }
+    }
+
+    double TotalHarmonic = 0.0;
+    double TotalPercussive = 0.0;
+    for (int32 Band = 0; Band < FAudioHarmonicPercussiveBands::NumBands; ++Band) {
+        if (BinsPerBand[Band] > 0) {
+            OutBands.Harmonic[Band] = (float)FMath::Sqrt(HarmonicEnergy[Band] / BinsPerBand[Band]);
+            OutBands.Percussive[Band] = (float)FMath::Sqrt(PercussiveEnergy[Band] / BinsPerBand[Band]);
+        }
+        TotalHarmonic += HarmonicEnergy[Band];
+        TotalPercussive += PercussiveEnergy[Band];
+    }
+
+    OutBands.PercussiveRatio = TotalHarmonic + TotalPercussive > 0.0 ? float(TotalPercussive / (TotalHarmonic + TotalPercussive)) : 0.0f;
+    OutBands.bValid = true;
+}
+
+void FAudioHarmonicPercussiveSeparator::UpdateBudget(double Seconds)
+{
+    Stats.ProcessedFrames++;
+    Stats.TotalSeconds += Seconds;
+    Stats.OverBudgetFrames += BudgetSeconds > 0.0 && Seconds > BudgetSeconds ? 1 : 0;
+
+    SmoothedSeconds = SmoothedSeconds > 0.0 ? SmoothedSeconds * 0.9 + Seconds * 0.1 : Seconds;
+
+    if (BudgetSeconds <= 0.0 || FixedDecimation > 0) {
+        return;
+    }
+
+    // Halving or doubling the bins roughly halves or doubles the cost; the wide gap avoids flapping
+    if (SmoothedSeconds > BudgetSeconds && Decimation < MaxDecimation) {
+        Configure(NumBins, SampleRate, Decimation * 2);
+        SmoothedSeconds *= 0.5;
+    } else if (SmoothedSeconds < BudgetSeconds * 0.25 && Decimation > 1) {
+        Configure(NumBins, SampleRate, Decimation / 2);
+        SmoothedSeconds *= 2.0;
+    }
+}
@@ -0,0 +1,287 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioLevelMeter.h"
+#include "AudioVectorMath.h"
+
+namespace {
+// ITU-R BS.1770-4 annex 2, 4x oversampling interpolation filter, one row per phase
+const float TruePeakCoefficients[4][12] = {
+    { 0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f, -0.0594482421875f, 0.1373291015625f, 0.9721679687500f, -0.1022949218750f, 0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f, -0.1665039062500f, 0.4650878906250f, 0.7797851562500f, -0.2003173828125f, 0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f, -0.2003173828125f, 0.7797851562500f, 0.4650878906250f, -0.1665039062500f, 0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f, -0.1022949218750f, 0.9721679687500f, 0.1373291015625f, -0.0594482421875f, 0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f },
+};
+
+float PowerToLufs(double MeanSquare)
+{
+    if (MeanSquare <= 1e-10) {
+        return FAudioLevelMetrics::MinLoudnessLufs;
+    }
+    return FMath::Max(float(-0.691 + 10.0 * FMath::LogX(10.0f, float(MeanSquare))), FAudioLevelMetrics::MinLoudnessLufs);
+}
+
+float LinearToDb(float Value)
+{
+    return Value > 1e-6f ? 20.0f * FMath::LogX(10.0f, Value) : -120.0f;
+}
+}
+
+float FAudioLevelMetrics::GetMaxRms() const
+{
+    float Value = 0.0f;
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        Value = FMath::Max(Value, Rms[Channel]);
+    }
+    return Value;
+}
+
+float FAudioLevelMetrics::GetMaxPeak() const
+{
+    float Value = 0.0f;
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        Value = FMath::Max(Value, Peak[Channel]);
+    }
+    return Value;
+}
+
+float FAudioLevelMetrics::GetMaxTruePeak() const
+{
+    float Value = 0.0f;
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        Value = FMath::Max(Value, TruePeak[Channel]);
+    }
+    return Value;
+}
+
+float FAudioLevelMetrics::GetMaxCrestFactorDb() const
+{
+    float Value = 0.0f;
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        Value = FMath::Max(Value, CrestFactorDb[Channel]);
+    }
+    return Value;
+}
+
+FAudioLevelMeter::FAudioLevelMeter()
+    : SampleRate(0)
+    , NumInputChannels(0)
+    , NumChannels(0)
+    , FramesSinceConsume(0)
+    , LoudnessBlockFrames(0)
+    , FramesInLoudnessBlock(0)
+    , NextBlock(0)
+    , NumFilledBlocks(0)
+{
+    Configure(48000, 2);
+}
+
+void FAudioLevelMeter::Configure(int32 InSampleRate, int32 InNumChannels)
+{
+    SampleRate = FMath::Max(InSampleRate, 8000);
+    NumInputChannels = FMath::Max(InNumChannels, 1);
+    NumChannels = FMath::Min(NumInputChannels, FAudioLevelMetrics::MaxChannels);
+
+    // BS.1770 K-weighting for an arbitrary sample rate: high shelf (head effect) then high pass (RLB)
+    {
+        const double F0 = 1681.974450955533;
+        const double GainDb = 3.999843853973347;
+        const double Q = 0.7071752369554196;
+        const double K = FMath::Tan(PI * F0 / SampleRate);
+        const double Vh = FMath::Pow(10.0, GainDb / 20.0);
+        const double Vb = FMath::Pow(Vh, 0.4996667741545416);
+        const double A0 = 1.0 + K / Q + K * K;
+
+        Stages[0].B0 = (Vh + Vb * K / Q + K * K) / A0;
+        Stages[0].B1 = 2.0 * (K * K - Vh) / A0;
+        Stages[0].B2 = (Vh - Vb * K / Q + K * K) / A0;
+        Stages[0].A1 = 2.0 * (K * K - 1.0) / A0;
+        Stages[0].A2 = (1.0 - K / Q + K * K) / A0;
+    }
+    {
+        const double F0 = 38.13547087602444;
+        const double Q = 0.5003270373238773;
+        const double K = FMath::Tan(PI * F0 / SampleRate);
+        const double A0 = 1.0 + K / Q + K * K;
+
+        Stages[1].B0 = 1.0;
+        Stages[1].B1 = -2.0;
+        Stages[1].B2 = 1.0;
+        Stages[1].A1 = 2.0 * (K * K - 1.0) / A0;
+        Stages[1].A2 = (1.0 - K / Q + K * K) / A0;
+    }
+
+    // Surround channels count 1.41x, the LFE of a 5.1/7.1 layout not at all
+    for (int32 Channel = 0; Channel < FAudioLevelMetrics::MaxChannels; ++Channel) {
+        ChannelWeights[Channel] = 1.0f;
+        if (NumChannels >= 6) {
+            ChannelWeights[Channel] = Channel == 3 ? 0.0f : (Channel >= 4 ? 1.41f : 1.0f);
+        }
+    }
+
+    Channels.Reset();
+    Channels.SetNum(NumChannels);
+    for (FChannelState& State : Channels) {
+        State.TruePeakHistory.SetNumZeroed(TruePeakTaps - 1);
+    }
+
+    LoudnessBlockFrames = SampleRate / 10;
+    FramesInLoudnessBlock = 0;
+    FramesSinceConsume = 0;
+    NextBlock = 0;
+    NumFilledBlocks = 0;
+    FMemory::Memzero(BlockPower, sizeof(BlockPower));
+}
+
+void FAudioLevelMeter::ProcessInt16(const int16* Samples, int32 NumFrames)
+{
+    if (NumFrames <= 0) {
+        return;
+    }
+
+    DeinterleaveBuffer.SetNumUninitialized(NumFrames * NumChannels, false);
+
+    float* ChannelBuffers[FAudioLevelMetrics::MaxChannels];
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        ChannelBuffers[Channel] = DeinterleaveBuffer.GetData() + Channel * NumFrames;
+    }
+
+    if (Samples != nullptr) {
+        FAudioVectorMath::DeinterleaveInt16(Samples, NumFrames, NumInputChannels, NumChannels, ChannelBuffers);
+    } else {
+        FMemory::Memzero(DeinterleaveBuffer.GetData(), DeinterleaveBuffer.Num() * sizeof(float));
+    }
+
+    // Split on the 100 ms loudness block boundaries
+    int32 Offset = 0;
+    while (Offset < NumFrames) {
+        const int32 SegmentFrames = FMath::Min(NumFrames - Offset, LoudnessBlockFrames - FramesInLoudnessBlock);
+
+        for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+            ProcessChannel(Channel, ChannelBuffers[Channel] + Offset, SegmentFrames);
+        }
+
+        Offset += SegmentFrames;
+        FramesInLoudnessBlock += SegmentFrames;
+
+        if (FramesInLoudnessBlock >= LoudnessBlockFrames) {
+            CloseLoudnessBlock();
+        }
+    }
+
+    FramesSinceConsume += NumFrames;
+}
+
+void FAudioLevelMeter::ProcessChannel(int32 Channel, const float* Samples, int32 NumFrames)
+{
+    FChannelState& State = Channels[Channel];
+
+    float SumOfSquares;
+    float Peak;
+    FAudioVectorMath::SumOfSquaresAndPeak(Samples, NumFrames, SumOfSquares, Peak);
+    State.SumOfSquares += SumOfSquares;
+    State.Peak = FMath::Max(State.Peak, Peak);
+
+    // True peak: every input sample produces TruePeakPhases interpolated outputs
+    TArray<float>& History = State.TruePeakHistory;
+    History.SetNumUninitialized(TruePeakTaps - 1 + NumFrames, false);
+    FMemory::Memcpy(History.GetData() + TruePeakTaps - 1, Samples, NumFrames * sizeof(float));
+
+    // Taps stored oldest-first so each phase is a plain dot product over the history window. Built by the
+    // first meter to get here, the static's initialization is thread safe
+    struct FReversedCoefficients {
+        float Phases[TruePeakPhases][TruePeakTaps];
+    };
+    static const FReversedCoefficients ReversedCoefficients = []() {
+        FReversedCoefficients Reversed;
+        for (int32 Phase = 0; Phase < TruePeakPhases; ++Phase) {
+            for (int32 Tap = 0; Tap < TruePeakTaps; ++Tap) {
+                Reversed.Phases[Phase][Tap] = TruePeakCoefficients[Phase][TruePeakTaps - 1 - Tap];
+            }
+        }
+        return Reversed;
+    }();
+
+    float TruePeak = State.TruePeak;
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        const float* Window = History.GetData() + Frame;
+        for (int32 Phase = 0; Phase < TruePeakPhases; ++Phase) {
+            TruePeak = FMath::Max(TruePeak, FMath::Abs(FAudioVectorMath::DotProduct(Window, ReversedCoefficients.Phases[Phase], TruePeakTaps)));
+        }
+    }
+    State.TruePeak = FMath::Max(TruePeak, State.Peak);
+
+    // Keep the tail for the next block
+    FMemory::Memmove(History.GetData(), History.GetData() + NumFrames, (TruePeakTaps - 1) * sizeof(float));
+    History.SetNumUninitialized(TruePeakTaps - 1, false);
+
+    // K-weighting, recursive so it runs sample by sample
+    const FBiquad& Shelf = Stages[0];
+    const FBiquad& HighPass = Stages[1];
+    double WeightedSum = 0.0;
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        const double In = Samples[Frame];
+
+        const double Mid = Shelf.B0 * In + State.Z1[0];
+        State.Z1[0] = Shelf.B1 * In - Shelf.A1 * Mid + State.Z2[0];
+        State.Z2[0] = Shelf.B2 * In - Shelf.A2 * Mid;
+
+        const double Out = HighPass.B0 * Mid + State.Z1[1];
+        State.Z1[1] = HighPass.B1 * Mid - HighPass.A1 * Out + State.Z2[1];
+        State.Z2[1] = HighPass.B2 * Mid - HighPass.A2 * Out;
+
+        WeightedSum += Out * Out;
+    }
+    State.WeightedBlockSum += WeightedSum;
+}
+
+void FAudioLevelMeter::CloseLoudnessBlock()
+{
+    double Power = 0.0;
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        Power += ChannelWeights[Channel] * Channels[Channel].WeightedBlockSum / FMath::Max(FramesInLoudnessBlock, 1);
+        Channels[Channel].WeightedBlockSum = 0.0;
+    }
+
+    BlockPower[NextBlock] = Power;
+    NextBlock = (NextBlock + 1) % ShortTermBlocks;
+    NumFilledBlocks = FMath::Min(NumFilledBlocks + 1, ShortTermBlocks);
+    FramesInLoudnessBlock = 0;
+}
+
+float FAudioLevelMeter::GetLoudness(int32 NumBlocks) const
+{
+    if (NumFilledBlocks < NumBlocks) {
+        return FAudioLevelMetrics::MinLoudnessLufs;
+    }
+
+    double Sum = 0.0;
+    for (int32 Block = 1; Block <= NumBlocks; ++Block) {
+        Sum += BlockPower[(NextBlock - Block + ShortTermBlocks) % ShortTermBlocks];
+    }
+    return PowerToLufs(Sum / NumBlocks);
+}
+
+FAudioLevelMetrics FAudioLevelMeter::ConsumeMetrics()
+{
+    FAudioLevelMetrics Metrics;
+    Metrics.NumChannels = NumChannels;
+
+    for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+        FChannelState& State = Channels[Channel];
+
+        const float Rms = FramesSinceConsume > 0 ? FMath::Sqrt(float(State.SumOfSquares / FramesSinceConsume)) : 0.0f;
+        Metrics.Rms[Channel] = Rms;
+        Metrics.Peak[Channel] = State.Peak;
+        Metrics.TruePeak[Channel] = State.TruePeak;
+        Metrics.CrestFactorDb[Channel] = Rms > 0.0f ? LinearToDb(State.Peak) - LinearToDb(Rms) : 0.0f;
+
+        State.SumOfSquares = 0.0;
+        State.Peak = 0.0f;
+        State.TruePeak = 0.0f;
+    }
+
+    Metrics.MomentaryLufs = GetLoudness(MomentaryBlocks);
+    Metrics.ShortTermLufs = GetLoudness(ShortTermBlocks);
+
+    FramesSinceConsume = 0;
+    return Metrics;
+}
@@ -1,6 +1,8 @@
 //Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
 #include "AudioListener.h"
 #include "WindowsAudioCapture.h"
+#include "AudioCaptureDeadlineMonitor.h"
+#include <ksmedia.h>
 
 // #define SAFE_RELEASE(punk)  \
 // 			  if ((punk) != NULL)  \
@@ -11,33 +13,163 @@ HRESULT ThrowOrExit(HRESULT hr)
 	return hr;
 }
 
-AudioListener::AudioListener(int BitsPerSample, int FormatTag, int BlockAlign, int XSize)
+// Forwards default render device changes (and removal of the bound device) to the listener.
+// Callbacks arrive on an MMDevice thread, so they only raise an atomic flag.
+class AudioEndpointNotificationClient : public IMMNotificationClient
 {
-	// This might break if done more than once
-	CoInitialize(nullptr);
+public:
+	explicit AudioEndpointNotificationClient(AudioListener* InListener)
+		: m_refCount(1)
+		, m_pListener(InListener)
+	{
+	}
+
+	// IUnknown
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return InterlockedIncrement(&m_refCount);
+	}
+
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		const ULONG refCount = InterlockedDecrement(&m_refCount);
+		if (refCount == 0)
+		{
+			delete this;
+		}
+		return refCount;
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, VOID** ppvInterface) override
+	{
+		if (riid == IID_IUnknown || riid == __uuidof(IMMNotificationClient))
+		{
+			AddRef();
+			*ppvInterface = (IMMNotificationClient*)this;
+			return S_OK;
+		}
+
+		*ppvInterface = NULL;
+		return E_NOINTERFACE;
+	}
+
+	// IMMNotificationClient
+	HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDeviceId) override
+	{
+		if (flow == eRender && role == eConsole)
+		{
+			m_pListener->OnDefaultDeviceChanged();
+		}
+		return S_OK;
+	}
+
+	HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState) override
+	{
+		// Headphones unplugged etc. A capture failure would catch it too, but this is quicker
+		if (dwNewState != DEVICE_STATE_ACTIVE)
+		{
+			m_pListener->OnDeviceDeactivated(pwstrDeviceId);
+		}
+		return S_OK;
+	}
 
+	HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR pwstrDeviceId) override { return S_OK; }
+	HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR pwstrDeviceId) override { return S_OK; }
+	HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key) override { return S_OK; }
+
+private:
+	LONG m_refCount;
+	AudioListener* m_pListener;
+};
+
+AudioListener::AudioListener(int BitsPerSample, int FormatTag, int XSize)
+	: m_bitsPerSample(BitsPerSample)
+	, m_formatTag(FormatTag)
+	, m_xSize(XSize)
+{
+}
+
+AudioListener::~AudioListener()
+{
+	Shutdown();
+}
+
+void AudioListener::Shutdown()
+{
+	Close();
+
+	if (m_pEnumerator && m_pNotificationClient)
+	{
+		m_pEnumerator->UnregisterEndpointNotificationCallback(m_pNotificationClient);
+	}
+	SAFE_RELEASE(m_pNotificationClient);
+	SAFE_RELEASE(m_pEnumerator);
+}
+
+bool AudioListener::Open()
+{
+	if (IsOpen())
+		return true;
+
+	m_lastError = OpenDefaultEndpoint();
+	if (m_lastError)
+	{
+		UE_LOG(WindowsAudioCaptureLog, Verbose, TEXT("AudioListener: could not open the default render device (0x%08x)"), (uint32)m_lastError);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+HRESULT AudioListener::OpenDefaultEndpoint()
+{
 	HRESULT hr;
 	REFERENCE_TIME hnsRequestedDuration = m_refTimesPerSec;
 
-	hr = CoCreateInstance(m_CLSID_MMDeviceEnumerator, NULL, CLSCTX_ALL, m_IID_IMMDeviceEnumerator, (void**)&m_pEnumerator);
+	// The enumerator and the notification callback outlive device switches
+	if (m_pEnumerator == NULL)
+	{
+		hr = CoCreateInstance(m_CLSID_MMDeviceEnumerator, NULL, CLSCTX_ALL, m_IID_IMMDeviceEnumerator, (void**)&m_pEnumerator);
+		if (hr)	return ThrowOrExit(hr);
 
-	if (hr)	throw hr;
+		m_pNotificationClient = new AudioEndpointNotificationClient(this);
+		hr = m_pEnumerator->RegisterEndpointNotificationCallback(m_pNotificationClient);
+		if (hr)	return ThrowOrExit(hr);
+	}
 
 	hr = m_pEnumerator->GetDefaultAudioEndpoint(
 		//eCapture, eConsole, &pDevice); //set this to capture from default recording device instead of render device
 		eRender, eConsole, &m_pDevice);
-	if (hr)	throw hr;
+	if (hr)	return ThrowOrExit(hr);
+
+	LPWSTR pwszDeviceId = NULL;
+	if (m_pDevice->GetId(&pwszDeviceId) == S_OK)
+	{
+		FScopeLock lock(&m_deviceIdLock);
+		m_deviceId = pwszDeviceId;
+		CoTaskMemFree(pwszDeviceId);
+	}
 
 	hr = m_pDevice->Activate(m_IID_IAudioClient, CLSCTX_ALL, NULL, (void**)&m_pAudioClient);
-	if (hr)	throw hr;
+	if (hr)	return ThrowOrExit(hr);
 
 	hr = m_pAudioClient->GetMixFormat(&m_pwfx);
-	if (hr)	throw hr;
+	if (hr)	return ThrowOrExit(hr);
 
-	m_pwfx->wBitsPerSample = BitsPerSample;
-	m_pwfx->nBlockAlign = BlockAlign;
-	m_pwfx->wFormatTag = FormatTag;
-	m_pwfx->cbSize = XSize;
+	// 16-bit integer samples, keeping every channel of the mix format. Multichannel formats stay
+	// WAVEFORMATEXTENSIBLE so the speaker layout (and the channel order the analysis relies on) survives.
+	m_pwfx->wBitsPerSample = m_bitsPerSample;
+	m_pwfx->nBlockAlign = m_pwfx->nChannels * m_bitsPerSample / 8;
+	if (m_pwfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE && m_pwfx->nChannels > 2) {
+		WAVEFORMATEXTENSIBLE* pExtensible = (WAVEFORMATEXTENSIBLE*)m_pwfx;
+		pExtensible->SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
+		pExtensible->Samples.wValidBitsPerSample = m_bitsPerSample;
+	}
+	else {
+		m_pwfx->wFormatTag = m_formatTag;
+		m_pwfx->cbSize = m_xSize;
+	}
 	m_pwfx->nAvgBytesPerSec = m_pwfx->nSamplesPerSec * m_pwfx->nBlockAlign;
 
 	hr = m_pAudioClient->Initialize(
@@ -49,27 +181,96 @@ AudioListener::AudioListener(int BitsPerSample, int FormatTag, int BlockAlign, i
 		0,
 		m_pwfx,
 		NULL);
-	if (hr)	throw hr;
+	if (hr)	return ThrowOrExit(hr);
 
 	// Get the size of the allocated buffer.
 	hr = m_pAudioClient->GetBufferSize(&m_bufferFrameCount);
-	if (hr)	throw hr;
+	if (hr)	return ThrowOrExit(hr);
 
 	hr = m_pAudioClient->GetService(m_IID_IAudioCaptureClient, (void**)&m_pCaptureClient);
-	if (hr) throw hr;
-
+	if (hr) return ThrowOrExit(hr);
 
 	// Calculate the actual duration of the allocated buffer.
 	m_hnsActualDuration = (double)m_refTimesPerSec *
 		m_bufferFrameCount / m_pwfx->nSamplesPerSec;
+
+	m_bFormatChanged = true;
+
+	return S_OK;
 }
 
-AudioListener::~AudioListener()
+void AudioListener::Close()
 {
+	Stop();
+
+	CoTaskMemFree(m_pwfx);
+	m_pwfx = NULL;
+	SAFE_RELEASE(m_pCaptureClient);
+	SAFE_RELEASE(m_pAudioClient);
+	SAFE_RELEASE(m_pDevice);
 
+	FScopeLock lock(&m_deviceIdLock);
+	m_deviceId.Empty();
 }
 
-HRESULT AudioListener::RecordAudioStream(IAudioSink* Sink, bool& Done)
+void AudioListener::OnDefaultDeviceChanged()
+{
+	m_deviceChanged = true;
+}
+
+void AudioListener::OnDeviceDeactivated(const TCHAR* DeviceId)
+{
+	FScopeLock lock(&m_deviceIdLock);
+
+	if (DeviceId != NULL && m_deviceId.Equals(DeviceId))
+	{
+		m_deviceChanged = true;
+	}
+}
+
+bool AudioListener::Start()
+{
+	if (m_bStarted)
+		return true;
+
+	if (!IsOpen())
+		return false;
+
+	m_lastError = m_pAudioClient->Start();  // Start recording.
+	if (m_lastError)
+		return false;
+
+	m_bStarted = true;
+
+	// Nothing was drained while stopped, the first drain is not late
+	if (m_pMonitor != NULL)
+	{
+		m_pMonitor->Suspend();
+	}
+	return true;
+}
+
+bool AudioListener::Stop()
+{
+	if (!m_bStarted)
+		return true;
+
+	m_bStarted = false;
+
+	m_lastError = m_pAudioClient->Stop();  // Stop recording.
+	return m_lastError == S_OK;
+}
+
+uint32 AudioListener::GetPollIntervalMs() const
+{
+	// m_hnsActualDuration is expressed in milliseconds, sleep for half the buffer duration.
+	// While no device is bound the state machine retries at this rate too.
+	const uint32 HalfBufferMs = IsOpen() ? (uint32)(m_hnsActualDuration / 2) : 10;
+
+	return HalfBufferMs > 0 ? HalfBufferMs : 1;
+}
+
+bool AudioListener::CapturePackets(IAudioSink* Sink)
 {
 	HRESULT hr;
 	BYTE *pData;
@@ -77,53 +278,88 @@ HRESULT AudioListener::RecordAudioStream(IAudioSink* Sink, bool& Done)
 	UINT32 packetLength = 0;
 	UINT32 numFramesAvailable;
 
-	hr = m_pAudioClient->Start();  // Start recording.
-	if (hr) throw hr;
+	// AUDCLNT_E_DEVICE_INVALIDATED shows up here when the endpoint is removed
+	hr = m_pCaptureClient->GetNextPacketSize(&packetLength);
+	if (hr)
+	{
+		m_lastError = ThrowOrExit(hr);
+		return false;
+	}
 
-	// Each loop fills about half of the shared buffer.
-	while (!Done)
+	if (m_bFormatChanged)
 	{
-		// Sleep for half the buffer duration.
-		Sleep(m_hnsActualDuration / m_refTimesPerMS / 2);
+		Sink->SetFormat(m_pwfx->nSamplesPerSec, m_pwfx->nChannels, m_pwfx->wBitsPerSample);
+		m_bFormatChanged = false;
+	}
 
-		hr = m_pCaptureClient->GetNextPacketSize(&packetLength);
+	// Frames already waiting in the shared buffer: how close this wake came to an overflow
+	if (m_pMonitor != NULL)
+	{
+		UINT32 paddingFrames = 0;
+		if (m_pAudioClient->GetCurrentPadding(&paddingFrames) == S_OK)
+		{
+			m_pMonitor->BeginCapture(paddingFrames, m_bufferFrameCount, m_pwfx->nSamplesPerSec);
+		}
+	}
+
+	while (packetLength != 0)
+	{
+		// Get the available data in the shared buffer.
+		hr = m_pCaptureClient->GetBuffer(&pData, &numFramesAvailable, &flags, NULL, NULL);
 		if (hr)
-			return ThrowOrExit(hr);
+		{
+			m_lastError = ThrowOrExit(hr);
+			return false;
+		}
 
-		while (packetLength != 0)
+		const bool bDiscontinuity = (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) != 0;
+
+		// A silent packet carries no valid data, the sink handles NULL as silence without reading it
+		if (flags & AUDCLNT_BUFFERFLAGS_SILENT)
 		{
-			// Get the available data in the shared buffer.
-			hr = m_pCaptureClient->GetBuffer(&pData, &numFramesAvailable, &flags, NULL, NULL);
-			if (hr) throw hr;
-
-			if ((flags & AUDCLNT_BUFFERFLAGS_SILENT) || (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY))
-			{
-				for (UINT32 i = 0; i < numFramesAvailable; i++)
-				{
-					pData[i] = 0;
-				}
-			}
-
-			// Copy the available capture data to the audio sink.
-			hr = Sink->CopyData(pData, numFramesAvailable);
-			if (hr) throw hr;
-
-			hr = m_pCaptureClient->ReleaseBuffer(numFramesAvailable);
-			if (hr) throw hr;
-
-			hr = m_pCaptureClient->GetNextPacketSize(&packetLength);
-			if (hr) throw hr;
+			pData = NULL;
+		}
+		else if (bDiscontinuity)
+		{
+			FMemory::Memzero(pData, numFramesAvailable * m_pwfx->nBlockAlign);
 		}
-	}
 
-	hr = m_pAudioClient->Stop();  // Stop recording.
-	if (hr) throw hr;
+		// WASAPI dropped audio before this packet (the buffer overflowed, or the stream just started), so
+		// the frames analysed from here on do not follow on from the previous ones
+		if (bDiscontinuity)
+		{
+			Sink->MarkDiscontinuity();
+		}
 
-	CoTaskMemFree(m_pwfx);
-	SAFE_RELEASE(m_pEnumerator);
-	SAFE_RELEASE(m_pDevice);
-	SAFE_RELEASE(m_pAudioClient);
-	SAFE_RELEASE(m_pCaptureClient);
+		// Copy the available capture data to the audio sink.
+		const double sinkStart = m_pMonitor != NULL ? FPlatformTime::Seconds() : 0.0;
+		hr = Sink->CopyData(pData, numFramesAvailable);
 
-	return hr;
+		if (m_pMonitor != NULL)
+		{
+			m_pMonitor->AddPacket(bDiscontinuity, (flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR) != 0, FPlatformTime::Seconds() - sinkStart);
+		}
+		if (hr)
+		{
+			m_pCaptureClient->ReleaseBuffer(numFramesAvailable);
+			m_lastError = ThrowOrExit(hr);
+			return false;
+		}
+
+		hr = m_pCaptureClient->ReleaseBuffer(numFramesAvailable);
+		if (hr)
+		{
+			m_lastError = ThrowOrExit(hr);
+			return false;
+		}
+
+		hr = m_pCaptureClient->GetNextPacketSize(&packetLength);
+		if (hr)
+		{
+			m_lastError = ThrowOrExit(hr);
+			return false;
+		}
+	}
+
+	return true;
 }
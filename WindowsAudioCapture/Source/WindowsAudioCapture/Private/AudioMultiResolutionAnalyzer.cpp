@@ -0,0 +1,217 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioMultiResolutionAnalyzer.h"
+#include "AudioVectorMath.h"
+#include "WindowsAudioCaptureMemory.h"
+
+namespace {
+// Taps per decimation step, the filter is DecimationFactor * TapsPerPhase long
+constexpr int32 TapsPerPhase = 16;
+
+void MakeHannWindow(TArray<float>& Window, int32 Size)
+{
+    Window.SetNumUninitialized(Size);
+    for (int32 Index = 0; Index < Size; ++Index) {
+        Window[Index] = 0.5f * (1.0f - FMath::Cos(2.0f * PI * Index / (Size - 1)));
+    }
+}
+}
+
+float FAudioMultiResolutionSettings::GetBandEdge(int32 Band) const
+{
+    return MinFrequency * FMath::Pow(MaxFrequency / MinFrequency, float(Band) / NumBands);
+}
+
+float FAudioMultiResolutionSettings::GetBandFrequency(int32 Band) const
+{
+    return MinFrequency * FMath::Pow(MaxFrequency / MinFrequency, (Band + 0.5f) / NumBands);
+}
+
+FAudioMultiResolutionAnalyzer::FAudioMultiResolutionAnalyzer()
+    : SampleRate(0)
+    , NumChannels(0)
+    , DecimatorWrite(0)
+    , DecimatorPhase(0)
+    , ShortWrite(0)
+    , LongWrite(0)
+    , ShortConfig(nullptr)
+    , LongConfig(nullptr)
+{
+}
+
+FAudioMultiResolutionAnalyzer::~FAudioMultiResolutionAnalyzer()
+{
+    Release();
+}
+
+void FAudioMultiResolutionAnalyzer::Release()
+{
+    if (ShortConfig != nullptr) {
+        FWindowsAudioCaptureMemory::FreeFftr(ShortConfig);
+        ShortConfig = nullptr;
+    }
+    if (LongConfig != nullptr) {
+        FWindowsAudioCaptureMemory::FreeFftr(LongConfig);
+        LongConfig = nullptr;
+    }
+}
+
+void FAudioMultiResolutionAnalyzer::Configure(int32 InSampleRate, int32 InNumChannels, const FAudioMultiResolutionSettings& InSettings)
+{
+    Release();
+
+    Settings = InSettings;
+    SampleRate = FMath::Max(InSampleRate, 8000);
+    NumChannels = FMath::Max(InNumChannels, 1);
+
+    // Windowed-sinc low pass with its cutoff at 90% of the decimated Nyquist frequency
+    const int32 Factor = FMath::Max(Settings.DecimationFactor, 1);
+    const int32 NumTaps = Factor * TapsPerPhase;
+    const float Cutoff = 0.9f * 0.5f / Factor;
+    DecimatorTaps.SetNumUninitialized(NumTaps);
+
+    float Sum = 0.0f;
+    for (int32 Tap = 0; Tap < NumTaps; ++Tap) {
+        const float Centered = Tap - (NumTaps - 1) * 0.5f;
+        const float Sinc = Centered == 0.0f ? 2.0f * Cutoff : FMath::Sin(2.0f * PI * Cutoff * Centered) / (PI * Centered);
+        const float Phase = 2.0f * PI * Tap / (NumTaps - 1);
+        const float Blackman = 0.42f - 0.5f * FMath::Cos(Phase) + 0.08f * FMath::Cos(2.0f * Phase);
+        DecimatorTaps[Tap] = Sinc * Blackman;
+        Sum += DecimatorTaps[Tap];
+    }
+    for (float& Tap : DecimatorTaps) {
+        Tap /= Sum;
+    }
+
+    DecimatorDelay.SetNumZeroed(NumTaps * 2);
+    DecimatorWrite = 0;
+    DecimatorPhase = 0;
+
+    ShortRing.SetNumZeroed(Settings.ShortWindow * 2);
+    ShortWrite = 0;
+    LongRing.SetNumZeroed(Settings.LongWindow * 2);
+    LongWrite = 0;
+
+    MakeHannWindow(ShortWindow, Settings.ShortWindow);
+    MakeHannWindow(LongWindow, Settings.LongWindow);
+
+    ShortConfig = FWindowsAudioCaptureMemory::AllocFftr(Settings.ShortWindow, false);
+    LongConfig = FWindowsAudioCaptureMemory::AllocFftr(Settings.LongWindow, false);
+}
+
+void FAudioMultiResolutionAnalyzer::PushInt16(const int16* Samples, int32 NumFrames)
+{
+    if (!IsConfigured()) {
+        return;
+    }
+
+    if (Samples == nullptr) {
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            PushSample(0.0f);
+        }
+        return;
+    }
+
+    const float Scale = 1.0f / NumChannels;
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        int32 Sum = 0;
+        for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+            Sum += Samples[Frame * NumChannels + Channel];
+        }
+        PushSample(Sum * Scale);
+    }
+}
+
+void FAudioMultiResolutionAnalyzer::PushSample(float Sample)
+{
+    const int32 ShortSize = Settings.ShortWindow;
+    ShortRing[ShortWrite] = Sample;
+    ShortRing[ShortWrite + ShortSize] = Sample;
+    ShortWrite = (ShortWrite + 1) % ShortSize;
+
+    const int32 NumTaps = DecimatorTaps.Num();
+    DecimatorDelay[DecimatorWrite] = Sample;
+    DecimatorDelay[DecimatorWrite + NumTaps] = Sample;
+    DecimatorWrite = (DecimatorWrite + 1) % NumTaps;
+
+    // Only every DecimationFactor-th output is kept, so only those are computed
+    if (++DecimatorPhase < Settings.DecimationFactor) {
+        return;
+    }
+    DecimatorPhase = 0;
+
+    const float Decimated = FAudioVectorMath::DotProduct(&DecimatorDelay[DecimatorWrite], DecimatorTaps.GetData(), NumTaps);
+
+    const int32 LongSize = Settings.LongWindow;
+    LongRing[LongWrite] = Decimated;
+    LongRing[LongWrite + LongSize] = Decimated;
+    LongWrite = (LongWrite + 1) % LongSize;
+}
+
+void FAudioMultiResolutionAnalyzer::AnalyzeWindow(kiss_fftr_cfg Config, const TArray<float>& Window, const TArray<float>& Ring, int32 RingStart, TArray<float>& OutMagnitudes)
+{
+    const int32 Size = Window.Num();
+
+    FftInput.SetNumUninitialized(Size, false);
+    const float* Newest = Ring.GetData() + RingStart;
+    float WindowSum = 0.0f;
+    for (int32 Index = 0; Index < Size; ++Index) {
+        FftInput[Index] = Newest[Index] * Window[Index];
+        WindowSum += Window[Index];
+    }
+
+    FftOutput.SetNumUninitialized(Size / 2 + 1, false);
+    kiss_fftr(Config, FftInput.GetData(), FftOutput.GetData());
+
+    // Amplitude normalisation: a sine of amplitude A peaks at A whatever the window length
+    const float Scale = 2.0f / WindowSum;
+    OutMagnitudes.SetNumUninitialized(Size / 2 + 1, false);
+    for (int32 Bin = 0; Bin <= Size / 2; ++Bin) {
+        OutMagnitudes[Bin] = FMath::Sqrt(FMath::Square(FftOutput[Bin].r) + FMath::Square(FftOutput[Bin].i)) * Scale;
+    }
+}
+
+float FAudioMultiResolutionAnalyzer::GetBandValue(const TArray<float>& Magnitudes, float BinWidth, float LowFrequency, float HighFrequency, float CentreFrequency)
+{
+    const int32 LastBin = Magnitudes.Num() - 1;
+    const int32 FirstInside = FMath::CeilToInt(LowFrequency / BinWidth);
+    const int32 LastInside = FMath::Min(FMath::CeilToInt(HighFrequency / BinWidth) - 1, LastBin);
+
+    if (FirstInside <= LastInside) {
+        float Value = 0.0f;
+        for (int32 Bin = FirstInside; Bin <= LastInside; ++Bin) {
+            Value = FMath::Max(Value, Magnitudes[Bin]);
+        }
+        return Value;
+    }
+
+    // Band narrower than a bin
+    const float Position = FMath::Clamp(CentreFrequency / BinWidth, 0.0f, float(LastBin));
+    const int32 Below = FMath::Min(FMath::FloorToInt(Position), LastBin - 1);
+    const float Alpha = Position - Below;
+    return Magnitudes[Below] + (Magnitudes[Below + 1] - Magnitudes[Below]) * Alpha;
+}
+
+void FAudioMultiResolutionAnalyzer::Analyze(TArray<float>& OutBands)
+{
+    OutBands.SetNumZeroed(Settings.NumBands);
+
+    if (!IsConfigured()) {
+        return;
+    }
+
+    AnalyzeWindow(ShortConfig, ShortWindow, ShortRing, ShortWrite, ShortMagnitudes);
+    AnalyzeWindow(LongConfig, LongWindow, LongRing, LongWrite, LongMagnitudes);
+
+    const float ShortBinWidth = float(SampleRate) / Settings.ShortWindow;
+    const float LongBinWidth = float(SampleRate) / Settings.DecimationFactor / Settings.LongWindow;
+
+    for (int32 Band = 0; Band < Settings.NumBands; ++Band) {
+        const float Low = Settings.GetBandEdge(Band);
+        const float High = Settings.GetBandEdge(Band + 1);
+        const float Centre = Settings.GetBandFrequency(Band);
+
+        OutBands[Band] = Centre < Settings.CrossoverFrequency
+            ? GetBandValue(LongMagnitudes, LongBinWidth, Low, High, Centre)
+            : GetBandValue(ShortMagnitudes, ShortBinWidth, Low, High, Centre);
+    }
+}
@@ -0,0 +1,186 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioMusicFeatures.h"
+#include "AudioConstantQ.h"
+#include "WindowsAudioCaptureMemory.h"
+
+FAudioConstantQSettings FAudioMusicFeatures::GetChromaLayout()
+{
+    return FAudioConstantQSettings(12, 32.7032f, 3951.066f);
+}
+
+void FAudioMusicFeatures::FoldChroma(const float* ConstantQMagnitudes, int32 NumBins)
+{
+    FMemory::Memzero(Chroma, sizeof(Chroma));
+
+    // Bin 0 is C1, so the bin index modulo 12 is the pitch class
+    for (int32 Bin = 0; Bin < NumBins; ++Bin) {
+        Chroma[Bin % NumPitchClasses] += ConstantQMagnitudes[Bin] * ConstantQMagnitudes[Bin];
+    }
+
+    float Max = 0.0f;
+    for (float Value : Chroma) {
+        Max = FMath::Max(Max, Value);
+    }
+
+    if (Max > 0.0f) {
+        for (float& Value : Chroma) {
+            Value /= Max;
+        }
+    }
+}
+
+FAudioPitchDetector::FAudioPitchDetector()
+    : SampleRate(0)
+    , NumChannels(0)
+    , RingWrite(0)
+    , ForwardConfig(nullptr)
+    , InverseConfig(nullptr)
+{
+}
+
+FAudioPitchDetector::~FAudioPitchDetector()
+{
+    Release();
+}
+
+void FAudioPitchDetector::Release()
+{
+    if (ForwardConfig != nullptr) {
+        FWindowsAudioCaptureMemory::FreeFftr(ForwardConfig);
+        ForwardConfig = nullptr;
+    }
+    if (InverseConfig != nullptr) {
+        FWindowsAudioCaptureMemory::FreeFftr(InverseConfig);
+        InverseConfig = nullptr;
+    }
+}
+
+void FAudioPitchDetector::Configure(int32 InSampleRate, int32 InNumChannels)
+{
+    Release();
+
+    SampleRate = FMath::Max(InSampleRate, 8000);
+    NumChannels = FMath::Max(InNumChannels, 1);
+
+    Ring.SetNumZeroed(WindowSize * 2);
+    RingWrite = 0;
+
+    // The first half is correlated against the whole window, lags up to half the window never wrap
+    ForwardConfig = FWindowsAudioCaptureMemory::AllocFftr(WindowSize, false);
+    InverseConfig = FWindowsAudioCaptureMemory::AllocFftr(WindowSize, true);
+
+    Head.SetNumZeroed(WindowSize);
+    HeadSpectrum.SetNumUninitialized(WindowSize / 2 + 1);
+    Spectrum.SetNumUninitialized(WindowSize / 2 + 1);
+    Correlation.SetNumUninitialized(WindowSize);
+    Difference.SetNumUninitialized(WindowSize / 2 + 1);
+}
+
+void FAudioPitchDetector::PushInt16(const int16* Samples, int32 NumFrames)
+{
+    if (!IsConfigured()) {
+        return;
+    }
+
+    const float Scale = 1.0f / (32768.0f * NumChannels);
+
+    for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+        float Value = 0.0f;
+        if (Samples != nullptr) {
+            int32 Sum = 0;
+            for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+                Sum += Samples[Frame * NumChannels + Channel];
+            }
+            Value = Sum * Scale;
+        }
+
+        Ring[RingWrite] = Value;
+        Ring[RingWrite + WindowSize] = Value;
+        RingWrite = (RingWrite + 1) % WindowSize;
+    }
+}
+
+void FAudioPitchDetector::Detect(FAudioMusicFeatures& Features)
+{
+    Features.PitchHz = 0.0f;
+    Features.PitchConfidence = 0.0f;
+    Features.MidiNote = 0.0f;
+
+    if (!IsConfigured()) {
+        return;
+    }
+
+    const float* Window = Ring.GetData() + RingWrite;
+    const int32 MaxLag = WindowSize / 2;
+
+    float EnergyHead = 0.0f;
+    for (int32 Index = 0; Index < MaxLag; ++Index) {
+        EnergyHead += Window[Index] * Window[Index];
+    }
+
+    if (EnergyHead < 1e-7f * MaxLag) {
+        return;
+    }
+
+    // r(tau) = sum over the first half of x[j] * x[j + tau] = IFFT(conj(FFT(head)) * FFT(window)).
+    // kiss leaves the inverse unscaled by 1/N.
+    FMemory::Memcpy(Head.GetData(), Window, MaxLag * sizeof(float));
+    kiss_fftr(ForwardConfig, Head.GetData(), HeadSpectrum.GetData());
+    kiss_fftr(ForwardConfig, Window, Spectrum.GetData());
+
+    for (int32 Bin = 0; Bin < Spectrum.Num(); ++Bin) {
+        const kiss_fft_cpx A = HeadSpectrum[Bin];
+        const kiss_fft_cpx B = Spectrum[Bin];
+        Spectrum[Bin].r = A.r * B.r + A.i * B.i;
+        Spectrum[Bin].i = A.r * B.i - A.i * B.r;
+    }
+    kiss_fftri(InverseConfig, Spectrum.GetData(), Correlation.GetData());
+
+    const float Normalize = 1.0f / WindowSize;
+
+    // YIN difference over the first half of the window: d(tau) = e(0) + e(tau) - 2 r(tau), where e(tau)
+    // is the energy of the half window starting at tau
+
+    float EnergyShifted = EnergyHead;
+    float RunningSum = 0.0f;
+    Difference[0] = 1.0f;
+
+    for (int32 Lag = 1; Lag <= MaxLag; ++Lag) {
+        EnergyShifted += Window[Lag + MaxLag - 1] * Window[Lag + MaxLag - 1] - Window[Lag - 1] * Window[Lag - 1];
+        const float Raw = FMath::Max(EnergyHead + EnergyShifted - 2.0f * Correlation[Lag] * Normalize, 0.0f);
+
+        // Cumulative mean normalized difference
+        RunningSum += Raw;
+        Difference[Lag] = RunningSum > 0.0f ? Raw * Lag / RunningSum : 1.0f;
+    }
+
+    const int32 MinLag = FMath::Max(FMath::FloorToInt(SampleRate / MaxPitchHz), 2);
+    const int32 LastLag = FMath::Min(FMath::CeilToInt(SampleRate / MinPitchHz), MaxLag - 1);
+
+    int32 BestLag = INDEX_NONE;
+    for (int32 Lag = MinLag; Lag <= LastLag; ++Lag) {
+        if (Difference[Lag] < Threshold) {
+            // Walk down to the bottom of this dip
+            while (Lag + 1 <= LastLag && Difference[Lag + 1] < Difference[Lag]) {
+                ++Lag;
+            }
+            BestLag = Lag;
+            break;
+        }
+    }
+
+    if (BestLag == INDEX_NONE) {
+        return;
+    }
+
+    // Parabolic interpolation around the minimum
+    const float Left = Difference[BestLag - 1];
+    const float Centre = Difference[BestLag];
+    const float Right = Difference[BestLag + 1];
+    const float Denominator = Left - 2.0f * Centre + Right;
+    const float Offset = FMath::Abs(Denominator) > 1e-9f ? FMath::Clamp(0.5f * (Left - Right) / Denominator, -0.5f, 0.5f) : 0.0f;
+
+    Features.PitchHz = SampleRate / (BestLag + Offset);
+    Features.PitchConfidence = FMath::Clamp(1.0f - Centre, 0.0f, 1.0f);
+    Features.MidiNote = 69.0f + 12.0f * FMath::Log2(Features.PitchHz / 440.0f);
+}
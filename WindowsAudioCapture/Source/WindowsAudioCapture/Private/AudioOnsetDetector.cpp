@@ -0,0 +1,111 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioOnsetDetector.h"
+
+namespace {
+const float BroadBandEdges[FAudioBandOnsets::NumBands + 1] = { 20.0f, 150.0f, 1000.0f, 6000.0f, 20000.0f };
+
+// Same compression as the feature file onsets, so live and offline strengths compare
+constexpr float FluxCompression = 1.0f / 32.0f;
+}
+
+float FAudioBandOnsets::GetBandEdge(int32 Band)
+{
+    return BroadBandEdges[FMath::Clamp(Band, 0, NumBands)];
+}
+
+FAudioOnsetDetector::FAudioOnsetDetector()
+    : NumHistoryHops(0)
+    , HopIndex(0)
+{
+    FMemory::Memzero(BandsPerBroadBand, sizeof(BandsPerBroadBand));
+    FMemory::Memzero(OnsetCount, sizeof(OnsetCount));
+    FMemory::Memzero(LastOnsetHop, sizeof(LastOnsetHop));
+}
+
+void FAudioOnsetDetector::Configure(const FAudioMultiResolutionSettings& InBandSettings, const FAudioOnsetSettings& InSettings)
+{
+    Settings = InSettings;
+    Settings.MeanHops = FMath::Max(Settings.MeanHops, 1);
+
+    BandOf.SetNumUninitialized(InBandSettings.NumBands);
+    FMemory::Memzero(BandsPerBroadBand, sizeof(BandsPerBroadBand));
+
+    for (int32 Band = 0; Band < InBandSettings.NumBands; ++Band) {
+        const float Frequency = InBandSettings.GetBandFrequency(Band);
+        BandOf[Band] = INDEX_NONE;
+
+        for (int32 BroadBand = 0; BroadBand < FAudioBandOnsets::NumBands; ++BroadBand) {
+            if (Frequency >= BroadBandEdges[BroadBand] && Frequency < BroadBandEdges[BroadBand + 1]) {
+                BandOf[Band] = BroadBand;
+                BandsPerBroadBand[BroadBand]++;
+                break;
+            }
+        }
+    }
+
+    PreviousLogBands.SetNumZeroed(InBandSettings.NumBands);
+    FluxHistory.SetNumZeroed(Settings.MeanHops * FAudioBandOnsets::NumBands);
+    Reset();
+}
+
+void FAudioOnsetDetector::Reset()
+{
+    FMemory::Memzero(PreviousLogBands.GetData(), PreviousLogBands.Num() * sizeof(float));
+    FMemory::Memzero(FluxHistory.GetData(), FluxHistory.Num() * sizeof(float));
+    NumHistoryHops = 0;
+}
+
+void FAudioOnsetDetector::Process(const float* Bands, int32 NumBands, FAudioBandOnsets& OutOnsets)
+{
+    OutOnsets = FAudioBandOnsets();
+
+    if (!IsConfigured() || Bands == nullptr) {
+        return;
+    }
+
+    float Energy[FAudioBandOnsets::NumBands] = {};
+    float Flux[FAudioBandOnsets::NumBands] = {};
+
+    NumBands = FMath::Min(NumBands, BandOf.Num());
+    for (int32 Band = 0; Band < NumBands; ++Band) {
+        const float LogBand = FMath::Loge(1.0f + Bands[Band] * FluxCompression);
+        const int32 BroadBand = BandOf[Band];
+
+        if (BroadBand != INDEX_NONE) {
+            Energy[BroadBand] += Bands[Band] * Bands[Band];
+            Flux[BroadBand] += FMath::Max(0.0f, LogBand - PreviousLogBands[Band]);
+        }
+        PreviousLogBands[Band] = LogBand;
+    }
+
+    const int32 HistorySlot = (int32)(HopIndex % Settings.MeanHops);
+
+    for (int32 BroadBand = 0; BroadBand < FAudioBandOnsets::NumBands; ++BroadBand) {
+        const int32 Count = FMath::Max(BandsPerBroadBand[BroadBand], 1);
+        const float BandFlux = Flux[BroadBand] / Count;
+
+        float* History = FluxHistory.GetData() + BroadBand * Settings.MeanHops;
+        // Slots not written since Reset hold 0, so summing all of them sums the valid ones
+        float Mean = 0.0f;
+        for (int32 Hop = 0; Hop < Settings.MeanHops; ++Hop) {
+            Mean += History[Hop];
+        }
+        Mean = NumHistoryHops > 0 ? Mean / NumHistoryHops : 0.0f;
+
+        if (BandFlux > 0.0f && BandFlux >= Mean * Settings.Threshold + Settings.Delta
+            && (OnsetCount[BroadBand] == 0 || HopIndex - LastOnsetHop[BroadBand] > (uint64)Settings.MinIntervalHops)) {
+            OnsetCount[BroadBand]++;
+            LastOnsetHop[BroadBand] = HopIndex;
+        }
+
+        History[HistorySlot] = BandFlux;
+
+        OutOnsets.Energy[BroadBand] = FMath::Sqrt(Energy[BroadBand] / Count);
+        OutOnsets.Strength[BroadBand] = BandFlux;
+        OutOnsets.OnsetCount[BroadBand] = OnsetCount[BroadBand];
+    }
+
+    NumHistoryHops = FMath::Min(NumHistoryHops + 1, Settings.MeanHops);
+    HopIndex++;
+    OutOnsets.bValid = true;
+}
@@ -0,0 +1,210 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioPolyphaseResampler.h"
+#include "AudioVectorMath.h"
+
+namespace {
+// Modified Bessel function of the first kind, order 0, for the Kaiser window
+double BesselI0(double X)
+{
+    double Sum = 1.0;
+    double Term = 1.0;
+    const double HalfX = X * 0.5;
+    for (int32 K = 1; K < 64; ++K) {
+        Term *= (HalfX / K) * (HalfX / K);
+        Sum += Term;
+        if (Term < Sum * 1e-12) {
+            break;
+        }
+    }
+    return Sum;
+}
+
+int32 GreatestCommonDivisor(int32 A, int32 B)
+{
+    while (B != 0) {
+        const int32 Remainder = A % B;
+        A = B;
+        B = Remainder;
+    }
+    return A;
+}
+}
+
+FAudioPolyphaseResampler::FAudioPolyphaseResampler()
+    : InputRate(0)
+    , OutputRate(0)
+    , NumChannels(0)
+    , Up(1)
+    , Down(1)
+    , NumTaps(0)
+    , InputIndex(0)
+    , Phase(0)
+{
+}
+
+void FAudioPolyphaseResampler::Configure(int32 InInputRate, int32 InOutputRate, int32 InNumChannels, const FAudioPolyphaseResamplerSettings& InSettings)
+{
+    InInputRate = FMath::Max(InInputRate, 1);
+    InOutputRate = FMath::Max(InOutputRate, 1);
+    InNumChannels = FMath::Max(InNumChannels, 1);
+
+    if (InInputRate == InputRate && InOutputRate == OutputRate && InNumChannels == NumChannels
+        && InSettings.HalfZeroCrossings == Settings.HalfZeroCrossings && InSettings.Cutoff == Settings.Cutoff && InSettings.KaiserBeta == Settings.KaiserBeta) {
+        return;
+    }
+
+    InputRate = InInputRate;
+    OutputRate = InOutputRate;
+    NumChannels = InNumChannels;
+    Settings = InSettings;
+    Settings.HalfZeroCrossings = FMath::Max(Settings.HalfZeroCrossings, 1);
+    Settings.Cutoff = FMath::Clamp(Settings.Cutoff, 0.1f, 1.0f);
+
+    const int32 Divisor = GreatestCommonDivisor(OutputRate, InputRate);
+    Up = OutputRate / Divisor;
+    Down = InputRate / Divisor;
+
+    BuildPhases();
+
+    Channels.SetNum(NumChannels);
+    Reset();
+}
+
+void FAudioPolyphaseResampler::BuildPhases()
+{
+    if (IsBypassed()) {
+        NumTaps = 0;
+        Phases.Empty();
+        return;
+    }
+
+    // The sinc is as wide as the lower rate needs, which for a decimation spans Down / Up input samples per zero crossing
+    const double Stretch = FMath::Max(1.0, (double)Down / Up);
+    NumTaps = Align((int32)FMath::CeilToDouble(2.0 * Settings.HalfZeroCrossings * Stretch), 4);
+
+    // Prototype at the upsampled rate InputRate * Up, cutoff relative to it
+    const int32 Length = NumTaps * Up;
+    const double Center = (Length - 1) * 0.5;
+    const double CutoffCycles = Settings.Cutoff * 0.5 / (Up * Stretch);
+    const double WindowNorm = 1.0 / BesselI0(Settings.KaiserBeta);
+
+    Phases.SetNumUninitialized(Length);
+
+    for (int32 PhaseIndex = 0; PhaseIndex < Up; ++PhaseIndex) {
+        float* PhaseTaps = Phases.GetData() + PhaseIndex * NumTaps;
+        double Sum = 0.0;
+
+        for (int32 Tap = 0; Tap < NumTaps; ++Tap) {
+            const int32 N = PhaseIndex + (NumTaps - 1 - Tap) * Up;
+            const double Offset = N - Center;
+
+            const double X = 2.0 * CutoffCycles * Offset;
+            const double Sinc = FMath::Abs(X) < 1e-9 ? 1.0 : FMath::Sin(PI * X) / (PI * X);
+
+            const double R = Offset / (Length * 0.5);
+            const double Window = BesselI0(Settings.KaiserBeta * FMath::Sqrt(FMath::Max(0.0, 1.0 - R * R))) * WindowNorm;
+
+            const double Coefficient = Sinc * Window;
+            PhaseTaps[Tap] = (float)Coefficient;
+            Sum += Coefficient;
+        }
+
+        // Unity gain at DC for every phase, so a constant input stays constant whatever the phase
+        const float Scale = Sum != 0.0 ? (float)(1.0 / Sum) : 0.0f;
+        FAudioVectorMath::Multiply(PhaseTaps, Scale, PhaseTaps, NumTaps);
+    }
+}
+
+void FAudioPolyphaseResampler::Reset()
+{
+    const int32 History = FMath::Max(NumTaps - 1, 0);
+    for (TArray<float>& Channel : Channels) {
+        Channel.SetNumZeroed(History);
+    }
+
+    InputIndex = 0;
+    Phase = 0;
+}
+
+int32 FAudioPolyphaseResampler::CountOutputFrames(int32 NumFrames) const
+{
+    // Outputs M = 0, 1, ... are at upsampled position Phase + M * Down past InputIndex, the last one
+    // still needs an input frame of this block
+    const int64 Available = ((int64)NumFrames - InputIndex) * Up - Phase;
+    return Available > 0 ? (int32)((Available + Down - 1) / Down) : 0;
+}
+
+int32 FAudioPolyphaseResampler::Process(const int16* In, int32 NumFrames, TArray<int16>& Out)
+{
+    if (!IsConfigured() || NumFrames <= 0) {
+        Out.Reset();
+        return 0;
+    }
+
+    if (IsBypassed()) {
+        Out.SetNumUninitialized(NumFrames * NumChannels);
+        FMemory::Memcpy(Out.GetData(), In, NumFrames * NumChannels * sizeof(int16));
+        return NumFrames;
+    }
+
+    const int32 History = NumTaps - 1;
+
+    // Appends the new frames behind the history of every channel
+    TArray<float*, TInlineAllocator<8>> ChannelInputs;
+    for (TArray<float>& Channel : Channels) {
+        Channel.SetNumUninitialized(History + NumFrames, false);
+        ChannelInputs.Add(Channel.GetData() + History);
+    }
+    FAudioVectorMath::DeinterleaveInt16(In, NumFrames, NumChannels, ChannelInputs.GetData());
+
+    const int32 NumOutput = CountOutputFrames(NumFrames);
+    Out.SetNumUninitialized(NumOutput * NumChannels);
+    int16* OutData = Out.GetData();
+
+    for (int32 Output = 0; Output < NumOutput; ++Output) {
+        const float* PhaseTaps = Phases.GetData() + Phase * NumTaps;
+
+        // The window ends at input frame InputIndex, which sits at History + InputIndex
+        for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+            const float Value = FAudioVectorMath::DotProduct(Channels[Channel].GetData() + InputIndex, PhaseTaps, NumTaps);
+            OutData[Output * NumChannels + Channel] = (int16)FMath::Clamp(FMath::RoundToInt(Value * 32768.0f), -32768, 32767);
+        }
+
+        Phase += Down;
+        InputIndex += Phase / Up;
+        Phase %= Up;
+    }
+
+    // The last History frames become the history of the next call
+    for (TArray<float>& Channel : Channels) {
+        FMemory::Memmove(Channel.GetData(), Channel.GetData() + NumFrames, History * sizeof(float));
+        Channel.SetNum(History, false);
+    }
+    InputIndex -= NumFrames;
+
+    return NumOutput;
+}
+
+int32 FAudioPolyphaseResampler::Skip(int32 NumFrames)
+{
+    if (!IsConfigured() || NumFrames <= 0) {
+        return 0;
+    }
+
+    if (IsBypassed()) {
+        return NumFrames;
+    }
+
+    const int32 NumOutput = CountOutputFrames(NumFrames);
+
+    const int64 Position = Phase + (int64)NumOutput * Down;
+    InputIndex += (int32)(Position / Up) - NumFrames;
+    Phase = (int32)(Position % Up);
+
+    // The history ends in the skipped silence
+    for (TArray<float>& Channel : Channels) {
+        FMemory::Memzero(Channel.GetData(), Channel.Num() * sizeof(float));
+    }
+
+    return NumOutput;
+}
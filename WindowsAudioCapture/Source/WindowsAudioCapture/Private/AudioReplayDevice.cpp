@@ -0,0 +1,139 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioReplayDevice.h"
+#include "WindowsAudioCapture.h"
+
+FAudioReplayDevice::FAudioReplayDevice()
+    : bLoop(false)
+    , PendingChunk()
+    , bHasPending(false)
+    , ClockOffset(0.0)
+    , StoppedAtSeconds(0.0)
+    , bStarted(false)
+    , bFinished(false)
+    , bFormatSent(false)
+    , SentFormat()
+{
+}
+
+void FAudioReplayDevice::SetRecording(const FString& InPath, bool bInLoop)
+{
+    Path = InPath;
+    bLoop = bInLoop;
+}
+
+bool FAudioReplayDevice::Open()
+{
+    Close();
+
+    FString error;
+    if (Path.IsEmpty() || !Reader.Open(Path, error)) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioReplayDevice: %s"), Path.IsEmpty() ? TEXT("no recording set") : *error);
+        return false;
+    }
+
+    // Start from the first keyframe so the format is known before the first packet
+    Reader.Seek(0.0);
+
+    bFinished = false;
+    bFormatSent = false;
+    StoppedAtSeconds = 0.0;
+    bHasPending = ReadPending();
+    return true;
+}
+
+void FAudioReplayDevice::Close()
+{
+    Reader.Close();
+    bHasPending = false;
+    bStarted = false;
+}
+
+bool FAudioReplayDevice::Start()
+{
+    if (!IsOpen()) {
+        return false;
+    }
+
+    // Resume where Stop left off
+    ClockOffset = FPlatformTime::Seconds() - StoppedAtSeconds;
+    bStarted = true;
+    return true;
+}
+
+bool FAudioReplayDevice::Stop()
+{
+    if (bStarted) {
+        StoppedAtSeconds = GetPlaybackSeconds();
+        bStarted = false;
+    }
+    return true;
+}
+
+double FAudioReplayDevice::GetPlaybackSeconds() const
+{
+    return bStarted ? FPlatformTime::Seconds() - ClockOffset : StoppedAtSeconds;
+}
+
+bool FAudioReplayDevice::ReadPending()
+{
+    while (Reader.ReadChunk(PendingChunk, PendingPayload)) {
+        if (PendingChunk.Type == EAudioRecordingChunk::Format || PendingChunk.Type == EAudioRecordingChunk::Pcm) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FAudioReplayDevice::CapturePackets(IAudioSink* Sink)
+{
+    if (!bStarted) {
+        return true;
+    }
+
+    const double playbackSeconds = GetPlaybackSeconds();
+
+    while (bHasPending && PendingChunk.Seconds <= playbackSeconds) {
+        if (PendingChunk.Type == EAudioRecordingChunk::Format && PendingPayload.Num() >= (int32)sizeof(FAudioRecordingFormat)) {
+            const FAudioRecordingFormat& format = *reinterpret_cast<const FAudioRecordingFormat*>(PendingPayload.GetData());
+            const bool bFormatChanged = !bFormatSent || format.SampleRate != SentFormat.SampleRate
+                || format.NumChannels != SentFormat.NumChannels || format.BitsPerSample != SentFormat.BitsPerSample;
+
+            if (bFormatChanged) {
+                Sink->SetFormat(format.SampleRate, format.NumChannels, format.BitsPerSample);
+                SentFormat = format;
+                bFormatSent = true;
+            }
+        }
+        else if (PendingChunk.Type == EAudioRecordingChunk::Pcm && bFormatSent && PendingPayload.Num() >= (int32)sizeof(FAudioRecordingPcmHeader)) {
+            const FAudioRecordingPcmHeader& pcm = *reinterpret_cast<const FAudioRecordingPcmHeader*>(PendingPayload.GetData());
+            const uint8* samples = PendingPayload.GetData() + sizeof(FAudioRecordingPcmHeader);
+
+            if (pcm.Flags & FAudioRecordingPcmHeader::Discontinuity) {
+                Sink->MarkDiscontinuity();
+            }
+
+            const bool bSilent = (pcm.Flags & FAudioRecordingPcmHeader::Silent) != 0;
+            Sink->CopyData(bSilent ? NULL : samples, pcm.NumFrames);
+        }
+
+        bHasPending = ReadPending();
+
+        if (!bHasPending && bLoop) {
+            // Rebase the clock on the first keyframe and go round again
+            Reader.Seek(0.0);
+            bHasPending = ReadPending();
+            if (bHasPending) {
+                ClockOffset = FPlatformTime::Seconds() - PendingChunk.Seconds;
+                Sink->MarkDiscontinuity();
+            }
+            break;
+        }
+    }
+
+    if (!bHasPending && !bFinished) {
+        UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioReplayDevice: end of %s"), *Path);
+        bFinished = true;
+    }
+
+    return true;
+}
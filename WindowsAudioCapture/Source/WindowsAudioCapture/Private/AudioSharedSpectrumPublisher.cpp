@@ -0,0 +1,122 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioSharedSpectrumPublisher.h"
+#include "WindowsAudioCapture.h"
+#include "wac_shared_spectrum.h"
+
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+
+FAudioSharedSpectrumPublisher::FAudioSharedSpectrumPublisher()
+    : Header(nullptr)
+    , Mapping(nullptr)
+{
+}
+
+FAudioSharedSpectrumPublisher::~FAudioSharedSpectrumPublisher()
+{
+    Close();
+}
+
+bool FAudioSharedSpectrumPublisher::Open(const FString& InName, const FAudioMultiResolutionSettings& BandSettings)
+{
+    Close();
+
+    // Local\ keeps the region in the session namespace, Global\ would need SeCreateGlobalPrivilege
+    const FString fullName = FString(TEXT("Local\\")) + InName;
+
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)WAC_SHM_REGION_SIZE, *fullName);
+    if (mapping == nullptr) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioSharedSpectrumPublisher: cannot create %s (error %u)"), *fullName, (uint32)GetLastError());
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, WAC_SHM_REGION_SIZE);
+    if (view == nullptr) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioSharedSpectrumPublisher: cannot map %s (error %u)"), *fullName, (uint32)GetLastError());
+        CloseHandle(mapping);
+        return false;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    Header = static_cast<wac_shm_header*>(view);
+    Mapping = mapping;
+
+    Header->band_min_frequency = BandSettings.MinFrequency;
+    Header->band_max_frequency = BandSettings.MaxFrequency;
+    wac_shm_init_header(Header, frequency.QuadPart, (uint32)GetCurrentProcessId());
+
+    {
+        FScopeLock lock(&StatsLock);
+        Stats.bOpen = true;
+        Stats.Name = InName;
+    }
+
+    UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FAudioSharedSpectrumPublisher: publishing to %s, %u bytes"), *fullName, (uint32)WAC_SHM_REGION_SIZE);
+    return true;
+}
+
+void FAudioSharedSpectrumPublisher::Close()
+{
+    if (Header != nullptr) {
+        UnmapViewOfFile(Header);
+        CloseHandle(Mapping);
+        Header = nullptr;
+        Mapping = nullptr;
+    }
+
+    FScopeLock lock(&StatsLock);
+    Stats.bOpen = false;
+}
+
+void FAudioSharedSpectrumPublisher::Publish(const FAudioSpectrumFrame& Frame, int32 SampleRate)
+{
+    if (Header == nullptr) {
+        return;
+    }
+
+    const uint32 numBins = (uint32)FMath::Min<int32>(Frame.Magnitudes.Num(), WAC_SHM_MAX_BINS);
+    const uint32 numBands = (uint32)FMath::Min<int32>(Frame.BandMagnitudes.Num(), WAC_SHM_MAX_BANDS);
+    const bool bTruncated = numBins < (uint32)Frame.Magnitudes.Num() || numBands < (uint32)Frame.BandMagnitudes.Num();
+
+    Header->sample_rate = (uint32)SampleRate;
+
+    wac_shm_frame* slot = wac_shm_begin_write(Header);
+
+    slot->flags = (Frame.bDiscontinuity ? WAC_SHM_FRAME_DISCONTINUITY : 0u)
+        | (Frame.bSilent ? WAC_SHM_FRAME_SILENT : 0u)
+        | (numBins > 0 ? WAC_SHM_FRAME_HAS_SPECTRUM : 0u)
+        | (numBands > 0 ? WAC_SHM_FRAME_HAS_BANDS : 0u);
+    slot->frame_index = Frame.FrameIndex;
+
+    // Magnitudes drop DC, so N bins come from a 2 * (N + 1) point FFT
+    slot->num_bins = numBins;
+    slot->bin_width_hz = Frame.Magnitudes.Num() > 0 ? SampleRate / (2.0f * (Frame.Magnitudes.Num() + 1)) : 0.0f;
+    slot->num_bands = numBands;
+
+    slot->momentary_lufs = Frame.Levels.MomentaryLufs;
+    slot->short_term_lufs = Frame.Levels.ShortTermLufs;
+    slot->rms = Frame.Levels.GetMaxRms();
+    slot->peak = Frame.Levels.GetMaxPeak();
+
+    FMemory::Memcpy(slot->magnitudes, Frame.Magnitudes.GetData(), numBins * sizeof(float));
+    FMemory::Memcpy(slot->bands, Frame.BandMagnitudes.GetData(), numBands * sizeof(float));
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    slot->publish_ticks = now.QuadPart;
+
+    wac_shm_end_write(Header, slot);
+
+    FScopeLock lock(&StatsLock);
+    ++Stats.PublishedFrames;
+    Stats.TruncatedFrames += bTruncated ? 1 : 0;
+}
+
+FAudioSharedSpectrumStats FAudioSharedSpectrumPublisher::GetStats() const
+{
+    FScopeLock lock(&StatsLock);
+    return Stats;
+}
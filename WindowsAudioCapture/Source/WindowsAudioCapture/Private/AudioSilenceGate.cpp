@@ -0,0 +1,97 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioSilenceGate.h"
+
+namespace {
+constexpr float MinLevelDb = -120.0f;
+constexpr float OneLsb = 1.0f / 32768.0f;
+
+float LevelToDb(float Level)
+{
+    return Level > 1e-6f ? 20.0f * FMath::LogX(10.0f, Level) : MinLevelDb;
+}
+}
+
+FAudioSilenceGate::FAudioSilenceGate(const FAudioSilenceGateSettings& InSettings)
+    : Settings(InSettings)
+{
+    Reset();
+}
+
+void FAudioSilenceGate::Reset()
+{
+    bOpen = false;
+    NoiseFloorDb = Settings.ThresholdDb - Settings.NoiseFloorMarginDb;
+    HoldRemainingSeconds = 0.0f;
+}
+
+FAudioSilenceGate::FBlockLevels FAudioSilenceGate::MeasureInt16(const int16* Samples, int32 NumSamples)
+{
+    FBlockLevels Levels;
+
+    if (Samples == nullptr || NumSamples <= 0) {
+        return Levels;
+    }
+
+    // Four independent lanes so the reduction does not serialize on one accumulator
+    int64 SumSquares[4] = { 0, 0, 0, 0 };
+    int32 Peak[4] = { 0, 0, 0, 0 };
+
+    const int32 NumQuads = NumSamples / 4;
+    for (int32 Quad = 0; Quad < NumQuads; ++Quad) {
+        for (int32 Lane = 0; Lane < 4; ++Lane) {
+            const int32 Sample = Samples[Quad * 4 + Lane];
+            const int32 Magnitude = Sample < 0 ? -Sample : Sample;
+            SumSquares[Lane] += Sample * Sample;
+            Peak[Lane] = Peak[Lane] > Magnitude ? Peak[Lane] : Magnitude;
+        }
+    }
+
+    for (int32 Index = NumQuads * 4; Index < NumSamples; ++Index) {
+        const int32 Sample = Samples[Index];
+        SumSquares[0] += Sample * Sample;
+        Peak[0] = FMath::Max(Peak[0], FMath::Abs(Sample));
+    }
+
+    const int64 TotalSquares = SumSquares[0] + SumSquares[1] + SumSquares[2] + SumSquares[3];
+    const int32 MaxPeak = FMath::Max(FMath::Max(Peak[0], Peak[1]), FMath::Max(Peak[2], Peak[3]));
+
+    Levels.Rms = FMath::Sqrt(float(double(TotalSquares) / NumSamples)) * OneLsb;
+    Levels.Peak = float(MaxPeak) * OneLsb;
+    return Levels;
+}
+
+bool FAudioSilenceGate::Process(const FBlockLevels& Levels, int32 NumFrames, int32 SampleRate)
+{
+    const float BlockSeconds = SampleRate > 0 ? float(NumFrames) / SampleRate : 0.0f;
+    const float LevelDb = LevelToDb(Levels.Rms);
+
+    const float CloseThresholdDb = FMath::Max(Settings.ThresholdDb, NoiseFloorDb + Settings.NoiseFloorMarginDb);
+    const float OpenThresholdDb = CloseThresholdDb + Settings.HysteresisDb;
+
+    // Nothing above the dither
+    const bool bDigitalSilence = Levels.Peak <= OneLsb;
+
+    if (bOpen) {
+        if (bDigitalSilence || LevelDb < CloseThresholdDb) {
+            HoldRemainingSeconds -= BlockSeconds;
+            bOpen = !bDigitalSilence && HoldRemainingSeconds > 0.0f;
+        } else {
+            HoldRemainingSeconds = Settings.HoldSeconds;
+        }
+    } else if (!bDigitalSilence && LevelDb > OpenThresholdDb) {
+        bOpen = true;
+        HoldRemainingSeconds = Settings.HoldSeconds;
+    }
+
+    // Only learn the floor from what we consider noise, never from the signal
+    if (!bOpen) {
+        if (LevelDb < NoiseFloorDb) {
+            NoiseFloorDb = FMath::Max(LevelDb, MinLevelDb);
+        } else {
+            NoiseFloorDb = FMath::Min(NoiseFloorDb + Settings.NoiseFloorRiseDbPerSecond * BlockSeconds, LevelDb);
+        }
+        NoiseFloorDb = FMath::Min(NoiseFloorDb, Settings.MaxNoiseFloorDb);
+    }
+
+    return bOpen;
+}
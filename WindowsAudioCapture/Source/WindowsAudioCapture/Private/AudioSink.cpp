@@ -1,6 +1,13 @@
 //Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
 #include "AudioSink.h"
 #include "WindowsAudioCapture.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarWACAnalysisSampleRate(
+    TEXT("WAC.AnalysisSampleRate"),
+    48000,
+    TEXT("Rate (Hz) the capture is resampled to before the analysis, whatever the device runs at, so the FFT bins, band\n")
+    TEXT("filters and kernels are the same on every machine. 0 analyses at the device rate. Read when the capture (re)starts."));
 
 AudioSink::AudioSink()
 {
@@ -8,71 +15,103 @@ AudioSink::AudioSink()
 
 AudioSink::~AudioSink()
 {
-    AudioChunk tmp;
-    EmptyQueue(tmp);
 }
 
-bool AudioSink::Dequeue(AudioChunk& Chunk)
+EAudioRingRead AudioSink::Read(FAudioRingCursor& Cursor, AudioChunk& OutChunk, TArray<int16>& OutSamples) const
+{
+    FAudioRingPacket packet;
+    const EAudioRingRead result = m_ring.Read(Cursor, packet, OutSamples);
+    if (result != EAudioRingRead::Packet) {
+        return result;
+    }
+
+    OutChunk.chunk = OutSamples.Num() > 0 ? OutSamples.GetData() : nullptr;
+    OutChunk.size = OutSamples.Num();
+    OutChunk.bDiscontinuity = (packet.Flags & FAudioRingPacket::Discontinuity) != 0;
+    OutChunk.bSilent = (packet.Flags & FAudioRingPacket::Silent) != 0;
+    OutChunk.numFrames = packet.NumFrames;
+    OutChunk.numChannels = packet.NumChannels;
+    OutChunk.sampleRate = packet.SampleRate;
+    return result;
+}
+
+int AudioSink::CopyData(const BYTE* Data, const int NumFramesAvailable)
 {
     FScopeLock lock(&m_mutex);
 
-    if (m_queue.IsEmpty())
-        return false;
+    const uint32 discontinuity = m_pendingDiscontinuity ? FAudioRingPacket::Discontinuity : 0;
+    m_pendingDiscontinuity = false;
+
+    if (Data == NULL) {
+        // Silent packet, keep the gate timing in step
+        m_gate.Process(FAudioSilenceGate::FBlockLevels(), NumFramesAvailable, m_deviceSampleRate);
+        m_meter.ProcessInt16(nullptr, NumFramesAvailable);
+        WritePacket(nullptr, NumFramesAvailable, discontinuity);
+        return 0;
+    }
+
+    const int numSamples = NumFramesAvailable * m_nChannels;
+
+    // Levels are metered before the gate so quiet passages still read correctly
+    m_meter.ProcessInt16((const int16*)Data, NumFramesAvailable);
+
+    // One pass for RMS/peak instead of scrubbing every sample, silent blocks are never copied
+    const FAudioSilenceGate::FBlockLevels levels = FAudioSilenceGate::MeasureInt16((const int16*)Data, numSamples);
+    const bool bSilent = !m_gate.Process(levels, NumFramesAvailable, m_deviceSampleRate);
 
-    m_queue.Dequeue(Chunk);
-    return true;
+    WritePacket(bSilent ? nullptr : (const int16*)Data, NumFramesAvailable, discontinuity);
+
+    return 0;
 }
 
-bool AudioSink::EmptyQueue(AudioChunk& Chunk)
+void AudioSink::WritePacket(const int16* Samples, int NumFrames, uint32 Discontinuity)
 {
-    //std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (Chunk.chunk != nullptr) {
-        delete[] Chunk.chunk;
-        Chunk.chunk = nullptr;
+    if (m_resampler.IsBypassed()) {
+        // Straight from the device buffer into the ring, one copy per packet however many readers there are
+        m_ring.Write(Samples, NumFrames, m_nChannels, m_sampleRate, Discontinuity | (Samples == nullptr ? FAudioRingPacket::Silent : 0));
+        return;
     }
 
-    while (!m_queue.IsEmpty()) {
-        m_queue.Dequeue(Chunk);
-        if (Chunk.chunk != nullptr) {
-            delete[] Chunk.chunk;
-            Chunk.chunk = nullptr;
-        }
+    // Silence only moves the resampler on, the filter has nothing to do
+    const int numFrames = Samples != nullptr ? m_resampler.Process(Samples, NumFrames, m_resampled) : m_resampler.Skip(NumFrames);
+
+    // A packet shorter than one output frame: the discontinuity waits for the next one
+    if (numFrames == 0) {
+        m_pendingDiscontinuity |= Discontinuity != 0;
+        return;
     }
 
-    return true;
+    m_ring.Write(Samples != nullptr ? m_resampled.GetData() : nullptr, numFrames, m_nChannels, m_sampleRate,
+        Discontinuity | (Samples == nullptr ? FAudioRingPacket::Silent : 0));
 }
 
-int AudioSink::CopyData(const BYTE* Data, const int NumFramesAvailable)
+void AudioSink::SetFormat(int SampleRate, int NumChannels, int BitsPerSample)
 {
     FScopeLock lock(&m_mutex);
 
-    AudioChunk chunk;
-    if (Data == NULL) {
-        chunk.size = 0;
-        m_queue.Enqueue(chunk);
-        return 0;
-    }
-    chunk.size = NumFramesAvailable * 2;
-    chunk.chunk = new int16[chunk.size];
-    const int multiplier = sizeof(int16) / sizeof(unsigned char);
-    //std::memcpy(chunk.chunk, Data, chunk.size * multiplier);
-    FMemory::Memcpy(chunk.chunk, Data, chunk.size * multiplier);
-    bool nonZero = false;
-
-    for (int i = 0; i < chunk.size; i++) {
-        if (chunk.chunk[i] == -1 || chunk.chunk[i] == 1) {
-            chunk.chunk[i] = 0;
-        }
-        if (chunk.chunk[i] != 0) {
-            nonZero = true;
-            //UE_LOG(LogTemp, Log, TEXT("NumFramesAvailable: %d, Sample number %d, Sample value %hi"), NumFramesAvailable, i, chunk.chunk[i]);
-        }
-    }
+    const int analysisRate = CVarWACAnalysisSampleRate.GetValueOnAnyThread();
 
-    if (nonZero) {
-        m_queue.Enqueue(chunk);
-    }
+    m_deviceSampleRate = SampleRate;
+    m_sampleRate = analysisRate > 0 ? analysisRate : SampleRate;
+    m_nChannels = NumChannels;
+    m_gate.Reset();
+    m_meter.Configure(SampleRate, NumChannels);
 
-    return 0;
+    // Clears the filter history too, the new stream does not follow on from the old one
+    m_resampler.Configure(SampleRate, m_sampleRate, NumChannels);
+    m_resampler.Reset();
+}
+
+FAudioLevelMetrics AudioSink::ConsumeLevels()
+{
+    FScopeLock lock(&m_mutex);
+
+    return m_meter.ConsumeMetrics();
+}
+
+void AudioSink::MarkDiscontinuity()
+{
+    FScopeLock lock(&m_mutex);
+
+    m_pendingDiscontinuity = true;
 }
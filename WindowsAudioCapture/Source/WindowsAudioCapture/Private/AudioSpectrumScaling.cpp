@@ -0,0 +1,59 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioSpectrumScaling.h"
+
+namespace {
+constexpr int32 FloatMantissaBits = 23;
+constexpr int32 FloatExponentBias = 127;
+constexpr int32 FractionBits = FloatMantissaBits - FAudioSpectrumScalingTable::MantissaIndexBits;
+constexpr uint32 FractionMask = (1u << FractionBits) - 1;
+
+constexpr uint32 MinBits = uint32(FloatExponentBias + FAudioSpectrumScalingTable::MinOctave) << FloatMantissaBits;
+constexpr uint32 MaxBits = uint32(FloatExponentBias + FAudioSpectrumScalingTable::MaxOctave) << FloatMantissaBits;
+constexpr int32 NumSegments = (FAudioSpectrumScalingTable::MaxOctave - FAudioSpectrumScalingTable::MinOctave) * FAudioSpectrumScalingTable::SegmentsPerOctave;
+}
+
+float FAudioSpectrumScalingProfile::Evaluate(float Magnitude) const
+{
+    const float Value = FMath::Pow(FMath::LogX(LogBase, Magnitude) * Multiplier, Power) + Offset;
+
+    // Negative values (and the NaN a fractional power of a negative log gives) read as silence
+    return Value > 0.0f ? Value : 0.0f;
+}
+
+FAudioSpectrumScalingTable::FAudioSpectrumScalingTable(const FAudioSpectrumScalingProfile& InProfile)
+    : Profile(InProfile)
+{
+    Table.SetNumUninitialized(NumSegments + 2);
+
+    for (int32 Segment = 0; Segment <= NumSegments; ++Segment) {
+        const int32 Octave = MinOctave + Segment / SegmentsPerOctave;
+        const float Mantissa = 1.0f + float(Segment % SegmentsPerOctave) / SegmentsPerOctave;
+        Table[Segment] = Profile.Evaluate(FMath::Pow(2.0f, float(Octave)) * Mantissa);
+    }
+
+    // Padding so a clamped MaxBits input can read Segment + 1
+    Table[NumSegments + 1] = Table[NumSegments];
+}
+
+void FAudioSpectrumScalingTable::Apply(const float* In, float* Out, int32 Num) const
+{
+    const float* TableData = Table.GetData();
+    const float FractionScale = 1.0f / float(1u << FractionBits);
+
+    for (int32 Index = 0; Index < Num; ++Index) {
+        uint32 Bits;
+        FMemory::Memcpy(&Bits, &In[Index], sizeof(Bits));
+
+        // Zero, denormals and anything below the range clamp to the first entry. Magnitudes are never negative.
+        Bits = Bits < MinBits ? MinBits : Bits;
+        Bits = Bits > MaxBits ? MaxBits : Bits;
+
+        const uint32 Offset = Bits - MinBits;
+        const uint32 Segment = Offset >> FractionBits;
+        const float Alpha = float(Offset & FractionMask) * FractionScale;
+
+        const float A = TableData[Segment];
+        const float B = TableData[Segment + 1];
+        Out[Index] = A + (B - A) * Alpha;
+    }
+}
@@ -0,0 +1,95 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioVectorMath.h"
+#include "Math/VectorRegister.h"
+
+void FAudioVectorMath::SumOfSquaresAndPeak(const float* Data, int32 Num, float& OutSumOfSquares, float& OutPeak)
+{
+    VectorRegister SumOfSquares = VectorZero();
+    VectorRegister Peak = VectorZero();
+
+    int32 Index = 0;
+    for (; Index + 4 <= Num; Index += 4) {
+        const VectorRegister Value = VectorLoad(&Data[Index]);
+        SumOfSquares = VectorMultiplyAdd(Value, Value, SumOfSquares);
+        Peak = VectorMax(Peak, VectorAbs(Value));
+    }
+
+    float SumLanes[4];
+    float PeakLanes[4];
+    VectorStore(SumOfSquares, SumLanes);
+    VectorStore(Peak, PeakLanes);
+
+    float Sum = (SumLanes[0] + SumLanes[1]) + (SumLanes[2] + SumLanes[3]);
+    float Max = FMath::Max(FMath::Max(PeakLanes[0], PeakLanes[1]), FMath::Max(PeakLanes[2], PeakLanes[3]));
+
+    for (; Index < Num; ++Index) {
+        Sum += Data[Index] * Data[Index];
+        Max = FMath::Max(Max, FMath::Abs(Data[Index]));
+    }
+
+    OutSumOfSquares = Sum;
+    OutPeak = Max;
+}
+
+float FAudioVectorMath::DotProduct(const float* A, const float* B, int32 Num)
+{
+    VectorRegister Sum = VectorZero();
+
+    int32 Index = 0;
+    for (; Index + 4 <= Num; Index += 4) {
+        Sum = VectorMultiplyAdd(VectorLoad(&A[Index]), VectorLoad(&B[Index]), Sum);
+    }
+
+    float Lanes[4];
+    VectorStore(Sum, Lanes);
+    float Result = (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+
+    for (; Index < Num; ++Index) {
+        Result += A[Index] * B[Index];
+    }
+    return Result;
+}
+
+void FAudioVectorMath::Multiply(const float* In, float Scale, float* Out, int32 Num)
+{
+    const VectorRegister ScaleVector = VectorSetFloat1(Scale);
+
+    int32 Index = 0;
+    for (; Index + 4 <= Num; Index += 4) {
+        VectorStore(VectorMultiply(VectorLoad(&In[Index]), ScaleVector), &Out[Index]);
+    }
+
+    for (; Index < Num; ++Index) {
+        Out[Index] = In[Index] * Scale;
+    }
+}
+
+void FAudioVectorMath::DeinterleaveInt16(const int16* Interleaved, int32 NumFrames, int32 NumChannels, float* const* OutChannels)
+{
+    DeinterleaveInt16(Interleaved, NumFrames, NumChannels, NumChannels, OutChannels);
+}
+
+void FAudioVectorMath::DeinterleaveInt16(const int16* Interleaved, int32 NumFrames, int32 NumChannels, int32 NumOutChannels, float* const* OutChannels)
+{
+    const float Scale = 1.0f / 32768.0f;
+
+    // Stereo is by far the common case, give the compiler a loop with a constant stride
+    if (NumChannels == 2 && NumOutChannels == 2) {
+        float* Left = OutChannels[0];
+        float* Right = OutChannels[1];
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            Left[Frame] = Interleaved[Frame * 2] * Scale;
+            Right[Frame] = Interleaved[Frame * 2 + 1] * Scale;
+        }
+        return;
+    }
+
+    NumOutChannels = FMath::Min(NumOutChannels, NumChannels);
+    for (int32 Channel = 0; Channel < NumOutChannels; ++Channel) {
+        float* Out = OutChannels[Channel];
+        const int16* In = Interleaved + Channel;
+        for (int32 Frame = 0; Frame < NumFrames; ++Frame) {
+            Out[Frame] = In[Frame * NumChannels] * Scale;
+        }
+    }
+}
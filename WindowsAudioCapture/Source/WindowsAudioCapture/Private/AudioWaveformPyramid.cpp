@@ -0,0 +1,216 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioWaveformPyramid.h"
+#include "WindowsAudioCapture.h"
+
+namespace {
+// The top level still holds this many entries
+constexpr int32 MinLevelEntries = 8;
+
+// Points span 4 to 8 blocks of the level they are read from
+constexpr int32 MinBlocksPerPoint = 4;
+
+// Level 0 and the three arrays of every level above it
+int64 GetChainBytes(int32 Capacity)
+{
+    int64 Entries = 0;
+    for (int32 NumEntries = Capacity / 2; NumEntries >= MinLevelEntries; NumEntries /= 2) {
+        Entries += NumEntries;
+    }
+    return ((int64)Capacity + 3 * Entries) * sizeof(float);
+}
+}
+
+FAudioWaveformPyramid::FAudioWaveformPyramid(int32 InCapacity)
+    : RequestedCapacity((int32)FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(InCapacity, 2 * MinLevelEntries)))
+    , Capacity(RequestedCapacity)
+    , SampleRate(0)
+    , NumChannels(0)
+    , TotalSamples(0)
+    , Memory(EWACMemory::WaveformHistory)
+{
+}
+
+void FAudioWaveformPyramid::Configure(int32 InSampleRate, int32 InNumChannels)
+{
+    WAC_LLM_SCOPE();
+
+    SampleRate = InSampleRate;
+    NumChannels = FMath::Max(InNumChannels, 1);
+
+    // Counted before the arrays grow, so the budget is checked ahead of the allocation
+    const int32 MinChainCapacity = FMath::Min(RequestedCapacity, MinCapacity);
+    Capacity = RequestedCapacity;
+    while (!Memory.TrySet(GetChainBytes(Capacity))) {
+        if (Capacity <= MinChainCapacity) {
+            Memory.Set(GetChainBytes(Capacity));
+            break;
+        }
+        Capacity /= 2;
+    }
+
+    if (Capacity < RequestedCapacity) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("FAudioWaveformPyramid: memory budget leaves room for %d samples of waveform history instead of %d"),
+            Capacity, RequestedCapacity);
+    }
+
+    // Keeps the allocations within the new capacity only
+    Samples.Empty(Capacity);
+
+    Samples.SetNumZeroed(Capacity);
+    Levels.Reset();
+
+    for (int32 NumEntries = Capacity / 2; NumEntries >= MinLevelEntries; NumEntries /= 2) {
+        FLevel& Level = Levels.AddDefaulted_GetRef();
+        Level.Min.SetNumZeroed(NumEntries);
+        Level.Max.SetNumZeroed(NumEntries);
+        Level.SumOfSquares.SetNumZeroed(NumEntries);
+        Level.Mask = (uint32)NumEntries - 1;
+    }
+
+    TotalSamples = 0;
+}
+
+void FAudioWaveformPyramid::Reset()
+{
+    // Entries that were never written are never read, only the count has to go
+    TotalSamples = 0;
+}
+
+void FAudioWaveformPyramid::PushInt16(const int16* InSamples, int32 NumFrames)
+{
+    if (!IsConfigured()) {
+        return;
+    }
+
+    const float Scale = 1.0f / (32768.0f * NumChannels);
+    const uint32 SampleMask = (uint32)Capacity - 1;
+
+    // A level can only be built from entries its lower level still holds
+    const int32 MaxPiece = Capacity / 2;
+
+    for (int32 PieceStart = 0; PieceStart < NumFrames; PieceStart += MaxPiece) {
+        const int32 PieceFrames = FMath::Min(MaxPiece, NumFrames - PieceStart);
+        const uint64 FirstSample = TotalSamples;
+
+        for (int32 Frame = 0; Frame < PieceFrames; ++Frame) {
+            float Value = 0.0f;
+            if (InSamples != nullptr) {
+                const int16* FrameSamples = InSamples + (PieceStart + Frame) * NumChannels;
+                int32 Sum = 0;
+                for (int32 Channel = 0; Channel < NumChannels; ++Channel) {
+                    Sum += FrameSamples[Channel];
+                }
+                Value = Sum * Scale;
+            }
+            Samples[(uint32)(FirstSample + Frame) & SampleMask] = Value;
+        }
+
+        TotalSamples += PieceFrames;
+
+        for (int32 Level = 1; Level <= Levels.Num(); ++Level) {
+            const uint64 FirstEntry = FirstSample >> Level;
+            const uint64 EndEntry = TotalSamples >> Level;
+
+            // Nothing completed here, nothing above either
+            if (FirstEntry == EndEntry) {
+                break;
+            }
+            UpdateLevel(Level, FirstEntry, EndEntry);
+        }
+    }
+}
+
+void FAudioWaveformPyramid::UpdateLevel(int32 Level, uint64 FirstEntry, uint64 EndEntry)
+{
+    FLevel& Target = Levels[Level - 1];
+
+    if (Level == 1) {
+        const uint32 SampleMask = (uint32)Capacity - 1;
+        for (uint64 Entry = FirstEntry; Entry < EndEntry; ++Entry) {
+            const float First = Samples[(uint32)(Entry * 2) & SampleMask];
+            const float Second = Samples[(uint32)(Entry * 2 + 1) & SampleMask];
+            const uint32 Index = (uint32)Entry & Target.Mask;
+            Target.Min[Index] = FMath::Min(First, Second);
+            Target.Max[Index] = FMath::Max(First, Second);
+            Target.SumOfSquares[Index] = First * First + Second * Second;
+        }
+        return;
+    }
+
+    const FLevel& Source = Levels[Level - 2];
+    for (uint64 Entry = FirstEntry; Entry < EndEntry; ++Entry) {
+        const uint32 First = (uint32)(Entry * 2) & Source.Mask;
+        const uint32 Second = (uint32)(Entry * 2 + 1) & Source.Mask;
+        const uint32 Index = (uint32)Entry & Target.Mask;
+        Target.Min[Index] = FMath::Min(Source.Min[First], Source.Min[Second]);
+        Target.Max[Index] = FMath::Max(Source.Max[First], Source.Max[Second]);
+        Target.SumOfSquares[Index] = Source.SumOfSquares[First] + Source.SumOfSquares[Second];
+    }
+}
+
+void FAudioWaveformPyramid::GetEnvelope(int32 NumSamples, int32 NumPoints, float* OutMin, float* OutMax, float* OutRms) const
+{
+    if (NumPoints <= 0) {
+        return;
+    }
+
+    FMemory::Memzero(OutMin, NumPoints * sizeof(float));
+    FMemory::Memzero(OutMax, NumPoints * sizeof(float));
+    FMemory::Memzero(OutRms, NumPoints * sizeof(float));
+
+    if (!IsConfigured() || TotalSamples == 0) {
+        return;
+    }
+
+    NumSamples = FMath::Clamp(NumSamples, 1, Capacity);
+
+    // Coarsest level with at least MinBlocksPerPoint blocks per point
+    int32 Level = 0;
+    while (Level < Levels.Num() && (int64(MinBlocksPerPoint) << (Level + 1)) * NumPoints <= NumSamples) {
+        ++Level;
+    }
+
+    // Only whole blocks exist, the window ends at the last completed one
+    const int64 EndEntry = int64(TotalSamples >> Level);
+    const int64 WindowEntries = FMath::Max<int64>(NumSamples >> Level, 1);
+    const int64 StartEntry = EndEntry - WindowEntries;
+    const float BlockSize = float(1 << Level);
+
+    const uint32 SampleMask = (uint32)Capacity - 1;
+    const FLevel* Source = Level > 0 ? &Levels[Level - 1] : nullptr;
+
+    for (int32 Point = 0; Point < NumPoints; ++Point) {
+        int64 First = StartEntry + WindowEntries * Point / NumPoints;
+        const int64 Last = FMath::Max(StartEntry + WindowEntries * (Point + 1) / NumPoints, First + 1);
+
+        // Before the first pushed sample
+        First = FMath::Max<int64>(First, 0);
+        if (Last <= First) {
+            continue;
+        }
+
+        float Min = TNumericLimits<float>::Max();
+        float Max = TNumericLimits<float>::Lowest();
+        float SumOfSquares = 0.0f;
+
+        if (Source == nullptr) {
+            for (int64 Entry = First; Entry < Last; ++Entry) {
+                const float Value = Samples[(uint32)Entry & SampleMask];
+                Min = FMath::Min(Min, Value);
+                Max = FMath::Max(Max, Value);
+                SumOfSquares += Value * Value;
+            }
+        } else {
+            for (int64 Entry = First; Entry < Last; ++Entry) {
+                const uint32 Index = (uint32)Entry & Source->Mask;
+                Min = FMath::Min(Min, Source->Min[Index]);
+                Max = FMath::Max(Max, Source->Max[Index]);
+                SumOfSquares += Source->SumOfSquares[Index];
+            }
+        }
+
+        OutMin[Point] = Min;
+        OutMax[Point] = Max;
+        OutRms[Point] = FMath::Sqrt(SumOfSquares / (float(Last - First) * BlockSize));
+    }
+}
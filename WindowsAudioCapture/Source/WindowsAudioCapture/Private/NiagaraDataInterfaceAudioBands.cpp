@@ -0,0 +1,471 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NiagaraDataInterfaceAudioBands.h"
+#include "AudioCaptureWorker.h"
+#include "WindowsAudioCaptureSubsystem.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "NiagaraShader.h"
+#include "NiagaraTypes.h"
+
+#define LOCTEXT_NAMESPACE "NiagaraDataInterfaceAudioBands"
+
+// Global VM function names, also used by the shaders code generation methods.
+static const FName GetBands4FunctionName("GetBands4");
+static const FName GetBandsArrayFunctionName("GetBandsArray");
+static const FName GetLevelFunctionName("GetLevel");
+
+// Global variable prefixes, used in HLSL parameter declarations.
+static const FString AudioBandsBufferName(TEXT("AudioBandsBuffer_"));
+static const FString AudioBandsNumBandsName(TEXT("AudioBandsNumBands_"));
+static const FString AudioBands4Name(TEXT("AudioBands4_"));
+static const FString AudioBandsOnsets4Name(TEXT("AudioBandsOnsets4_"));
+static const FString AudioBandsLevelsName(TEXT("AudioBandsLevels_"));
+
+FNiagaraDataInterfaceProxyAudioBands::FNiagaraDataInterfaceProxyAudioBands()
+    : LastUpdateFrame(0)
+    , bHasOnsetCounts(false)
+    , GPUBands4(0.0f, 0.0f, 0.0f, 0.0f)
+    , GPUOnsets4(0.0f, 0.0f, 0.0f, 0.0f)
+    , GPULevels(0.0f, 0.0f, FAudioLevelMetrics::MinLoudnessLufs, FAudioLevelMetrics::MinLoudnessLufs)
+    , GPUNumBands(0)
+{
+    FMemory::Memzero(LastOnsetCount, sizeof(LastOnsetCount));
+}
+
+FNiagaraDataInterfaceProxyAudioBands::~FNiagaraDataInterfaceProxyAudioBands()
+{
+    check(IsInRenderingThread());
+    GPUBandsBuffer.Release();
+}
+
+void FNiagaraDataInterfaceProxyAudioBands::UpdateSnapshot(const FAudioBandOnsets& Onsets, const TArray<float>& Bands, const FAudioLevelMetrics& Levels)
+{
+    check(IsInGameThread());
+
+    // Every system instance ticks the data interface, one snapshot per frame is enough
+    if (LastUpdateFrame == GFrameCounter) {
+        return;
+    }
+    LastUpdateFrame = GFrameCounter;
+
+    TSharedPtr<FAudioBandsSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FAudioBandsSnapshot, ESPMode::ThreadSafe>();
+
+    if (Onsets.bValid) {
+        for (int32 Band = 0; Band < FAudioBandOnsets::NumBands; ++Band) {
+            NewSnapshot->Bands4[Band] = FMath::Clamp(Onsets.Energy[Band], 0.0f, 1.0f);
+
+            // Counts only grow, a difference means at least one onset since the previous frame.
+            // The first counts seen are only a baseline, they include onsets from before the system started.
+            const bool bBandOnset = bHasOnsetCounts && Onsets.OnsetCount[Band] != LastOnsetCount[Band];
+            NewSnapshot->Onsets4[Band] = bBandOnset ? 1.0f : 0.0f;
+            NewSnapshot->bOnset |= bBandOnset;
+            LastOnsetCount[Band] = Onsets.OnsetCount[Band];
+        }
+        bHasOnsetCounts = true;
+    }
+
+    NewSnapshot->Levels[0] = Levels.GetMaxRms();
+    NewSnapshot->Levels[1] = Levels.GetMaxPeak();
+    NewSnapshot->Levels[2] = Levels.MomentaryLufs;
+    NewSnapshot->Levels[3] = Levels.ShortTermLufs;
+
+    NewSnapshot->Bands.SetNumUninitialized(Bands.Num());
+    for (int32 Band = 0; Band < Bands.Num(); ++Band) {
+        NewSnapshot->Bands[Band] = FMath::Clamp(Bands[Band], 0.0f, 1.0f);
+    }
+
+    {
+        FScopeLock ScopeLock(&SnapshotLock);
+        Snapshot = NewSnapshot;
+    }
+
+    FNiagaraDataInterfaceProxyAudioBands* BandsProxy = this;
+    FAudioBandsSnapshotPtr UploadedSnapshot = NewSnapshot;
+    ENQUEUE_RENDER_COMMAND(FUpdateDIAudioBands)
+    (
+        [BandsProxy, UploadedSnapshot](FRHICommandListImmediate& RHICmdList) {
+            BandsProxy->UploadSnapshot(*UploadedSnapshot);
+        });
+}
+
+FAudioBandsSnapshotPtr FNiagaraDataInterfaceProxyAudioBands::GetSnapshot()
+{
+    FScopeLock ScopeLock(&SnapshotLock);
+    return Snapshot;
+}
+
+void FNiagaraDataInterfaceProxyAudioBands::UploadSnapshot(const FAudioBandsSnapshot& InSnapshot)
+{
+    check(IsInRenderingThread());
+
+    GPUBands4 = FVector4(InSnapshot.Bands4[0], InSnapshot.Bands4[1], InSnapshot.Bands4[2], InSnapshot.Bands4[3]);
+    GPUOnsets4 = FVector4(InSnapshot.Onsets4[0], InSnapshot.Onsets4[1], InSnapshot.Onsets4[2], InSnapshot.Onsets4[3]);
+    GPULevels = FVector4(InSnapshot.Levels[0], InSnapshot.Levels[1], InSnapshot.Levels[2], InSnapshot.Levels[3]);
+
+    const uint32 BufferSize = InSnapshot.Bands.Num() * sizeof(float);
+    if (BufferSize == 0) {
+        GPUNumBands = 0;
+        return;
+    }
+
+    if (GPUBandsBuffer.NumBytes != BufferSize) {
+        GPUBandsBuffer.Release();
+        GPUBandsBuffer.Initialize(sizeof(float), InSnapshot.Bands.Num(), EPixelFormat::PF_R32_FLOAT, BUF_Dynamic);
+    }
+
+    float* BufferData = static_cast<float*>(RHILockVertexBuffer(GPUBandsBuffer.Buffer, 0, BufferSize, EResourceLockMode::RLM_WriteOnly));
+    FPlatformMemory::Memcpy(BufferData, InSnapshot.Bands.GetData(), BufferSize);
+    RHIUnlockVertexBuffer(GPUBandsBuffer.Buffer);
+
+    GPUNumBands = InSnapshot.Bands.Num();
+}
+
+FReadBuffer& FNiagaraDataInterfaceProxyAudioBands::GetBandsSRV()
+{
+    check(IsInRenderingThread());
+
+    // The shader needs a view before the first spectrum arrives, it reads no band while GPUNumBands is 0
+    if (GPUBandsBuffer.NumBytes == 0) {
+        GPUBandsBuffer.Initialize(sizeof(float), 1, EPixelFormat::PF_R32_FLOAT, BUF_Dynamic);
+        GPUNumBands = 0;
+    }
+    return GPUBandsBuffer;
+}
+
+UNiagaraDataInterfaceAudioBands::UNiagaraDataInterfaceAudioBands(FObjectInitializer const& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    Proxy = TUniquePtr<FNiagaraDataInterfaceProxyAudioBands>(new FNiagaraDataInterfaceProxyAudioBands());
+}
+
+void UNiagaraDataInterfaceAudioBands::GetBands4(FVectorVMContext& Context)
+{
+    VectorVM::FExternalFuncRegisterHandler<float> OutBands[FAudioBandOnsets::NumBands] = {
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+    };
+    VectorVM::FExternalFuncRegisterHandler<float> OutOnsets[FAudioBandOnsets::NumBands] = {
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+        VectorVM::FExternalFuncRegisterHandler<float>(Context),
+    };
+    VectorVM::FExternalFuncRegisterHandler<float> OutLevel(Context);
+
+    // The outputs are the same for every instance: one lookup per batch, then plain fills
+    const FAudioBandsSnapshotPtr Snapshot = GetProxyAs<FNiagaraDataInterfaceProxyAudioBands>()->GetSnapshot();
+    const FAudioBandsSnapshot Empty;
+    const FAudioBandsSnapshot& Values = Snapshot.IsValid() ? *Snapshot : Empty;
+
+    for (int32 Band = 0; Band < FAudioBandOnsets::NumBands; ++Band) {
+        float* Bands = OutBands[Band].GetDest();
+        float* Onsets = OutOnsets[Band].GetDest();
+        for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
+            Bands[InstanceIdx] = Values.Bands4[Band];
+            Onsets[InstanceIdx] = Values.Onsets4[Band];
+        }
+    }
+
+    float* Level = OutLevel.GetDest();
+    for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
+        Level[InstanceIdx] = Values.Levels[0];
+    }
+}
+
+void UNiagaraDataInterfaceAudioBands::GetBandsArray(FVectorVMContext& Context)
+{
+    VectorVM::FExternalFuncInputHandler<int32> InIndex(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutValue(Context);
+    VectorVM::FExternalFuncRegisterHandler<int32> OutNumBands(Context);
+
+    const FAudioBandsSnapshotPtr Snapshot = GetProxyAs<FNiagaraDataInterfaceProxyAudioBands>()->GetSnapshot();
+    const int32 NumBands = Snapshot.IsValid() ? Snapshot->Bands.Num() : 0;
+    const float* Bands = Snapshot.IsValid() ? Snapshot->Bands.GetData() : nullptr;
+
+    for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
+        const int32 Index = InIndex.GetAndAdvance();
+        *OutValue.GetDestAndAdvance() = (Index >= 0 && Index < NumBands) ? Bands[Index] : 0.0f;
+        *OutNumBands.GetDestAndAdvance() = NumBands;
+    }
+}
+
+void UNiagaraDataInterfaceAudioBands::GetLevel(FVectorVMContext& Context)
+{
+    VectorVM::FExternalFuncRegisterHandler<float> OutRms(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutPeak(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutMomentaryLufs(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutShortTermLufs(Context);
+    VectorVM::FExternalFuncRegisterHandler<FNiagaraBool> OutOnset(Context);
+
+    const FAudioBandsSnapshotPtr Snapshot = GetProxyAs<FNiagaraDataInterfaceProxyAudioBands>()->GetSnapshot();
+    const float Rms = Snapshot.IsValid() ? Snapshot->Levels[0] : 0.0f;
+    const float Peak = Snapshot.IsValid() ? Snapshot->Levels[1] : 0.0f;
+    const float MomentaryLufs = Snapshot.IsValid() ? Snapshot->Levels[2] : FAudioLevelMetrics::MinLoudnessLufs;
+    const float ShortTermLufs = Snapshot.IsValid() ? Snapshot->Levels[3] : FAudioLevelMetrics::MinLoudnessLufs;
+    FNiagaraBool Onset;
+    Onset.SetValue(Snapshot.IsValid() && Snapshot->bOnset);
+
+    float* RmsDest = OutRms.GetDest();
+    float* PeakDest = OutPeak.GetDest();
+    float* MomentaryDest = OutMomentaryLufs.GetDest();
+    float* ShortTermDest = OutShortTermLufs.GetDest();
+    FNiagaraBool* OnsetDest = OutOnset.GetDest();
+
+    for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
+        RmsDest[InstanceIdx] = Rms;
+        PeakDest[InstanceIdx] = Peak;
+        MomentaryDest[InstanceIdx] = MomentaryLufs;
+        ShortTermDest[InstanceIdx] = ShortTermLufs;
+        OnsetDest[InstanceIdx] = Onset;
+    }
+}
+
+void UNiagaraDataInterfaceAudioBands::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+    Super::GetFunctions(OutFunctions);
+
+    {
+        FNiagaraFunctionSignature GetBands4Signature;
+        GetBands4Signature.Name = GetBands4FunctionName;
+        GetBands4Signature.Inputs.Add(FNiagaraVariable(GetClass(), TEXT("AudioBands")));
+        GetBands4Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec4Def(), TEXT("Bands")));
+        GetBands4Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec4Def(), TEXT("Onsets")));
+        GetBands4Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Level")));
+
+        GetBands4Signature.bMemberFunction = true;
+        GetBands4Signature.bRequiresContext = false;
+        OutFunctions.Add(GetBands4Signature);
+    }
+
+    {
+        FNiagaraFunctionSignature GetBandsArraySignature;
+        GetBandsArraySignature.Name = GetBandsArrayFunctionName;
+        GetBandsArraySignature.Inputs.Add(FNiagaraVariable(GetClass(), TEXT("AudioBands")));
+        GetBandsArraySignature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index")));
+        GetBandsArraySignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Value")));
+        GetBandsArraySignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("NumBands")));
+
+        GetBandsArraySignature.bMemberFunction = true;
+        GetBandsArraySignature.bRequiresContext = false;
+        OutFunctions.Add(GetBandsArraySignature);
+    }
+
+    {
+        FNiagaraFunctionSignature GetLevelSignature;
+        GetLevelSignature.Name = GetLevelFunctionName;
+        GetLevelSignature.Inputs.Add(FNiagaraVariable(GetClass(), TEXT("AudioBands")));
+        GetLevelSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Rms")));
+        GetLevelSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Peak")));
+        GetLevelSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("MomentaryLufs")));
+        GetLevelSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("ShortTermLufs")));
+        GetLevelSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Onset")));
+
+        GetLevelSignature.bMemberFunction = true;
+        GetLevelSignature.bRequiresContext = false;
+        OutFunctions.Add(GetLevelSignature);
+    }
+}
+
+DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceAudioBands, GetBands4);
+DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceAudioBands, GetBandsArray);
+DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceAudioBands, GetLevel);
+
+void UNiagaraDataInterfaceAudioBands::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo,
+    void* InstanceData, FVMExternalFunction& OutFunc)
+{
+    if (BindingInfo.Name == GetBands4FunctionName) {
+        NDI_FUNC_BINDER(UNiagaraDataInterfaceAudioBands, GetBands4)::Bind(this, OutFunc);
+    } else if (BindingInfo.Name == GetBandsArrayFunctionName) {
+        NDI_FUNC_BINDER(UNiagaraDataInterfaceAudioBands, GetBandsArray)::Bind(this, OutFunc);
+    } else if (BindingInfo.Name == GetLevelFunctionName) {
+        NDI_FUNC_BINDER(UNiagaraDataInterfaceAudioBands, GetLevel)::Bind(this, OutFunc);
+    } else {
+        ensureMsgf(false, TEXT("Error! Function defined for this class but not bound."));
+    }
+}
+
+bool UNiagaraDataInterfaceAudioBands::GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+    const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+    int FunctionInstanceIndex, FString& OutHLSL)
+{
+    bool ParentRet = Super::GetFunctionHLSL(ParamInfo, FunctionInfo, FunctionInstanceIndex, OutHLSL);
+    if (ParentRet) {
+        return true;
+    }
+
+    TMap<FString, FStringFormatArg> Args = {
+        { TEXT("FunctionName"), FStringFormatArg(FunctionInfo.InstanceName) },
+        { TEXT("Buffer"), FStringFormatArg(AudioBandsBufferName + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("NumBands"), FStringFormatArg(AudioBandsNumBandsName + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("Bands4"), FStringFormatArg(AudioBands4Name + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("Onsets4"), FStringFormatArg(AudioBandsOnsets4Name + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("Levels"), FStringFormatArg(AudioBandsLevelsName + ParamInfo.DataInterfaceHLSLSymbol) },
+    };
+
+    if (FunctionInfo.DefinitionName == GetBands4FunctionName) {
+        static const TCHAR* FormatBands4 = TEXT(
+            R"(
+			void {FunctionName}(out float4 Out_Bands, out float4 Out_Onsets, out float Out_Level)
+			{
+				Out_Bands = {Bands4};
+				Out_Onsets = {Onsets4};
+				Out_Level = {Levels}.x;
+			}
+		)");
+        OutHLSL += FString::Format(FormatBands4, Args);
+        return true;
+    } else if (FunctionInfo.DefinitionName == GetBandsArrayFunctionName) {
+        // See UNiagaraDataInterfaceAudioBands::GetBandsArray
+        static const TCHAR* FormatBandsArray = TEXT(
+            R"(
+			void {FunctionName}(int In_Index, out float Out_Value, out int Out_NumBands)
+			{
+				Out_Value = (In_Index >= 0 && In_Index < {NumBands}) ? {Buffer}.Load(In_Index) : 0.0;
+				Out_NumBands = {NumBands};
+			}
+		)");
+        OutHLSL += FString::Format(FormatBandsArray, Args);
+        return true;
+    } else if (FunctionInfo.DefinitionName == GetLevelFunctionName) {
+        static const TCHAR* FormatLevel = TEXT(
+            R"(
+			void {FunctionName}(out float Out_Rms, out float Out_Peak, out float Out_MomentaryLufs, out float Out_ShortTermLufs, out bool Out_Onset)
+			{
+				Out_Rms = {Levels}.x;
+				Out_Peak = {Levels}.y;
+				Out_MomentaryLufs = {Levels}.z;
+				Out_ShortTermLufs = {Levels}.w;
+				Out_Onset = any({Onsets4} > 0.0);
+			}
+		)");
+        OutHLSL += FString::Format(FormatLevel, Args);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void UNiagaraDataInterfaceAudioBands::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+    FString& OutHLSL)
+{
+    Super::GetParameterDefinitionHLSL(ParamInfo, OutHLSL);
+
+    static const TCHAR* FormatDeclarations = TEXT(R"(
+		Buffer<float> {BufferName};
+		int {NumBandsName};
+		float4 {Bands4Name};
+		float4 {Onsets4Name};
+		float4 {LevelsName};
+	)");
+
+    TMap<FString, FStringFormatArg> ArgsDeclarations = {
+        { TEXT("BufferName"), FStringFormatArg(AudioBandsBufferName + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("NumBandsName"), FStringFormatArg(AudioBandsNumBandsName + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("Bands4Name"), FStringFormatArg(AudioBands4Name + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("Onsets4Name"), FStringFormatArg(AudioBandsOnsets4Name + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("LevelsName"), FStringFormatArg(AudioBandsLevelsName + ParamInfo.DataInterfaceHLSLSymbol) },
+    };
+    OutHLSL += FString::Format(FormatDeclarations, ArgsDeclarations);
+}
+
+struct FNiagaraDataInterfaceParametersCS_AudioBands : public FNiagaraDataInterfaceParametersCS {
+    DECLARE_INLINE_TYPE_LAYOUT(FNiagaraDataInterfaceParametersCS_AudioBands, NonVirtual);
+
+    void Bind(const FNiagaraDataInterfaceGPUParamInfo& ParameterInfo, const class FShaderParameterMap& ParameterMap)
+    {
+        BandsBuffer.Bind(ParameterMap, *(AudioBandsBufferName + ParameterInfo.DataInterfaceHLSLSymbol));
+        NumBands.Bind(ParameterMap, *(AudioBandsNumBandsName + ParameterInfo.DataInterfaceHLSLSymbol));
+        Bands4.Bind(ParameterMap, *(AudioBands4Name + ParameterInfo.DataInterfaceHLSLSymbol));
+        Onsets4.Bind(ParameterMap, *(AudioBandsOnsets4Name + ParameterInfo.DataInterfaceHLSLSymbol));
+        Levels.Bind(ParameterMap, *(AudioBandsLevelsName + ParameterInfo.DataInterfaceHLSLSymbol));
+    }
+
+    void Set(FRHICommandList& RHICmdList, const FNiagaraDataInterfaceSetArgs& Context) const
+    {
+        check(IsInRenderingThread());
+
+        FRHIComputeShader* ComputeShaderRHI = Context.Shader.GetComputeShader();
+
+        FNiagaraDataInterfaceProxyAudioBands* NDI = (FNiagaraDataInterfaceProxyAudioBands*)Context.DataInterface;
+        FReadBuffer& BandsSRV = NDI->GetBandsSRV();
+
+        RHICmdList.SetShaderResourceViewParameter(ComputeShaderRHI, BandsBuffer.GetBaseIndex(), BandsSRV.SRV);
+        SetShaderValue(RHICmdList, ComputeShaderRHI, NumBands, NDI->GetGPUNumBands());
+        SetShaderValue(RHICmdList, ComputeShaderRHI, Bands4, NDI->GetGPUBands4());
+        SetShaderValue(RHICmdList, ComputeShaderRHI, Onsets4, NDI->GetGPUOnsets4());
+        SetShaderValue(RHICmdList, ComputeShaderRHI, Levels, NDI->GetGPULevels());
+    }
+
+    LAYOUT_FIELD(FShaderResourceParameter, BandsBuffer);
+    LAYOUT_FIELD(FShaderParameter, NumBands);
+    LAYOUT_FIELD(FShaderParameter, Bands4);
+    LAYOUT_FIELD(FShaderParameter, Onsets4);
+    LAYOUT_FIELD(FShaderParameter, Levels);
+};
+
+IMPLEMENT_NIAGARA_DI_PARAMETER(UNiagaraDataInterfaceAudioBands, FNiagaraDataInterfaceParametersCS_AudioBands);
+
+void UNiagaraDataInterfaceAudioBands::PostInitProperties()
+{
+    Super::PostInitProperties();
+
+    if (HasAnyFlags(RF_ClassDefaultObject)) {
+        FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), /*bCanBeParameter*/ true, /*bCanBePayload*/
+            false, /*bIsUserDefined*/ false);
+    }
+}
+
+bool UNiagaraDataInterfaceAudioBands::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+    FNDIAudioBandsInstanceData* InstanceData = new (PerInstanceData) FNDIAudioBandsInstanceData();
+
+    if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+        Subsystem->AcquireCapture();
+        InstanceData->bCaptureAcquired = true;
+    }
+    return true;
+}
+
+void UNiagaraDataInterfaceAudioBands::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+    FNDIAudioBandsInstanceData* InstanceData = static_cast<FNDIAudioBandsInstanceData*>(PerInstanceData);
+
+    if (InstanceData->bCaptureAcquired) {
+        if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+            Subsystem->ReleaseCapture();
+        }
+    }
+    InstanceData->~FNDIAudioBandsInstanceData();
+}
+
+bool UNiagaraDataInterfaceAudioBands::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+    WAC_LLM_SCOPE();
+
+    // Game thread: one worker query per frame, shared by the VM and the GPU
+    UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    if (Worker != nullptr) {
+        const FAudioSpectrumScalingProfile Profile;
+        const FAudioBandOnsets Onsets = Worker->GetBandOnsets(Profile);
+        const TArray<float> Bands = Worker->GetBandSpectrum(Profile);
+
+        GetProxyAs<FNiagaraDataInterfaceProxyAudioBands>()->UpdateSnapshot(Onsets, Bands, Worker->GetLatestLevels());
+    }
+    return false;
+}
+
+bool UNiagaraDataInterfaceAudioBands::Equals(const UNiagaraDataInterface* Other) const
+{
+    return Super::Equals(Other);
+}
+
+bool UNiagaraDataInterfaceAudioBands::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+    return Super::CopyToInternal(Destination);
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,377 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NiagaraDataInterfaceAudioWaveform.h"
+#include "AudioCaptureWorker.h"
+#include "WindowsAudioCaptureSubsystem.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "NiagaraShader.h"
+#include "NiagaraTypes.h"
+
+#define LOCTEXT_NAMESPACE "NiagaraDataInterfaceAudioWaveform"
+
+// Global VM function names, also used by the shaders code generation methods.
+static const FName SampleWaveformFunctionName("SampleWaveform");
+static const FName GetWaveformResolutionFunctionName("GetWaveformResolution");
+
+// Global variable prefixes, used in HLSL parameter declarations.
+static const FString WaveformEnvelopeName(TEXT("WaveformEnvelope_"));
+static const FString WaveformNumPointsName(TEXT("WaveformNumPoints_"));
+
+// Floats per point in the envelope: min, max, rms
+static const int32 ValuesPerPoint = 3;
+
+FNiagaraDataInterfaceProxyAudioWaveform::FNiagaraDataInterfaceProxyAudioWaveform()
+    : LastUpdateFrame(0)
+    , GPUNumPoints(0)
+{
+}
+
+FNiagaraDataInterfaceProxyAudioWaveform::~FNiagaraDataInterfaceProxyAudioWaveform()
+{
+    check(IsInRenderingThread());
+    GPUEnvelopeBuffer.Release();
+}
+
+void FNiagaraDataInterfaceProxyAudioWaveform::UpdateEnvelope(const FAudioWaveformEnvelopePtr& InEnvelope)
+{
+    check(IsInGameThread());
+
+    // Every system instance ticks the data interface, one envelope per frame is enough
+    if (LastUpdateFrame == GFrameCounter) {
+        return;
+    }
+    LastUpdateFrame = GFrameCounter;
+
+    {
+        FScopeLock ScopeLock(&EnvelopeLock);
+        Envelope = InEnvelope;
+    }
+
+    FNiagaraDataInterfaceProxyAudioWaveform* WaveformProxy = this;
+    ENQUEUE_RENDER_COMMAND(FUpdateDIAudioWaveform)
+    (
+        [WaveformProxy, InEnvelope](FRHICommandListImmediate& RHICmdList) {
+            WaveformProxy->UploadEnvelope(*InEnvelope);
+        });
+}
+
+FAudioWaveformEnvelopePtr FNiagaraDataInterfaceProxyAudioWaveform::GetEnvelope()
+{
+    FScopeLock ScopeLock(&EnvelopeLock);
+    return Envelope;
+}
+
+void FNiagaraDataInterfaceProxyAudioWaveform::UploadEnvelope(const TArray<float>& InEnvelope)
+{
+    check(IsInRenderingThread());
+
+    const uint32 BufferSize = InEnvelope.Num() * sizeof(float);
+    if (BufferSize == 0) {
+        GPUNumPoints = 0;
+        return;
+    }
+
+    if (GPUEnvelopeBuffer.NumBytes != BufferSize) {
+        GPUEnvelopeBuffer.Release();
+        GPUEnvelopeBuffer.Initialize(sizeof(float), InEnvelope.Num(), EPixelFormat::PF_R32_FLOAT, BUF_Dynamic);
+    }
+
+    float* BufferData = static_cast<float*>(RHILockVertexBuffer(GPUEnvelopeBuffer.Buffer, 0, BufferSize, EResourceLockMode::RLM_WriteOnly));
+    FPlatformMemory::Memcpy(BufferData, InEnvelope.GetData(), BufferSize);
+    RHIUnlockVertexBuffer(GPUEnvelopeBuffer.Buffer);
+
+    GPUNumPoints = InEnvelope.Num() / ValuesPerPoint;
+}
+
+FReadBuffer& FNiagaraDataInterfaceProxyAudioWaveform::GetEnvelopeSRV()
+{
+    check(IsInRenderingThread());
+
+    // The shader needs a view before the first envelope arrives, it reads no point while GPUNumPoints is 0
+    if (GPUEnvelopeBuffer.NumBytes == 0) {
+        GPUEnvelopeBuffer.Initialize(sizeof(float), ValuesPerPoint, EPixelFormat::PF_R32_FLOAT, BUF_Dynamic);
+        GPUNumPoints = 0;
+    }
+    return GPUEnvelopeBuffer;
+}
+
+UNiagaraDataInterfaceAudioWaveform::UNiagaraDataInterfaceAudioWaveform(FObjectInitializer const& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    Proxy = TUniquePtr<FNiagaraDataInterfaceProxyAudioWaveform>(new FNiagaraDataInterfaceProxyAudioWaveform());
+}
+
+void UNiagaraDataInterfaceAudioWaveform::SampleWaveform(FVectorVMContext& Context)
+{
+    VectorVM::FExternalFuncInputHandler<float> InNormalizedPos(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutMin(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutMax(Context);
+    VectorVM::FExternalFuncRegisterHandler<float> OutRms(Context);
+
+    // One lookup per batch, the envelope itself is never modified
+    const FAudioWaveformEnvelopePtr Envelope = GetProxyAs<FNiagaraDataInterfaceProxyAudioWaveform>()->GetEnvelope();
+    const int32 NumPoints = Envelope.IsValid() ? Envelope->Num() / ValuesPerPoint : 0;
+    const float* Values = Envelope.IsValid() ? Envelope->GetData() : nullptr;
+
+    for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
+        float Min = 0.0f;
+        float Max = 0.0f;
+        float Rms = 0.0f;
+
+        if (NumPoints > 0) {
+            // Linear between the two nearest points, same as the HLSL below
+            const float Position = FMath::Clamp(InNormalizedPos.Get(), 0.0f, 1.0f) * (NumPoints - 1);
+            const int32 Index = FMath::Min(FMath::FloorToInt(Position), NumPoints - 1);
+            const int32 Next = FMath::Min(Index + 1, NumPoints - 1);
+            const float Alpha = Position - Index;
+
+            Min = FMath::Lerp(Values[Index * ValuesPerPoint], Values[Next * ValuesPerPoint], Alpha);
+            Max = FMath::Lerp(Values[Index * ValuesPerPoint + 1], Values[Next * ValuesPerPoint + 1], Alpha);
+            Rms = FMath::Lerp(Values[Index * ValuesPerPoint + 2], Values[Next * ValuesPerPoint + 2], Alpha);
+        }
+
+        *OutMin.GetDestAndAdvance() = Min;
+        *OutMax.GetDestAndAdvance() = Max;
+        *OutRms.GetDestAndAdvance() = Rms;
+        InNormalizedPos.Advance();
+    }
+}
+
+void UNiagaraDataInterfaceAudioWaveform::GetWaveformResolution(FVectorVMContext& Context)
+{
+    VectorVM::FExternalFuncRegisterHandler<int32> OutNumPoints(Context);
+
+    const FAudioWaveformEnvelopePtr Envelope = GetProxyAs<FNiagaraDataInterfaceProxyAudioWaveform>()->GetEnvelope();
+    const int32 NumPoints = Envelope.IsValid() ? Envelope->Num() / ValuesPerPoint : 0;
+
+    for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
+        *OutNumPoints.GetDestAndAdvance() = NumPoints;
+    }
+}
+
+void UNiagaraDataInterfaceAudioWaveform::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+    Super::GetFunctions(OutFunctions);
+
+    {
+        FNiagaraFunctionSignature SampleWaveformSignature;
+        SampleWaveformSignature.Name = SampleWaveformFunctionName;
+        SampleWaveformSignature.Inputs.Add(FNiagaraVariable(GetClass(), TEXT("Waveform")));
+        SampleWaveformSignature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("NormalizedPosition")));
+        SampleWaveformSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Min")));
+        SampleWaveformSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Max")));
+        SampleWaveformSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Rms")));
+
+        SampleWaveformSignature.bMemberFunction = true;
+        SampleWaveformSignature.bRequiresContext = false;
+        OutFunctions.Add(SampleWaveformSignature);
+    }
+
+    {
+        FNiagaraFunctionSignature GetResolutionSignature;
+        GetResolutionSignature.Name = GetWaveformResolutionFunctionName;
+        GetResolutionSignature.Inputs.Add(FNiagaraVariable(GetClass(), TEXT("Waveform")));
+        GetResolutionSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("NumPoints")));
+
+        GetResolutionSignature.bMemberFunction = true;
+        GetResolutionSignature.bRequiresContext = false;
+        OutFunctions.Add(GetResolutionSignature);
+    }
+}
+
+DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceAudioWaveform, SampleWaveform);
+DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceAudioWaveform, GetWaveformResolution);
+
+void UNiagaraDataInterfaceAudioWaveform::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo,
+    void* InstanceData, FVMExternalFunction& OutFunc)
+{
+    if (BindingInfo.Name == SampleWaveformFunctionName) {
+        NDI_FUNC_BINDER(UNiagaraDataInterfaceAudioWaveform, SampleWaveform)::Bind(this, OutFunc);
+    } else if (BindingInfo.Name == GetWaveformResolutionFunctionName) {
+        NDI_FUNC_BINDER(UNiagaraDataInterfaceAudioWaveform, GetWaveformResolution)::Bind(this, OutFunc);
+    } else {
+        ensureMsgf(false, TEXT("Error! Function defined for this class but not bound."));
+    }
+}
+
+bool UNiagaraDataInterfaceAudioWaveform::GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+    const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+    int FunctionInstanceIndex, FString& OutHLSL)
+{
+    bool ParentRet = Super::GetFunctionHLSL(ParamInfo, FunctionInfo, FunctionInstanceIndex, OutHLSL);
+    if (ParentRet) {
+        return true;
+    }
+
+    TMap<FString, FStringFormatArg> Args = {
+        { TEXT("FunctionName"), FStringFormatArg(FunctionInfo.InstanceName) },
+        { TEXT("Envelope"), FStringFormatArg(WaveformEnvelopeName + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("NumPoints"), FStringFormatArg(WaveformNumPointsName + ParamInfo.DataInterfaceHLSLSymbol) },
+    };
+
+    if (FunctionInfo.DefinitionName == SampleWaveformFunctionName) {
+        // See UNiagaraDataInterfaceAudioWaveform::SampleWaveform
+        static const TCHAR* FormatSample = TEXT(
+            R"(
+			void {FunctionName}(float In_NormalizedPosition, out float Out_Min, out float Out_Max, out float Out_Rms)
+			{
+				Out_Min = 0.0;
+				Out_Max = 0.0;
+				Out_Rms = 0.0;
+				if ({NumPoints} > 0)
+				{
+					float Position = saturate(In_NormalizedPosition) * ({NumPoints} - 1);
+					int Index = min((int)floor(Position), {NumPoints} - 1);
+					int Next = min(Index + 1, {NumPoints} - 1);
+					float Alpha = Position - Index;
+					Out_Min = lerp({Envelope}.Load(Index * 3), {Envelope}.Load(Next * 3), Alpha);
+					Out_Max = lerp({Envelope}.Load(Index * 3 + 1), {Envelope}.Load(Next * 3 + 1), Alpha);
+					Out_Rms = lerp({Envelope}.Load(Index * 3 + 2), {Envelope}.Load(Next * 3 + 2), Alpha);
+				}
+			}
+		)");
+        OutHLSL += FString::Format(FormatSample, Args);
+        return true;
+    } else if (FunctionInfo.DefinitionName == GetWaveformResolutionFunctionName) {
+        static const TCHAR* FormatResolution = TEXT(
+            R"(
+			void {FunctionName}(out int Out_NumPoints)
+			{
+				Out_NumPoints = {NumPoints};
+			}
+		)");
+        OutHLSL += FString::Format(FormatResolution, Args);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void UNiagaraDataInterfaceAudioWaveform::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+    FString& OutHLSL)
+{
+    Super::GetParameterDefinitionHLSL(ParamInfo, OutHLSL);
+
+    static const TCHAR* FormatDeclarations = TEXT(R"(
+		Buffer<float> {EnvelopeName};
+		int {NumPointsName};
+	)");
+
+    TMap<FString, FStringFormatArg> ArgsDeclarations = {
+        { TEXT("EnvelopeName"), FStringFormatArg(WaveformEnvelopeName + ParamInfo.DataInterfaceHLSLSymbol) },
+        { TEXT("NumPointsName"), FStringFormatArg(WaveformNumPointsName + ParamInfo.DataInterfaceHLSLSymbol) },
+    };
+    OutHLSL += FString::Format(FormatDeclarations, ArgsDeclarations);
+}
+
+struct FNiagaraDataInterfaceParametersCS_AudioWaveform : public FNiagaraDataInterfaceParametersCS {
+    DECLARE_INLINE_TYPE_LAYOUT(FNiagaraDataInterfaceParametersCS_AudioWaveform, NonVirtual);
+
+    void Bind(const FNiagaraDataInterfaceGPUParamInfo& ParameterInfo, const class FShaderParameterMap& ParameterMap)
+    {
+        Envelope.Bind(ParameterMap, *(WaveformEnvelopeName + ParameterInfo.DataInterfaceHLSLSymbol));
+        NumPoints.Bind(ParameterMap, *(WaveformNumPointsName + ParameterInfo.DataInterfaceHLSLSymbol));
+    }
+
+    void Set(FRHICommandList& RHICmdList, const FNiagaraDataInterfaceSetArgs& Context) const
+    {
+        check(IsInRenderingThread());
+
+        FRHIComputeShader* ComputeShaderRHI = Context.Shader.GetComputeShader();
+
+        FNiagaraDataInterfaceProxyAudioWaveform* NDI = (FNiagaraDataInterfaceProxyAudioWaveform*)Context.DataInterface;
+        FReadBuffer& EnvelopeSRV = NDI->GetEnvelopeSRV();
+
+        RHICmdList.SetShaderResourceViewParameter(ComputeShaderRHI, Envelope.GetBaseIndex(), EnvelopeSRV.SRV);
+        SetShaderValue(RHICmdList, ComputeShaderRHI, NumPoints, NDI->GetGPUNumPoints());
+    }
+
+    LAYOUT_FIELD(FShaderResourceParameter, Envelope);
+    LAYOUT_FIELD(FShaderParameter, NumPoints);
+};
+
+IMPLEMENT_NIAGARA_DI_PARAMETER(UNiagaraDataInterfaceAudioWaveform, FNiagaraDataInterfaceParametersCS_AudioWaveform);
+
+void UNiagaraDataInterfaceAudioWaveform::PostInitProperties()
+{
+    Super::PostInitProperties();
+
+    if (HasAnyFlags(RF_ClassDefaultObject)) {
+        FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), /*bCanBeParameter*/ true, /*bCanBePayload*/
+            false, /*bIsUserDefined*/ false);
+    }
+}
+
+bool UNiagaraDataInterfaceAudioWaveform::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+    FNDIAudioWaveformInstanceData* InstanceData = new (PerInstanceData) FNDIAudioWaveformInstanceData();
+
+    if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+        Subsystem->AcquireCapture();
+        InstanceData->bCaptureAcquired = true;
+    }
+    return true;
+}
+
+void UNiagaraDataInterfaceAudioWaveform::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+    FNDIAudioWaveformInstanceData* InstanceData = static_cast<FNDIAudioWaveformInstanceData*>(PerInstanceData);
+
+    if (InstanceData->bCaptureAcquired) {
+        if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+            Subsystem->ReleaseCapture();
+        }
+    }
+    InstanceData->~FNDIAudioWaveformInstanceData();
+}
+
+bool UNiagaraDataInterfaceAudioWaveform::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+    WAC_LLM_SCOPE();
+
+    // Game thread: query the envelope once, interleave it for the VM and the GPU buffer
+    UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    if (Worker != nullptr) {
+        TArray<float> Min;
+        TArray<float> Max;
+        TArray<float> Rms;
+        Worker->GetWaveformEnvelope(WindowSeconds, FMath::Clamp(Resolution, 2, 4096), Min, Max, Rms);
+
+        TSharedPtr<TArray<float>, ESPMode::ThreadSafe> Envelope = MakeShared<TArray<float>, ESPMode::ThreadSafe>();
+        Envelope->SetNumUninitialized(Min.Num() * ValuesPerPoint);
+        for (int32 Point = 0; Point < Min.Num(); ++Point) {
+            (*Envelope)[Point * ValuesPerPoint] = Min[Point];
+            (*Envelope)[Point * ValuesPerPoint + 1] = Max[Point];
+            (*Envelope)[Point * ValuesPerPoint + 2] = Rms[Point];
+        }
+
+        GetProxyAs<FNiagaraDataInterfaceProxyAudioWaveform>()->UpdateEnvelope(Envelope);
+    }
+    return false;
+}
+
+bool UNiagaraDataInterfaceAudioWaveform::Equals(const UNiagaraDataInterface* Other) const
+{
+    const UNiagaraDataInterfaceAudioWaveform* CastedOther = Cast<const UNiagaraDataInterfaceAudioWaveform>(Other);
+    return Super::Equals(Other)
+        && (CastedOther->WindowSeconds == WindowSeconds)
+        && (CastedOther->Resolution == Resolution);
+}
+
+bool UNiagaraDataInterfaceAudioWaveform::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+    Super::CopyToInternal(Destination);
+
+    UNiagaraDataInterfaceAudioWaveform* CastedDestination = Cast<UNiagaraDataInterfaceAudioWaveform>(Destination);
+
+    if (CastedDestination) {
+        CastedDestination->WindowSeconds = WindowSeconds;
+        CastedDestination->Resolution = Resolution;
+    }
+
+    return true;
+}
+
+#undef LOCTEXT_NAMESPACE
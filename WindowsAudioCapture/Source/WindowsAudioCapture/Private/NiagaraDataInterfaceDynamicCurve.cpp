@@ -2,6 +2,9 @@
 
 #include "NiagaraDataInterfaceDynamicCurve.h"
 #include "../Plugins/FX/Niagara/Source/Niagara/Public/NiagaraCommon.h"
+#include "AudioCaptureWorker.h"
+#include "WindowsAudioCaptureSubsystem.h"
+#include "WindowsAudioCaptureMemory.h"
 #include "Curves/CurveFloat.h"
 #include "Curves/CurveLinearColor.h"
 #include "Curves/CurveVector.h"
@@ -13,18 +16,25 @@
 
 // Global VM function names, also used by the shaders code generation methods.
 static const FName SampleAudioBufferFunctionName("SampleAudioBuffer");
+static const FName GetNumChannelsFunctionName("GetNumChannels");
 
 // Global variable prefixes, used in HLSL parameter declarations.
 static const FString AudioBufferName(TEXT("AudioBuffer_"));
 
 FNiagaraDataInterfaceProxyDynamicCurve::FNiagaraDataInterfaceProxyDynamicCurve()
     : CurveFloatRegisteredTo(nullptr)
+    , bReadCaptureDirectly(false)
+    , DecodedFrameIndex(0)
     , NumChannelsInDownsampledBuffer(0)
+    , Memory(EWACMemory::Niagara)
 {
+    WAC_LLM_SCOPE();
+
     //     UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FNiagaraDataInterfaceProxyDynamicCurve::FNiagaraDataInterfaceProxyDynamicCurve"));
     VectorVMReadBuffer.Reset();
     VectorVMReadBuffer.AddZeroed(
         UNiagaraDataInterfaceDynamicCurve::MaxBufferResolution /** AUDIO_MIXER_MAX_OUTPUT_CHANNELS*/);
+    UpdateMemory();
 }
 
 FNiagaraDataInterfaceProxyDynamicCurve::~FNiagaraDataInterfaceProxyDynamicCurve()
@@ -37,12 +47,50 @@ FNiagaraDataInterfaceProxyDynamicCurve::~FNiagaraDataInterfaceProxyDynamicCurve(
 void FNiagaraDataInterfaceProxyDynamicCurve::OnUpdateFloatCurve(UCurveFloat* Curve)
 {
     //UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FNiagaraDataInterfaceProxyDynamicCurve::OnUpdateFloatCurve(%p)"), Curve);
+    WAC_LLM_SCOPE();
+
     CurveFloatRegisteredTo = Curve;
     if (Curve != nullptr) {
         FScopeLock ScopeLock(&DownsampleBufferLock);
         VectorVMReadBuffer.Reset();
         VectorVMReadBuffer.AddZeroed(Curve->FloatCurve.GetNumKeys());
+        UpdateMemory();
+    }
+}
+
+void FNiagaraDataInterfaceProxyDynamicCurve::OnUpdateSource(UCurveFloat* Curve, bool bInReadCaptureDirectly)
+{
+    WAC_LLM_SCOPE();
+
+    if (!bInReadCaptureDirectly) {
+        {
+            FScopeLock ScopeLock(&DownsampleBufferLock);
+            bReadCaptureDirectly = false;
+            CompactSpectrum.Reset();
+        }
+        OnUpdateFloatCurve(Curve);
+        return;
     }
+
+    CurveFloatRegisteredTo = nullptr;
+
+    FScopeLock ScopeLock(&DownsampleBufferLock);
+    bReadCaptureDirectly = true;
+    DecodedFrameIndex = 0;
+    VectorVMReadBuffer.Reset();
+    VectorVMReadBuffer.AddZeroed(UNiagaraDataInterfaceDynamicCurve::MaxBufferResolution);
+    UpdateMemory();
+}
+
+void FNiagaraDataInterfaceProxyDynamicCurve::UpdateMemory()
+{
+    Memory.Set(VectorVMReadBuffer.GetAllocatedSize() + DownsampledBuffer.GetAllocatedSize());
+}
+
+void FNiagaraDataInterfaceProxyDynamicCurve::OnUpdateCompactSpectrum(const FAudioCompactSpectrumPtr& Compact)
+{
+    FScopeLock ScopeLock(&DownsampleBufferLock);
+    CompactSpectrum = Compact;
 }
 
 UNiagaraDataInterfaceDynamicCurve::UNiagaraDataInterfaceDynamicCurve(FObjectInitializer const& ObjectInitializer)
@@ -91,10 +139,14 @@ int32 FNiagaraDataInterfaceProxyDynamicCurve::GetNumChannels()
 void UNiagaraDataInterfaceDynamicCurve::GetNumChannels(FVectorVMContext& Context)
 {
     //     UE_LOG(WindowsAudioCaptureLog, Log, TEXT("UNiagaraDataInterfaceDynamicCurve::GetNumChannels"));
+    FNiagaraDataInterfaceProxyDynamicCurve* CurveProxy = GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>();
+    CurveProxy->DownsampleAudioToBuffer();
+    const int32 NumChannels = CurveProxy->GetNumChannels();
+
     VectorVM::FExternalFuncRegisterHandler<int32> OutChannel(Context);
 
     for (int32 InstanceIdx = 0; InstanceIdx < Context.NumInstances; ++InstanceIdx) {
-        *OutChannel.GetDestAndAdvance() = GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->GetNumChannels();
+        *OutChannel.GetDestAndAdvance() = NumChannels;
     }
 }
 
@@ -116,9 +168,21 @@ void UNiagaraDataInterfaceDynamicCurve::GetFunctions(TArray<FNiagaraFunctionSign
         SampleAudioBufferSignature.bRequiresContext = false;
         OutFunctions.Add(SampleAudioBufferSignature);
     }
+
+    {
+        FNiagaraFunctionSignature GetNumChannelsSignature;
+        GetNumChannelsSignature.Name = GetNumChannelsFunctionName;
+        GetNumChannelsSignature.Inputs.Add(FNiagaraVariable(GetClass(), TEXT("Curve")));
+        GetNumChannelsSignature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("NumChannels")));
+
+        GetNumChannelsSignature.bMemberFunction = true;
+        GetNumChannelsSignature.bRequiresContext = false;
+        OutFunctions.Add(GetNumChannelsSignature);
+    }
 }
 
 DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceDynamicCurve, SampleAudio);
+DEFINE_NDI_DIRECT_FUNC_BINDER(UNiagaraDataInterfaceDynamicCurve, GetNumChannels);
 
 void UNiagaraDataInterfaceDynamicCurve::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo,
     void* InstanceData, FVMExternalFunction& OutFunc)
@@ -126,6 +190,8 @@ void UNiagaraDataInterfaceDynamicCurve::GetVMExternalFunction(const FVMExternalF
     //     UE_LOG(WindowsAudioCaptureLog, Log, TEXT("UNiagaraDataInterfaceDynamicCurve::GetVMExternalFunction"));
     if (BindingInfo.Name == SampleAudioBufferFunctionName) {
         NDI_FUNC_BINDER(UNiagaraDataInterfaceDynamicCurve, SampleAudio)::Bind(this, OutFunc);
+    } else if (BindingInfo.Name == GetNumChannelsFunctionName) {
+        NDI_FUNC_BINDER(UNiagaraDataInterfaceDynamicCurve, GetNumChannels)::Bind(this, OutFunc);
     } else {
         ensureMsgf(false, TEXT("Error! Function defined for this class but not bound."));
     }
@@ -154,10 +220,25 @@ bool UNiagaraDataInterfaceDynamicCurve::GetFunctionHLSL(const FNiagaraDataInterf
         TMap<FString, FStringFormatArg> ArgsBounds = {
             { TEXT("FunctionName"), FStringFormatArg(FunctionInfo.InstanceName) },
             { TEXT("AudioBuffer"), FStringFormatArg(AudioBufferName + ParamInfo.DataInterfaceHLSLSymbol) },
-            { TEXT("AudioBufferNumSamples"), FStringFormatArg(FloatCurve != nullptr ? FloatCurve->FloatCurve.GetNumKeys() : 0) },
+            { TEXT("AudioBufferNumSamples"), FStringFormatArg(bReadCaptureDirectly ? MaxBufferResolution : (FloatCurve != nullptr ? FloatCurve->FloatCurve.GetNumKeys() : 0)) },
         };
         OutHLSL += FString::Format(FormatBounds, ArgsBounds);
         return true;
+    } else if (FunctionInfo.DefinitionName == GetNumChannelsFunctionName) {
+        // The buffer holds one curve (or one spectrum) whichever source fills it
+        static const TCHAR* FormatNumChannels = TEXT(
+            R"(
+			void {FunctionName}(out int Out_NumChannels)
+			{
+				Out_NumChannels = {NumChannels};
+			}
+		)");
+        TMap<FString, FStringFormatArg> ArgsNumChannels = {
+            { TEXT("FunctionName"), FStringFormatArg(FunctionInfo.InstanceName) },
+            { TEXT("NumChannels"), FStringFormatArg((bReadCaptureDirectly || FloatCurve != nullptr) ? 1 : 0) },
+        };
+        OutHLSL += FString::Format(FormatNumChannels, ArgsNumChannels);
+        return true;
     } else {
         return false;
     }
@@ -222,12 +303,13 @@ void UNiagaraDataInterfaceDynamicCurve::PostEditChangeProperty(struct FPropertyC
     Super::PostEditChangeProperty(PropertyChangedEvent);
 
     static FName FloatCurveFName = GET_MEMBER_NAME_CHECKED(UNiagaraDataInterfaceDynamicCurve, FloatCurve);
+    static FName ReadCaptureDirectlyFName = GET_MEMBER_NAME_CHECKED(UNiagaraDataInterfaceDynamicCurve, bReadCaptureDirectly);
 
     // Regenerate on save any compressed sound formats or if analysis needs to be re-done
     if (FProperty* PropertyThatChanged = PropertyChangedEvent.Property) {
         const FName& Name = PropertyThatChanged->GetFName();
-        if (Name == FloatCurveFName) {
-            GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateFloatCurve(FloatCurve);
+        if (Name == FloatCurveFName || Name == ReadCaptureDirectlyFName) {
+            GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateSource(FloatCurve, bReadCaptureDirectly);
         }
     }
 }
@@ -243,7 +325,7 @@ void UNiagaraDataInterfaceDynamicCurve::PostInitProperties()
             false, /*bIsUserDefined*/ false);
     }
 
-    GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateFloatCurve(FloatCurve);
+    GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateSource(FloatCurve, bReadCaptureDirectly);
 }
 
 void FNiagaraDataInterfaceProxyDynamicCurve::OnBeginDestroy()
@@ -263,7 +345,49 @@ void UNiagaraDataInterfaceDynamicCurve::PostLoad()
 {
     //UE_LOG(WindowsAudioCaptureLog, Log, TEXT("UNiagaraDataInterfaceDynamicCurve::PostLoad"));
     Super::PostLoad();
-    GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateFloatCurve(FloatCurve);
+    GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateSource(FloatCurve, bReadCaptureDirectly);
+}
+
+bool UNiagaraDataInterfaceDynamicCurve::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+    FNDIDynamicCurveInstanceData* InstanceData = new (PerInstanceData) FNDIDynamicCurveInstanceData();
+
+    if (bReadCaptureDirectly) {
+        if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+            Subsystem->AcquireCapture();
+            InstanceData->bCaptureAcquired = true;
+        }
+    }
+    return true;
+}
+
+void UNiagaraDataInterfaceDynamicCurve::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+    FNDIDynamicCurveInstanceData* InstanceData = static_cast<FNDIDynamicCurveInstanceData*>(PerInstanceData);
+
+    if (InstanceData->bCaptureAcquired) {
+        if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+            Subsystem->ReleaseCapture();
+        }
+    }
+    InstanceData->~FNDIDynamicCurveInstanceData();
+}
+
+bool UNiagaraDataInterfaceDynamicCurve::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+    // Game thread: hand the latest compact spectrum to the proxy, the VM and the render thread decode it
+    if (bReadCaptureDirectly) {
+        UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+        FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+        if (Worker != nullptr) {
+            FAudioCompactSpectrumPtr Compact = Worker->GetCompactSpectrum(FAudioSpectrumScalingProfile(), CompactPrecision);
+            if (Compact.IsValid()) {
+                GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateCompactSpectrum(Compact);
+            }
+        }
+    }
+    return false;
 }
 
 bool UNiagaraDataInterfaceDynamicCurve::Equals(const UNiagaraDataInterface* Other) const
@@ -271,7 +395,9 @@ bool UNiagaraDataInterfaceDynamicCurve::Equals(const UNiagaraDataInterface* Othe
     //     UE_LOG(WindowsAudioCaptureLog, Log, TEXT("UNiagaraDataInterfaceDynamicCurve::Equals"));
     const UNiagaraDataInterfaceDynamicCurve* CastedOther = Cast<const UNiagaraDataInterfaceDynamicCurve>(Other);
     return Super::Equals(Other)
-        && (CastedOther->FloatCurve == FloatCurve);
+        && (CastedOther->FloatCurve == FloatCurve)
+        && (CastedOther->bReadCaptureDirectly == bReadCaptureDirectly)
+        && (CastedOther->CompactPrecision == CompactPrecision);
 }
 
 bool UNiagaraDataInterfaceDynamicCurve::CopyToInternal(UNiagaraDataInterface* Destination) const
@@ -283,7 +409,9 @@ bool UNiagaraDataInterfaceDynamicCurve::CopyToInternal(UNiagaraDataInterface* De
 
     if (CastedDestination) {
         CastedDestination->FloatCurve = FloatCurve;
-        CastedDestination->GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateFloatCurve(FloatCurve);
+        CastedDestination->bReadCaptureDirectly = bReadCaptureDirectly;
+        CastedDestination->CompactPrecision = CompactPrecision;
+        CastedDestination->GetProxyAs<FNiagaraDataInterfaceProxyDynamicCurve>()->OnUpdateSource(FloatCurve, bReadCaptureDirectly);
     }
 
     return true;
@@ -295,6 +423,8 @@ void FNiagaraDataInterfaceProxyDynamicCurve::PostAudioToGPU()
     ENQUEUE_RENDER_COMMAND(FUpdateDIAudioBuffer)
     (
         [&](FRHICommandListImmediate& RHICmdList) {
+            WAC_LLM_SCOPE();
+
             DownsampleAudioToBuffer();
             size_t BufferSize = DownsampledBuffer.Num() * sizeof(float);
             //             UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FNiagaraDataInterfaceProxyDynamicCurve::ENQUEUE_RENDER_COMMAND; BufferSize=%d"), BufferSize);
@@ -315,6 +445,25 @@ void FNiagaraDataInterfaceProxyDynamicCurve::PostAudioToGPU()
 
 int32 FNiagaraDataInterfaceProxyDynamicCurve::DownsampleAudioToBuffer()
 {
+    WAC_LLM_SCOPE();
+
+    if (bReadCaptureDirectly) {
+        FScopeLock ScopeLock(&DownsampleBufferLock);
+
+        // Decoded once per frame, whichever of the VM and the render thread gets here first
+        if (CompactSpectrum.IsValid() && CompactSpectrum->FrameIndex != DecodedFrameIndex) {
+            CompactSpectrum->Decode(VectorVMReadBuffer.GetData(), 0, VectorVMReadBuffer.Num());
+            for (float& Value : VectorVMReadBuffer) {
+                Value = FMath::Clamp<float>(Value, 0.0f, 1.0f);
+            }
+            DecodedFrameIndex = CompactSpectrum->FrameIndex;
+            DownsampledBuffer = VectorVMReadBuffer;
+            NumChannelsInDownsampledBuffer.Set(1);
+            UpdateMemory();
+        }
+        return VectorVMReadBuffer.Num();
+    }
+
     if (CurveFloatRegisteredTo != nullptr) {
         FScopeLock ScopeLock(&DownsampleBufferLock);
 
@@ -334,6 +483,8 @@ int32 FNiagaraDataInterfaceProxyDynamicCurve::DownsampleAudioToBuffer()
         FMemory::Memcpy(VectorVMReadBuffer.GetData(), data.GetData(), data.Num() * sizeof(float));
 
         DownsampledBuffer = VectorVMReadBuffer;
+        NumChannelsInDownsampledBuffer.Set(1);
+        UpdateMemory();
 
         //         UE_LOG(WindowsAudioCaptureLog, Log, TEXT("FNiagaraDataInterfaceProxyDynamicCurve::DownsampleAudioToBuffer (%d, %d, %d)"),
         //             DownsampledBuffer.Num(), data.Num(), VectorVMReadBuffer.Num());
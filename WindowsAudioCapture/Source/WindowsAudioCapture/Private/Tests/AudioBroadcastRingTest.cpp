@@ -0,0 +1,207 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioBroadcastRing.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+// Sample Index of packet PacketIndex. Every packet has its own pattern, so a copy that mixes two
+// packets, or a packet with another one's descriptor, does not pass IsIntact
+int16 PatternSample(uint64 PacketIndex, int32 Index)
+{
+    return (int16)((PacketIndex * 7919 + (uint64)Index * 31) & 0x7fff);
+}
+
+void WritePatternPacket(FAudioBroadcastRing& Ring, TArray<int16>& Scratch, int32 NumFrames, int32 NumChannels)
+{
+    const uint64 PacketIndex = Ring.GetWrittenPackets();
+    Scratch.SetNumUninitialized(NumFrames * NumChannels, false);
+    for (int32 Index = 0; Index < Scratch.Num(); ++Index) {
+        Scratch[Index] = PatternSample(PacketIndex, Index);
+    }
+    Ring.Write(Scratch.GetData(), NumFrames, NumChannels, 48000, 0);
+}
+
+bool IsIntact(const FAudioRingPacket& Packet, const TArray<int16>& Samples)
+{
+    if (Samples.Num() != Packet.NumFrames * Packet.NumChannels) {
+        return false;
+    }
+    for (int32 Index = 0; Index < Samples.Num(); ++Index) {
+        if (Samples[Index] != PatternSample(Packet.PacketIndex, Index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads the ring on its own thread until the writer is done and the ring is drained, checking every
+// packet. A slow reader sleeps after each packet so the writer laps it
+class FRingStressReader : public FRunnable {
+public:
+    FRingStressReader(const FAudioBroadcastRing& InRing, const std::atomic<bool>& bInWriterDone, float InSleepSeconds)
+        : Ring(InRing)
+        , bWriterDone(bInWriterDone)
+        , SleepSeconds(InSleepSeconds)
+        , Cursor(InRing.MakeCursor())
+    {
+    }
+
+    virtual uint32 Run() override {
+        FAudioRingPacket Packet;
+        TArray<int16> PacketSamples;
+
+        for (;;) {
+            // Read the flag first, a packet written after it is still read before Empty ends the loop
+            const bool bDone = bWriterDone.load(std::memory_order_acquire);
+            const uint64 Expected = Cursor.NextPacket;
+            const EAudioRingRead Result = Ring.Read(Cursor, Packet, PacketSamples);
+
+            if (Result == EAudioRingRead::Packet) {
+                ReadPackets++;
+                TornPackets += IsIntact(Packet, PacketSamples) ? 0 : 1;
+                OutOfOrderPackets += Packet.PacketIndex == Expected ? 0 : 1;
+                if (SleepSeconds > 0.0f) {
+                    FPlatformProcess::Sleep(SleepSeconds);
+                }
+            } else if (Result == EAudioRingRead::Empty) {
+                if (bDone) {
+                    break;
+                }
+                FPlatformProcess::Sleep(0.0f);
+            }
+        }
+        return 0;
+    }
+
+    const FAudioBroadcastRing& Ring;
+    const std::atomic<bool>& bWriterDone;
+    const float SleepSeconds;
+
+    FAudioRingCursor Cursor;
+    uint64 ReadPackets = 0;
+    uint64 TornPackets = 0;
+    uint64 OutOfOrderPackets = 0;
+};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAudioBroadcastRingReadTest, "WindowsAudioCapture.BroadcastRing.Read",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// One reader step by step: empty ring, packets in order, lapped on the descriptors and on the samples,
+// a cursor made late, a silent packet
+bool FAudioBroadcastRingReadTest::RunTest(const FString& Parameters)
+{
+    FAudioBroadcastRing Ring(8, FAudioBroadcastRing::MinSampleCapacity);
+    TArray<int16> Scratch;
+    FAudioRingPacket Packet;
+    TArray<int16> PacketSamples;
+
+    FAudioRingCursor Cursor = Ring.MakeCursor();
+    TestTrue(TEXT("Empty before the first write"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Empty);
+
+    for (int32 Index = 0; Index < 3; ++Index) {
+        WritePatternPacket(Ring, Scratch, 16, 2);
+    }
+    for (int32 Index = 0; Index < 3; ++Index) {
+        TestTrue(TEXT("Packet written is read"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Packet);
+        TestEqual(TEXT("Packets in order"), (int32)Packet.PacketIndex, Index);
+        TestTrue(TEXT("Packet intact"), IsIntact(Packet, PacketSamples));
+    }
+    TestTrue(TEXT("Empty once caught up"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Empty);
+
+    // Lapped on the descriptors: 20 packets into 8 slots, the 12 oldest are gone
+    for (int32 Index = 0; Index < 20; ++Index) {
+        WritePatternPacket(Ring, Scratch, 16, 2);
+    }
+    TestTrue(TEXT("Overrun when lapped"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Overrun);
+    TestEqual(TEXT("Lost packets counted"), (int32)Cursor.LostPackets, 12);
+    TestEqual(TEXT("One overrun"), (int32)Cursor.Overruns, 1);
+    for (int32 Index = 15; Index < 23; ++Index) {
+        TestTrue(TEXT("Resynced to the oldest packet"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Packet);
+        TestEqual(TEXT("Packets in order after the overrun"), (int32)Packet.PacketIndex, Index);
+        TestTrue(TEXT("Packet intact after the overrun"), IsIntact(Packet, PacketSamples));
+    }
+    TestTrue(TEXT("Empty after the resync"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Empty);
+
+    // Lapped on the samples: each packet is half the sample ring, only the newest two survive
+    const int32 HalfRingFrames = Ring.GetSampleCapacity() / 4;
+    for (int32 Index = 0; Index < 5; ++Index) {
+        WritePatternPacket(Ring, Scratch, HalfRingFrames, 2);
+    }
+    TestTrue(TEXT("Overrun when the samples are overwritten"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Overrun);
+    TestEqual(TEXT("Packets with overwritten samples counted as lost"), (int32)Cursor.LostPackets, 15);
+    for (int32 Index = 26; Index < 28; ++Index) {
+        TestTrue(TEXT("Newest packets still readable"), Ring.Read(Cursor, Packet, PacketSamples) == EAudioRingRead::Packet);
+        TestEqual(TEXT("Packets in order after the sample overrun"), (int32)Packet.PacketIndex, Index);
+        TestTrue(TEXT("Large packet intact"), IsIntact(Packet, PacketSamples));
+    }
+
+    // A late cursor starts with the next packet, silent packets carry no samples
+    FAudioRingCursor LateCursor = Ring.MakeCursor();
+    TestTrue(TEXT("Late cursor starts empty"), Ring.Read(LateCursor, Packet, PacketSamples) == EAudioRingRead::Empty);
+    Ring.Write(nullptr, 480, 2, 48000, FAudioRingPacket::Silent);
+    TestTrue(TEXT("Late cursor reads the next packet"), Ring.Read(LateCursor, Packet, PacketSamples) == EAudioRingRead::Packet);
+    TestTrue(TEXT("Silent flag kept"), (Packet.Flags & FAudioRingPacket::Silent) != 0);
+    TestEqual(TEXT("Silent packet keeps its length"), Packet.NumFrames, 480);
+    TestEqual(TEXT("Silent packet has no samples"), PacketSamples.Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAudioBroadcastRingStressTest, "WindowsAudioCapture.BroadcastRing.Stress",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// 24 readers against a writer that never waits for them: the fast ones keep up, the slow ones are lapped.
+// None may see a torn or out of order packet, and every packet is either read or counted as lost
+bool FAudioBroadcastRingStressTest::RunTest(const FString& Parameters)
+{
+    const int32 NumReaders = 24;
+    const int32 NumSlowReaders = 4;
+    const int32 NumPackets = 20000;
+
+    // About 17 packets of samples, so the sample ring laps before the descriptors do
+    FAudioBroadcastRing Ring(64, FAudioBroadcastRing::MinSampleCapacity);
+    std::atomic<bool> bWriterDone(false);
+
+    TArray<TUniquePtr<FRingStressReader>> Readers;
+    TArray<FRunnableThread*> Threads;
+    for (int32 Index = 0; Index < NumReaders; ++Index) {
+        Readers.Add(MakeUnique<FRingStressReader>(Ring, bWriterDone, Index < NumSlowReaders ? 0.001f : 0.0f));
+    }
+    for (int32 Index = 0; Index < NumReaders; ++Index) {
+        Threads.Add(FRunnableThread::Create(Readers[Index].Get(), *FString::Printf(TEXT("WACRingReader%d"), Index)));
+    }
+
+    TArray<int16> Scratch;
+    for (int32 Index = 0; Index < NumPackets; ++Index) {
+        WritePatternPacket(Ring, Scratch, 480, 2);
+
+        // Lets the readers in now and then, so the fast ones keep up on a machine with few cores
+        if ((Index & 3) == 0) {
+            FPlatformProcess::Sleep(0.0f);
+        }
+    }
+    bWriterDone.store(true, std::memory_order_release);
+
+    for (FRunnableThread* Thread : Threads) {
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+
+    uint32 SlowReaderOverruns = 0;
+    for (int32 Index = 0; Index < NumReaders; ++Index) {
+        const FRingStressReader& Reader = *Readers[Index];
+        TestEqual(FString::Printf(TEXT("Reader %d saw no torn packet"), Index), (int32)Reader.TornPackets, 0);
+        TestEqual(FString::Printf(TEXT("Reader %d saw no packet out of order"), Index), (int32)Reader.OutOfOrderPackets, 0);
+        TestEqual(FString::Printf(TEXT("Reader %d read or lost every packet"), Index), (int32)(Reader.ReadPackets + Reader.Cursor.LostPackets), NumPackets);
+        if (Index < NumSlowReaders) {
+            SlowReaderOverruns += Reader.Cursor.Overruns;
+        }
+    }
+    TestTrue(TEXT("The slow readers were lapped"), SlowReaderOverruns > 0);
+    return true;
+}
+
+#endif
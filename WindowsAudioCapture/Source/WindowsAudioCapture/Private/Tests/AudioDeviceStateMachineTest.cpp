@@ -0,0 +1,197 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "AudioDeviceStateMachine.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+// Scripted endpoint: the test decides whether Open, Start and CapturePackets succeed. Open takes OpenSeconds
+// on the fake clock, like WASAPI activating a client
+class FFakeCaptureDevice : public IAudioCaptureDevice {
+public:
+    explicit FFakeCaptureDevice(double& InNowSeconds)
+        : NowSeconds(InNowSeconds)
+    {
+    }
+
+    virtual bool Open() override {
+        OpenCalls++;
+        NowSeconds += OpenSeconds;
+        bOpen = bCanOpen;
+        return bOpen;
+    }
+
+    virtual void Close() override {
+        bOpen = false;
+        bStarted = false;
+    }
+
+    virtual bool IsOpen() const override { return bOpen; }
+
+    virtual bool Start() override {
+        bStarted = bOpen && bCanStart;
+        return bStarted;
+    }
+
+    virtual bool Stop() override {
+        bStarted = false;
+        return true;
+    }
+
+    virtual bool CapturePackets(IAudioSink* Sink) override { return bStarted && bCanCapture; }
+
+    virtual bool ConsumeDeviceChanged() override {
+        const bool bChanged = bDeviceChanged;
+        bDeviceChanged = false;
+        return bChanged;
+    }
+
+    bool bCanOpen = true;
+    bool bCanStart = true;
+    bool bCanCapture = true;
+    bool bDeviceChanged = false;
+    double OpenSeconds = 0.0;
+
+    bool bOpen = false;
+    bool bStarted = false;
+    int32 OpenCalls = 0;
+
+private:
+    double& NowSeconds;
+};
+
+class FFakeSink : public IAudioSink {
+public:
+    virtual int CopyData(const BYTE* Data, const int NumFramesAvailable) override { return NumFramesAvailable; }
+    virtual void MarkDiscontinuity() override { Discontinuities++; }
+
+    int32 Discontinuities = 0;
+};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAudioDeviceStateMachineReconnectTest, "WindowsAudioCapture.DeviceStateMachine.Reconnect",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Running -> Lost -> retries backing off -> Stopped -> Running, with the discontinuity and the reconnect time
+bool FAudioDeviceStateMachineReconnectTest::RunTest(const FString& Parameters)
+{
+    double NowSeconds = 10.0;
+    FFakeCaptureDevice Device(NowSeconds);
+    FFakeSink Sink;
+    FAudioDeviceStateMachine Machine(Device, [&NowSeconds]() { return NowSeconds; }, 0.25, 1.0);
+
+    TestTrue(TEXT("Running after the first update"), Machine.Update(true, &Sink) == EAudioDeviceState::Running);
+    TestEqual(TEXT("The first open is not a discontinuity"), Sink.Discontinuities, 0);
+
+    // The device is unplugged: the capture fails and nothing can be opened
+    Device.bCanCapture = false;
+    Device.bCanOpen = false;
+    NowSeconds = 11.0;
+    TestTrue(TEXT("Lost when the capture fails"), Machine.Update(true, &Sink) == EAudioDeviceState::Lost);
+    TestFalse(TEXT("The lost endpoint is closed"), Device.bOpen);
+
+    // The first retry is right away, then 0.25, 0.5, 1.0 and 1.0 s apart
+    const TArray<double> RetryAtSeconds = { 11.0, 11.25, 11.75, 12.75, 13.75 };
+    for (int32 Retry = 0; Retry < RetryAtSeconds.Num(); ++Retry) {
+        if (Retry > 0) {
+            NowSeconds = RetryAtSeconds[Retry] - 0.01;
+            Machine.Update(true, &Sink);
+            TestEqual(FString::Printf(TEXT("No retry before %.2f s"), RetryAtSeconds[Retry]), Device.OpenCalls, 1 + Retry);
+        }
+
+        NowSeconds = RetryAtSeconds[Retry];
+        TestTrue(TEXT("Still lost while the open fails"), Machine.Update(true, &Sink) == EAudioDeviceState::Lost);
+        TestEqual(FString::Printf(TEXT("Retried at %.2f s"), RetryAtSeconds[Retry]), Device.OpenCalls, 2 + Retry);
+    }
+    TestEqual(TEXT("Failed attempts counted"), Machine.GetStats().FailedReconnectAttempts, RetryAtSeconds.Num());
+    TestEqual(TEXT("Nothing counted as a reconnect yet"), Sink.Discontinuities, 0);
+
+    // A new device shows up, the capture is parked meanwhile
+    Device.bCanOpen = true;
+    Device.bCanCapture = true;
+    Device.OpenSeconds = 0.05;
+    NowSeconds = 14.75;
+    TestTrue(TEXT("Stopped after the reopen while parked"), Machine.Update(false, &Sink) == EAudioDeviceState::Stopped);
+    TestEqual(TEXT("The gap is marked once"), Sink.Discontinuities, 1);
+    TestEqual(TEXT("Failed attempts kept until the stream runs"), Machine.GetStats().FailedReconnectAttempts, RetryAtSeconds.Num());
+    TestEqual(TEXT("A reconnect counts once the stream runs"), Machine.GetStats().ReconnectCount, 0);
+
+    NowSeconds = 15.0;
+    TestTrue(TEXT("Running again"), Machine.Update(true, &Sink) == EAudioDeviceState::Running);
+
+    const FAudioDeviceStats Stats = Machine.GetStats();
+    TestEqual(TEXT("One reconnect"), Stats.ReconnectCount, 1);
+    TestEqual(TEXT("Reconnect time from the loss to the restart"), Stats.LastReconnectSeconds, 4.0);
+    TestEqual(TEXT("No second discontinuity on the start"), Sink.Discontinuities, 1);
+    TestEqual(TEXT("Failed attempts reset by the start"), Stats.FailedReconnectAttempts, 0);
+
+    Machine.Shutdown();
+    TestTrue(TEXT("Closed after shutdown"), Machine.GetState() == EAudioDeviceState::Closed);
+    TestFalse(TEXT("Endpoint released by the shutdown"), Device.bOpen);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAudioDeviceStateMachineDeviceChangeTest, "WindowsAudioCapture.DeviceStateMachine.DeviceChange",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// A default-device change reconnects within the same update, the time spent opening is measured
+bool FAudioDeviceStateMachineDeviceChangeTest::RunTest(const FString& Parameters)
+{
+    double NowSeconds = 0.0;
+    FFakeCaptureDevice Device(NowSeconds);
+    FFakeSink Sink;
+    FAudioDeviceStateMachine Machine(Device, [&NowSeconds]() { return NowSeconds; }, 0.25, 1.0);
+
+    Machine.Update(true, &Sink);
+
+    Device.bDeviceChanged = true;
+    Device.OpenSeconds = 0.02;
+    NowSeconds = 5.0;
+    TestTrue(TEXT("Running on the new default after one update"), Machine.Update(true, &Sink) == EAudioDeviceState::Running);
+    TestEqual(TEXT("Reopened once"), Device.OpenCalls, 2);
+    TestEqual(TEXT("The switch is a discontinuity"), Sink.Discontinuities, 1);
+
+    const FAudioDeviceStats Stats = Machine.GetStats();
+    TestEqual(TEXT("One reconnect"), Stats.ReconnectCount, 1);
+    TestEqual(TEXT("Reconnect time includes the open"), Stats.LastReconnectSeconds, 0.02);
+    TestEqual(TEXT("No failed attempts"), Stats.FailedReconnectAttempts, 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAudioDeviceStateMachineStartFailureTest, "WindowsAudioCapture.DeviceStateMachine.StartFailure",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// An endpoint that opens but never starts backs off like one that does not open, instead of being reopened every update
+bool FAudioDeviceStateMachineStartFailureTest::RunTest(const FString& Parameters)
+{
+    double NowSeconds = 0.0;
+    FFakeCaptureDevice Device(NowSeconds);
+    FFakeSink Sink;
+    FAudioDeviceStateMachine Machine(Device, [&NowSeconds]() { return NowSeconds; }, 0.25, 1.0);
+
+    Device.bCanStart = false;
+    TestTrue(TEXT("Lost when the start fails"), Machine.Update(true, &Sink) == EAudioDeviceState::Lost);
+    TestFalse(TEXT("The endpoint that did not start is closed"), Device.bOpen);
+    TestEqual(TEXT("A failed start counts as a failed attempt"), Machine.GetStats().FailedReconnectAttempts, 1);
+
+    // 0.25, 0.5, 1.0 and 1.0 s apart, the open in between succeeding every time
+    const TArray<double> RetryAtSeconds = { 0.25, 0.75, 1.75, 2.75 };
+    for (int32 Retry = 0; Retry < RetryAtSeconds.Num(); ++Retry) {
+        NowSeconds = RetryAtSeconds[Retry] - 0.01;
+        Machine.Update(true, &Sink);
+        TestEqual(FString::Printf(TEXT("No reopen before %.2f s"), RetryAtSeconds[Retry]), Device.OpenCalls, 1 + Retry);
+
+        NowSeconds = RetryAtSeconds[Retry];
+        TestTrue(TEXT("Still lost while the start fails"), Machine.Update(true, &Sink) == EAudioDeviceState::Lost);
+        TestEqual(FString::Printf(TEXT("Reopened at %.2f s"), RetryAtSeconds[Retry]), Device.OpenCalls, 2 + Retry);
+    }
+    TestEqual(TEXT("Failed attempts kept across the successful opens"), Machine.GetStats().FailedReconnectAttempts, 1 + RetryAtSeconds.Num());
+
+    Device.bCanStart = true;
+    NowSeconds = 3.75;
+    TestTrue(TEXT("Running once the start succeeds"), Machine.Update(true, &Sink) == EAudioDeviceState::Running);
+    TestEqual(TEXT("Failed attempts reset by the start"), Machine.GetStats().FailedReconnectAttempts, 0);
+    return true;
+}
+
+#endif
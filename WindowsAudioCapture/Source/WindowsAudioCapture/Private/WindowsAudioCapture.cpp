@@ -1,5 +1,6 @@
 //Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
 #include "WindowsAudioCapture.h"
+#include "WindowsAudioCaptureMemory.h"
 
 #define LOCTEXT_NAMESPACE "FWindowsAudioCaptureModule"
 
@@ -8,6 +9,7 @@ DEFINE_LOG_CATEGORY(WindowsAudioCaptureLog)
 void FWindowsAudioCaptureModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	FWindowsAudioCaptureMemory::RegisterLLMTag();
 }
 
 void FWindowsAudioCaptureModule::ShutdownModule()
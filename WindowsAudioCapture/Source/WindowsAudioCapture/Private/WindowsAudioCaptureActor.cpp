@@ -2,6 +2,9 @@
 
 #include "WindowsAudioCaptureActor.h"
 #include "WindowsAudioCaptureComponent.h"
+#include "WindowsAudioCaptureSubsystem.h"
+#include "AudioCaptureWorker.h"
+#include "WindowsAudioCaptureMemory.h"
 
 // Sets default values
 AWindowsAudioCaptureActor::AWindowsAudioCaptureActor()
@@ -19,29 +22,80 @@ AWindowsAudioCaptureActor::AWindowsAudioCaptureActor()
     SetRootComponent(billboardComp);
 }
 
-AWindowsAudioCaptureActor::~AWindowsAudioCaptureActor()
+// Called when the game starts or when spawned
+void AWindowsAudioCaptureActor::BeginPlay()
 {
-    if (!FAudioCaptureWorker::Runnable == NULL) {
-        FAudioCaptureWorker::Runnable->ShutdownWorker();
+    Super::BeginPlay();
+
+    if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+        Subsystem->AcquireCapture();
+        bCaptureAcquired = true;
+    }
+
+    // Every actor listens, whether or not it was the one that started the capture
+    FAudioCaptureWorker* Worker = bCaptureAcquired ? UWindowsAudioCaptureSubsystem::Get()->GetWorker() : nullptr;
+    if (Worker != nullptr) {
+        FramePublishedHandle = Worker->AddFramePublishedListener(
+            FAudioFramePublishedEvent::FDelegate::CreateUObject(this, &AWindowsAudioCaptureActor::onFramePublished));
     }
 }
 
-// Called when the game starts or when spawned
-void AWindowsAudioCaptureActor::BeginPlay()
+void AWindowsAudioCaptureActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    Super::BeginPlay();
+    if (bCaptureAcquired) {
+        if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get()) {
+            if (Subsystem->GetWorker() != nullptr) {
+                Subsystem->GetWorker()->RemoveFramePublishedListener(FramePublishedHandle);
+            }
+            Subsystem->ReleaseCapture();
+        }
+        FramePublishedHandle.Reset();
+        bCaptureAcquired = false;
+    }
 
-    if (FAudioCaptureWorker::Runnable == NULL) {
-        // Init new Worker
-        FAudioCaptureWorker::Runnable->InitializeWorker();
-        GetWorld()->GetTimerManager().SetTimer(CaptureDataTimerHandler, this, &AWindowsAudioCaptureActor::onCaptureData, defaultTimerTime, true);
+    Super::EndPlay(EndPlayReason);
+}
+
+void AWindowsAudioCaptureActor::onFramePublished(const FAudioSpectrumFramePtr& frame)
+{
+    const double now = FPlatformTime::Seconds();
+    if (now - LastBroadcastSeconds < defaultTimerTime) {
+        return;
     }
+    LastBroadcastSeconds = now;
+
+    onCaptureData();
 }
 
 void AWindowsAudioCaptureActor::onCaptureData()
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(TEXT("AWindowsAudioCaptureActor::onCaptureData"));
-    TArray<float> data = GetFrequencyArray(defaultFreqLogBase, defaultFreqMultiplier, defaultFreqPower, defaultFreqOffset);
+    WAC_LLM_SCOPE();
+    UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    // Frames are not consumed by reading them anymore, only broadcast the ones we have not seen yet
+    if (Worker == nullptr || Worker->GetLatestFrameIndex() == LastBroadcastFrameIndex) {
+        return;
+    }
+    LastBroadcastFrameIndex = Worker->GetLatestFrameIndex();
+
+    // Encoded once per frame by the worker and shared by every actor with the same settings
+    if (OnAudioCaptureCompactEvent.IsBound()) {
+        const FAudioSpectrumScalingProfile profile(defaultFreqLogBase, defaultFreqMultiplier, defaultFreqPower, defaultFreqOffset);
+        FAudioCompactSpectrumPtr compact = Worker->GetCompactSpectrum(profile, compactPrecision);
+        if (compact.IsValid()) {
+            OnAudioCaptureCompactEvent.Broadcast(compact);
+        }
+    }
+
+    // Nobody reads the float array, skip building it
+    if (!OnAudioCaptureEvent.IsBound() && !OnAudioCaptureNativeEvent.IsBound() && curveAudioData == nullptr) {
+        return;
+    }
+
+    TArray<float> data = bAdaptiveNormalization ? Worker->GetNormalizedSpectrum()
+        : GetFrequencyArray(defaultFreqLogBase, defaultFreqMultiplier, defaultFreqPower, defaultFreqOffset);
 
     if (data.Num() > 0) {
         float outAvgBass = 0;
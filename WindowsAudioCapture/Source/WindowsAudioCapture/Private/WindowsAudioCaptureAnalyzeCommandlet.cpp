@@ -0,0 +1,81 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "WindowsAudioCaptureAnalyzeCommandlet.h"
+#include "AudioFeatureFile.h"
+#include "WindowsAudioCapture.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+const TCHAR* UWindowsAudioCaptureAnalyzeCommandlet::FeatureFileExtension = TEXT(".wacf");
+
+UWindowsAudioCaptureAnalyzeCommandlet::UWindowsAudioCaptureAnalyzeCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UWindowsAudioCaptureAnalyzeCommandlet::Main(const FString& Params)
+{
+    FString input;
+    if (!FParse::Value(*Params, TEXT("Input="), input)) {
+        UE_LOG(WindowsAudioCaptureLog, Error, TEXT("Usage: -run=WindowsAudioCaptureAnalyze -Input=<file.wav or folder> [-Output=<file or folder>] [-Hop=480]"));
+        return 1;
+    }
+
+    FString output;
+    FParse::Value(*Params, TEXT("Output="), output);
+
+    FAudioFeatureFileSettings settings;
+    FParse::Value(*Params, TEXT("Hop="), settings.HopFrames);
+    if (settings.HopFrames <= 0) {
+        UE_LOG(WindowsAudioCaptureLog, Error, TEXT("WindowsAudioCaptureAnalyze: -Hop must be positive"));
+        return 1;
+    }
+
+    TArray<FString> wavePaths;
+    const bool bInputIsFolder = IFileManager::Get().DirectoryExists(*input);
+
+    if (bInputIsFolder) {
+        TArray<FString> names;
+        IFileManager::Get().FindFiles(names, *FPaths::Combine(input, TEXT("*.wav")), true, false);
+        for (const FString& name : names) {
+            wavePaths.Add(FPaths::Combine(input, name));
+        }
+    }
+    else {
+        wavePaths.Add(input);
+    }
+
+    int32 numFailed = 0;
+
+    for (const FString& wavePath : wavePaths) {
+        FString outputPath;
+        if (output.IsEmpty()) {
+            outputPath = FPaths::ChangeExtension(wavePath, FeatureFileExtension);
+        }
+        else if (bInputIsFolder) {
+            outputPath = FPaths::Combine(output, FPaths::GetBaseFilename(wavePath) + FeatureFileExtension);
+        }
+        else {
+            outputPath = output;
+        }
+
+        const double start = FPlatformTime::Seconds();
+        FString error;
+
+        if (FAudioFeatureFileWriter::AnalyzeWaveFile(wavePath, outputPath, settings, error)) {
+            UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WindowsAudioCaptureAnalyze: %s -> %s (%.2f s)"), *wavePath, *outputPath, FPlatformTime::Seconds() - start);
+        }
+        else {
+            UE_LOG(WindowsAudioCaptureLog, Error, TEXT("WindowsAudioCaptureAnalyze: %s"), *error);
+            numFailed++;
+        }
+    }
+
+    if (wavePaths.Num() == 0) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("WindowsAudioCaptureAnalyze: no .wav file in %s"), *input);
+    }
+
+    return numFailed > 0 ? 1 : 0;
+}
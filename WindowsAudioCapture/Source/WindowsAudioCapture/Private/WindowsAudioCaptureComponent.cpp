@@ -1,20 +1,67 @@
 //Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
 #include "WindowsAudioCaptureComponent.h"
 #include "WindowsAudioCapture.h"
+#include "WindowsAudioCaptureSubsystem.h"
+#include "LatentActions.h"
+#include "HAL/IConsoleManager.h"
 
-
-// Sets default values for this component's properties
-UWindowsAudioCaptureComponent::UWindowsAudioCaptureComponent()
+// Completed by the worker's game thread dispatch. Shared with the callback, which may run after the
+// latent action is gone (world torn down)
+struct FWaitForAudioFrameResult
 {
-	PrimaryComponentTick.bCanEverTick = false;
-}
+	bool bDone = false;
+	FAudioSpectrumFramePtr Frame;
+};
 
-UWindowsAudioCaptureComponent::~UWindowsAudioCaptureComponent()
+// Latent action behind "Wait For Next Spectrum" and "Wait For Onset". Polling the flag is what the
+// latent action manager does anyway; the capture itself is never polled
+class FWaitForAudioFrameAction : public FPendingLatentAction
 {
-	if (!FAudioCaptureWorker::Runnable == NULL)
+public:
+	FWaitForAudioFrameAction(const FLatentActionInfo& LatentInfo, TFunction<void(const FAudioSpectrumFramePtr&)> InWriteOutputs)
+		: ExecutionFunction(LatentInfo.ExecutionFunction)
+		, OutputLink(LatentInfo.Linkage)
+		, CallbackTarget(LatentInfo.CallbackTarget)
+		, Result(MakeShared<FWaitForAudioFrameResult, ESPMode::ThreadSafe>())
+		, WriteOutputs(MoveTemp(InWriteOutputs))
+	{
+	}
+
+	// Callback for the worker's WaitForNextSpectrum / WaitForOnset
+	FAudioFrameCallback MakeCallback() const
+	{
+		TSharedRef<FWaitForAudioFrameResult, ESPMode::ThreadSafe> SharedResult = Result;
+		return [SharedResult](const FAudioSpectrumFramePtr& Frame)
+		{
+			SharedResult->Frame = Frame;
+			SharedResult->bDone = true;
+		};
+	}
+
+	virtual void UpdateOperation(FLatentResponse& Response) override
 	{
-		FAudioCaptureWorker::Runnable->ShutdownWorker();
+		// The outputs live in the Blueprint frame, only write them while the action (and so the frame) is alive
+		if (Result->bDone)
+		{
+			WriteOutputs(Result->Frame);
+		}
+		Response.FinishAndTriggerIf(Result->bDone, ExecutionFunction, OutputLink, CallbackTarget);
 	}
+
+private:
+	FName ExecutionFunction;
+	int32 OutputLink;
+	FWeakObjectPtr CallbackTarget;
+
+	TSharedRef<FWaitForAudioFrameResult, ESPMode::ThreadSafe> Result;
+	TFunction<void(const FAudioSpectrumFramePtr&)> WriteOutputs;
+};
+
+
+// Sets default values for this component's properties
+UWindowsAudioCaptureComponent::UWindowsAudioCaptureComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
 // Called when the game starts
@@ -22,15 +69,24 @@ void UWindowsAudioCaptureComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	if (FAudioCaptureWorker::Runnable == NULL)
+	if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get())
 	{
-		// Init new Worker 
-		FAudioCaptureWorker::Runnable->InitializeWorker();
+		Subsystem->AcquireCapture();
+		bCaptureAcquired = true;
 	}
 }
 
 void UWindowsAudioCaptureComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	if (bCaptureAcquired)
+	{
+		if (UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get())
+		{
+			Subsystem->ReleaseCapture();
+		}
+		bCaptureAcquired = false;
+	}
+
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -46,14 +102,312 @@ TArray<float> UWindowsAudioCaptureComponent::BP_GetFrequencyArray(float inFreqLo
 {
 	TArray<float> FrequencyArray;
 
-	if (FAudioCaptureWorker::Runnable)
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		FrequencyArray = Subsystem->GetWorker()->GetFrequencyArray(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset);
+	}
+
+	return FrequencyArray;
+}
+
+// This function will return the Frequency Array of one channel.
+TArray<float> UWindowsAudioCaptureComponent::BP_GetChannelFrequencyArray(int32 InChannel, float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	TArray<float> FrequencyArray;
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
 	{
-		FrequencyArray = FAudioCaptureWorker::Runnable->GetFrequencyArray(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset);
+		FrequencyArray = Subsystem->GetWorker()->GetChannelSpectrum(InChannel, FAudioSpectrumScalingProfile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset));
 	}
 
 	return FrequencyArray;
 }
 
+// This function will return the stereo width, balance and per band pan.
+void UWindowsAudioCaptureComponent::BP_GetStereoImage(int32& OutNumChannels, float& OutStereoWidth, float& OutBalance, TArray<float>& OutBandPan)
+{
+	FAudioChannelSpectra Spectra;
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		Subsystem->GetWorker()->RequestSpectrum();
+
+		FAudioSpectrumFramePtr Frame = Subsystem->GetWorker()->GetLatestFrame();
+		if (Frame.IsValid())
+		{
+			Spectra.NumChannels = Frame->Channels.NumChannels;
+			Spectra.StereoWidth = Frame->Channels.StereoWidth;
+			Spectra.Balance = Frame->Channels.Balance;
+			FMemory::Memcpy(Spectra.BandPan, Frame->Channels.BandPan, sizeof(Spectra.BandPan));
+		}
+	}
+
+	OutNumChannels = Spectra.NumChannels;
+	OutStereoWidth = Spectra.StereoWidth;
+	OutBalance = Spectra.Balance;
+	OutBandPan = TArray<float>(Spectra.BandPan, FAudioChannelSpectra::NumPanBands);
+}
+
+// This function will return the min/max/RMS envelope of the waveform.
+void UWindowsAudioCaptureComponent::BP_GetWaveformEnvelope(TArray<float>& OutMin, TArray<float>& OutMax, TArray<float>& OutRms, float InWindowSeconds, int32 InNumPoints)
+{
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		Subsystem->GetWorker()->GetWaveformEnvelope(InWindowSeconds, InNumPoints, OutMin, OutMax, OutRms);
+	}
+	else
+	{
+		OutMin.SetNumZeroed(FMath::Max(InNumPoints, 0));
+		OutMax.SetNumZeroed(FMath::Max(InNumPoints, 0));
+		OutRms.SetNumZeroed(FMath::Max(InNumPoints, 0));
+	}
+}
+
+// This function will return the chroma vector and the dominant pitch.
+void UWindowsAudioCaptureComponent::BP_GetMusicFeatures(TArray<float>& OutChroma, float& OutPitchHz, float& OutPitchConfidence, float& OutMidiNote)
+{
+	FAudioMusicFeatures Features;
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		Features = Subsystem->GetWorker()->GetMusicFeatures();
+	}
+
+	OutChroma = TArray<float>(Features.Chroma, FAudioMusicFeatures::NumPitchClasses);
+	OutPitchHz = Features.PitchHz;
+	OutPitchConfidence = Features.PitchConfidence;
+	OutMidiNote = Features.MidiNote;
+}
+
+// This function will return the harmonic and percussive energy per band.
+void UWindowsAudioCaptureComponent::BP_GetHarmonicPercussive(TArray<float>& OutHarmonic, TArray<float>& OutPercussive, float& OutPercussiveRatio, float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	FAudioHarmonicPercussiveBands Bands;
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		Bands = Subsystem->GetWorker()->GetHarmonicPercussive(FAudioSpectrumScalingProfile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset));
+	}
+
+	OutHarmonic = TArray<float>(Bands.Harmonic, FAudioHarmonicPercussiveBands::NumBands);
+	OutPercussive = TArray<float>(Bands.Percussive, FAudioHarmonicPercussiveBands::NumBands);
+	OutPercussiveRatio = Bands.PercussiveRatio;
+}
+
+// This function will return the constant-Q spectrum.
+void UWindowsAudioCaptureComponent::BP_GetConstantQSpectrum(TArray<float>& OutBinValues, TArray<float>& OutBinFrequencies, int32 InBinsPerOctave, float InMinFrequency, float InMaxFrequency, float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	const FAudioConstantQSettings Settings(InBinsPerOctave, InMinFrequency, InMaxFrequency);
+
+	OutBinValues.Reset();
+	OutBinFrequencies.SetNumUninitialized(Settings.GetNumBins());
+
+	for (int32 Bin = 0; Bin < OutBinFrequencies.Num(); Bin++)
+	{
+		OutBinFrequencies[Bin] = Settings.GetBinFrequency(Bin);
+	}
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		OutBinValues = Subsystem->GetWorker()->GetConstantQSpectrum(Settings, FAudioSpectrumScalingProfile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset));
+	}
+}
+
+// This function will return the multi-resolution log-frequency spectrum.
+void UWindowsAudioCaptureComponent::BP_GetBandSpectrum(TArray<float>& OutBandValues, TArray<float>& OutBandFrequencies, float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	OutBandValues.Reset();
+	OutBandFrequencies.Reset();
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		OutBandValues = Subsystem->GetWorker()->GetBandSpectrum(FAudioSpectrumScalingProfile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset));
+		OutBandFrequencies = Subsystem->GetWorker()->GetBandFrequencies();
+	}
+}
+
+// This function will return the adaptively normalized Frequency Array.
+void UWindowsAudioCaptureComponent::BP_GetNormalizedFrequencyArray(TArray<float>& OutFrequencyValues)
+{
+	OutFrequencyValues.Reset();
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		OutFrequencyValues = Subsystem->GetWorker()->GetNormalizedSpectrum();
+	}
+}
+
+// This function will return the adaptively normalized band spectrum.
+void UWindowsAudioCaptureComponent::BP_GetNormalizedBandSpectrum(TArray<float>& OutBandValues, TArray<float>& OutBandFrequencies)
+{
+	OutBandValues.Reset();
+	OutBandFrequencies.Reset();
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		OutBandValues = Subsystem->GetWorker()->GetNormalizedBandSpectrum();
+		OutBandFrequencies = Subsystem->GetWorker()->GetBandFrequencies();
+	}
+}
+
+// This function will return the value of each requested frequency.
+void UWindowsAudioCaptureComponent::BP_GetTargetFrequencyValues(const TArray<int32>& InFrequencies, TArray<float>& OutFrequencyValues, float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	OutFrequencyValues.Reset();
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		OutFrequencyValues = Subsystem->GetWorker()->GetTargetFrequencyValues(InFrequencies, FAudioSpectrumScalingProfile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset));
+	}
+	else
+	{
+		OutFrequencyValues.SetNumZeroed(InFrequencies.Num());
+	}
+}
+
+// This function will return the time-domain levels of the latest capture frame.
+void UWindowsAudioCaptureComponent::BP_GetAudioLevels(float& OutRms, float& OutPeak, float& OutTruePeak, float& OutCrestFactorDb, float& OutMomentaryLufs, float& OutShortTermLufs)
+{
+	FAudioLevelMetrics Levels;
+
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		Levels = Subsystem->GetWorker()->GetLatestLevels();
+	}
+
+	OutRms = Levels.GetMaxRms();
+	OutPeak = Levels.GetMaxPeak();
+	OutTruePeak = Levels.GetMaxTruePeak();
+	OutCrestFactorDb = Levels.GetMaxCrestFactorDb();
+	OutMomentaryLufs = Levels.MomentaryLufs;
+	OutShortTermLufs = Levels.ShortTermLufs;
+}
+
+// This function will wait for the next spectrum.
+void UWindowsAudioCaptureComponent::BP_WaitForNextSpectrum(UObject* WorldContextObject, FLatentActionInfo LatentInfo, TArray<float>& OutFrequencies, float inFreqLogBase, float inFreqMultiplier, float inFreqPower, float inFreqOffset)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (World == nullptr || Subsystem == nullptr || Subsystem->GetWorker() == nullptr)
+	{
+		return;
+	}
+
+	FLatentActionManager& LatentActionManager = World->GetLatentActionManager();
+
+	// Already waiting on this node
+	if (LatentActionManager.FindExistingAction<FWaitForAudioFrameAction>(LatentInfo.CallbackTarget, LatentInfo.UUID) != nullptr)
+	{
+		return;
+	}
+
+	const FAudioSpectrumScalingProfile Profile(inFreqLogBase, inFreqMultiplier, inFreqPower, inFreqOffset);
+
+	FWaitForAudioFrameAction* Action = new FWaitForAudioFrameAction(LatentInfo, [&OutFrequencies, Profile](const FAudioSpectrumFramePtr& Frame)
+	{
+		OutFrequencies.Reset();
+
+		UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+		// The scaled copy of the latest frame is memoized per profile, and is at least as new as Frame
+		if (Frame.IsValid() && Subsystem && Subsystem->GetWorker())
+		{
+			OutFrequencies = Subsystem->GetWorker()->GetScaledSpectrum(Profile);
+		}
+	});
+
+	Subsystem->GetWorker()->WaitForNextSpectrum(Action->MakeCallback());
+	LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, Action);
+}
+
+// This function will wait for the next onset.
+void UWindowsAudioCaptureComponent::BP_WaitForOnset(UObject* WorldContextObject, FLatentActionInfo LatentInfo, int32& OutBand, float& OutStrength, int32 InBand)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (World == nullptr || Subsystem == nullptr || Subsystem->GetWorker() == nullptr)
+	{
+		return;
+	}
+
+	FLatentActionManager& LatentActionManager = World->GetLatentActionManager();
+
+	if (LatentActionManager.FindExistingAction<FWaitForAudioFrameAction>(LatentInfo.CallbackTarget, LatentInfo.UUID) != nullptr)
+	{
+		return;
+	}
+
+	const int32 Band = (InBand >= 0 && InBand < FAudioBandOnsets::NumBands) ? InBand : INDEX_NONE;
+
+	FWaitForAudioFrameAction* Action = new FWaitForAudioFrameAction(LatentInfo, [&OutBand, &OutStrength, Band](const FAudioSpectrumFramePtr& Frame)
+	{
+		OutBand = INDEX_NONE;
+		OutStrength = 0.0f;
+
+		if (!Frame.IsValid())
+		{
+			return;
+		}
+
+		// Several bands can fire in one frame, report the strongest (or the one asked for)
+		for (int32 Index = 0; Index < FAudioBandOnsets::NumBands; Index++)
+		{
+			if ((Band == INDEX_NONE || Band == Index) && (OutBand == INDEX_NONE || Frame->Onsets.Strength[Index] > OutStrength))
+			{
+				OutBand = Index;
+				OutStrength = Frame->Onsets.Strength[Index];
+			}
+		}
+	});
+
+	Subsystem->GetWorker()->WaitForOnset(Band, Action->MakeCallback());
+	LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, Action);
+}
+
+// Rate of the spectrum the Blueprint frequency arrays come from, WAC.AnalysisSampleRate when nothing was analyzed yet
+static int32 GetSpectrumSampleRate()
+{
+	UWindowsAudioCaptureSubsystem* Subsystem = UWindowsAudioCaptureSubsystem::Get();
+
+	if (Subsystem && Subsystem->GetWorker())
+	{
+		FAudioSpectrumFramePtr Frame = Subsystem->GetWorker()->GetLatestFrame();
+		if (Frame.IsValid() && Frame->SampleRate > 0)
+		{
+			return Frame->SampleRate;
+		}
+	}
+
+	static const auto CVarAnalysisSampleRate = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("WAC.AnalysisSampleRate"));
+	return CVarAnalysisSampleRate && CVarAnalysisSampleRate->GetValueOnAnyThread() > 0 ? CVarAnalysisSampleRate->GetValueOnAnyThread() : 48000;
+}
+
 // This function will return the value of a specific frequency.
 void UWindowsAudioCaptureComponent::BP_GetSpecificFrequencyValue(TArray<float> InFrequencies, int32 InWantedFrequency, float& OutFrequencyValue)
 {
@@ -63,9 +417,11 @@ void UWindowsAudioCaptureComponent::BP_GetSpecificFrequencyValue(TArray<float> I
 	if (InWantedFrequency < 0 || InWantedFrequency > 22000)
 		return;
 
-	if (InFrequencies.Num() > 0 && (int32)(InWantedFrequency * InFrequencies.Num() * 2 / 48000) < InFrequencies.Num())
+	const int32 Bin = (int32)((int64)InWantedFrequency * InFrequencies.Num() * 2 / GetSpectrumSampleRate());
+
+	if (InFrequencies.Num() > 0 && Bin < InFrequencies.Num())
 	{
-		OutFrequencyValue = InFrequencies[(int32)(InWantedFrequency * InFrequencies.Num() * 2 / 48000)];
+		OutFrequencyValue = InFrequencies[Bin];
 	}
 }
 
@@ -95,8 +451,9 @@ void UWindowsAudioCaptureComponent::BP_GetAverageFrequencyValueInRange
 	if (InStartFrequency >= InEndFrequency || InStartFrequency < 0 || InEndFrequency > 22000)
 		return;
 
-	int32 FStart = (int32)(InStartFrequency  * InFrequencies.Num() * 2 / 48000);
-	int32 FEnd = (int32)(InEndFrequency * InFrequencies.Num() * 2 / 48000);
+	const int32 SampleRate = GetSpectrumSampleRate();
+	int32 FStart = (int32)((int64)InStartFrequency * InFrequencies.Num() * 2 / SampleRate);
+	int32 FEnd = (int32)((int64)InEndFrequency * InFrequencies.Num() * 2 / SampleRate);
 
 	if (FStart < 0 || FEnd >= InFrequencies.Num())
 		return;
@@ -0,0 +1,193 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#include "WindowsAudioCaptureMemory.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/LowLevelMemStats.h"
+
+static TAutoConsoleVariable<int32> CVarWACMemoryBudgetMB(
+    TEXT("WAC.MemoryBudgetMB"),
+    64,
+    TEXT("Memory the capture history, the waveform history and the recorder queue may hold together, in MB. Past it the\n")
+    TEXT("histories are made shorter and the recorder drops packets. 0 for no budget. WAC.Memory lists what is in use."));
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER && STATS
+DECLARE_LLM_MEMORY_STAT(TEXT("WindowsAudioCapture"), STAT_WindowsAudioCaptureLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("WindowsAudioCapture"), STAT_WindowsAudioCaptureSummaryLLM, STATGROUP_LLM);
+#endif
+
+namespace {
+constexpr int32 NumCategories = (int32)EWACMemory::Num;
+
+const TCHAR* const CategoryNames[NumCategories] = {
+    TEXT("Capture history"),
+    TEXT("Waveform history"),
+    TEXT("Recorder queue"),
+    TEXT("FFT plans"),
+    TEXT("Niagara"),
+};
+
+bool IsBudgeted(EWACMemory Category)
+{
+    return Category == EWACMemory::CaptureHistory || Category == EWACMemory::WaveformHistory || Category == EWACMemory::RecorderQueue;
+}
+
+std::atomic<int64> LiveBytes[NumCategories];
+std::atomic<int64> PeakBytes[NumCategories];
+std::atomic<uint64> DeniedAllocations[NumCategories];
+std::atomic<int64> BudgetedBytes(0);
+
+// In front of every MallocBlock, keeps the block 16 byte aligned for the SIMD users
+struct alignas(16) FBlockHeader {
+    int64 Bytes;
+    EWACMemory Category;
+};
+
+void AddLiveBytes(EWACMemory Category, int64 Bytes)
+{
+    const int32 Index = (int32)Category;
+    const int64 Live = LiveBytes[Index].fetch_add(Bytes, std::memory_order_relaxed) + Bytes;
+
+    int64 Peak = PeakBytes[Index].load(std::memory_order_relaxed);
+    while (Live > Peak && !PeakBytes[Index].compare_exchange_weak(Peak, Live, std::memory_order_relaxed)) {
+    }
+}
+}
+
+bool FWindowsAudioCaptureMemory::TryAllocate(EWACMemory Category, int64 Bytes)
+{
+    if (!IsBudgeted(Category) || Bytes <= 0) {
+        Allocate(Category, Bytes);
+        return true;
+    }
+
+    const int64 Budget = GetBudgetBytes();
+    int64 Budgeted = BudgetedBytes.load(std::memory_order_relaxed);
+
+    do {
+        if (Budget > 0 && Budgeted + Bytes > Budget) {
+            DeniedAllocations[(int32)Category].fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!BudgetedBytes.compare_exchange_weak(Budgeted, Budgeted + Bytes, std::memory_order_relaxed));
+
+    AddLiveBytes(Category, Bytes);
+    return true;
+}
+
+void FWindowsAudioCaptureMemory::Allocate(EWACMemory Category, int64 Bytes)
+{
+    if (IsBudgeted(Category)) {
+        BudgetedBytes.fetch_add(Bytes, std::memory_order_relaxed);
+    }
+    AddLiveBytes(Category, Bytes);
+}
+
+void FWindowsAudioCaptureMemory::Free(EWACMemory Category, int64 Bytes)
+{
+    if (IsBudgeted(Category)) {
+        BudgetedBytes.fetch_sub(Bytes, std::memory_order_relaxed);
+    }
+    LiveBytes[(int32)Category].fetch_sub(Bytes, std::memory_order_relaxed);
+}
+
+void* FWindowsAudioCaptureMemory::MallocBlock(EWACMemory Category, SIZE_T Bytes)
+{
+    WAC_LLM_SCOPE();
+
+    FBlockHeader* Header = (FBlockHeader*)FMemory::Malloc(sizeof(FBlockHeader) + Bytes, alignof(FBlockHeader));
+    Header->Bytes = (int64)Bytes;
+    Header->Category = Category;
+
+    Allocate(Category, (int64)Bytes);
+    return Header + 1;
+}
+
+void FWindowsAudioCaptureMemory::FreeBlock(void* Block)
+{
+    if (Block == nullptr) {
+        return;
+    }
+
+    FBlockHeader* Header = (FBlockHeader*)Block - 1;
+    Free(Header->Category, Header->Bytes);
+    FMemory::Free(Header);
+}
+
+kiss_fftr_cfg FWindowsAudioCaptureMemory::AllocFftr(int32 Size, bool bInverse)
+{
+    // The first call only asks for the size of the plan
+    size_t Length = 0;
+    kiss_fftr_alloc(Size, bInverse ? 1 : 0, nullptr, &Length);
+    if (Length == 0) {
+        return nullptr;
+    }
+
+    void* Block = MallocBlock(EWACMemory::FftPlans, Length);
+    kiss_fftr_cfg Config = kiss_fftr_alloc(Size, bInverse ? 1 : 0, Block, &Length);
+    if (Config == nullptr) {
+        FreeBlock(Block);
+    }
+    return Config;
+}
+
+void FWindowsAudioCaptureMemory::FreeFftr(kiss_fftr_cfg Config)
+{
+    // The plan starts at the beginning of its block
+    FreeBlock(Config);
+}
+
+int64 FWindowsAudioCaptureMemory::GetBudgetBytes()
+{
+    return (int64)FMath::Max(0, CVarWACMemoryBudgetMB.GetValueOnAnyThread()) * 1024 * 1024;
+}
+
+FWACMemoryStats FWindowsAudioCaptureMemory::GetStats()
+{
+    FWACMemoryStats Stats;
+    Stats.BudgetBytes = GetBudgetBytes();
+    Stats.BudgetedBytes = BudgetedBytes.load(std::memory_order_relaxed);
+
+    for (int32 Index = 0; Index < NumCategories; ++Index) {
+        FWACMemoryCategoryStats& Category = Stats.Categories[Index];
+        Category.Name = CategoryNames[Index];
+        Category.bBudgeted = IsBudgeted((EWACMemory)Index);
+        Category.LiveBytes = LiveBytes[Index].load(std::memory_order_relaxed);
+        Category.PeakBytes = PeakBytes[Index].load(std::memory_order_relaxed);
+        Category.DeniedAllocations = DeniedAllocations[Index].load(std::memory_order_relaxed);
+    }
+    return Stats;
+}
+
+void FWindowsAudioCaptureMemory::RegisterLLMTag()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#if STATS
+    FLowLevelMemTracker::Get().RegisterProjectTag(WAC_LLM_TAG, TEXT("WindowsAudioCapture"),
+        GET_STATFNAME(STAT_WindowsAudioCaptureLLM), GET_STATFNAME(STAT_WindowsAudioCaptureSummaryLLM));
+#else
+    FLowLevelMemTracker::Get().RegisterProjectTag(WAC_LLM_TAG, TEXT("WindowsAudioCapture"), NAME_None, NAME_None);
+#endif
+#endif
+}
+
+void FWACMemoryCounter::Set(int64 NewBytes)
+{
+    if (NewBytes > Bytes) {
+        FWindowsAudioCaptureMemory::Allocate(Category, NewBytes - Bytes);
+    } else if (NewBytes < Bytes) {
+        FWindowsAudioCaptureMemory::Free(Category, Bytes - NewBytes);
+    }
+    Bytes = NewBytes;
+}
+
+bool FWACMemoryCounter::TrySet(int64 NewBytes)
+{
+    if (NewBytes > Bytes) {
+        if (!FWindowsAudioCaptureMemory::TryAllocate(Category, NewBytes - Bytes)) {
+            return false;
+        }
+    } else if (NewBytes < Bytes) {
+        FWindowsAudioCaptureMemory::Free(Category, Bytes - NewBytes);
+    }
+    Bytes = NewBytes;
+    return true;
+}
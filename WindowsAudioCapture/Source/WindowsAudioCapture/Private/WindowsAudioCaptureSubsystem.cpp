@@ -0,0 +1,382 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+
+#include "WindowsAudioCaptureSubsystem.h"
+#include "AudioCaptureWorker.h"
+#include "AudioCaptureBenchmarks.h"
+#include "WindowsAudioCapture.h"
+#include "WindowsAudioCaptureMemory.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "wac_shared_spectrum.h"
+
+static FAutoConsoleCommand GWindowsAudioCaptureStatsCommand(
+    TEXT("WAC.Stats"),
+    TEXT("Prints the Windows Audio Capture device and analysis statistics to the log."),
+    FConsoleCommandDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::DumpStats));
+
+static FAutoConsoleCommand GWindowsAudioCaptureDeadlinesCommand(
+    TEXT("WAC.Deadlines"),
+    TEXT("Prints the capture thread deadline misses and the histograms of its wake lateness, buffer fill and sink time. Argument \"reset\" clears them after printing."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::DumpDeadlines));
+
+static FAutoConsoleCommand GWindowsAudioCaptureMemoryCommand(
+    TEXT("WAC.Memory"),
+    TEXT("Prints the live and peak bytes of every Windows Audio Capture memory category and what WAC.MemoryBudgetMB refused."),
+    FConsoleCommandDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::DumpMemory));
+
+static FAutoConsoleCommand GWindowsAudioCaptureBenchmarkTargetsCommand(
+    TEXT("WAC.BenchmarkTargets"),
+    TEXT("Times the FFT against the Goertzel target bank and logs the crossover. Optional argument: block size in frames (default 480)."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::BenchmarkTargets));
+
+static FAutoConsoleCommand GWindowsAudioCaptureBenchmarkCompactCommand(
+    TEXT("WAC.BenchmarkCompact"),
+    TEXT("Times the 8 and 16 bit compact spectrum encoders and logs their error and size against floats. Optional argument: number of bins (default 255)."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::BenchmarkCompact));
+
+static FAutoConsoleCommand GWindowsAudioCaptureBenchmarkKernelsCommand(
+    TEXT("WAC.BenchmarkKernels"),
+    TEXT("Times the channel analysis with the specialized kernels against the generic ones for 1, 2, 6 and 8 channels. Optional argument: block size in frames (default 480)."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::BenchmarkKernels));
+
+static FAutoConsoleCommand GWindowsAudioCaptureBenchmarkHarmonicPercussiveCommand(
+    TEXT("WAC.BenchmarkHarmonicPercussive"),
+    TEXT("Times the harmonic/percussive separation at every bin decimation and logs how well it tells clicks from tones. Optional argument: number of bins (default 255)."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::BenchmarkHarmonicPercussive));
+
+static FAutoConsoleCommand GWindowsAudioCaptureBenchmarkSilenceGateCommand(
+    TEXT("WAC.BenchmarkSilenceGate"),
+    TEXT("Times the channel analysis of the same half-silent input with and without the silence gate and logs the measured saving next to the WAC.Stats estimate. Optional argument: block size in frames (default 480)."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::BenchmarkSilenceGate));
+
+static FAutoConsoleCommand GWindowsAudioCaptureRecordCommand(
+    TEXT("WAC.Record"),
+    TEXT("Records the captured audio and the published frames to a .wacr file until WAC.StopRecord. Optional argument: file path (default Saved/WindowsAudioCapture/Capture-<date>.wacr)."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::StartRecording));
+
+static FAutoConsoleCommand GWindowsAudioCaptureStopRecordCommand(
+    TEXT("WAC.StopRecord"),
+    TEXT("Flushes and closes the recording started with WAC.Record."),
+    FConsoleCommandDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::StopRecording));
+
+static FAutoConsoleCommand GWindowsAudioCaptureReplayCommand(
+    TEXT("WAC.Replay"),
+    TEXT("Analyses a .wacr recording instead of the default device. Arguments: file path, then \"loop\" to repeat it. WAC.StopReplay goes back to live capture."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::StartReplay));
+
+static FAutoConsoleCommand GWindowsAudioCaptureStopReplayCommand(
+    TEXT("WAC.StopReplay"),
+    TEXT("Goes back to capturing the default device after WAC.Replay."),
+    FConsoleCommandDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::StopReplay));
+
+static FAutoConsoleCommand GWindowsAudioCaptureShareSpectrumCommand(
+    TEXT("WAC.ShareSpectrum"),
+    TEXT("Starts the capture and publishes every frame to a shared-memory ring for other processes (Extras/SharedSpectrumReader). Optional argument: region name (default ") TEXT(WAC_SHM_DEFAULT_NAME) TEXT(")."),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::StartSharedSpectrum));
+
+static FAutoConsoleCommand GWindowsAudioCaptureStopShareSpectrumCommand(
+    TEXT("WAC.StopShareSpectrum"),
+    TEXT("Stops publishing to the shared-memory ring and releases the capture it held."),
+    FConsoleCommandDelegate::CreateStatic(&UWindowsAudioCaptureSubsystem::StopSharedSpectrum));
+
+void UWindowsAudioCaptureSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    CaptureRefCount = 0;
+}
+
+void UWindowsAudioCaptureSubsystem::Deinitialize()
+{
+    if (bSharingSpectrum) {
+        bSharingSpectrum = false;
+        --CaptureRefCount;
+    }
+
+    if (CaptureRefCount != 0) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("UWindowsAudioCaptureSubsystem: %d capture reference(s) still held at shutdown"), CaptureRefCount);
+    }
+
+    // Bounded: Stop() wakes the capture thread out of its poll wait
+    Worker.Reset();
+    CaptureRefCount = 0;
+
+    Super::Deinitialize();
+}
+
+UWindowsAudioCaptureSubsystem* UWindowsAudioCaptureSubsystem::Get()
+{
+    return GEngine != nullptr ? GEngine->GetEngineSubsystem<UWindowsAudioCaptureSubsystem>() : nullptr;
+}
+
+void UWindowsAudioCaptureSubsystem::AcquireCapture()
+{
+    check(IsInGameThread());
+
+    if (!Worker.IsValid()) {
+        // The worker and its rings, the capture thread tags its own allocations
+        WAC_LLM_SCOPE();
+        Worker = MakeUnique<FAudioCaptureWorker>();
+    }
+
+    if (++CaptureRefCount == 1) {
+        Worker->SetCaptureEnabled(true);
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::ReleaseCapture()
+{
+    check(IsInGameThread());
+
+    if (!ensureMsgf(CaptureRefCount > 0, TEXT("UWindowsAudioCaptureSubsystem::ReleaseCapture without matching AcquireCapture"))) {
+        return;
+    }
+
+    if (--CaptureRefCount == 0 && Worker.IsValid()) {
+        Worker->SetCaptureEnabled(false);
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::DumpStats()
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    if (Worker == nullptr) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: capture not running"));
+        return;
+    }
+
+    const FAudioDeviceStats DeviceStats = Worker->GetDeviceStats();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: refs %d, device state %d, %d reconnect(s), last reconnect %.1f ms"),
+        Subsystem->GetCaptureRefCount(), (int32)DeviceStats.State, DeviceStats.ReconnectCount, DeviceStats.LastReconnectSeconds * 1000.0);
+
+    const FAudioAnalysisStats AnalysisStats = Worker->GetAnalysisStats();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu frame(s) analysed, %.1f us average; %llu analyses skipped by the silence gate, ~%.1f ms CPU saved in total (estimated, WAC.BenchmarkSilenceGate measures it); noise floor %.1f dBFS"),
+        AnalysisStats.AnalyzedFrames, AnalysisStats.GetAverageAnalysisSeconds() * 1000000.0,
+        AnalysisStats.SkippedSilentAnalyses, AnalysisStats.GetEstimatedSavedSeconds() * 1000.0, AnalysisStats.NoiseFloorDb);
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu captured packet(s) lost by the analysis to sink ring overruns"), AnalysisStats.LostPackets);
+
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu frame(s) analysed with the target bank, %.1f us average"),
+        AnalysisStats.AnalyzedTargetFrames, AnalysisStats.GetAverageTargetAnalysisSeconds() * 1000000.0);
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu multi-resolution band frame(s), %.1f us average; %d constant-Q kernel(s) built"),
+        AnalysisStats.AnalyzedBandFrames, AnalysisStats.GetAverageBandAnalysisSeconds() * 1000000.0, AnalysisStats.ConstantQKernelsBuilt);
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu chroma/pitch frame(s), %.1f us average"),
+        AnalysisStats.AnalyzedMusicFrames, AnalysisStats.GetAverageMusicAnalysisSeconds() * 1000000.0);
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu harmonic/percussive frame(s), %.1f us average, %llu over budget, decimation %d"),
+        AnalysisStats.AnalyzedHarmonicPercussiveFrames, AnalysisStats.GetAverageHarmonicPercussiveSeconds() * 1000000.0,
+        AnalysisStats.HarmonicPercussiveOverBudgetFrames, AnalysisStats.HarmonicPercussiveDecimation);
+
+    const FAudioAnalysisGraphStats GraphStats = Worker->GetAnalysisGraphStats();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu analysis graph(s) inline, %llu on the task graph, %.1f us average"),
+        GraphStats.InlineRuns, GraphStats.ParallelRuns, GraphStats.GetAverageSeconds() * 1000000.0);
+    for (const FAudioAnalysisStageStats& Stage : GraphStats.Stages) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC:   stage %s, %llu run(s), %.1f us average, %.1f us recent, %.1f us last"),
+            *Stage.Name.ToString(), Stage.Runs, Stage.GetAverageSeconds() * 1000000.0, Stage.RecentSeconds * 1000000.0, Stage.LastSeconds * 1000000.0);
+    }
+
+    const FAudioCaptureDeadlineStats DeadlineStats = Worker->GetDeadlineStats();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu capture deadline miss(es) in %llu drain(s), p99 wake lateness %.1f us, p99 buffer fill %.0f%%; details in WAC.Deadlines"),
+        DeadlineStats.DeadlineMisses, DeadlineStats.Captures, DeadlineStats.WakeLateness.GetQuantile(0.99), DeadlineStats.BufferFill.GetQuantile(0.99));
+
+    const FAudioRecorderStats RecorderStats = Worker->GetRecorderStats();
+    if (RecorderStats.bRecording || !RecorderStats.Path.IsEmpty()) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %s %s, %lld bytes written, %lld queued (peak %lld); dropped %lld frame(s) in %d packet(s) and %d spectrum frame(s)"),
+            RecorderStats.bRecording ? TEXT("recording") : TEXT("recorded"), *RecorderStats.Path, RecorderStats.WrittenBytes, RecorderStats.QueuedBytes,
+            RecorderStats.PeakQueuedBytes, RecorderStats.DroppedPcmFrames, RecorderStats.DroppedPcmPackets, RecorderStats.DroppedSpectrumFrames);
+    }
+
+    const FAudioSharedSpectrumStats SharedStats = Worker->GetSharedSpectrumStats();
+    if (SharedStats.bOpen || SharedStats.PublishedFrames > 0) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %s shared spectrum %s, %llu frame(s) published, %llu truncated"),
+            SharedStats.bOpen ? TEXT("publishing") : TEXT("published"), *SharedStats.Name, SharedStats.PublishedFrames, SharedStats.TruncatedFrames);
+    }
+
+    const FAudioFrameNotifierStats NotifierStats = Worker->GetNotifierStats();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu frame wait(s), %llu completed in %llu game thread dispatch(es)"),
+        NotifierStats.Waits, NotifierStats.CompletedWaits, NotifierStats.Dispatches);
+
+    const FAudioLevelMetrics Levels = Worker->GetLatestLevels();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu level-only frame(s) without a spectrum request; peak %.3f, true peak %.3f, momentary %.1f LUFS, short-term %.1f LUFS"),
+        AnalysisStats.SkippedUnrequestedAnalyses, Levels.GetMaxPeak(), Levels.GetMaxTruePeak(), Levels.MomentaryLufs, Levels.ShortTermLufs);
+}
+
+static void LogDeadlineHistogram(const TCHAR* Name, const TCHAR* Unit, const FAudioDeadlineHistogramSnapshot& Histogram)
+{
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %s: %llu sample(s), mean %.1f %s, p50 %.1f, p99 %.1f, p99.9 %.1f, max %.1f"),
+        Name, Histogram.Count, Histogram.GetMean(), Unit, Histogram.GetQuantile(0.5), Histogram.GetQuantile(0.99), Histogram.GetQuantile(0.999), Histogram.Max);
+
+    double LowerEdge = 0.0;
+    for (int32 Bucket = 0; Bucket < FAudioDeadlineHistogramSnapshot::NumBuckets; ++Bucket) {
+        if (Histogram.Counts[Bucket] > 0) {
+            if (Bucket + 1 < FAudioDeadlineHistogramSnapshot::NumBuckets) {
+                UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC:   %10.1f .. %10.1f %s: %llu"), LowerEdge, Histogram.BucketEdges[Bucket], Unit, Histogram.Counts[Bucket]);
+            } else {
+                UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC:   %10.1f ..            %s: %llu"), LowerEdge, Unit, Histogram.Counts[Bucket]);
+            }
+        }
+        LowerEdge = Histogram.BucketEdges[Bucket];
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::DumpDeadlines(const TArray<FString>& Args)
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    if (Worker == nullptr) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: capture not running"));
+        return;
+    }
+
+    const FAudioCaptureDeadlineStats Stats = Worker->GetDeadlineStats();
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu iteration(s), %llu drain(s); %llu deadline miss(es) against a %.1f ms buffer, longest gap %.1f ms"),
+        Stats.Iterations, Stats.Captures, Stats.DeadlineMisses, Stats.BufferSeconds * 1000.0, Stats.MaxCaptureGapSeconds * 1000.0);
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %llu discontinuity packet(s), %llu timestamp error(s)"), Stats.Discontinuities, Stats.TimestampErrors);
+
+    LogDeadlineHistogram(TEXT("wake lateness"), TEXT("us"), Stats.WakeLateness);
+    LogDeadlineHistogram(TEXT("packets per wake"), TEXT("packet(s)"), Stats.PacketsPerWake);
+    LogDeadlineHistogram(TEXT("buffer fill"), TEXT("%"), Stats.BufferFill);
+    LogDeadlineHistogram(TEXT("sink time"), TEXT("us"), Stats.SinkTime);
+    LogDeadlineHistogram(TEXT("iteration time"), TEXT("us"), Stats.IterationTime);
+
+    if (Args.Num() > 0 && Args[0] == TEXT("reset")) {
+        Worker->ResetDeadlineStats();
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: deadline statistics reset"));
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::DumpMemory()
+{
+    // Counted whether or not the capture runs, the Niagara proxies and FFT plans live outside the worker
+    const FWACMemoryStats Stats = FWindowsAudioCaptureMemory::GetStats();
+
+    if (Stats.BudgetBytes > 0) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %.2f MB live; %.2f MB of the %.2f MB budget in use"),
+            Stats.GetTotalLiveBytes() / (1024.0 * 1024.0), Stats.BudgetedBytes / (1024.0 * 1024.0), Stats.BudgetBytes / (1024.0 * 1024.0));
+    } else {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %.2f MB live; no budget"), Stats.GetTotalLiveBytes() / (1024.0 * 1024.0));
+    }
+
+    for (const FWACMemoryCategoryStats& Category : Stats.Categories) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC:   %-16s %10lld bytes live, %10lld peak%s, %llu allocation(s) refused"),
+            Category.Name, Category.LiveBytes, Category.PeakBytes, Category.bBudgeted ? TEXT(", budgeted") : TEXT(""), Category.DeniedAllocations);
+    }
+
+    UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: every plugin allocation is tagged WindowsAudioCapture in LLM (-llm, stat LLMFULL)"));
+}
+
+void UWindowsAudioCaptureSubsystem::StartRecording(const TArray<FString>& Args)
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    if (Worker == nullptr) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: capture not running"));
+        return;
+    }
+
+    const FString Path = Args.Num() > 0 ? Args[0]
+        : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("WindowsAudioCapture"), FString::Printf(TEXT("Capture-%s.wacr"), *FDateTime::Now().ToString()));
+
+    FString Error;
+    if (!Worker->StartRecording(Path, Error)) {
+        UE_LOG(WindowsAudioCaptureLog, Warning, TEXT("WAC: %s"), *Error);
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::StopRecording()
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+
+    if (Subsystem != nullptr && Subsystem->GetWorker() != nullptr) {
+        Subsystem->GetWorker()->StopRecording();
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::StartReplay(const TArray<FString>& Args)
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+    FAudioCaptureWorker* Worker = Subsystem != nullptr ? Subsystem->GetWorker() : nullptr;
+
+    if (Worker == nullptr || Args.Num() == 0) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: %s"), Worker == nullptr ? TEXT("capture not running") : TEXT("usage: WAC.Replay <file.wacr> [loop]"));
+        return;
+    }
+
+    Worker->StartReplay(Args[0], Args.Num() > 1 && Args[1] == TEXT("loop"));
+}
+
+void UWindowsAudioCaptureSubsystem::StopReplay()
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+
+    if (Subsystem != nullptr && Subsystem->GetWorker() != nullptr) {
+        Subsystem->GetWorker()->StopReplay();
+    }
+}
+
+void UWindowsAudioCaptureSubsystem::BenchmarkTargets(const TArray<FString>& Args)
+{
+    const int32 NumFrames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 480;
+
+    FAudioCaptureBenchmarks::TargetAnalysis(NumFrames);
+}
+
+void UWindowsAudioCaptureSubsystem::BenchmarkCompact(const TArray<FString>& Args)
+{
+    const int32 NumBins = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 255;
+
+    FAudioCaptureBenchmarks::CompactSpectrum(NumBins);
+}
+
+void UWindowsAudioCaptureSubsystem::BenchmarkKernels(const TArray<FString>& Args)
+{
+    const int32 NumFrames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 480;
+
+    FAudioCaptureBenchmarks::AnalysisKernels(NumFrames);
+}
+
+void UWindowsAudioCaptureSubsystem::BenchmarkHarmonicPercussive(const TArray<FString>& Args)
+{
+    const int32 NumBins = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 255;
+
+    FAudioCaptureBenchmarks::HarmonicPercussive(NumBins);
+}
+
+void UWindowsAudioCaptureSubsystem::BenchmarkSilenceGate(const TArray<FString>& Args)
+{
+    const int32 NumFrames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 480;
+
+    FAudioCaptureBenchmarks::SilenceGate(NumFrames);
+}
+
+void UWindowsAudioCaptureSubsystem::StartSharedSpectrum(const TArray<FString>& Args)
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+
+    if (Subsystem == nullptr) {
+        UE_LOG(WindowsAudioCaptureLog, Display, TEXT("WAC: engine not running"));
+        return;
+    }
+
+    if (!Subsystem->bSharingSpectrum) {
+        Subsystem->AcquireCapture();
+        Subsystem->bSharingSpectrum = true;
+    }
+
+    Subsystem->GetWorker()->StartSharedSpectrum(Args.Num() > 0 ? Args[0] : FString(TEXT(WAC_SHM_DEFAULT_NAME)));
+}
+
+void UWindowsAudioCaptureSubsystem::StopSharedSpectrum()
+{
+    UWindowsAudioCaptureSubsystem* Subsystem = Get();
+
+    if (Subsystem == nullptr || !Subsystem->bSharingSpectrum) {
+        return;
+    }
+
+    Subsystem->GetWorker()->StopSharedSpectrum();
+    Subsystem->bSharingSpectrum = false;
+    Subsystem->ReleaseCapture();
+}
@@ -0,0 +1,80 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAudioAdaptiveNormalizerSettings {
+    // Quantiles of the recent values of a band that map to 0 and 1
+    float FloorQuantile = 0.1f;
+    float CeilingQuantile = 0.95f;
+
+    // Frames it takes to follow a level change of one floor-to-ceiling range; 200 is about 2 s at 100 frames/s
+    int32 AdaptFrames = 200;
+
+    // Smallest floor-to-ceiling distance in octaves of magnitude (1 = 6 dB), so a band that barely moves
+    // (noise, a steady hum) is not stretched to full scale
+    float MinRangeOctaves = 2.0f;
+
+    // Values below this are silence: they output 0 and do not move the estimates. Same units as the input
+    float SilenceThreshold = 1.0f;
+
+    bool operator==(const FAudioAdaptiveNormalizerSettings& Other) const {
+        return FloorQuantile == Other.FloorQuantile && CeilingQuantile == Other.CeilingQuantile && AdaptFrames == Other.AdaptFrames
+            && MinRangeOctaves == Other.MinRangeOctaves && SilenceThreshold == Other.SilenceThreshold;
+    }
+
+    bool operator!=(const FAudioAdaptiveNormalizerSettings& Other) const {
+        return !(*this == Other);
+    }
+};
+
+///<summary>
+// Maps every band to 0..1 between running estimates of its own floor and ceiling, so the output no
+// longer depends on the source volume the way a fixed FAudioSpectrumScalingProfile does.
+// Works on any array of non-negative values (linear magnitudes, bands, scaled values) and can sit at
+// any point of the analysis. Each band keeps two streaming quantile estimates of its log magnitude,
+// updated by stochastic approximation: the estimate moves up by Step * Q when a value is above it and
+// down by Step * (1 - Q) otherwise, which settles where a fraction Q of the values lies below. The step
+// follows the band's own range, so the estimates converge whatever the units, and is sized so the slow
+// direction still follows a level change in about AdaptFrames frames. That is O(1) state and
+// work per band and frame with no history. The log2 comes from the float bits like
+// FAudioSpectrumScalingTable, and every update is a select, so Process() vectorizes across bands.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioAdaptiveNormalizer {
+public:
+    FAudioAdaptiveNormalizer();
+
+    // Starts the estimates over, unless InSettings are the ones passed last time
+    void Configure(const FAudioAdaptiveNormalizerSettings& InSettings);
+
+    // Settings in use, after clamping
+    const FAudioAdaptiveNormalizerSettings& GetSettings() const { return Settings; }
+
+    // Forgets the estimates, the next values start them over
+    void Reset();
+
+    // Out[i] = normalized In[i], Out must hold Num floats and may alias In. A change of Num resets the
+    // estimates. With bTrain false the estimates are only read (e.g. for silent frames)
+    void Process(const float* In, float* Out, int32 Num, bool bTrain = true);
+
+    int32 GetNumBands() const { return Floor.Num(); }
+
+    // Current floor and ceiling of Band in the input units, 0 before the band saw a value
+    float GetFloor(int32 Band) const;
+    float GetCeiling(int32 Band) const;
+
+private:
+    FAudioAdaptiveNormalizerSettings Settings;
+
+    // As passed to Configure, before clamping
+    FAudioAdaptiveNormalizerSettings RequestedSettings;
+
+    // Log2 of the estimates, per band
+    TArray<float> Floor;
+    TArray<float> Ceiling;
+
+    // 1 once the band saw a value above the silence threshold
+    TArray<float> Initialized;
+
+    TArray<float> LogValues;
+};
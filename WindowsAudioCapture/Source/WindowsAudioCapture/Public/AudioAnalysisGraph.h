@@ -0,0 +1,98 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAudioAnalysisStageStats {
+    FName Name;
+
+    // Runs of every stage with this name, e.g. one per channel for the channel FFTs
+    uint64 Runs = 0;
+    double TotalSeconds = 0.0;
+    double LastSeconds = 0.0;
+
+    // Moving average over about the last 32 runs, what Run() plans with
+    double RecentSeconds = 0.0;
+
+    double GetAverageSeconds() const {
+        return Runs > 0 ? TotalSeconds / Runs : 0.0;
+    }
+};
+
+struct FAudioAnalysisGraphStats {
+    // Graphs run on the calling thread in stage order, and on the task graph
+    uint64 InlineRuns = 0;
+    uint64 ParallelRuns = 0;
+
+    // Wall time of the whole graph, from Run() to the last stage
+    double TotalSeconds = 0.0;
+
+    // In the order the names were first added
+    TArray<FAudioAnalysisStageStats> Stages;
+
+    double GetAverageSeconds() const {
+        return InlineRuns + ParallelRuns > 0 ? TotalSeconds / (InlineRuns + ParallelRuns) : 0.0;
+    }
+};
+
+///<summary>
+// The analysis of one frame as a DAG of stages: the FFT of each channel, the mix of the channels,
+// then the feature stages that read the mixed spectrum, with the band analysis beside all of it.
+// Run() hands the stages to the task graph, each one dispatched when its prerequisites are done, and
+// waits for the last of them, so independent channels and features run on the worker threads.
+// A stage costs a task dispatch and a wake, which is more than a short stereo frame takes, so Run()
+// first estimates from the recent timings of every stage how much work could overlap (the sum of
+// the stages minus the longest chain) and runs the stages inline, in the order they were added, when
+// that is below the minimum. New stages count as free until they have run once.
+// The graph is rebuilt for every frame (Reset, AddStage), the timings are kept by stage name.
+// Stages may only write what no other stage without a path to or from them touches.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioAnalysisGraph {
+public:
+    FAudioAnalysisGraph();
+
+    // Drops the stages of the last frame, keeps the timings
+    void Reset();
+
+    // Prerequisites are indices returned by earlier AddStage calls, so the stages are always in a
+    // valid order. Returns the index of the new stage
+    int32 AddStage(FName Name, TFunction<void()> Work, const TArray<int32>& Prerequisites = TArray<int32>());
+
+    // Runs every stage and returns when all are done. Capture thread only
+    void Run();
+
+    // Work that could overlap (seconds) below which Run() stays on the calling thread
+    void SetMinParallelSeconds(double InMinParallelSeconds) { MinParallelSeconds = InMinParallelSeconds; }
+
+    // False always runs inline
+    void SetParallelEnabled(bool bInParallelEnabled) { bParallelEnabled = bInParallelEnabled; }
+
+    // Safe from any thread
+    FAudioAnalysisGraphStats GetStats() const;
+
+private:
+    struct FStage {
+        FName Name;
+        TFunction<void()> Work;
+        // Room for the channel FFTs of a 7.1 stream without an allocation
+        TArray<int32, TInlineAllocator<8>> Prerequisites;
+
+        // Index in Stats.Stages
+        int32 StatsIndex = INDEX_NONE;
+
+        // Written by whichever thread runs the stage, read after the graph is done
+        double Seconds = 0.0;
+    };
+
+    bool ShouldRunParallel() const;
+
+    static void RunStage(FStage& Stage);
+
+    TArray<FStage> Stages;
+
+    double MinParallelSeconds;
+    bool bParallelEnabled;
+
+    FAudioAnalysisGraphStats Stats;
+    mutable FCriticalSection StatsLock;
+};
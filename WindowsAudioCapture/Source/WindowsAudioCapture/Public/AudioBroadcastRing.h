@@ -0,0 +1,107 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WindowsAudioCaptureMemory.h"
+#include <atomic>
+
+enum class EAudioRingRead : uint8 {
+    // OutPacket and OutSamples hold the packet at the cursor, the cursor moved past it
+    Packet,
+    // The cursor is at the newest packet, nothing to read yet
+    Empty,
+    // The writer lapped the cursor. It was moved to the oldest packet still in the ring and the
+    // packets skipped are added to FAudioRingCursor::LostPackets. Read again to carry on.
+    Overrun,
+};
+
+struct FAudioRingPacket {
+    enum : uint32 {
+        // Does not follow on from the previous packet (device switch, dropped packets)
+        Discontinuity = 1 << 0,
+        // Closed by the silence gate, no samples were stored
+        Silent = 1 << 1,
+    };
+
+    // Position in the stream of packets, increases by one per written packet
+    uint64 PacketIndex = 0;
+
+    int32 NumFrames = 0;
+    int32 NumChannels = 0;
+    int32 SampleRate = 0;
+    uint32 Flags = 0;
+};
+
+// Position of one reader. Owned by the reader, the ring never touches it.
+struct FAudioRingCursor {
+    // Next packet to read
+    uint64 NextPacket = 0;
+
+    // Packets overwritten before this reader got to them, and how many times that happened
+    uint64 LostPackets = 0;
+    uint32 Overruns = 0;
+};
+
+///<summary>
+// Single-writer, multi-reader ring of interleaved int16 packets.
+// The writer copies each packet into a sample ring and then publishes a small descriptor. Every
+// reader owns a cursor and copies packets out at its own pace. Readers never write to the ring and
+// never wait, so their number only costs the copies they make. The writer never waits for them
+// either: a reader that falls a whole ring behind finds its packets overwritten and gets an
+// explicit Overrun. Descriptors and samples are validated seqlock style after the copy, so a packet
+// overwritten mid-read is reported as an overrun and never returned torn.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioBroadcastRing {
+public:
+    // Both capacities are rounded up to a power of two. The defaults hold about 5 s of 10 ms
+    // stereo 48 kHz packets. The samples count as EWACMemory::CaptureHistory; when WAC.MemoryBudgetMB
+    // does not leave room for them the sample ring is halved until it fits, down to MinSampleCapacity.
+    static constexpr int32 MinSampleCapacity = 1 << 14;
+
+    explicit FAudioBroadcastRing(int32 InPacketCapacity = 512, int32 InSampleCapacity = 1 << 19);
+
+    // Writer thread. Samples may be null for a silent packet; packets larger than the sample ring
+    // keep their newest frames.
+    void Write(const int16* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, uint32 Flags);
+
+    // Packets written so far
+    uint64 GetWrittenPackets() const { return WrittenPackets.load(std::memory_order_acquire); }
+
+    // Any thread. A cursor that starts with the next packet written
+    FAudioRingCursor MakeCursor() const;
+
+    // Any thread, any number of readers at once as long as each uses its own cursor
+    EAudioRingRead Read(FAudioRingCursor& Cursor, FAudioRingPacket& OutPacket, TArray<int16>& OutSamples) const;
+
+    int32 GetPacketCapacity() const { return PacketMask + 1; }
+    int32 GetSampleCapacity() const { return (int32)(SampleMask + 1); }
+
+private:
+    struct FDescriptor {
+        // PacketIndex + 1 once the descriptor is complete, 0 while the writer fills it in
+        std::atomic<uint64> Sequence;
+
+        // Absolute position of the first sample in the sample ring
+        uint64 SampleOffset;
+        int32 NumSamples;
+
+        FAudioRingPacket Packet;
+    };
+
+    // Moves the cursor to the oldest packet that can still be read and counts what was skipped
+    void SkipLostPackets(FAudioRingCursor& Cursor, uint64 OldestReadable) const;
+
+    TUniquePtr<FDescriptor[]> Descriptors;
+    int32 PacketMask;
+
+    TArray<int16> Samples;
+    uint64 SampleMask;
+
+    // Absolute end of the samples written or being written. Raised before the samples are copied,
+    // so a reader can tell afterwards whether its range was overwritten.
+    std::atomic<uint64> ReservedSamples;
+
+    std::atomic<uint64> WrittenPackets;
+
+    FWACMemoryCounter Memory;
+};
@@ -0,0 +1,44 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+///<summary>
+// Micro-benchmarks behind the WAC.Benchmark* console commands. Each one runs on the calling thread on
+// synthetic input, logs its results and leaves the live capture alone. They share the timing loop and
+// the seeded test signal, so a benchmark only brings the kernel it times and the numbers of two runs
+// or two machines compare.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioCaptureBenchmarks {
+public:
+    // Times the FFT against the Goertzel bank on a NumFrames stereo block and logs the number of target
+    // frequencies at which both cost the same. Returns that number.
+    static int32 TargetAnalysis(int32 NumFrames);
+
+    // Encodes and decodes a NumBins spectrum of a tone mix at both compact precisions and logs the time,
+    // the error against the float values and the bytes moved per frame.
+    static void CompactSpectrum(int32 NumBins);
+
+    // Times the channel analysis with the kernels specialized per channel count and sample format
+    // against the generic runtime-stride kernels, for a NumFrames block at several channel counts.
+    static void AnalysisKernels(int32 NumFrames);
+
+    // Runs the harmonic/percussive separation on a NumBins spectrogram of a tone with clicks at every
+    // bin decimation and logs the time per frame and how well the clicks are told from the tone.
+    static void HarmonicPercussive(int32 NumBins);
+
+    // Runs the same stream of NumFrames stereo blocks, seconds of noise alternating with seconds of a quiet
+    // room, through the channel analysis once with the silence gate in front and once without. Logs the
+    // measured saving next to the one WAC.Stats would estimate from the skipped blocks.
+    static void SilenceGate(int32 NumFrames);
+
+private:
+    // Seconds per call of Body, averaged over NumCalls calls. Body gets the index of the call
+    static double TimePerCall(int32 NumCalls, TFunctionRef<void(int32 Call)> Body);
+
+    // NumFrames interleaved frames of white noise at about -12 dBFS, the same on every run
+    static TArray<int16> MakeNoise(int32 NumFrames, int32 NumChannels);
+
+    static constexpr int32 DefaultCalls = 200;
+    static constexpr int32 Seed = 1234;
+};
@@ -0,0 +1,179 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+// Copy of an FAudioDeadlineHistogram at one point in time
+struct FAudioDeadlineHistogramSnapshot {
+    static constexpr int32 NumBuckets = 24;
+
+    // Upper edge of every bucket, the last one has no upper edge
+    double BucketEdges[NumBuckets] = {};
+    uint64 Counts[NumBuckets] = {};
+
+    uint64 Count = 0;
+    double Sum = 0.0;
+    double Max = 0.0;
+
+    double GetMean() const {
+        return Count > 0 ? Sum / Count : 0.0;
+    }
+
+    // Upper edge of the bucket Quantile (0 to 1) of the values fall in, Max for the last bucket
+    double GetQuantile(double Quantile) const;
+};
+
+///<summary>
+// Histogram with fixed buckets, Width apart (linear) or doubling from Width (log2), written by one
+// thread and read by any. Every count is its own relaxed atomic, so Add never takes a lock and a
+// reader never holds up the writer; a snapshot taken during an Add may miss that one value.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioDeadlineHistogram {
+public:
+    static constexpr int32 NumBuckets = FAudioDeadlineHistogramSnapshot::NumBuckets;
+
+    enum class EScale : uint8 {
+        Linear,
+        Log2,
+    };
+
+    FAudioDeadlineHistogram(EScale InScale, double InWidth);
+
+    // Single writer
+    void Add(double Value);
+
+    // Any thread; values added meanwhile may end up on either side of the reset
+    void Reset();
+
+    FAudioDeadlineHistogramSnapshot GetSnapshot() const;
+
+private:
+    int32 GetBucket(double Value) const;
+    double GetBucketEdge(int32 Bucket) const;
+
+    const EScale Scale;
+    const double Width;
+
+    std::atomic<uint64> Counts[NumBuckets];
+    std::atomic<double> Sum;
+    std::atomic<double> Max;
+};
+
+struct FAudioCaptureDeadlineStats {
+    // Loop iterations of the running capture thread, and the WASAPI drains
+    uint64 Iterations = 0;
+    uint64 Captures = 0;
+
+    // Drains that came later than the WASAPI buffer duration after the previous one, or found it full.
+    // Audio was lost there
+    uint64 DeadlineMisses = 0;
+
+    // Packets flagged by WASAPI: data discontinuity (overflow) and timestamp error
+    uint64 Discontinuities = 0;
+    uint64 TimestampErrors = 0;
+
+    // Longest time between two drains of the running stream
+    double MaxCaptureGapSeconds = 0.0;
+
+    // Duration of the WASAPI buffer of the last drain, the deadline
+    double BufferSeconds = 0.0;
+
+    // How much later than its timeout a timed wait returned (us)
+    FAudioDeadlineHistogramSnapshot WakeLateness;
+
+    // Packets drained per wake
+    FAudioDeadlineHistogramSnapshot PacketsPerWake;
+
+    // WASAPI buffer fill at the start of a drain (percent)
+    FAudioDeadlineHistogramSnapshot BufferFill;
+
+    // Time spent in Sink->CopyData per wake, including its locks (us)
+    FAudioDeadlineHistogramSnapshot SinkTime;
+
+    // Work of one iteration, capture and analysis, from the wake to the next wait (us)
+    FAudioDeadlineHistogramSnapshot IterationTime;
+};
+
+///<summary>
+// Watches every iteration of the capture thread against the deadline it really has: the WASAPI shared
+// buffer holds BufferSeconds of audio, a drain later than that loses some. The worker reports its waits
+// and iterations, AudioListener every drain and packet; the monitor keeps counters and
+// FAudioDeadlineHistograms that WAC.Deadlines prints while the capture runs. Nothing here allocates or
+// locks, so it stays on in shipping builds. Tells apart a late wake (scheduler, loaded machine), a
+// slow iteration (analysis) and a slow sink (a reader holding the sink lock).
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioCaptureDeadlineMonitor {
+public:
+    FAudioCaptureDeadlineMonitor();
+
+    // Capture thread, around a wait with a timeout. bTriggered is what FEvent::Wait returned; a wait cut
+    // short by the event says nothing about the scheduler and is not counted
+    void BeginWait(double TimeoutSeconds);
+    void EndWait(bool bTriggered);
+
+    // Capture thread, around the work of one loop iteration
+    void BeginIteration();
+    void EndIteration();
+
+    // Capture thread: the stream (re)started or was paused, the gap to the next drain is not a miss
+    void Suspend();
+
+    // Start of a drain: frames queued in a WASAPI buffer of BufferFrames at SampleRate
+    void BeginCapture(uint32 QueuedFrames, uint32 BufferFrames, int32 SampleRate);
+
+    // One packet of the drain and the time its CopyData took
+    void AddPacket(bool bDiscontinuity, bool bTimestampError, double SinkSeconds);
+
+    // Any thread
+    void Reset();
+    FAudioCaptureDeadlineStats GetStats() const;
+
+private:
+    std::atomic<uint64> Iterations;
+    std::atomic<uint64> Captures;
+    std::atomic<uint64> DeadlineMisses;
+    std::atomic<uint64> Discontinuities;
+    std::atomic<uint64> TimestampErrors;
+    std::atomic<double> MaxCaptureGapSeconds;
+    std::atomic<double> BufferSeconds;
+
+    FAudioDeadlineHistogram WakeLateness;
+    FAudioDeadlineHistogram PacketsPerWake;
+    FAudioDeadlineHistogram BufferFill;
+    FAudioDeadlineHistogram SinkTime;
+    FAudioDeadlineHistogram IterationTime;
+
+    // Capture thread only
+    double WaitDeadlineSeconds;
+    double IterationStartSeconds;
+    double LastCaptureSeconds;
+    int32 IterationPackets;
+    double IterationSinkSeconds;
+    bool bCapturedThisIteration;
+};
+
+///<summary>
+// Scheduling of the calling thread for the capture: an MMCSS task ("Pro Audio", "Audio", ...), or a
+// thread priority, and an affinity mask. MMCSS raises the priority on its own, so Priority only applies
+// while no task is set. Apply() compares with what is already applied and only calls the OS on changes.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioCaptureThreadScheduling {
+public:
+    FAudioCaptureThreadScheduling();
+
+    // Calling thread. Empty MmcssTask leaves MMCSS, Priority is an EThreadPriority or < 0 for TPri_Normal
+    // (what the capture thread is created with), AffinityMask 0 allows every core
+    void Apply(const FString& MmcssTask, int32 Priority, uint64 AffinityMask);
+
+    // Calling thread, undoes the MMCSS registration. Call before the thread exits, the next Apply registers again
+    void Revert();
+
+    bool IsMmcssRegistered() const { return MmcssHandle != nullptr; }
+
+private:
+    void* MmcssHandle;
+    FString AppliedTask;
+    int32 AppliedPriority;
+    uint64 AppliedAffinity;
+};
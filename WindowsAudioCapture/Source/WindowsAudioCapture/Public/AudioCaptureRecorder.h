@@ -0,0 +1,141 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IAudioSink.h"
+#include "AudioCaptureRecording.h"
+#include "AudioSpectrumFrame.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+
+struct FAudioRecorderStats {
+    bool bRecording = false;
+    FString Path;
+
+    int64 WrittenBytes = 0;
+    int64 QueuedBytes = 0;
+    int64 PeakQueuedBytes = 0;
+
+    int64 RecordedPcmFrames = 0;
+    int64 DroppedPcmFrames = 0;
+    int32 DroppedPcmPackets = 0;
+
+    int32 RecordedSpectrumFrames = 0;
+    int32 DroppedSpectrumFrames = 0;
+};
+
+///<summary>
+// Optional tee in front of the capture sink that records what the listener delivers, and the frames
+// the worker publishes, into a .wacr file (see AudioCaptureRecording.h).
+// Every IAudioSink call is forwarded to the downstream sink unchanged. While recording, the capture
+// thread copies the packet into a single-producer/single-consumer lock-free queue and returns; a
+// writer thread owns the file. Published frames are queued by reference since they are immutable.
+// Memory is bounded: once WAC.RecorderMaxQueuedMB is queued, or the queue would take the plugin past
+// WAC.MemoryBudgetMB (EWACMemory::RecorderQueue), new items are dropped and counted, and
+// the next recorded packet is flagged discontinuous with the number of frames lost.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioCaptureRecorder : public IAudioSink, public FRunnable {
+public:
+    explicit FAudioCaptureRecorder(IAudioSink& InDownstream);
+    ~FAudioCaptureRecorder();
+
+    // Game thread. Creates the file and the writer thread, stopping a previous recording first
+    bool StartRecording(const FString& Path, FString& OutError);
+
+    // Game thread. Waits for the writer to flush the queue, writes the index and closes the file
+    void StopRecording();
+
+    bool IsRecording() const { return bRecording.load(std::memory_order_relaxed); }
+
+    FAudioRecorderStats GetStats() const;
+
+    // Capture thread, from FAudioCaptureWorker::PublishFrame
+    void RecordFrame(const FAudioSpectrumFramePtr& Frame);
+
+    // IAudioSink, capture thread
+    int CopyData(const BYTE* Data, const int NumFramesAvailable) override;
+    void MarkDiscontinuity() override;
+    void SetFormat(int SampleRate, int NumChannels, int BitsPerSample) override;
+
+    // FRunnable, writer thread
+    uint32 Run() override;
+
+private:
+    struct FQueuedItem {
+        FAudioRecordingChunkHeader Chunk;
+        FAudioRecordingFormat Format;
+        FAudioRecordingPcmHeader Pcm;
+        TArray<uint8> Samples;
+        FAudioSpectrumFramePtr Frame;
+        uint32 DroppedFramesBefore = 0;
+        int64 Bytes = 0;
+    };
+
+    // Capture thread: claims Bytes of the queue budget, false if the item has to be dropped
+    bool ReserveQueueBytes(int64 Bytes);
+
+    // Capture thread: first call of a new recording queues the current format
+    void BeginProducerSession();
+
+    // Writer thread
+    void DrainQueue();
+    void WriteItem(const FQueuedItem& Item);
+    void WriteChunk(EAudioRecordingChunk Type, double Seconds, const void* First, uint32 FirstSize, const void* Second = nullptr, uint32 SecondSize = 0, const void* Third = nullptr, uint32 ThirdSize = 0);
+    void FinishFile();
+
+    IAudioSink& Downstream;
+
+    TQueue<FQueuedItem, EQueueMode::Spsc> Queue;
+
+    std::atomic<bool> bRecording;
+
+    // Producer calls in flight, StopRecording waits for them to leave before flushing
+    std::atomic<int32> ProducersInFlight;
+
+    // Incremented by StartRecording, the capture thread starts a new stream when it sees a new value
+    std::atomic<uint32> Session;
+
+    // Added by the capture thread, released by the writer
+    std::atomic<int64> QueuedBytes;
+    int64 MaxQueuedBytes;
+
+    // Written by the capture thread only
+    std::atomic<int64> PeakQueuedBytes;
+    std::atomic<int64> DroppedPcmFrames;
+    std::atomic<int32> DroppedPcmPackets;
+    std::atomic<int32> DroppedSpectrumFrames;
+
+    // Set before bRecording, read by the capture thread
+    double RecordingStartSeconds;
+
+    // Capture thread only
+    uint32 ProducerSession;
+    FAudioRecordingFormat CurrentFormat;
+    uint64 StreamFrame;
+    uint64 PendingDroppedFrames;
+    uint32 PendingDroppedSpectrumFrames;
+    bool bPendingDiscontinuity;
+
+    // Written by the game thread before the writer thread starts, then owned by the writer
+    TUniquePtr<IFileHandle> File;
+    FAudioRecordingFileHeader FileHeader;
+    FAudioRecordingFormat WriterFormat;
+    bool bFormatPending;
+    bool bWriteFailed;
+    double LastKeyframeSeconds;
+    double LastChunkSeconds;
+    TArray<FAudioRecordingIndexEntry> Keyframes;
+
+    FRunnableThread* WriterThread;
+    FEvent* WakeEvent;
+    std::atomic<bool> bStopWriter;
+
+    // Path, bRecording and the writer side counters
+    FAudioRecorderStats Stats;
+    mutable FCriticalSection StatsLock;
+};
@@ -0,0 +1,147 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+// Capture recording (.wacr) layout, little endian, written as-is:
+//   FAudioRecordingFileHeader, then chunks of FAudioRecordingChunkHeader + PayloadSize bytes.
+// Every chunk carries its own size, so a file cut short by a crash still reads up to its last whole
+// chunk. About once a second the writer repeats the Format chunk right before a Pcm chunk; those
+// keyframes are listed in the Index chunk written on close, and a reader seeking to one of them has
+// everything it needs to decode from there.
+struct FAudioRecordingFileHeader {
+    // "WACR"
+    static constexpr uint32 ExpectedMagic = 0x52434157;
+
+    // Bumped whenever a chunk layout changes, older files are rejected
+    static constexpr uint32 CurrentVersion = 1;
+
+    uint32 Magic;
+    uint32 Version;
+
+    // FPlatformTime::Seconds() when the recording started, chunk times are relative to it
+    double StartSeconds;
+
+    // Offset of the Index chunk, 0 if the recording was not closed properly
+    uint64 IndexOffset;
+};
+
+static_assert(sizeof(FAudioRecordingFileHeader) == 24, "FAudioRecordingFileHeader is part of the file format");
+
+enum class EAudioRecordingChunk : uint32 {
+    // FAudioRecordingFormat, applies to the Pcm chunks that follow
+    Format = 1,
+    // FAudioRecordingPcmHeader followed by the interleaved samples of the packet
+    Pcm = 2,
+    // FAudioRecordingFrameHeader followed by NumMagnitudes then NumBands floats
+    Frame = 3,
+    // Array of FAudioRecordingIndexEntry
+    Index = 4,
+};
+
+struct FAudioRecordingChunkHeader {
+    EAudioRecordingChunk Type;
+    uint32 PayloadSize;
+
+    // Capture time relative to FAudioRecordingFileHeader::StartSeconds
+    double Seconds;
+};
+
+static_assert(sizeof(FAudioRecordingChunkHeader) == 16, "FAudioRecordingChunkHeader is part of the file format");
+
+struct FAudioRecordingFormat {
+    uint32 SampleRate;
+    uint32 NumChannels;
+    uint32 BitsPerSample;
+    uint32 Reserved;
+
+    uint32 GetBytesPerFrame() const { return NumChannels * BitsPerSample / 8; }
+};
+
+struct FAudioRecordingPcmHeader {
+    enum : uint32 {
+        // The packet does not follow on from the previous one: device switch, or packets were dropped
+        Discontinuity = 1 << 0,
+        // WASAPI flagged the packet silent, no samples follow
+        Silent = 1 << 1,
+    };
+
+    // Position of the first frame in the recorded stream, dropped packets included
+    uint64 StreamFrame;
+    uint32 NumFrames;
+    uint32 Flags;
+
+    // Frames the recorder had to drop right before this packet
+    uint64 DroppedFramesBefore;
+};
+
+struct FAudioRecordingFrameHeader {
+    enum : uint32 {
+        Discontinuity = 1 << 0,
+        Silent = 1 << 1,
+        HasSpectrum = 1 << 2,
+    };
+
+    // FAudioSpectrumFrame::FrameIndex and its Timestamp relative to the start of the recording
+    uint64 FrameIndex;
+    double Timestamp;
+
+    uint32 Flags;
+    uint32 NumMagnitudes;
+    uint32 NumBands;
+
+    // Published frames the recorder had to drop right before this one
+    uint32 DroppedFramesBefore;
+
+    float MomentaryLufs;
+    float ShortTermLufs;
+    float Rms;
+    float Peak;
+};
+
+struct FAudioRecordingIndexEntry {
+    double Seconds;
+    uint64 StreamFrame;
+
+    // File offset of a keyframe: a Format chunk immediately followed by a Pcm chunk
+    uint64 Offset;
+};
+
+///<summary>
+// Sequential reader for capture recordings with keyframe seeking.
+// Open loads the Index chunk, or rebuilds the keyframe list by walking the chunk headers when the
+// recording was never closed. Chunks are then read one at a time; payloads are not interpreted here.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioRecordingReader {
+public:
+    FAudioRecordingReader();
+    ~FAudioRecordingReader();
+
+    bool Open(const FString& Path, FString& OutError);
+    void Close();
+
+    bool IsOpen() const { return File.IsValid(); }
+
+    const FAudioRecordingFileHeader& GetHeader() const { return Header; }
+    const TArray<FAudioRecordingIndexEntry>& GetKeyframes() const { return Keyframes; }
+
+    // Time of the last chunk
+    double GetDuration() const { return Duration; }
+
+    // Positions the reader on the last keyframe at or before Seconds (the first one for earlier times)
+    bool Seek(double Seconds);
+
+    // Next chunk; false at the end of the recording, the Index chunk or a truncated chunk
+    bool ReadChunk(FAudioRecordingChunkHeader& OutHeader, TArray<uint8>& OutPayload);
+
+private:
+    // Walks the chunk headers from the current position and records every keyframe
+    void RebuildKeyframes();
+
+    TUniquePtr<IFileHandle> File;
+    FAudioRecordingFileHeader Header;
+    TArray<FAudioRecordingIndexEntry> Keyframes;
+    double Duration;
+};
@@ -4,52 +4,428 @@
 #include "Engine.h"
 #include "AudioSink.h"
 #include "AudioListener.h"
+#include "AudioDeviceStateMachine.h"
+#include "AudioSpectrumFrame.h"
+#include "AudioSpectrumScaling.h"
+#include "AudioGoertzelBank.h"
+#include "AudioMultiResolutionAnalyzer.h"
+#include "AudioMusicFeatures.h"
+#include "AudioChannelSpectrumAnalyzer.h"
+#include "AudioCaptureRecorder.h"
+#include "AudioReplayDevice.h"
+#include "AudioSharedSpectrumPublisher.h"
+#include "AudioCompactSpectrum.h"
+#include "AudioWaveformPyramid.h"
+#include "AudioFrameNotifier.h"
+#include "AudioAdaptiveNormalizer.h"
+#include "AudioAnalysisGraph.h"
+#include "AudioCaptureDeadlineMonitor.h"
+#include <atomic>
 
-// KISS Headers
-#include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
-#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftnd.h"
+struct FAudioAnalysisStats
+{
+	// Frames that went through the FFT
+	uint64 AnalyzedFrames = 0;
+
+	// Wakes where the silence gate was closed and the FFT was skipped
+	uint64 SkippedSilentAnalyses = 0;
+
+	// Wakes where only levels were published because nobody had asked for a spectrum recently
+	uint64 SkippedUnrequestedAnalyses = 0;
+
+	// Constant-Q kernels built so far, one per sample rate / FFT size / layout combination
+	int32 ConstantQKernelsBuilt = 0;
+
+	// Frames with chroma and pitch
+	uint64 AnalyzedMusicFrames = 0;
+	double TotalMusicAnalysisSeconds = 0.0;
+
+	double GetAverageMusicAnalysisSeconds() const {
+		return AnalyzedMusicFrames > 0 ? TotalMusicAnalysisSeconds / AnalyzedMusicFrames : 0.0;
+	}
+
+	// Frames with a multi-resolution band spectrum
+	uint64 AnalyzedBandFrames = 0;
+	double TotalBandAnalysisSeconds = 0.0;
+
+	double GetAverageBandAnalysisSeconds() const {
+		return AnalyzedBandFrames > 0 ? TotalBandAnalysisSeconds / AnalyzedBandFrames : 0.0;
+	}
+
+	// Frames with a harmonic/percussive split, how many of them went over WAC.HarmonicPercussiveBudgetMs
+	// and the bin decimation the budget settled on
+	uint64 AnalyzedHarmonicPercussiveFrames = 0;
+	double TotalHarmonicPercussiveSeconds = 0.0;
+	uint64 HarmonicPercussiveOverBudgetFrames = 0;
+	int32 HarmonicPercussiveDecimation = 1;
+
+	double GetAverageHarmonicPercussiveSeconds() const {
+		return AnalyzedHarmonicPercussiveFrames > 0 ? TotalHarmonicPercussiveSeconds / AnalyzedHarmonicPercussiveFrames : 0.0;
+	}
+
+	double GetAverageTargetAnalysisSeconds() const {
+		return AnalyzedTargetFrames > 0 ? TotalTargetAnalysisSeconds / AnalyzedTargetFrames : 0.0;
+	}
+
+	double TotalAnalysisSeconds = 0.0;
+
+	// Frames where only the registered target frequencies were evaluated
+	uint64 AnalyzedTargetFrames = 0;
+	double TotalTargetAnalysisSeconds = 0.0;
+
+	// Noise floor tracked by the silence gate
+	float NoiseFloorDb = 0.0f;
+
+	// Captured packets the analysis fell a whole sink ring behind on
+	uint64 LostPackets = 0;
+
+	double GetAverageAnalysisSeconds() const {
+		return AnalyzedFrames > 0 ? TotalAnalysisSeconds / AnalyzedFrames : 0.0;
+	}
+
+	// CPU time the gate and the demand check saved, assuming a skipped analysis would have cost the average one
+	double GetEstimatedSavedSeconds() const {
+		return (SkippedSilentAnalyses + SkippedUnrequestedAnalyses) * GetAverageAnalysisSeconds();
+	}
+};
 
 class FAudioCaptureWorker : public FRunnable
 {
 
 public:
 
-	//Singleton instance, can access the thread any time via static accessor, if it is active! 
-	static FAudioCaptureWorker* Runnable;
-
 	//Thread to run the worker FRunnable on 
 	FRunnableThread* Thread;
 
 	//TArray<float> GetFrequencies();
 	TArray<float> GetFrequencyArray(float FreqLogBase, float FreqMultiplier, float FreqPower, float FreqOffset);
 
+	// Latest published frame scaled with Profile. Reading the same frame again with the same profile returns the memoized array
+	TArray<float> GetScaledSpectrum(const FAudioSpectrumScalingProfile& Profile);
+
+	// GetScaledSpectrum quantized to Precision. Encoded once per frame, profile and precision and shared
+	// by every caller, null until the first analysis. Safe from any thread
+	FAudioCompactSpectrumPtr GetCompactSpectrum(const FAudioSpectrumScalingProfile& Profile, EAudioCompactPrecision Precision);
+
+	// Latest published frame (linear magnitudes), null until the first analysis. Safe from any thread
+	FAudioSpectrumFramePtr GetLatestFrame() const;
+
+	// Index of the latest published frame, 0 until the first analysis
+	uint64 GetLatestFrameIndex() const;
+
+	// Time-domain levels of the latest frame. Reading levels never makes the worker run an FFT
+	FAudioLevelMetrics GetLatestLevels() const;
+
+	// Value at each frequency (Hz) scaled with Profile, one entry per frequency. The frequencies stay
+	// registered for SpectrumDemandTimeout seconds; while only a small set is registered and nobody asks
+	// for the full spectrum, the worker evaluates them with a Goertzel bank instead of the FFT.
+	TArray<float> GetTargetFrequencyValues(const TArray<int32>& Frequencies, const FAudioSpectrumScalingProfile& Profile);
+
+	// Latest multi-resolution band spectrum scaled with Profile, one value per band. Keeps the band
+	// analysis running for SpectrumDemandTimeout seconds; it is independent of the linear FFT.
+	TArray<float> GetBandSpectrum(const FAudioSpectrumScalingProfile& Profile);
+
+	// Latest spectrum on the constant-Q layout in Settings, scaled with Profile. Keeps the FFT and the
+	// mapping running for SpectrumDemandTimeout seconds. The last caller's layout is the one computed;
+	// an empty array means the latest frame was analysed with another layout (or none yet).
+	TArray<float> GetConstantQSpectrum(const FAudioConstantQSettings& Settings, const FAudioSpectrumScalingProfile& Profile);
+
+	// One channel of the latest frame scaled with Profile, empty if the stream has fewer channels.
+	// The stereo image (width, balance, per band pan) is in GetLatestFrame()->Channels.
+	TArray<float> GetChannelSpectrum(int32 Channel, const FAudioSpectrumScalingProfile& Profile);
+
+	// Chroma and dominant pitch of the latest frame. Keeps the FFT and the feature stage running for
+	// SpectrumDemandTimeout seconds; bValid is false until the first frame analysed after the request.
+	FAudioMusicFeatures GetMusicFeatures();
+
+	// Harmonic and percussive energy per band of the latest frame, both scaled with Profile. Keeps the
+	// FFT and the separation running for SpectrumDemandTimeout seconds; bValid is false until the first
+	// frame analysed after the request.
+	FAudioHarmonicPercussiveBands GetHarmonicPercussive(const FAudioSpectrumScalingProfile& Profile);
+
+	// Min, max and RMS of the captured waveform (mono, -1 to 1) over the last WindowSeconds, split into
+	// NumPoints equal points, oldest first. Keeps the envelope updated for SpectrumDemandTimeout seconds;
+	// the window is cut to the FAudioWaveformPyramid capacity and the points are 0 until samples arrive.
+	void GetWaveformEnvelope(float WindowSeconds, int32 NumPoints, TArray<float>& OutMin, TArray<float>& OutMax, TArray<float>& OutRms);
+
+	// Bass / low mid / high mid / treble energy of the band spectrum scaled with Profile, and the onset counts.
+	// Keeps the band analysis running for SpectrumDemandTimeout seconds like GetBandSpectrum.
+	FAudioBandOnsets GetBandOnsets(const FAudioSpectrumScalingProfile& Profile);
+
+	// Centre frequency (Hz) of every band returned by GetBandSpectrum
+	TArray<float> GetBandFrequencies() const;
+
+	// Latest spectrum with every bin mapped to 0..1 between running quantiles of its own recent values
+	// (WAC.NormalizeFloorQuantile / WAC.NormalizeCeilingQuantile), so no scaling profile has to be tuned
+	// to the source volume. Keeps the FFT and the normalization running for SpectrumDemandTimeout seconds
+	TArray<float> GetNormalizedSpectrum();
+
+	// GetBandSpectrum normalized the same way, one value per band of GetBandFrequencies
+	TArray<float> GetNormalizedBandSpectrum();
+
+	// Completed with the next frame that has a spectrum, on the game thread, or with null if the worker
+	// is destroyed first. Keeps the FFT running while the wait is pending. Safe from any thread
+	TFuture<FAudioSpectrumFramePtr> WaitForNextSpectrum();
+	void WaitForNextSpectrum(FAudioFrameCallback Callback);
+
+	// Completed with the first frame that has an onset in Band (an FAudioBandOnsets band, INDEX_NONE for
+	// any) after the call, on the game thread. Keeps the band analysis running while the wait is pending
+	TFuture<FAudioSpectrumFramePtr> WaitForOnset(int32 Band = INDEX_NONE);
+	void WaitForOnset(int32 Band, FAudioFrameCallback Callback);
+
+	// Game thread. The delegate runs once per game thread frame in which frames were published, with the
+	// latest of them, instead of polling GetLatestFrameIndex on a timer
+	FDelegateHandle AddFramePublishedListener(FAudioFramePublishedEvent::FDelegate Delegate) {
+		return FrameNotifier.AddListener(MoveTemp(Delegate));
+	}
+
+	void RemoveFramePublishedListener(FDelegateHandle Handle) {
+		FrameNotifier.RemoveListener(Handle);
+	}
+
+	FAudioFrameNotifierStats GetNotifierStats() const {
+		return FrameNotifier.GetStats();
+	}
+
+	// Captured int16 packets, before any analysis. Any number of consumers can read them from any
+	// thread without locking: each makes its own cursor and reads at its own pace, nothing is consumed.
+	FAudioRingCursor MakeSampleCursor() const {
+		return m_sink.MakeCursor();
+	}
+
+	EAudioRingRead ReadSamples(FAudioRingCursor& Cursor, AudioChunk& OutChunk, TArray<int16>& OutSamples) const {
+		return m_sink.Read(Cursor, OutChunk, OutSamples);
+	}
+
+	// Keeps the FFT running for SpectrumDemandTimeout seconds. GetScaledSpectrum calls this, readers of
+	// GetLatestFrame that want Magnitudes filled have to call it themselves
+	void RequestSpectrum();
+
 private:
 
 	//Stop this thread? Uses Thread Safe Counter 
 	FThreadSafeCounter StopTaskCounter;
 
 	// Bool to check if the thread is running
-	bool bIsFinished;
+	FThreadSafeBool bIsFinished;
+
+	// Is the listener allowed to capture? The thread stays parked while this is false
+	FThreadSafeBool bCaptureEnabled;
+
+	// Number of published frames that follow a gap (device switch)
+	FThreadSafeCounter DiscontinuityCounter;
+
+	// Wakes the capture thread early on Stop() and on capture enable/disable, so shutdown never waits a full poll interval
+	FEvent* WakeEvent;
 
 	// Counter for the ThreadNames
 	static int32 ThreadCounter;
 
-	// Function to calculate the frequency spectrum
-	void CalculateFrequencySpectrum
-	(
-		int16* SamplePointer,
-		const int32 NumChannels,
-		const int32 NumAvailableSamples,
-		float FreqLogBase,
-		float FreqMultiplier,
-		float FreqPower,
-		float FreqOffset,
-		TArray<float>& OutFrequencies
-	);
+	// Capture thread: analyse what the sink received since the last call and publish it
+	void AnalyzeCapturedAudio();
+
+	// Has anyone asked for a spectrum within SpectrumDemandTimeout?
+	bool IsSpectrumRequested() const;
+
+	bool IsBandSpectrumRequested() const;
+
+	bool IsMusicFeaturesRequested() const;
+
+	bool IsHarmonicPercussiveRequested() const;
+
+	bool IsWaveformRequested() const;
+
+	bool IsNormalizedRequested() const;
+
+	// Capture thread: push a chunk read from the sink into PitchDetector, (re)configuring it on format changes
+	void FeedPitchDetector(const AudioChunk& Chunk);
+
+	// Capture thread or an analysis stage: chroma from the frame's linear magnitudes, pitch from PitchDetector
+	void AnalyzeMusicFeatures(FAudioSpectrumFrame& Frame, FAudioConstantQKernel& ChromaKernel);
+
+	// Analysis stage: split the frame's linear magnitudes with HarmonicPercussive. SampleRate is read on
+	// the capture thread, the sink is not for other threads
+	void AnalyzeHarmonicPercussive(FAudioSpectrumFrame& Frame, int32 SampleRate, bool bDiscontinuity);
+
+	// Capture thread: fill the normalized arrays of whatever the frame holds, silent frames only read the estimates
+	void NormalizeFrame(FAudioSpectrumFrame& Frame);
+
+	// Layout of the last GetConstantQSpectrum call, false if that was more than SpectrumDemandTimeout ago
+	bool GetRequestedConstantQ(FAudioConstantQSettings& OutSettings) const;
+
+	// Capture thread: push a chunk read from the sink into BandAnalyzer, (re)configuring it on format changes
+	void FeedBandAnalyzer(const AudioChunk& Chunk);
+
+	// Capture thread: push a chunk read from the sink into Waveform, starting it over after a pause in the requests
+	void FeedWaveform(const AudioChunk& Chunk);
+
+	// Capture thread: run BandAnalyzer into Frame
+	void AnalyzeBands(FAudioSpectrumFrame& Frame);
+
+	// Target frequencies requested within SpectrumDemandTimeout, sorted. Drops the expired ones
+	void GatherTargetFrequencies(TArray<int32>& OutFrequencies);
+
+	// Capture thread: run the Goertzel bank over the chunk into Frame
+	void AnalyzeTargetFrequencies(const AudioChunk& Chunk, const TArray<int32>& Frequencies, FAudioSpectrumFrame& Frame);
+
+	// Capture thread: switch between m_listener and m_replay after StartReplay/StopReplay
+	void ApplyPendingReplay();
+
+	// Capture thread: open or close m_sharedSpectrum after StartSharedSpectrum/StopSharedSpectrum
+	void ApplyPendingSharedSpectrum();
+
+	// Capture thread: stamp the frame, make it the latest one and wake the waits it completes
+	void PublishFrame(TSharedPtr<FAudioSpectrumFrame, ESPMode::ThreadSafe> Frame, bool bDiscontinuity);
+
+	// FPlatformTime::Seconds() of the last spectrum request
+	std::atomic<double> LastSpectrumRequestSeconds;
+
+	// The FFT stops this long after the last spectrum request, levels keep being published
+	static constexpr double SpectrumDemandTimeout = 2.0;
+
+	FAudioAnalysisStats AnalysisStats;
+	mutable FCriticalSection AnalysisStatsLock;
+
+	// Latest frame, swapped under FrameLock by the capture thread
+	FAudioSpectrumFramePtr LatestFrame;
+	mutable FCriticalSection FrameLock;
+	uint64 NextFrameIndex;
+
+	// Scaled copies of the latest frame, one per profile in use
+	struct FScaledSpectrumCacheEntry
+	{
+		TSharedPtr<FAudioSpectrumScalingTable> Table;
+		uint64 FrameIndex = 0;
+		uint64 LastUseFrameIndex = 0;
+		TArray<float> Values;
+
+		// Values encoded at each EAudioCompactPrecision, on demand
+		FAudioCompactSpectrumPtr Compact[2];
+	};
+
+	// Least recently used profiles are dropped past this
+	static const int32 MaxCachedScalingProfiles = 8;
+
+	TArray<FScaledSpectrumCacheEntry> ScalingCache;
+	FCriticalSection ScalingCacheLock;
+
+	// Finds or creates the cache entry for Profile, evicting the least recently used one. ScalingCacheLock must be held
+	FScaledSpectrumCacheEntry& FindOrAddScalingEntry(const FAudioSpectrumScalingProfile& Profile, uint64 FrameIndex);
+
+	// Brings Entry.Values up to Frame. ScalingCacheLock must be held
+	static void UpdateScaledValues(FScaledSpectrumCacheEntry& Entry, const FAudioSpectrumFrame& Frame);
+
+	// Target frequency (Hz) -> FPlatformTime::Seconds() of its last request
+	TMap<int32, double> TargetRequests;
+	FCriticalSection TargetLock;
+
+	// Capture thread only
+	FAudioGoertzelBank TargetBank;
+	FAudioChannelSpectrumAnalyzer ChannelAnalyzer;
+
+	// Capture thread only, rebuilt for every frame; its stages are the only code touching the analyzers while it runs
+	FAudioAnalysisGraph AnalysisGraph;
+
+	// Set by GetConstantQSpectrum, read by the capture thread
+	FAudioConstantQSettings RequestedConstantQSettings;
+	double LastConstantQRequestSeconds;
+	mutable FCriticalSection ConstantQLock;
+
+	// Capture thread only
+	FAudioConstantQKernelCache ConstantQKernels;
+
+	// FPlatformTime::Seconds() of the last GetMusicFeatures call
+	std::atomic<double> LastMusicRequestSeconds;
+
+	// Capture thread only, fed with every captured frame while the music features are in use
+	FAudioPitchDetector PitchDetector;
+	TArray<float> ChromaBins;
+
+	// FPlatformTime::Seconds() of the last GetHarmonicPercussive call
+	std::atomic<double> LastHarmonicPercussiveRequestSeconds;
+
+	// Capture thread only, keeps the spectrogram history while the split is in use
+	FAudioHarmonicPercussiveSeparator HarmonicPercussive;
+
+	// FPlatformTime::Seconds() of the last GetNormalizedSpectrum / GetNormalizedBandSpectrum call
+	std::atomic<double> LastNormalizedRequestSeconds;
+
+	// Capture thread only, one set of estimates per layout
+	FAudioAdaptiveNormalizer SpectrumNormalizer;
+	FAudioAdaptiveNormalizer BandNormalizer;
+
+	// Waits and listeners for published frames, completed on the game thread
+	FAudioFrameNotifier FrameNotifier;
+
+	// Band layout, fixed for the lifetime of the worker
+	const FAudioMultiResolutionSettings BandSettings;
+
+	// FPlatformTime::Seconds() of the last GetBandSpectrum call
+	std::atomic<double> LastBandRequestSeconds;
+
+	// Capture thread only, fed with every captured frame while the band spectrum is in use
+	FAudioMultiResolutionAnalyzer BandAnalyzer;
+
+	// Capture thread only, runs on every band spectrum
+	FAudioOnsetDetector OnsetDetector;
+
+	// FPlatformTime::Seconds() of the last GetWaveformEnvelope call
+	std::atomic<double> LastWaveformRequestSeconds;
+
+	// Written by the capture thread with every captured frame while the envelope is in use, read under WaveformLock
+	FAudioWaveformPyramid Waveform;
+	mutable FCriticalSection WaveformLock;
+
+	// Capture thread only: Waveform holds an unbroken run of the requested stream
+	bool bWaveformFed;
 
 	AudioListener	m_listener;
 	AudioSink		m_sink;
 
+	// Fed by the capture loop and by m_listener on every drain
+	FAudioCaptureDeadlineMonitor DeadlineMonitor;
+
+	// Capture thread only: MMCSS, priority and affinity from the WAC.CaptureThread* cvars
+	FAudioCaptureThreadScheduling ThreadScheduling;
+
+	// Capture thread only: the analysis reads m_sink like any other consumer
+	FAudioRingCursor SinkCursor;
+	TArray<int16> ChunkSamples;
+	TArray<int16> LatestSamples;
+
+	// Written by the capture thread
+	std::atomic<uint64> LostSinkPackets;
+
+	// Rebinds m_listener to the new default device without tearing down the sink
+	FAudioDeviceStateMachine	m_deviceState;
+
+	// Tee in front of m_sink, both devices deliver through it
+	FAudioCaptureRecorder		m_recorder;
+
+	// Takes the place of m_listener during a replay; the listener stays bound but parked meanwhile
+	FAudioReplayDevice			m_replay;
+	FAudioDeviceStateMachine	m_replayState;
+
+	// The replay device has no WASAPI buffer to size the wait on
+	static const uint32 ReplayPollIntervalMs = 5;
+
+	// Set by StartReplay/StopReplay, applied by the capture thread
+	FString PendingReplayPath;
+	bool bPendingReplayLoop;
+	bool bReplayChangePending;
+	FCriticalSection ReplayLock;
+
+	// Capture thread only
+	bool bReplaying;
+
+	// Opened and fed by the capture thread
+	FAudioSharedSpectrumPublisher	m_sharedSpectrum;
+
+	// Set by StartSharedSpectrum, applied by the capture thread
+	FString PendingSharedSpectrumName;
+	bool bSharedSpectrumChangePending;
+	FCriticalSection SharedSpectrumLock;
+
 protected:
 
 
@@ -59,11 +435,72 @@ public:
 	FAudioCaptureWorker();
 	~FAudioCaptureWorker();
 
-	// Custom Init function
-	static FAudioCaptureWorker* InitializeWorker();
+	// Resume or park the capture. The device stays initialized while parked so a restart skips COM activation
+	void SetCaptureEnabled(bool bEnabled);
 
-	// Custom Shutdown function
-	static void ShutdownWorker();
+	bool IsCaptureEnabled() const {
+		return bCaptureEnabled;
+	}
+
+	// Device state, reconnect count and duration of the last reconnect
+	FAudioDeviceStats GetDeviceStats() const {
+		return m_deviceState.GetStats();
+	}
+
+	// Game thread. Records the captured PCM and the published frames to Path (.wacr) until StopRecording
+	bool StartRecording(const FString& Path, FString& OutError) {
+		return m_recorder.StartRecording(Path, OutError);
+	}
+
+	void StopRecording() {
+		m_recorder.StopRecording();
+	}
+
+	FAudioRecorderStats GetRecorderStats() const {
+		return m_recorder.GetStats();
+	}
+
+	// Plays a recording into the analysis in place of the default device, from the next capture wake.
+	// An empty path goes back to live capture.
+	void StartReplay(const FString& Path, bool bLoop);
+
+	void StopReplay() {
+		StartReplay(FString(), false);
+	}
+
+	// Copies every published frame into the named shared-memory ring for other processes, from the
+	// next capture wake. Keeps the spectrum and the bands computed while it runs. An empty name stops.
+	void StartSharedSpectrum(const FString& Name);
+
+	void StopSharedSpectrum() {
+		StartSharedSpectrum(FString());
+	}
+
+	FAudioSharedSpectrumStats GetSharedSpectrumStats() const {
+		return m_sharedSpectrum.GetStats();
+	}
+
+	// Analysis counters, including what the silence gate saved
+	FAudioAnalysisStats GetAnalysisStats() const;
+
+	// Timings of the analysis stages and how often they went to the task graph
+	FAudioAnalysisGraphStats GetAnalysisGraphStats() const {
+		return AnalysisGraph.GetStats();
+	}
+
+	// Wake lateness, buffer fill and deadline misses of the capture thread, see WAC.Deadlines
+	FAudioCaptureDeadlineStats GetDeadlineStats() const {
+		return DeadlineMonitor.GetStats();
+	}
+
+	void ResetDeadlineStats() {
+		DeadlineMonitor.Reset();
+	}
+
+	// Changes every time a published frame follows a gap in the capture
+	int32 GetDiscontinuityCount() const {
+		return DiscontinuityCounter.GetValue();
+	}
 
 	// Start FRunnable Interface
 	virtual bool Init();
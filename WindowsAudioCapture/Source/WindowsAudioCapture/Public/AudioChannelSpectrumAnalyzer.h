@@ -0,0 +1,130 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// KISS Headers
+#include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
+#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftr.h"
+
+enum class EAudioSampleFormat : uint8 {
+    Int16,
+    // [-1, 1), analysed as int16 * 32768 so both formats give the same magnitudes
+    Float,
+};
+
+// Per-channel spectra of one frame plus the stereo image derived from them.
+// Magnitudes is structure-of-arrays: channel c owns [c * NumBins, (c + 1) * NumBins), so each channel can
+// be handed to a consumer (or uploaded for Niagara) as one contiguous block.
+struct FAudioChannelSpectra {
+    // 7.1 loopback: FL, FR, FC, LFE, BL, BR, SL, SR
+    static constexpr int32 MaxChannels = 8;
+
+    // Octave-ish bands for BandPan, see GetPanBandEdge
+    static constexpr int32 NumPanBands = 8;
+
+    int32 NumChannels = 0;
+    int32 NumBins = 0;
+
+    // Linear magnitude per channel and bin, same bins as FAudioSpectrumFrame::Magnitudes
+    TArray<float> Magnitudes;
+
+    // Side over mid+side energy of the left and right groups: 0 mono, about 0.5 unrelated channels, 1 out of phase
+    float StereoWidth = 0.0f;
+
+    // Right minus left energy over their sum, -1 (left only) to 1 (right only)
+    float Balance = 0.0f;
+
+    // Balance per band, computed from the magnitudes of the left and right groups
+    float BandPan[NumPanBands] = {};
+
+    const float* GetChannel(int32 Channel) const { return Magnitudes.GetData() + Channel * NumBins; }
+
+    // Lower edge of Band in Hz, Band == NumPanBands gives the upper edge of the last band
+    static float GetPanBandEdge(int32 Band);
+
+    // Channels that count as left / right for width, balance and pan (front, back and side pairs)
+    static bool IsLeftChannel(int32 Channel, int32 NumChannels);
+    static bool IsRightChannel(int32 Channel, int32 NumChannels);
+};
+
+///<summary>
+// Windowed real FFT of every channel of a block, up to FAudioChannelSpectra::MaxChannels.
+// Channels are transformed in parallel when there are more than two; each channel has its own kiss
+// plan and scratch buffers since a kiss plan is not safe to share between threads.
+// The FFT size and window follow the original stereo analysis (power of two above twice the frame
+// count, Hann window over the full FFT length applied to the captured part), so the averaged output is
+// the spectrum GetFrequencyArray has always published.
+// The per-sample loops (deinterleave + window, stereo energy) are templates on the sample format and
+// the channel count. The instantiation is picked from a table once per stream format, so the loops
+// have a compile-time stride and no per-sample branches, and the compiler vectorizes them. Streams
+// with more than MaxChannels channels use the generic runtime-stride kernels.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioChannelSpectrumAnalyzer {
+public:
+    FAudioChannelSpectrumAnalyzer();
+    ~FAudioChannelSpectrumAnalyzer();
+
+    // FFT size used for a block of NumFrames
+    static int32 GetFftSize(int32 NumFrames);
+
+    // Samples are interleaved int16 frames. OutAverage receives the mean magnitude over all channels.
+    void Analyze(const int16* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage);
+
+    // Same for interleaved float frames
+    void Analyze(const float* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage);
+
+    // Analyze in three steps for callers that schedule the channels themselves (FAudioAnalysisGraph):
+    // BeginBlock, AnalyzeBlockChannel for every channel it returns (from any thread, in any order), then
+    // EndBlock. Samples must stay valid until EndBlock. BeginBlock returns 0 for an empty block, OutSpectra
+    // is cleared then and there is nothing else to call.
+    int32 BeginBlock(const int16* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra);
+    void AnalyzeBlockChannel(int32 Channel, FAudioChannelSpectra& OutSpectra);
+    void EndBlock(FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage);
+
+    // Runs the generic runtime-stride kernels for every format, for WAC.BenchmarkKernels
+    void SetUseGenericKernels(bool bInUseGenericKernels);
+
+private:
+    // Kernels for one sample format and channel count. Samples point at interleaved frames of that format.
+    struct FKernels {
+        // Out[Frame] = Samples[Frame * NumChannels + Channel] * Window[Frame]
+        void (*WindowChannel)(const void* Samples, int32 NumFrames, int32 NumChannels, int32 Channel, const float* Window, float* Out);
+
+        // Time-domain energy of the summed left and right groups: mid, side, left, right
+        void (*StereoEnergy)(const void* Samples, int32 NumFrames, int32 NumChannels, double* OutEnergies);
+    };
+
+    static FKernels SelectKernels(EAudioSampleFormat Format, int32 NumChannels, bool bGeneric);
+
+    void AnalyzeInterleaved(const void* Samples, EAudioSampleFormat Format, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra, TArray<float>& OutAverage);
+
+    int32 BeginInterleaved(const void* Samples, EAudioSampleFormat Format, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra);
+
+    struct FChannelScratch {
+        kiss_fftr_cfg Config = nullptr;
+        TArray<float> Input;
+        TArray<kiss_fft_cpx> Output;
+    };
+
+    void Prepare(int32 InFftSize, int32 NumChannels);
+    void Release();
+
+    void AnalyzeChannel(int32 Channel, const void* Samples, int32 NumFrames, int32 NumChannels, FAudioChannelSpectra& OutSpectra);
+    void ComputeStereoImage(const void* Samples, int32 NumFrames, int32 NumChannels, int32 SampleRate, FAudioChannelSpectra& OutSpectra) const;
+
+    FKernels Kernels;
+    EAudioSampleFormat KernelFormat;
+    int32 KernelChannels;
+    bool bUseGenericKernels;
+
+    int32 FftSize;
+    TArray<float> Window;
+    TArray<FChannelScratch> Scratch;
+
+    // Block between BeginBlock and EndBlock
+    const void* BlockSamples;
+    int32 BlockFrames;
+    int32 BlockChannels;
+    int32 BlockSampleRate;
+};
@@ -0,0 +1,83 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AudioCompactSpectrum.generated.h"
+
+UENUM(BlueprintType)
+enum class EAudioCompactPrecision : uint8 {
+    // One byte per bin over 72 dB below the frame peak, decoded values within 1.7% of the originals
+    Bits8 UMETA(DisplayName = "8 bit"),
+    // Two bytes per bin over 144 dB below the frame peak, decoded values within 0.014% of the originals
+    Bits16 UMETA(DisplayName = "16 bit"),
+};
+
+///<summary>
+// A spectrum stored as log-quantized integer codes with one scale per frame, for consumers that
+// fan the analysis out widely or keep a history of it. 255 bins take 1020 bytes as floats and
+// 276 bytes at 8 bit.
+// Scale is the largest value in the frame. Code 0 is silence, codes 1..MaxCode cover
+// [Scale * 10^(-RangeDb / 20), Scale] in equal steps of log magnitude, so the relative error is
+// the same for every bin: at most 2^(Step / 2) - 1 where Step = RangeDb / (MaxCode - 1) in octaves
+// (GetMaxRelativeError). Values below the range decode to 0, an absolute error under
+// Scale * 10^(-RangeDb / 20).
+// Encode and Decode are branch-free loops over the IEEE-754 bits (polynomial log2 and exp2) that
+// the compiler turns into SIMD code, the same way FAudioSpectrumScalingTable::Apply does.
+// WAC.BenchmarkCompact measures the cost and the error on this machine.
+///</summary>
+struct WINDOWSAUDIOCAPTURE_API FAudioCompactSpectrum {
+    static constexpr float DefaultRangeDb8 = 72.0f;
+    static constexpr float DefaultRangeDb16 = 144.0f;
+
+    EAudioCompactPrecision Precision = EAudioCompactPrecision::Bits8;
+
+    // FAudioSpectrumFrame::FrameIndex of the source frame, 0 when encoded from anything else
+    uint64 FrameIndex = 0;
+
+    int32 NumBins = 0;
+
+    // Value of the largest code. 0 when every bin is silent.
+    float Scale = 0.0f;
+
+    // Dynamic range covered by the codes below Scale
+    float RangeDb = 0.0f;
+
+    // NumBins codes, uint8 or uint16 depending on Precision
+    TArray<uint8> Codes;
+
+    static int32 GetBytesPerBin(EAudioCompactPrecision InPrecision) { return InPrecision == EAudioCompactPrecision::Bits8 ? 1 : 2; }
+    static uint32 GetMaxCode(EAudioCompactPrecision InPrecision) { return InPrecision == EAudioCompactPrecision::Bits8 ? 0xFF : 0xFFFF; }
+    static float GetDefaultRangeDb(EAudioCompactPrecision InPrecision) { return InPrecision == EAudioCompactPrecision::Bits8 ? DefaultRangeDb8 : DefaultRangeDb16; }
+
+    // Bound on |Decoded - Value| / Value for every value inside the range
+    static float GetMaxRelativeError(EAudioCompactPrecision InPrecision, float InRangeDb);
+
+    // Values must not be negative. RangeDb <= 0 picks GetDefaultRangeDb. Reuses the Codes allocation.
+    void Encode(const float* Values, int32 Num, EAudioCompactPrecision InPrecision, float InRangeDb = 0.0f);
+
+    // Out[i] = value of bin FirstBin + i. Bins past NumBins read as 0.
+    void Decode(float* Out, int32 FirstBin, int32 Num) const;
+
+    void Decode(TArray<float>& Out) const
+    {
+        Out.SetNumUninitialized(NumBins, false);
+        Decode(Out.GetData(), 0, NumBins);
+    }
+
+    float DecodeBin(int32 Bin) const
+    {
+        float Value;
+        Decode(&Value, Bin, 1);
+        return Value;
+    }
+
+    // What one copy of this frame moves: the codes plus the fields above
+    int32 GetNumBytes() const { return Codes.Num() + sizeof(FrameIndex) + sizeof(NumBins) + sizeof(Scale) + sizeof(RangeDb) + sizeof(Precision); }
+
+    const uint8* GetCodes8() const { return Codes.GetData(); }
+    const uint16* GetCodes16() const { return reinterpret_cast<const uint16*>(Codes.GetData()); }
+};
+
+// Immutable once published, shared by every consumer of the frame
+typedef TSharedPtr<const FAudioCompactSpectrum, ESPMode::ThreadSafe> FAudioCompactSpectrumPtr;
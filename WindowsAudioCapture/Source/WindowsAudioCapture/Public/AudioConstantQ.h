@@ -0,0 +1,95 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Layout of a constant-Q spectrum: BinsPerOctave log-spaced bins from MinFrequency up to MaxFrequency.
+// The defaults give one bin per semitone from C1 to C10, with bin k on the k-th note above C1.
+struct FAudioConstantQSettings {
+    int32 BinsPerOctave = 12;
+    float MinFrequency = 32.7032f;
+    float MaxFrequency = 16744.04f;
+
+    FAudioConstantQSettings() {}
+
+    FAudioConstantQSettings(int32 InBinsPerOctave, float InMinFrequency, float InMaxFrequency)
+        : BinsPerOctave(FMath::Clamp(InBinsPerOctave, 1, 96))
+        , MinFrequency(FMath::Max(InMinFrequency, 1.0f))
+        , MaxFrequency(FMath::Max(InMaxFrequency, InMinFrequency))
+    {
+    }
+
+    bool operator==(const FAudioConstantQSettings& Other) const
+    {
+        return BinsPerOctave == Other.BinsPerOctave && MinFrequency == Other.MinFrequency && MaxFrequency == Other.MaxFrequency;
+    }
+
+    bool operator!=(const FAudioConstantQSettings& Other) const
+    {
+        return !(*this == Other);
+    }
+
+    int32 GetNumBins() const;
+
+    // Centre frequency of Bin in Hz
+    float GetBinFrequency(int32 Bin) const;
+
+    // Centre frequency over bandwidth, the same for every bin
+    float GetQ() const;
+};
+
+///<summary>
+// Sparse spectral kernel that maps the linear FFT magnitudes of FAudioSpectrumFrame onto constant-Q
+// bins. Each constant-Q bin sums the power of the linear bins within one bandwidth of its centre under
+// a Hann weight that peaks at 1, so a tone on a bin centre reads its linear magnitude whatever the bin
+// width. Where the bandwidth is narrower than a linear bin the kernel interpolates between the two
+// nearest bins instead. Every row covers a contiguous run of linear bins, so applying the kernel is
+// one short dot product per output bin.
+// The kernel works on magnitudes because that is what the frame publishes; the phase of the
+// per-channel FFTs is gone by then.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioConstantQKernel {
+public:
+    // NumLinearBins is FAudioSpectrumFrame::Magnitudes.Num(): bins 1 .. N/2-1 of an N point FFT
+    FAudioConstantQKernel(const FAudioConstantQSettings& InSettings, int32 InSampleRate, int32 InNumLinearBins);
+
+    const FAudioConstantQSettings& GetSettings() const { return Settings; }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumLinearBins() const { return NumLinearBins; }
+
+    // Out must hold Settings.GetNumBins() values
+    void Apply(const float* LinearMagnitudes, float* Out);
+
+private:
+    struct FRow {
+        int32 FirstLinearBin = 0;
+        int32 NumWeights = 0;
+        int32 WeightOffset = 0;
+    };
+
+    FAudioConstantQSettings Settings;
+    int32 SampleRate;
+    int32 NumLinearBins;
+
+    TArray<FRow> Rows;
+    TArray<float> Weights;
+
+    // Squared input, reused between calls
+    TArray<float> LinearPower;
+};
+
+// Kernels by sample rate, FFT size and layout. Building one is far more expensive than applying it,
+// and the FFT size only changes with the WASAPI packet size, so the few combinations in use are kept.
+class WINDOWSAUDIOCAPTURE_API FAudioConstantQKernelCache {
+public:
+    FAudioConstantQKernel& FindOrBuild(const FAudioConstantQSettings& Settings, int32 SampleRate, int32 NumLinearBins);
+
+    int32 GetNumBuilt() const { return NumBuilt; }
+
+private:
+    static const int32 MaxKernels = 4;
+
+    // Most recently used last
+    TArray<TSharedPtr<FAudioConstantQKernel>> Kernels;
+    int32 NumBuilt = 0;
+};
@@ -0,0 +1,73 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IAudioCaptureDevice.h"
+
+enum class EAudioDeviceState : uint8 {
+    // No endpoint bound (startup, or after a failed reconnect attempt)
+    Closed,
+    // Endpoint bound, stream stopped (capture parked)
+    Stopped,
+    // Endpoint bound and streaming into the sink
+    Running,
+    // The endpoint went away while running, reconnecting to the new default
+    Lost,
+};
+
+struct FAudioDeviceStats {
+    EAudioDeviceState State = EAudioDeviceState::Closed;
+    int32 ReconnectCount = 0;
+    // Failed open or start attempts since the stream last ran
+    int32 FailedReconnectAttempts = 0;
+    double LastReconnectSeconds = 0.0;
+};
+
+///<summary>
+// Keeps a capture device bound to the default endpoint across device changes.
+// Driven from the capture thread with Update(); a default-device change or a capture failure closes
+// the endpoint and re-opens the new default in place, so everything downstream of the sink (queued
+// chunks, FFT state, subscribers) survives. The time from loss to the first successful restart is
+// measured and the sink is told about the gap through MarkDiscontinuity(). A failed open or start is
+// retried after the retry interval, doubled with every further failure up to the max, so a removed
+// device is picked up again quickly and a machine without any usable output device is not polled.
+// The clock is injectable so the transitions can be exercised against a fake device and a fake clock.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioDeviceStateMachine {
+public:
+    // InClock returns seconds, FPlatformTime::Seconds when not set
+    explicit FAudioDeviceStateMachine(IAudioCaptureDevice& InDevice, TFunction<double()> InClock = nullptr, double InRetryIntervalSeconds = 0.25,
+        double InMaxRetryIntervalSeconds = 4.0);
+
+    // One step of the capture loop. bWantRunning false parks the stream but keeps the endpoint bound.
+    EAudioDeviceState Update(bool bWantRunning, IAudioSink* Sink);
+
+    // Stop and release the endpoint (shutdown).
+    void Shutdown();
+
+    EAudioDeviceState GetState() const { return State; }
+
+    FAudioDeviceStats GetStats() const;
+
+private:
+    bool TryOpen(IAudioSink* Sink, double NowSeconds);
+    void EnterLost(double NowSeconds);
+    void ScheduleRetry(double NowSeconds);
+
+    IAudioCaptureDevice& Device;
+    TFunction<double()> Clock;
+    EAudioDeviceState State;
+
+    const double RetryIntervalSeconds;
+    const double MaxRetryIntervalSeconds;
+    double LostAtSeconds;
+    double NextRetrySeconds;
+    bool bReconnecting;
+
+    int32 ReconnectCount;
+    int32 FailedReconnectAttempts;
+    double LastReconnectSeconds;
+
+    // Stats are read from the game thread
+    mutable FCriticalSection StatsLock;
+};
@@ -0,0 +1,157 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AudioMultiResolutionAnalyzer.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// First bytes of a feature file. Everything is little endian and written as-is, so a mapped file can
+// be read in place. The header is followed (at RecordOffset) by NumHops records of RecordStride bytes:
+// an FAudioFeatureRecord, NumSpectrumBins spectrum floats, then NumBands band floats.
+struct FAudioFeatureFileHeader {
+    // "WACF"
+    static constexpr uint32 ExpectedMagic = 0x46434157;
+
+    // Bumped whenever the header or the record layout changes, older files are rejected and need a re-run
+    static constexpr uint32 CurrentVersion = 1;
+
+    uint32 Magic;
+    uint32 Version;
+    uint32 SampleRate;
+    uint32 NumChannels;
+
+    // Source frames per record, the spectrum of a record is the FFT of exactly these frames
+    uint32 HopFrames;
+    uint32 NumHops;
+
+    // Same bins as FAudioSpectrumFrame::Magnitudes for a HopFrames packet (DC dropped)
+    uint32 FftSize;
+    uint32 NumSpectrumBins;
+
+    // Layout of the bands, see FAudioMultiResolutionSettings
+    uint32 NumBands;
+    float BandMinFrequency;
+    float BandMaxFrequency;
+    uint32 RecordStride;
+
+    uint64 RecordOffset;
+    uint64 SourceFrames;
+};
+
+static_assert(sizeof(FAudioFeatureFileHeader) == 64, "FAudioFeatureFileHeader is part of the file format");
+
+// Fixed part of a record, the spectrum and the bands follow it
+struct FAudioFeatureRecord {
+    // Half-wave rectified log band flux, and whether the peak picker marked an onset on this hop
+    float OnsetStrength;
+    uint32 bOnset;
+
+    float MomentaryLufs;
+    float ShortTermLufs;
+
+    // Largest channel value over the hop, full scale = 1
+    float Rms;
+    float Peak;
+    float TruePeak;
+
+    // Digital silence, the spectrum and the bands are all zero
+    uint32 bSilent;
+};
+
+static_assert(sizeof(FAudioFeatureRecord) == 32, "FAudioFeatureRecord is part of the file format");
+
+// One hop of an open feature file. Points into the file data, valid while the file stays open.
+struct FAudioFeatureFrameView {
+    int32 HopIndex = INDEX_NONE;
+    const FAudioFeatureRecord* Record = nullptr;
+
+    // Linear magnitudes, same units as FAudioSpectrumFrame::Magnitudes
+    const float* Spectrum = nullptr;
+    int32 NumSpectrumBins = 0;
+
+    // Peak magnitude per band in int16 units, same as FAudioSpectrumFrame::BandMagnitudes
+    const float* Bands = nullptr;
+    int32 NumBands = 0;
+
+    bool IsValid() const { return Record != nullptr; }
+};
+
+struct FAudioFeatureFileSettings {
+    // 10 ms at 48 kHz, the usual WASAPI packet, so the spectra match what the live capture publishes
+    int32 HopFrames = 480;
+
+    FAudioMultiResolutionSettings Bands;
+
+    // A hop is an onset when its flux is the largest within OnsetPeakHops on either side, exceeds the mean
+    // within OnsetMeanHops by OnsetThreshold times plus OnsetDelta, and OnsetMinIntervalHops passed since
+    // the previous onset
+    int32 OnsetPeakHops = 3;
+    int32 OnsetMeanHops = 10;
+    float OnsetThreshold = 1.5f;
+    float OnsetDelta = 0.01f;
+    int32 OnsetMinIntervalHops = 5;
+};
+
+///<summary>
+// Offline version of the capture analysis for tracks known in advance.
+// The samples are cut into HopFrames blocks, each block goes through the same stages the capture
+// worker runs on a packet (per-channel FFT, multi-resolution bands, level meter) and one fixed-size
+// record is written per block. Onsets come from spectral flux over the bands; since the whole track is
+// available, the peak picker looks ahead as well as behind.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioFeatureFileWriter {
+public:
+    // Samples are interleaved int16 frames. Returns false for an empty input or when the file would
+    // not fit a single array (about 2 GB, split the track).
+    static bool Analyze(const int16* Samples, int64 NumFrames, int32 NumChannels, int32 SampleRate, const FAudioFeatureFileSettings& Settings, TArray<uint8>& OutData);
+
+    // Reads a 16-bit PCM WAV file and saves the feature file to OutputPath
+    static bool AnalyzeWaveFile(const FString& WavePath, const FString& OutputPath, const FAudioFeatureFileSettings& Settings, FString& OutError);
+
+private:
+    static void PickOnsets(const TArray<float>& Flux, const FAudioFeatureFileSettings& Settings, TArray<bool>& OutOnsets);
+};
+
+///<summary>
+// Read-only access to a feature file. The file is memory mapped when the platform supports it and
+// loaded into memory otherwise; either way a frame lookup is an index computation and a few pointer
+// additions, nothing is parsed or copied after Open.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioFeatureFile {
+public:
+    FAudioFeatureFile();
+    ~FAudioFeatureFile();
+
+    bool Open(const FString& Path, FString& OutError);
+    void Close();
+
+    bool IsOpen() const { return Data != nullptr; }
+
+    // Only valid while open
+    const FAudioFeatureFileHeader& GetHeader() const { return *reinterpret_cast<const FAudioFeatureFileHeader*>(Data); }
+
+    int32 GetNumHops() const { return IsOpen() ? (int32)GetHeader().NumHops : 0; }
+    double GetHopSeconds() const;
+    double GetDuration() const;
+
+    // Hop playing at Seconds into the track, INDEX_NONE before the start, past the end or when closed
+    int32 GetHopIndex(double Seconds) const;
+
+    FAudioFeatureFrameView GetFrame(int32 HopIndex) const;
+    FAudioFeatureFrameView GetFrameAtTime(double Seconds) const { return GetFrame(GetHopIndex(Seconds)); }
+
+    // Checks a header against the number of bytes available behind it
+    static bool ValidateHeader(const FAudioFeatureFileHeader& Header, int64 Size, FString& OutError);
+
+private:
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+
+    // Used when the platform cannot map the file
+    TArray<uint8> LoadedData;
+
+    const uint8* Data;
+    int64 DataSize;
+};
@@ -0,0 +1,163 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "AudioFeatureFile.h"
+#include "AudioSpectrumScaling.h"
+#include "AudioFeatureTrackComponent.generated.h"
+
+class UAudioComponent;
+class USoundWave;
+
+
+/**
+* This Component plays back a feature file made by the WindowsAudioCaptureAnalyze commandlet, for tracks that are known in advance.
+* It gives the same values as the live capture without capturing or analysing anything: every call looks up the hop at the playback time.
+* Either call "Play Track" and let the component advance its own clock, or "Sync To Audio Component" to follow the sound that plays the track.
+*/
+UCLASS(ClassGroup = "Audio", meta = (BlueprintSpawnableComponent, DisplayName = "Windows Audio Capture Track"))
+class WINDOWSAUDIOCAPTURE_API UAudioFeatureTrackComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UAudioFeatureTrackComponent();
+
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Feature file opened in BeginPlay. Relative paths are relative to the project folder.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "WindowsAudioCapture | Track", meta = (FilePathFilter = "wacf"))
+	FFilePath FeatureFile;
+
+
+	/**
+	* This function will open a feature file, closing the previous one. Playback stops.
+	*
+	* @param	InPath		Path of the .wacf file, relative paths are relative to the project folder.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Open Feature File", Keywords = "Open Feature File Track"), Category = "WindowsAudioCapture | Track")
+		bool BP_OpenFeatureFile(const FString& InPath);
+
+
+	/**
+	* This function will start the playback clock of the track.
+	*
+	* @param	InStartTime		Playback time to start from, in seconds.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Play Track", Keywords = "Play Track Start"), Category = "WindowsAudioCapture | Track")
+		void BP_PlayTrack(float InStartTime = 0.0f);
+
+
+	// This function will stop the playback clock of the track. The values stay at the last hop.
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Stop Track", Keywords = "Stop Track"), Category = "WindowsAudioCapture | Track")
+		void BP_StopTrack();
+
+
+	/**
+	* This function will make the track follow an Audio Component: the playback time comes from its playback percent, and the track plays and stops with it.
+	*
+	* @param	InAudioComponent	The Audio Component that plays the analysed sound. None to go back to the internal clock.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Sync To Audio Component", Keywords = "Sync To Audio Component Track"), Category = "WindowsAudioCapture | Track")
+		void BP_SyncToAudioComponent(UAudioComponent* InAudioComponent);
+
+
+	// This function will return the playback time of the track in seconds.
+	UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Track Time", Keywords = "Get Track Time Playback"), Category = "WindowsAudioCapture | Track")
+		float BP_GetTrackTime() const { return (float)PlaybackSeconds; }
+
+
+	/**
+	* This function will return the Frequency Array of the track at the playback time, same layout and curve as "Get Frequency Array".
+	*
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Track Frequency Array", Keywords = "Get Track Frequency Array"), Category = "WindowsAudioCapture | Track")
+		TArray<float> BP_GetTrackFrequencyArray
+		(
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will return the log-spaced band magnitudes of the track at the playback time, same values as "Get Band Spectrum".
+	*
+	* @param	OutBands		Peak magnitude per band.
+	* @param	OutFrequencies	Centre frequency of every band in Hz.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Track Band Spectrum", Keywords = "Get Track Band Spectrum"), Category = "WindowsAudioCapture | Track")
+		void BP_GetTrackBandSpectrum(TArray<float>& OutBands, TArray<float>& OutFrequencies) const;
+
+
+	/**
+	* This function will return the levels of the track at the playback time.
+	*
+	* @param	OutRms				RMS level of the hop, the highest channel.
+	* @param	OutPeak				Sample peak of the hop.
+	* @param	OutMomentaryLufs	K-weighted loudness over the last 400ms.
+	* @param	OutShortTermLufs	K-weighted loudness over the last 3s.
+	*
+	*/
+	UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Track Levels", Keywords = "Get Track Levels RMS Peak Loudness LUFS"), Category = "WindowsAudioCapture | Track")
+		void BP_GetTrackLevels(float& OutRms, float& OutPeak, float& OutMomentaryLufs, float& OutShortTermLufs) const;
+
+
+	/**
+	* This function will tell if an onset was passed since the previous tick, so no onset is missed when a game frame spans several hops.
+	*
+	* @param	OutOnsetStrength	Spectral flux of the hop at the playback time.
+	*
+	*/
+	UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Track Onset", Keywords = "Get Track Onset Beat Transient"), Category = "WindowsAudioCapture | Track")
+		bool BP_GetTrackOnset(float& OutOnsetStrength) const;
+
+
+	// Hop at the playback time, invalid while no file is open or past the end of the track
+	FAudioFeatureFrameView GetCurrentFrame() const { return Track.GetFrame(CurrentHop); }
+
+	const FAudioFeatureFile& GetTrack() const { return Track; }
+
+protected:
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	UFUNCTION()
+	void OnAudioPlaybackPercent(const USoundWave* PlayingSoundWave, const float PlaybackPercent);
+
+	UFUNCTION()
+	void OnAudioFinished();
+
+	void UpdateCurrentHop();
+
+	FAudioFeatureFile Track;
+
+	UPROPERTY(Transient)
+	UAudioComponent* SyncAudioComponent = nullptr;
+
+	double PlaybackSeconds = 0.0;
+	bool bPlaying = false;
+
+	int32 CurrentHop = INDEX_NONE;
+
+	// Set by the tick when an onset hop lies in (previous hop, current hop]
+	bool bOnsetSinceLastTick = false;
+
+	// Rebuilt when BP_GetTrackFrequencyArray is called with another curve
+	TUniquePtr<FAudioSpectrumScalingTable> ScalingTable;
+};
@@ -0,0 +1,119 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "AudioSpectrumFrame.h"
+#include <atomic>
+
+// Called on the game thread with the frame that satisfied the wait, or null when the worker shut
+// down before one was published
+typedef TFunction<void(const FAudioSpectrumFramePtr&)> FAudioFrameCallback;
+
+// Game thread, with the latest frame published since the previous dispatch
+DECLARE_MULTICAST_DELEGATE_OneParam(FAudioFramePublishedEvent, const FAudioSpectrumFramePtr&);
+
+enum class EAudioFrameWaitKind : uint8 {
+    // Next frame with a spectrum (FAudioSpectrumFrame::bHasSpectrum)
+    Spectrum,
+
+    // Next frame whose onset counts moved past the ones seen when the wait started
+    Onset,
+};
+
+struct FAudioFrameNotifierStats {
+    // Waits registered and completed so far
+    uint64 Waits = 0;
+    uint64 CompletedWaits = 0;
+
+    // Game thread dispatches, each one completes every wait and listener ready at the time
+    uint64 Dispatches = 0;
+};
+
+///<summary>
+// Lets consumers wait for the next published frame instead of polling for it.
+// The capture thread checks the pending waits when it publishes a frame and only moves the satisfied
+// ones to a ready list. Completion happens on the game thread: the first ready wait queues one game
+// thread task, and that task completes everything that became ready until it runs, so however many
+// frames or waits pile up there is at most one dispatch per game thread frame. Futures, callbacks and
+// the frame listeners all go through it.
+// The state is shared with the queued task, so the notifier can be destroyed while a dispatch is in flight.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioFrameNotifier {
+public:
+    FAudioFrameNotifier();
+    ~FAudioFrameNotifier();
+
+    // Any thread. Band is an FAudioBandOnsets band for EAudioFrameWaitKind::Onset, INDEX_NONE for any band
+    TFuture<FAudioSpectrumFramePtr> Wait(EAudioFrameWaitKind Kind, int32 Band, const FAudioSpectrumFramePtr& LatestFrame);
+    void Wait(EAudioFrameWaitKind Kind, int32 Band, const FAudioSpectrumFramePtr& LatestFrame, FAudioFrameCallback Callback);
+
+    // Game thread. Listeners get every dispatch, with the latest frame published since the previous one
+    FDelegateHandle AddListener(FAudioFramePublishedEvent::FDelegate Delegate);
+    void RemoveListener(FDelegateHandle Handle);
+
+    // Any thread: are there pending waits of Kind? The worker keeps the analysis they wait for running
+    bool HasWaiters(EAudioFrameWaitKind Kind) const;
+
+    // Capture thread, from FAudioCaptureWorker::PublishFrame
+    void OnFramePublished(const FAudioSpectrumFramePtr& Frame);
+
+    // Game thread. Completes every pending wait with null and drops the listeners
+    void Shutdown();
+
+    FAudioFrameNotifierStats GetStats() const;
+
+private:
+    struct FWaiter {
+        EAudioFrameWaitKind Kind = EAudioFrameWaitKind::Spectrum;
+        int32 Band = INDEX_NONE;
+
+        // Onset counts the wait started from, taken from the first frame with valid onsets
+        bool bHasBaseline = false;
+        uint32 BaselineOnsetCount[FAudioBandOnsets::NumBands] = {};
+
+        // Exactly one of the two is set
+        TSharedPtr<TPromise<FAudioSpectrumFramePtr>, ESPMode::ThreadSafe> Promise;
+        FAudioFrameCallback Callback;
+
+        FAudioSpectrumFramePtr Frame;
+
+        // Capture thread: does Frame end the wait?
+        bool IsSatisfiedBy(const FAudioSpectrumFrame& InFrame);
+    };
+
+    struct FState {
+        TArray<FWaiter> Pending;
+        TArray<FWaiter> Ready;
+
+        // Latest frame published since the last dispatch, for the listeners
+        FAudioSpectrumFramePtr LatestFrame;
+
+        bool bDispatchQueued = false;
+        bool bShutdown = false;
+
+        FAudioFrameNotifierStats Stats;
+        FCriticalSection Lock;
+
+        // Game thread only
+        FAudioFramePublishedEvent Listeners;
+
+        // Read by the capture thread without the lock
+        std::atomic<int32> NumListeners { 0 };
+        std::atomic<int32> NumWaiters[2] = { { 0 }, { 0 } };
+    };
+
+    typedef TSharedRef<FState, ESPMode::ThreadSafe> FStateRef;
+
+    void AddWaiter(FWaiter&& Waiter, const FAudioSpectrumFramePtr& LatestFrame);
+
+    // State->Lock must be held
+    static void QueueDispatch(const FStateRef& InState);
+
+    // Game thread
+    static void Dispatch(const FStateRef& InState);
+
+    static void Complete(FWaiter& Waiter);
+
+    FStateRef State;
+};
@@ -0,0 +1,45 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+///<summary>
+// Goertzel filters for a small set of target frequencies, used instead of the full FFT when
+// consumers only look at a few frequencies. Each filter costs one multiply-add per sample, four
+// frequencies are run side by side in one VectorRegister.
+// The block is windowed exactly like FAudioChannelSpectrumAnalyzer, so a value from here can stand
+// in for the FFT bin at the same frequency.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioGoertzelBank {
+public:
+    FAudioGoertzelBank();
+
+    // Rebuilds the coefficients for the target frequencies (Hz)
+    void Configure(int32 InSampleRate, const TArray<int32>& InFrequencies);
+
+    int32 GetSampleRate() const { return SampleRate; }
+    const TArray<int32>& GetFrequencies() const { return Frequencies; }
+
+    // Linear magnitude at every target frequency, averaged over the channels, one entry per frequency.
+    // Samples are interleaved int16 frames.
+    void Process(const int16* Samples, int32 NumFrames, int32 NumChannels, TArray<float>& OutMagnitudes);
+
+private:
+    void UpdateWindow(int32 NumFrames, int32 NumChannels);
+
+    int32 SampleRate;
+    TArray<int32> Frequencies;
+
+    // Per frequency, padded to a multiple of 4 lanes
+    TArray<float> Coefficients;
+    TArray<float> Cosines;
+    TArray<float> Sines;
+
+    // Hann window for the current block size, scaled back to int16 units
+    TArray<float> Window;
+    int32 WindowFrames;
+    int32 WindowChannels;
+
+    TArray<float> DeinterleaveBuffer;
+    TArray<float*> ChannelBuffers;
+};
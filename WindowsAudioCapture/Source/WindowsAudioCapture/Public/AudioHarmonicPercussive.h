@@ -0,0 +1,110 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Harmonic ("tonal") and percussive ("drums") energy of one analysis frame
+struct FAudioHarmonicPercussiveBands {
+    // Same octave-ish split as the stereo pan bands, see GetBandEdge
+    static constexpr int32 NumBands = 8;
+
+    // False until the separation ran for this frame
+    bool bValid = false;
+
+    // RMS magnitude of the harmonic and percussive parts per band, same units as FAudioSpectrumFrame::Magnitudes
+    float Harmonic[NumBands] = {};
+    float Percussive[NumBands] = {};
+
+    // Percussive share of the energy over all bands, 0 (tonal only) to 1 (drums only)
+    float PercussiveRatio = 0.0f;
+
+    // Lower edge of Band in Hz, Band == NumBands gives the upper edge of the last band
+    static float GetBandEdge(int32 Band);
+};
+
+// Time spent in the separation and what the budget did about it
+struct FAudioHarmonicPercussiveStats {
+    uint64 ProcessedFrames = 0;
+    double TotalSeconds = 0.0;
+
+    // Frames that took longer than the budget
+    uint64 OverBudgetFrames = 0;
+
+    // Bins merged per working bin, 1 at full resolution
+    int32 Decimation = 1;
+
+    double GetAverageSeconds() const { return ProcessedFrames > 0 ? TotalSeconds / ProcessedFrames : 0.0; }
+};
+
+///<summary>
+// Real-time harmonic/percussive separation (median filtering, Fitzgerald 2010) on the linear spectrum.
+// Harmonic sounds are smooth along time, percussive ones along frequency, so each bin is compared with
+// the median of its own last TimeMedianLength frames and with the median of the FrequencyMedianLength
+// bins around it. Soft (Wiener) masks H^2 / (H^2 + P^2) split every bin between the two parts, and the
+// parts are summed into FAudioHarmonicPercussiveBands.
+// The time median is causal: the newest frame is compared with its own past, which adds no latency.
+// Both medians are sliding windows over sorted arrays, so a frame costs one ordered replace per bin
+// for the time axis and one insert / remove per bin for the frequency axis instead of a sort.
+// The stage keeps to a per-frame CPU budget: when its smoothed cost goes over, adjacent bins are
+// merged (2, 4, 8) before the medians, and split again once the cost is well under the budget.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioHarmonicPercussiveSeparator {
+public:
+    // About 170 ms of history at one frame per 10 ms wake
+    static constexpr int32 TimeMedianLength = 17;
+
+    // Percussive median width in working bins
+    static constexpr int32 FrequencyMedianLength = 17;
+
+    static constexpr int32 MaxDecimation = 8;
+
+    FAudioHarmonicPercussiveSeparator();
+
+    // Seconds per frame the stage should stay under, 0 disables the budget
+    void SetBudgetSeconds(double InBudgetSeconds) { BudgetSeconds = InBudgetSeconds; }
+
+    // Forgets the spectrogram history, e.g. after a discontinuity
+    void Reset();
+
+    // Magnitudes as in FAudioSpectrumFrame::Magnitudes: bin b (0-based) sits at (b + 1) * SampleRate / (2 * (NumBins + 1)).
+    // A change of NumBins or SampleRate resets the history.
+    void Process(const float* Magnitudes, int32 NumBins, int32 SampleRate, FAudioHarmonicPercussiveBands& OutBands);
+
+    // Pins the decimation and turns the budget off while non-zero, for WAC.BenchmarkHarmonicPercussive
+    void SetFixedDecimation(int32 InDecimation);
+
+    const FAudioHarmonicPercussiveStats& GetStats() const { return Stats; }
+
+private:
+    void Configure(int32 InNumBins, int32 InSampleRate, int32 InDecimation);
+    void Separate(const float* Magnitudes, FAudioHarmonicPercussiveBands& OutBands);
+    void UpdateBudget(double Seconds);
+
+    int32 NumBins;
+    int32 SampleRate;
+    int32 Decimation;
+    int32 FixedDecimation;
+    int32 NumWorkBins;
+
+    double BudgetSeconds;
+    double SmoothedSeconds;
+
+    // Working spectrum: RMS of each group of Decimation bins
+    TArray<float> Work;
+
+    // Per working bin: the last TimeMedianLength values in arrival order (ring) and sorted
+    TArray<float> TimeHistory;
+    TArray<float> TimeSorted;
+    int32 HistoryWrite;
+
+    // Sliding window along frequency
+    TArray<float> FrequencySorted;
+
+    TArray<float> HarmonicMask;
+
+    // Band of every working bin, -1 outside the bands
+    TArray<int32> WorkBand;
+    int32 BinsPerBand[FAudioHarmonicPercussiveBands::NumBands];
+
+    FAudioHarmonicPercussiveStats Stats;
+};
@@ -0,0 +1,111 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Time-domain levels published with every FAudioSpectrumFrame. Linear values are normalized to full
+// scale (1.0 = 0 dBFS) and cover the audio received since the previous frame.
+struct FAudioLevelMetrics {
+    static constexpr int32 MaxChannels = 8;
+
+    // Reported for silence, and for the loudness windows until they are filled
+    static constexpr float MinLoudnessLufs = -70.0f;
+
+    int32 NumChannels = 0;
+
+    float Rms[MaxChannels] = {};
+    float Peak[MaxChannels] = {};
+
+    // Inter-sample peak estimated with 4x oversampling (ITU-R BS.1770-4 annex 2)
+    float TruePeak[MaxChannels] = {};
+
+    // Peak over RMS in dB
+    float CrestFactorDb[MaxChannels] = {};
+
+    // K-weighted loudness over the last 400 ms and the last 3 s
+    float MomentaryLufs = MinLoudnessLufs;
+    float ShortTermLufs = MinLoudnessLufs;
+
+    float GetMaxRms() const;
+    float GetMaxPeak() const;
+    float GetMaxTruePeak() const;
+    float GetMaxCrestFactorDb() const;
+};
+
+///<summary>
+// RMS, sample peak, true peak, crest factor and BS.1770 loudness computed straight from the captured
+// samples, so consumers that only need levels never wait for (or pay for) an FFT.
+// The samples are deinterleaved once into per-channel float buffers; RMS/peak and the 12-tap
+// polyphase true-peak filter run through FAudioVectorMath, the K-weighting is a pair of biquads per
+// channel. Loudness is accumulated in 100 ms blocks: 4 blocks make the momentary window, 30 the
+// short-term one.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioLevelMeter {
+public:
+    FAudioLevelMeter();
+
+    // Rebuilds the filters for the stream format and clears all history
+    void Configure(int32 InSampleRate, int32 InNumChannels);
+
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+
+    // Interleaved int16 frames, as many channels per frame as Configure was given; only the first
+    // MaxChannels of them are metered. Samples may be null for a silent block.
+    void ProcessInt16(const int16* Samples, int32 NumFrames);
+
+    // Levels since the previous call; loudness is the current state of the sliding windows
+    FAudioLevelMetrics ConsumeMetrics();
+
+private:
+    struct FBiquad {
+        double B0 = 1.0, B1 = 0.0, B2 = 0.0, A1 = 0.0, A2 = 0.0;
+    };
+
+    struct FChannelState {
+        // Transposed direct form II state for the two K-weighting stages
+        double Z1[2] = {};
+        double Z2[2] = {};
+
+        // Last TruePeakTaps - 1 samples of the previous block, followed by the current block
+        TArray<float> TruePeakHistory;
+
+        double SumOfSquares = 0.0;
+        float Peak = 0.0f;
+        float TruePeak = 0.0f;
+
+        // K-weighted sum of squares of the 100 ms block being filled
+        double WeightedBlockSum = 0.0;
+    };
+
+    void ProcessChannel(int32 Channel, const float* Samples, int32 NumFrames);
+    void CloseLoudnessBlock();
+    float GetLoudness(int32 NumBlocks) const;
+
+    static constexpr int32 TruePeakTaps = 12;
+    static constexpr int32 TruePeakPhases = 4;
+    static constexpr int32 ShortTermBlocks = 30;
+    static constexpr int32 MomentaryBlocks = 4;
+
+    int32 SampleRate;
+
+    // Channels per interleaved frame, and the first NumChannels of them that are metered
+    int32 NumInputChannels;
+    int32 NumChannels;
+
+    FBiquad Stages[2];
+    float ChannelWeights[FAudioLevelMetrics::MaxChannels];
+
+    TArray<FChannelState> Channels;
+    TArray<float> DeinterleaveBuffer;
+
+    int64 FramesSinceConsume;
+
+    int32 LoudnessBlockFrames;
+    int32 FramesInLoudnessBlock;
+
+    // Channel-weighted mean square of the last ShortTermBlocks blocks, ring indexed by NextBlock
+    double BlockPower[ShortTermBlocks];
+    int32 NextBlock;
+    int32 NumFilledBlocks;
+};
@@ -6,26 +6,83 @@
 #define NTDDI_THRESHOLD NTDDI_VERSION
 #endif
 
-#include "IAudioSink.h"
+#include "IAudioCaptureDevice.h"
 #include <Audioclient.h>
 #include <atomic>
 #include <mmdeviceapi.h>
 
-class AudioListener {
+class AudioEndpointNotificationClient;
+class FAudioCaptureDeadlineMonitor;
+
+// WASAPI loopback capture of the default render endpoint.
+// All methods are called from the capture thread, which owns the COM apartment.
+class AudioListener : public IAudioCaptureDevice {
 public:
-    AudioListener(int BitsPerSample, int FormatTag, int BlockAlign, int XSize);
+    // The block alignment follows from BitsPerSample and the channel count of the device mix format
+    AudioListener(int BitsPerSample, int FormatTag, int XSize);
     ~AudioListener();
-    HRESULT RecordAudioStream(IAudioSink*, bool&);
+
+    // IAudioCaptureDevice
+    bool Open() override;
+    void Close() override;
+    bool IsOpen() const override { return m_pCaptureClient != NULL; }
+
+    // Close and drop the enumerator and device notifications. Call on the capture thread before it exits
+    void Shutdown();
+
+    // Start/Stop the loopback stream. The device stays activated in between, so a
+    // paused listener can be restarted without going through COM activation again.
+    bool Start() override;
+    bool Stop() override;
+    bool IsStarted() const { return m_bStarted; }
+
+    // Drain every packet currently queued by WASAPI into the sink. Called once per wake of the capture thread.
+    bool CapturePackets(IAudioSink* Sink) override;
+
+    bool ConsumeDeviceChanged() override { return m_deviceChanged.exchange(false); }
+
+    // How long the capture thread may sleep between two calls to CapturePackets (half the shared buffer).
+    uint32 GetPollIntervalMs() const;
+
+    // Gets the buffer fill, flags and sink time of every drain, null for none
+    void SetDeadlineMonitor(FAudioCaptureDeadlineMonitor* InMonitor) { m_pMonitor = InMonitor; }
+
+    // Last failing HRESULT, for logging
+    HRESULT GetLastError() const { return m_lastError; }
 
 private:
+    friend class AudioEndpointNotificationClient;
+
+    HRESULT OpenDefaultEndpoint();
+
+    // Called from the MMDevice notification thread
+    void OnDefaultDeviceChanged();
+    void OnDeviceDeactivated(const TCHAR* DeviceId);
+
     WAVEFORMATEX* m_pwfx = NULL;
     IAudioClient* m_pAudioClient = NULL;
     IAudioCaptureClient* m_pCaptureClient = NULL;
     IMMDeviceEnumerator* m_pEnumerator = NULL;
     IMMDevice* m_pDevice = NULL;
+    AudioEndpointNotificationClient* m_pNotificationClient = NULL;
+    FAudioCaptureDeadlineMonitor* m_pMonitor = NULL;
+
+    int m_bitsPerSample;
+    int m_formatTag;
+    int m_xSize;
+
+    UINT32 m_bufferFrameCount = 0;
+    REFERENCE_TIME m_hnsActualDuration = 0;
+    bool m_bStarted = false;
+    // Set by Open, the sink gets the new format with the next packet
+    bool m_bFormatChanged = false;
+    HRESULT m_lastError = S_OK;
+
+    std::atomic<bool> m_deviceChanged { false };
 
-    UINT32 m_bufferFrameCount;
-    REFERENCE_TIME m_hnsActualDuration;
+    // Id of the bound endpoint, compared against device state notifications
+    FString m_deviceId;
+    FCriticalSection m_deviceIdLock;
 
     const int m_refTimesPerMS = 1000;
     const int m_refTimesPerSec = 1000;
@@ -0,0 +1,96 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// KISS Headers
+#include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
+#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftr.h"
+
+struct FAudioMultiResolutionSettings {
+    // Range and resolution of the merged log-frequency spectrum
+    float MinFrequency = 20.0f;
+    float MaxFrequency = 20000.0f;
+    int32 NumBands = 96;
+
+    // Bands centred below this come from the decimated long window, the others from the short one
+    float CrossoverFrequency = 500.0f;
+
+    // 48 kHz / 8 = 6 kHz for the low band, 1024 samples there is a 170 ms window with 5.9 Hz bins
+    int32 DecimationFactor = 8;
+    int32 LongWindow = 1024;
+
+    // 512 samples at the full rate, about 11 ms
+    int32 ShortWindow = 512;
+
+    // Centre of Band, log spaced between MinFrequency and MaxFrequency
+    float GetBandFrequency(int32 Band) const;
+
+    // Lower edge of Band, Band == NumBands gives the upper edge of the last band
+    float GetBandEdge(int32 Band) const;
+};
+
+///<summary>
+// Two-resolution spectrum of the continuous capture stream, merged into log-spaced bands.
+// Every captured frame is downmixed to mono and pushed here, so the windows no longer depend on the
+// WASAPI packet size. The lows go through a decimating low-pass filter (evaluated only at the kept
+// output samples) into a long window at the reduced rate, the highs use a short window at the full
+// rate. Both are real FFTs with plans made once in Configure; together they cost a fraction of a
+// single full-rate FFT with the same bass resolution (8192 points at 48 kHz).
+// Band values are peak magnitudes in int16 units: a sine of amplitude A reads A in its band.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioMultiResolutionAnalyzer {
+public:
+    FAudioMultiResolutionAnalyzer();
+    ~FAudioMultiResolutionAnalyzer();
+
+    void Configure(int32 InSampleRate, int32 InNumChannels, const FAudioMultiResolutionSettings& InSettings = FAudioMultiResolutionSettings());
+
+    bool IsConfigured() const { return ShortConfig != nullptr; }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    const FAudioMultiResolutionSettings& GetSettings() const { return Settings; }
+
+    // Interleaved int16 frames. Samples may be null for a silent block.
+    void PushInt16(const int16* Samples, int32 NumFrames);
+
+    // One value per band from the most recent windows
+    void Analyze(TArray<float>& OutBands);
+
+private:
+    void Release();
+    void PushSample(float Sample);
+
+    // Windowed magnitude spectrum of the newest Window.Num() samples of Ring
+    void AnalyzeWindow(kiss_fftr_cfg Config, const TArray<float>& Window, const TArray<float>& Ring, int32 RingStart, TArray<float>& OutMagnitudes);
+
+    // Largest bin inside [LowFrequency, HighFrequency), interpolated at the centre when no bin falls inside
+    static float GetBandValue(const TArray<float>& Magnitudes, float BinWidth, float LowFrequency, float HighFrequency, float CentreFrequency);
+
+    FAudioMultiResolutionSettings Settings;
+    int32 SampleRate;
+    int32 NumChannels;
+
+    // Low-pass FIR for the decimator, taps stored oldest-first to match the delay line
+    TArray<float> DecimatorTaps;
+    TArray<float> DecimatorDelay;
+    int32 DecimatorWrite;
+    int32 DecimatorPhase;
+
+    // Rings are written twice, at i and i + Size, so the newest window is always contiguous
+    TArray<float> ShortRing;
+    int32 ShortWrite;
+    TArray<float> LongRing;
+    int32 LongWrite;
+
+    TArray<float> ShortWindow;
+    TArray<float> LongWindow;
+
+    kiss_fftr_cfg ShortConfig;
+    kiss_fftr_cfg LongConfig;
+
+    TArray<float> FftInput;
+    TArray<kiss_fft_cpx> FftOutput;
+    TArray<float> ShortMagnitudes;
+    TArray<float> LongMagnitudes;
+};
@@ -0,0 +1,90 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// KISS Headers
+#include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
+#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftr.h"
+
+struct FAudioConstantQSettings;
+
+// Harmony and lead note of one analysis frame
+struct FAudioMusicFeatures {
+    static constexpr int32 NumPitchClasses = 12;
+
+    // False until the feature stage ran for this frame
+    bool bValid = false;
+
+    // Energy per pitch class, C first, normalized so the strongest class is 1. All zero in silence.
+    float Chroma[NumPitchClasses] = {};
+
+    // Dominant pitch in Hz, 0 when no periodic signal was found
+    float PitchHz = 0.0f;
+
+    // 1 - YIN aperiodicity at the chosen period, 0 when no pitch
+    float PitchConfidence = 0.0f;
+
+    // PitchHz as a fractional MIDI note number (69 = A4), 0 when no pitch
+    float MidiNote = 0.0f;
+
+    // Constant-Q layout the chroma is folded from: semitones from C1 to B7
+    static FAudioConstantQSettings GetChromaLayout();
+
+    // Sums constant-Q bins laid out by GetChromaLayout() into Chroma and normalizes it
+    void FoldChroma(const float* ConstantQMagnitudes, int32 NumBins);
+};
+
+///<summary>
+// YIN pitch estimator over a fixed window of the continuous capture stream.
+// Frames are downmixed to mono into a ring, so the window (and the lowest detectable pitch) does not
+// depend on the WASAPI packet size. The difference function is built from a correlation computed with
+// two forward and one inverse real FFT of the window size, so the cost per frame is fixed.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioPitchDetector {
+public:
+    // 2048 frames at 48 kHz: 43 ms, periods up to 1024 samples (47 Hz)
+    static constexpr int32 WindowSize = 2048;
+
+    // Periods are searched between these, clamped to half the window
+    static constexpr float MinPitchHz = 50.0f;
+    static constexpr float MaxPitchHz = 2000.0f;
+
+    // YIN absolute threshold on the cumulative mean normalized difference
+    static constexpr float Threshold = 0.15f;
+
+    FAudioPitchDetector();
+    ~FAudioPitchDetector();
+
+    void Configure(int32 InSampleRate, int32 InNumChannels);
+
+    bool IsConfigured() const { return ForwardConfig != nullptr; }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+
+    // Interleaved int16 frames. Samples may be null for a silent block.
+    void PushInt16(const int16* Samples, int32 NumFrames);
+
+    // Estimates the pitch of the newest WindowSize frames into Features
+    void Detect(FAudioMusicFeatures& Features);
+
+private:
+    void Release();
+
+    int32 SampleRate;
+    int32 NumChannels;
+
+    // Written at i and i + WindowSize so the newest window is contiguous
+    TArray<float> Ring;
+    int32 RingWrite;
+
+    kiss_fftr_cfg ForwardConfig;
+    kiss_fftr_cfg InverseConfig;
+
+    // First half of the window, zero padded to WindowSize
+    TArray<float> Head;
+    TArray<kiss_fft_cpx> HeadSpectrum;
+    TArray<kiss_fft_cpx> Spectrum;
+    TArray<float> Correlation;
+    TArray<float> Difference;
+};
@@ -0,0 +1,76 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AudioMultiResolutionAnalyzer.h"
+
+// Energy and onsets of the multi-resolution band spectrum folded into four broad bands
+struct FAudioBandOnsets {
+    // Bass, low mids, high mids and treble, see GetBandEdge
+    static constexpr int32 NumBands = 4;
+
+    // False until the band spectrum was analysed
+    bool bValid = false;
+
+    // RMS of the band magnitudes inside each broad band, int16 units like FAudioSpectrumFrame::BandMagnitudes
+    float Energy[NumBands] = {};
+
+    // Half-wave rectified log flux of the latest frame
+    float Strength[NumBands] = {};
+
+    // Onsets detected since the capture started. Never reset, so a reader that compares them with the
+    // counts it saw last time catches every onset in between, however many frames it skipped.
+    uint32 OnsetCount[NumBands] = {};
+
+    // Lower edge of Band in Hz, Band == NumBands gives the upper edge of the last band
+    static float GetBandEdge(int32 Band);
+};
+
+struct FAudioOnsetSettings {
+    // A frame is an onset when its flux exceeds the mean of the previous MeanHops frames by Threshold
+    // times plus Delta, and MinIntervalHops frames passed since the previous onset in the same band.
+    // Defaults follow FAudioFeatureFileSettings, except that Delta is larger: there is no look-ahead peak
+    // picking to reject noise, and a broad band averages fewer bands than the offline flux.
+    int32 MeanHops = 10;
+    float Threshold = 1.5f;
+    float Delta = 0.1f;
+    int32 MinIntervalHops = 5;
+};
+
+///<summary>
+// Causal onset detection on the live band spectrum, the real-time counterpart of the feature file
+// onsets. Every broad band gets the mean log flux of the bands centred inside it and its own
+// adaptive threshold, so a kick and a hi-hat are told apart. Costs one log per band per frame.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioOnsetDetector {
+public:
+    FAudioOnsetDetector();
+
+    void Configure(const FAudioMultiResolutionSettings& InBandSettings, const FAudioOnsetSettings& InSettings = FAudioOnsetSettings());
+
+    bool IsConfigured() const { return BandOf.Num() > 0; }
+
+    // Forgets the flux history, e.g. after silence: the first frame after it measures flux from zero.
+    // The onset counts keep going.
+    void Reset();
+
+    // Bands as produced by FAudioMultiResolutionAnalyzer::Analyze with the configured settings
+    void Process(const float* Bands, int32 NumBands, FAudioBandOnsets& OutOnsets);
+
+private:
+    FAudioOnsetSettings Settings;
+
+    // Broad band of every input band, INDEX_NONE outside them
+    TArray<int32> BandOf;
+    int32 BandsPerBroadBand[FAudioBandOnsets::NumBands];
+
+    TArray<float> PreviousLogBands;
+
+    // Last MeanHops flux values per broad band, written at HopIndex % MeanHops
+    TArray<float> FluxHistory;
+    int32 NumHistoryHops;
+    uint64 HopIndex;
+
+    uint64 LastOnsetHop[FAudioBandOnsets::NumBands];
+    uint32 OnsetCount[FAudioBandOnsets::NumBands];
+};
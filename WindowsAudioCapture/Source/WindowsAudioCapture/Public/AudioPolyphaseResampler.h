@@ -0,0 +1,84 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAudioPolyphaseResamplerSettings {
+    // Zero crossings of the sinc on each side of the centre, at the lower of the two rates. More is a
+    // steeper transition band for more taps; 16 keeps the images 80 dB down from 0.9 of Nyquist
+    int32 HalfZeroCrossings = 16;
+
+    // Passband edge as a fraction of the lower Nyquist frequency
+    float Cutoff = 0.9f;
+
+    // Kaiser window shape, about 8 for 80 dB of stopband
+    float KaiserBeta = 8.0f;
+};
+
+///<summary>
+// Converts interleaved int16 audio from one rate to another by a rational factor Up / Down (48000 /
+// 44100 = 160 / 147, 48000 / 192000 = 1 / 4). A Kaiser windowed sinc lowpass at the lower of the two
+// Nyquist frequencies is split into Up phases of NumTaps coefficients each, stored reversed and padded
+// to a multiple of four, so every output sample is one FAudioVectorMath::DotProduct over the last
+// NumTaps input samples of its channel. Only the outputs are computed, never the zero-stuffed
+// intermediate stream, so a 4:1 decimation costs NumTaps multiply-adds per output and none for the
+// samples it drops. State (the last NumTaps input samples per channel and the phase) is kept across
+// Process calls, so packets of any size join without clicks. Latency is about NumTaps / 2 input samples.
+// Equal rates bypass the filter and copy.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioPolyphaseResampler {
+public:
+    FAudioPolyphaseResampler();
+
+    // Builds the phase tables and clears the state. Does nothing if nothing changed
+    void Configure(int32 InInputRate, int32 InOutputRate, int32 InNumChannels,
+        const FAudioPolyphaseResamplerSettings& InSettings = FAudioPolyphaseResamplerSettings());
+
+    bool IsConfigured() const { return NumChannels > 0; }
+    bool IsBypassed() const { return Up == Down; }
+
+    int32 GetInputRate() const { return InputRate; }
+    int32 GetOutputRate() const { return OutputRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    int32 GetNumTaps() const { return NumTaps; }
+
+    // Clears the history, e.g. after a gap in the input
+    void Reset();
+
+    // Resamples NumFrames interleaved frames and replaces the contents of Out with the result, which
+    // may be a frame more or less than NumFrames * Up / Down depending on the phase. Returns the output frames
+    int32 Process(const int16* In, int32 NumFrames, TArray<int16>& Out);
+
+    // Advances over NumFrames frames of silence without filtering them. Returns the output frames
+    // Process would have produced
+    int32 Skip(int32 NumFrames);
+
+private:
+    // Output frames from the current position given NumFrames more input frames
+    int32 CountOutputFrames(int32 NumFrames) const;
+
+    void BuildPhases();
+
+    FAudioPolyphaseResamplerSettings Settings;
+
+    int32 InputRate;
+    int32 OutputRate;
+    int32 NumChannels;
+
+    // OutputRate / InputRate reduced
+    int32 Up;
+    int32 Down;
+
+    // Coefficients per phase, a multiple of four
+    int32 NumTaps;
+
+    // Up phases of NumTaps coefficients, phase P holds h[P + (NumTaps - 1 - j) * Up] at j
+    TArray<float> Phases;
+
+    // Per channel: NumTaps - 1 samples of history followed by the current input
+    TArray<TArray<float>> Channels;
+
+    // Next output: input frame (relative to the current input, after the history) and phase
+    int32 InputIndex;
+    int32 Phase;
+};
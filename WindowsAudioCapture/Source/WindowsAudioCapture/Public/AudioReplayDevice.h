@@ -0,0 +1,62 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IAudioCaptureDevice.h"
+#include "AudioCaptureRecording.h"
+
+///<summary>
+// Capture device that plays a .wacr recording back into the sink in real time, so a field
+// recording goes through exactly the analysis the live capture would have run.
+// Packets are delivered when their recorded time is reached on the capture thread's clock; formats
+// and discontinuities are replayed as recorded, and gaps left by dropped packets come through as
+// discontinuities. Published spectrum frames in the file are skipped, the worker recomputes them.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioReplayDevice : public IAudioCaptureDevice {
+public:
+    FAudioReplayDevice();
+
+    // Takes effect on the next Open. bLoop restarts from the beginning at the end of the file
+    void SetRecording(const FString& InPath, bool bInLoop);
+
+    const FString& GetPath() const { return Path; }
+
+    // True once a non-looping replay delivered its last packet
+    bool IsFinished() const { return bFinished; }
+
+    // IAudioCaptureDevice
+    bool Open() override;
+    void Close() override;
+    bool IsOpen() const override { return Reader.IsOpen(); }
+    bool Start() override;
+    bool Stop() override;
+    bool CapturePackets(IAudioSink* Sink) override;
+    bool ConsumeDeviceChanged() override { return false; }
+
+    // Recording time being played
+    double GetPlaybackSeconds() const;
+
+private:
+    // Reads the next Pcm or Format chunk into Pending, false at the end of the file
+    bool ReadPending();
+
+    FString Path;
+    bool bLoop;
+
+    FAudioRecordingReader Reader;
+
+    FAudioRecordingChunkHeader PendingChunk;
+    TArray<uint8> PendingPayload;
+    bool bHasPending;
+
+    // FPlatformTime::Seconds() at recording time 0, moved on Stop/Start so a paused replay resumes in place
+    double ClockOffset;
+    double StoppedAtSeconds;
+    bool bStarted;
+    bool bFinished;
+
+    // Last format given to the sink. Every keyframe repeats the format, and SetFormat resets the sink's
+    // gate, meter and resampler, so only a change is passed on
+    bool bFormatSent;
+    FAudioRecordingFormat SentFormat;
+};
@@ -0,0 +1,52 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AudioSpectrumFrame.h"
+#include "AudioMultiResolutionAnalyzer.h"
+
+// Layout shared with the reader library in Extras/SharedSpectrumReader
+struct wac_shm_header;
+
+struct FAudioSharedSpectrumStats {
+    bool bOpen = false;
+    FString Name;
+
+    uint64 PublishedFrames = 0;
+
+    // Frames with more bins or bands than a slot holds, published cut short
+    uint64 TruncatedFrames = 0;
+};
+
+///<summary>
+// Copies every published frame into a named shared-memory ring so that other processes on the
+// machine (LED walls, lighting controllers) can read the analysis without running their own capture.
+// The layout, the per-slot seqlock and the C reader library are in
+// Extras/SharedSpectrumReader/wac_shared_spectrum.h. Publishing is a bounded memcpy into the next
+// slot on the capture thread. Readers are never waited for; a reader that falls behind skips frames.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioSharedSpectrumPublisher {
+public:
+    FAudioSharedSpectrumPublisher();
+    ~FAudioSharedSpectrumPublisher();
+
+    // Capture thread. Creates the region, or reopens it and carries on numbering if readers still
+    // hold it from an earlier session.
+    bool Open(const FString& InName, const FAudioMultiResolutionSettings& BandSettings);
+    void Close();
+
+    // Capture thread
+    bool IsOpen() const { return Header != nullptr; }
+
+    // Capture thread, from FAudioCaptureWorker::PublishFrame
+    void Publish(const FAudioSpectrumFrame& Frame, int32 SampleRate);
+
+    FAudioSharedSpectrumStats GetStats() const;
+
+private:
+    wac_shm_header* Header;
+    void* Mapping;
+
+    FAudioSharedSpectrumStats Stats;
+    mutable FCriticalSection StatsLock;
+};
@@ -0,0 +1,60 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FAudioSilenceGateSettings {
+    // Below this RMS (dBFS) a block is always silence, whatever the noise floor
+    float ThresholdDb = -70.0f;
+
+    // The gate opens this far above the close threshold, so it does not chatter around it
+    float HysteresisDb = 6.0f;
+
+    // Blocks less than this above the tracked noise floor count as silence
+    float NoiseFloorMarginDb = 6.0f;
+
+    // The noise floor is not allowed above this, so a long quiet passage cannot gate out the music
+    float MaxNoiseFloorDb = -50.0f;
+
+    // How fast the noise floor may rise while the gate is closed. It falls immediately.
+    float NoiseFloorRiseDbPerSecond = 3.0f;
+
+    // How long the level has to stay below the close threshold before the gate closes
+    float HoldSeconds = 0.25f;
+};
+
+///<summary>
+// Decides per captured block whether there is anything worth analysing.
+// MeasureInt16 computes RMS and peak in one pass over the samples with integer accumulators (no
+// branches, auto-vectorized). Process compares the RMS against a threshold that follows the tracked
+// noise floor, with hysteresis and a hold time so short pauses between notes keep the gate open.
+// Blocks whose peak is within one LSB of zero are always silent, which covers the +-1 dither that
+// AudioSink::CopyData used to scrub sample by sample.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioSilenceGate {
+public:
+    struct FBlockLevels {
+        // Normalized to full scale (1.0 = 0 dBFS)
+        float Rms = 0.0f;
+        float Peak = 0.0f;
+    };
+
+    explicit FAudioSilenceGate(const FAudioSilenceGateSettings& InSettings = FAudioSilenceGateSettings());
+
+    static FBlockLevels MeasureInt16(const int16* Samples, int32 NumSamples);
+
+    // Feed the levels of one block of NumFrames frames. Returns true while the gate is open.
+    bool Process(const FBlockLevels& Levels, int32 NumFrames, int32 SampleRate);
+
+    bool IsOpen() const { return bOpen; }
+    float GetNoiseFloorDb() const { return NoiseFloorDb; }
+
+    void Reset();
+
+private:
+    FAudioSilenceGateSettings Settings;
+
+    bool bOpen;
+    float NoiseFloorDb;
+    float HoldRemainingSeconds;
+};
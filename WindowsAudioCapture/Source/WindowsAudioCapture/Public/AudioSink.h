@@ -2,27 +2,65 @@
 #pragma once
 
 #include "IAudioSink.h"
-#include <mutex>
-#include <queue>
+#include "AudioSilenceGate.h"
+#include "AudioLevelMeter.h"
+#include "AudioBroadcastRing.h"
+#include "AudioPolyphaseResampler.h"
 
+// One packet read from the sink. chunk points into the sample buffer the reader passed to Read.
 struct AudioChunk {
-    int16* chunk = nullptr;
+    const int16* chunk = nullptr;
     int size = 0;
+    // First chunk after a gap in the capture (device switch)
+    bool bDiscontinuity = false;
+    // Closed by the silence gate. No samples are copied, chunk is null and size is 0
+    bool bSilent = false;
+    int numFrames = 0;
+    int numChannels = 0;
+    int sampleRate = 0;
 };
 
+// Capture side of the analysis: meters and gates every packet at the device rate, resamples it to the
+// analysis rate (WAC.AnalysisSampleRate) and writes it to a broadcast ring. Reading is not destructive.
+// Every consumer makes its own cursor and reads at its own pace without locking; one that falls a
+// whole ring behind gets EAudioRingRead::Overrun.
 class AudioSink : public IAudioSink {
 public:
-    bool Dequeue(AudioChunk& Chunk);
-    bool EmptyQueue(AudioChunk& Chunk);
+    // Any thread. A cursor starting with the next packet captured
+    FAudioRingCursor MakeCursor() const { return m_ring.MakeCursor(); }
+
+    // Any thread, one cursor per reader. OutSamples is the reader's buffer, reused across calls
+    EAudioRingRead Read(FAudioRingCursor& Cursor, AudioChunk& OutChunk, TArray<int16>& OutSamples) const;
+
     int CopyData(const BYTE* Data, const int NumFramesAvailable) override;
+    void MarkDiscontinuity() override;
+    void SetFormat(int SampleRate, int NumChannels, int BitsPerSample) override;
+
+    float GetNoiseFloorDb() const { return m_gate.GetNoiseFloorDb(); }
+
+    // Capture thread only, same thread as SetFormat. Rate of the packets in the ring, what the analysis runs at
+    int GetSampleRate() const { return m_sampleRate; }
+
+    // Capture thread only, rate the device delivers
+    int GetDeviceSampleRate() const { return m_deviceSampleRate; }
+
+    // Levels of everything received since the previous call, gated or not
+    FAudioLevelMetrics ConsumeLevels();
     AudioSink();
     ~AudioSink();
 
 private:
-    TQueue<AudioChunk> m_queue;
-    int m_bitDepth;
-    int m_maxSampleVal;
-    int m_nChannels;
-    int m_chunkSize;
+    // Resamples unless the rates match and writes to the ring. Samples null for a silent packet
+    void WritePacket(const int16* Samples, int NumFrames, uint32 Discontinuity);
+
+    FAudioBroadcastRing m_ring;
+    int m_nChannels = 2;
+    int m_sampleRate = 48000;
+    int m_deviceSampleRate = 48000;
+    bool m_pendingDiscontinuity = false;
+    FAudioSilenceGate m_gate;
+    FAudioLevelMeter m_meter;
+    FAudioPolyphaseResampler m_resampler;
+    TArray<int16> m_resampled;
     FCriticalSection m_mutex;
 };
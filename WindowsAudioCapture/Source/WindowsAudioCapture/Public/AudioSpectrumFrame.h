@@ -0,0 +1,76 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AudioLevelMeter.h"
+#include "AudioConstantQ.h"
+#include "AudioMusicFeatures.h"
+#include "AudioChannelSpectrumAnalyzer.h"
+#include "AudioHarmonicPercussive.h"
+#include "AudioOnsetDetector.h"
+
+// One analysis result published by FAudioCaptureWorker.
+// Frames are immutable once published and shared by every consumer, so any number of readers can
+// look at the same analysis without copying or re-running it.
+struct FAudioSpectrumFrame {
+    // Increases by one for every published frame, 0 means "no frame yet"
+    uint64 FrameIndex = 0;
+
+    // FPlatformTime::Seconds() when the frame was published
+    double Timestamp = 0.0;
+
+    // The audio analysed here does not follow on from the previous frame (device switch)
+    bool bDiscontinuity = false;
+
+    // The silence gate was closed: no FFT was run and every magnitude is zero
+    bool bSilent = false;
+
+    // False when nobody asked for a spectrum recently and the FFT was skipped; Magnitudes is empty then
+    bool bHasSpectrum = false;
+
+    // Rate (Hz) the analysis ran at, WAC.AnalysisSampleRate unless that is 0. Bin i of Magnitudes is
+    // at i * SampleRate / (2 * Magnitudes.Num()) Hz
+    int32 SampleRate = 0;
+
+    // Frequencies (Hz) registered through GetTargetFrequencyValues when this frame was analysed, and
+    // their Goertzel magnitudes in the same units as Magnitudes. Only filled when the target bank ran
+    // instead of the FFT.
+    TArray<int32> TargetFrequencies;
+    TArray<float> TargetMagnitudes;
+
+    // Magnitudes mapped onto the constant-Q layout in ConstantQSettings. Empty unless
+    // GetConstantQSpectrum was called recently.
+    TArray<float> ConstantQMagnitudes;
+    FAudioConstantQSettings ConstantQSettings;
+
+    // Log-spaced bands from the multi-resolution analyzer, see FAudioMultiResolutionSettings for the
+    // layout. Peak magnitude in int16 units. Empty unless GetBandSpectrum was called recently.
+    TArray<float> BandMagnitudes;
+
+    // BandMagnitudes folded into four broad bands, with live onsets. Filled along with BandMagnitudes;
+    // the onset counts carry over silent frames.
+    FAudioBandOnsets Onsets;
+
+    // Chroma and dominant pitch, bValid only while GetMusicFeatures is being called
+    FAudioMusicFeatures Music;
+
+    // Time-domain levels, always filled
+    FAudioLevelMetrics Levels;
+
+    // Per-channel magnitudes (structure-of-arrays) and the stereo image, filled along with Magnitudes
+    FAudioChannelSpectra Channels;
+
+    // Harmonic and percussive band energies, bValid only while GetHarmonicPercussive is being called
+    FAudioHarmonicPercussiveBands HarmonicPercussive;
+
+    // Magnitudes and BandMagnitudes mapped to 0..1 against the running floor and ceiling of every bin.
+    // Empty unless GetNormalizedSpectrum / GetNormalizedBandSpectrum was called recently, 0 on silent frames
+    TArray<float> NormalizedMagnitudes;
+    TArray<float> NormalizedBandMagnitudes;
+
+    // Linear FFT magnitude per bin, averaged over the channels. DC is dropped so index 0 is the first
+    // bin above 0 Hz, same layout as the array returned by GetFrequencyArray.
+    TArray<float> Magnitudes;
+};
+
+typedef TSharedPtr<const FAudioSpectrumFrame, ESPMode::ThreadSafe> FAudioSpectrumFramePtr;
@@ -0,0 +1,23 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Small SIMD kernels shared by the analysis stages, written against VectorRegister so they build
+// for SSE and NEON alike. Pointers do not need to be aligned, the tails are handled in scalar code.
+struct WINDOWSAUDIOCAPTURE_API FAudioVectorMath {
+    // Sum of Data[i]^2 and Max(|Data[i]|) in one pass
+    static void SumOfSquaresAndPeak(const float* Data, int32 Num, float& OutSumOfSquares, float& OutPeak);
+
+    // Sum of A[i] * B[i]
+    static float DotProduct(const float* A, const float* B, int32 Num);
+
+    // Out[i] = In[i] * Scale
+    static void Multiply(const float* In, float Scale, float* Out, int32 Num);
+
+    // Interleaved int16 frames to one float buffer per channel, scaled to [-1, 1)
+    static void DeinterleaveInt16(const int16* Interleaved, int32 NumFrames, int32 NumChannels, float* const* OutChannels);
+
+    // Same for the first NumOutChannels of the NumChannels in every frame, the rest are skipped
+    static void DeinterleaveInt16(const int16* Interleaved, int32 NumFrames, int32 NumChannels, int32 NumOutChannels, float* const* OutChannels);
+};
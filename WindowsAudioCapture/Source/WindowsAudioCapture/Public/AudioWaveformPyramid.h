@@ -0,0 +1,77 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WindowsAudioCaptureMemory.h"
+
+///<summary>
+// Min / max / RMS envelope of the recent capture stream (downmixed to mono, -1 to 1) as a mip chain,
+// for oscilloscope style visuals at any zoom level.
+// Level 0 is a ring of the last Capacity samples. Every level above it holds one entry (min, max,
+// sum of squares) per pair of entries of the level below, so level L summarizes blocks of 2^L
+// samples and the whole chain takes about 2 * Capacity entries.
+// PushInt16 keeps the chain up to date as samples arrive: each new sample writes level 0 and every
+// completed pair writes one entry of the level above, about two entries per sample in total.
+// GetEnvelope reads the level whose blocks are 4 to 8 times smaller than an output point, so a
+// query costs O(NumPoints) whatever the window length. Points are aligned to whole blocks of that
+// level, which moves their edges by less than a quarter of a point and ends the window up to one
+// block (a quarter of a point) before the newest sample.
+// The chain counts as EWACMemory::WaveformHistory. Configure halves the capacity until it fits in
+// WAC.MemoryBudgetMB, down to MinCapacity, so a tight budget shortens the envelope instead of failing.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FAudioWaveformPyramid {
+public:
+    // 2.7 s at 48 kHz
+    static constexpr int32 DefaultCapacity = 1 << 17;
+
+    // 85 ms at 48 kHz
+    static constexpr int32 MinCapacity = 1 << 12;
+
+    explicit FAudioWaveformPyramid(int32 InCapacity = DefaultCapacity);
+
+    // Allocates the chain and forgets every sample. GetCapacity() may be smaller than asked for afterwards
+    void Configure(int32 InSampleRate, int32 InNumChannels);
+
+    bool IsConfigured() const { return SampleRate > 0; }
+    int32 GetSampleRate() const { return SampleRate; }
+    int32 GetNumChannels() const { return NumChannels; }
+    int32 GetCapacity() const { return Capacity; }
+
+    // Samples pushed since Configure / Reset, the envelope covers at most the last Capacity of them
+    uint64 GetNumPushedSamples() const { return TotalSamples; }
+
+    void Reset();
+
+    // Interleaved int16 frames. Samples may be null for a silent block.
+    void PushInt16(const int16* Samples, int32 NumFrames);
+
+    // Envelope of the last NumSamples samples split into NumPoints equal points, oldest first. Each
+    // Out array holds NumPoints values. Points older than the first pushed sample read 0.
+    void GetEnvelope(int32 NumSamples, int32 NumPoints, float* OutMin, float* OutMax, float* OutRms) const;
+
+private:
+    // Fills the entries of Level completed by the samples pushed since the level was last updated
+    void UpdateLevel(int32 Level, uint64 FirstEntry, uint64 EndEntry);
+
+    struct FLevel {
+        TArray<float> Min;
+        TArray<float> Max;
+        TArray<float> SumOfSquares;
+        uint32 Mask = 0;
+    };
+
+    // As passed to the constructor, Capacity is what the budget allowed of it
+    int32 RequestedCapacity;
+    int32 Capacity;
+    int32 SampleRate;
+    int32 NumChannels;
+    uint64 TotalSamples;
+
+    // Level 0, min = max = the sample
+    TArray<float> Samples;
+
+    // Levels[i] is level i + 1
+    TArray<FLevel> Levels;
+
+    FWACMemoryCounter Memory;
+};
@@ -0,0 +1,25 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "IAudioSink.h"
+
+// A capture endpoint as seen by FAudioDeviceStateMachine. AudioListener is the WASAPI implementation;
+// the interface carries no platform types so the state machine can be driven by a fake device.
+class IAudioCaptureDevice {
+public:
+	virtual ~IAudioCaptureDevice() {}
+
+	// Bind to the current default endpoint. Close() releases it again.
+	virtual bool Open() = 0;
+	virtual void Close() = 0;
+	virtual bool IsOpen() const = 0;
+
+	virtual bool Start() = 0;
+	virtual bool Stop() = 0;
+
+	// Drain the available packets into the sink. false means the endpoint is gone.
+	virtual bool CapturePackets(IAudioSink* Sink) = 0;
+
+	// true once after the default endpoint changed or the bound endpoint went away.
+	virtual bool ConsumeDeviceChanged() = 0;
+};
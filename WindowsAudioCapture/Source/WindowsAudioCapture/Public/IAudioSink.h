@@ -10,4 +10,10 @@ class IAudioSink {
 public:
 	virtual ~IAudioSink() {}
 	virtual int CopyData(const BYTE* Data, const int NumFramesAvailable) = 0;
+
+	// The next data does not follow on from the previous one (device switch, dropped packets)
+	virtual void MarkDiscontinuity() {}
+
+	// Stream format of the data passed to CopyData, sent again whenever the device changes
+	virtual void SetFormat(int SampleRate, int NumChannels, int BitsPerSample) {}
 };
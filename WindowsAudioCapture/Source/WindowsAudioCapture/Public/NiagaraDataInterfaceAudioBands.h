@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraCommon.h"
+#include "NiagaraDataInterface.h"
+#include "NiagaraShared.h"
+#include "VectorVM.h"
+#include "AudioLevelMeter.h"
+#include "AudioOnsetDetector.h"
+
+#include "NiagaraDataInterfaceAudioBands.generated.h"
+
+// Everything the bands data interface exposes for one engine frame. Immutable once handed to the proxy
+struct FAudioBandsSnapshot {
+    // Scaled broad band energies, 0..1
+    float Bands4[FAudioBandOnsets::NumBands] = {};
+
+    // 1 where the broad band had an onset since the previous snapshot
+    float Onsets4[FAudioBandOnsets::NumBands] = {};
+
+    // Rms, peak, momentary and short-term loudness (LUFS)
+    float Levels[4] = {};
+
+    bool bOnset = false;
+
+    // Scaled band spectrum, 0..1
+    TArray<float> Bands;
+};
+
+typedef TSharedPtr<const FAudioBandsSnapshot, ESPMode::ThreadSafe> FAudioBandsSnapshotPtr;
+
+/**
+ * UNiagaraDataInterfaceAudioBands gives Niagara the band energies, onsets and loudness of the capture
+ * in one call per batch, instead of one curve lookup per particle and value
+ */
+
+struct FNiagaraDataInterfaceProxyAudioBands final : public FNiagaraDataInterfaceProxy {
+    FNiagaraDataInterfaceProxyAudioBands();
+
+    ~FNiagaraDataInterfaceProxyAudioBands();
+
+    // Game thread: publish a new snapshot to the VM and queue its upload to the GPU. Once per engine frame.
+    void UpdateSnapshot(const FAudioBandOnsets& Onsets, const TArray<float>& Bands, const FAudioLevelMetrics& Levels);
+
+    // Snapshot read by VectorVM worker threads, null before the first update
+    FAudioBandsSnapshotPtr GetSnapshot();
+
+    // Render thread: values for the generated HLSL
+    FReadBuffer& GetBandsSRV();
+    const FVector4& GetGPUBands4() const { return GPUBands4; }
+    const FVector4& GetGPUOnsets4() const { return GPUOnsets4; }
+    const FVector4& GetGPULevels() const { return GPULevels; }
+    int32 GetGPUNumBands() const { return GPUNumBands; }
+
+    virtual int32 PerInstanceDataPassedToRenderThreadSize() const override
+    {
+        return 0;
+    }
+
+private:
+    // Render thread
+    void UploadSnapshot(const FAudioBandsSnapshot& InSnapshot);
+
+    FAudioBandsSnapshotPtr Snapshot;
+    FCriticalSection SnapshotLock;
+
+    // Game thread, GFrameCounter of the last UpdateSnapshot and the onset counts it saw
+    uint64 LastUpdateFrame;
+    uint32 LastOnsetCount[FAudioBandOnsets::NumBands];
+    bool bHasOnsetCounts;
+
+    // Render thread only
+    FReadBuffer GPUBandsBuffer;
+    FVector4 GPUBands4;
+    FVector4 GPUOnsets4;
+    FVector4 GPULevels;
+    int32 GPUNumBands;
+};
+
+// Per system instance: keeps the capture running while the system lives
+struct FNDIAudioBandsInstanceData {
+    bool bCaptureAcquired = false;
+};
+
+/** Data Interface giving access to the band energies, onsets and loudness of the capture. */
+UCLASS(EditInlineNew, Category = "Audio", meta = (DisplayName = "Audio Capture Bands"))
+class WINDOWSAUDIOCAPTURE_API UNiagaraDataInterfaceAudioBands final : public UNiagaraDataInterface {
+    GENERATED_UCLASS_BODY()
+public:
+    DECLARE_NIAGARA_DI_PARAMETER();
+
+    //VM function overrides:
+    void GetBands4(FVectorVMContext& Context);
+    void GetBandsArray(FVectorVMContext& Context);
+    void GetLevel(FVectorVMContext& Context);
+
+    virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+    virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData,
+        FVMExternalFunction& OutFunc) override;
+
+    virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override
+    {
+        return true;
+    }
+
+    virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+    virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+    virtual int32 PerInstanceDataSize() const override { return sizeof(FNDIAudioBandsInstanceData); }
+    virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+
+    virtual bool GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+        const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo, int FunctionInstanceIndex,
+        FString& OutHLSL) override;
+    virtual void
+    GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+
+    virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+
+    virtual void PostInitProperties() override;
+
+protected:
+    virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+};
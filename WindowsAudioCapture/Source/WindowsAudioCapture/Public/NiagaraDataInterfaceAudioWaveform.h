@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraCommon.h"
+#include "NiagaraDataInterface.h"
+#include "NiagaraShared.h"
+#include "VectorVM.h"
+
+#include "NiagaraDataInterfaceAudioWaveform.generated.h"
+
+// NumPoints (min, max, rms) triples, oldest point first. Immutable once handed to the proxy
+typedef TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> FAudioWaveformEnvelopePtr;
+
+/**
+ * UNiagaraDataInterfaceAudioWaveform gives Niagara the min/max/RMS envelope of the captured waveform,
+ * an oscilloscope line at any zoom level (see FAudioWaveformPyramid)
+ */
+
+struct FNiagaraDataInterfaceProxyAudioWaveform final : public FNiagaraDataInterfaceProxy {
+    FNiagaraDataInterfaceProxyAudioWaveform();
+
+    ~FNiagaraDataInterfaceProxyAudioWaveform();
+
+    // Game thread: publish a new envelope to the VM and queue its upload to the GPU. Once per engine frame.
+    void UpdateEnvelope(const FAudioWaveformEnvelopePtr& InEnvelope);
+
+    // Envelope read by VectorVM worker threads, null before the first update
+    FAudioWaveformEnvelopePtr GetEnvelope();
+
+    // Render thread: the envelope buffer and its number of points for the generated HLSL
+    FReadBuffer& GetEnvelopeSRV();
+    int32 GetGPUNumPoints() const { return GPUNumPoints; }
+
+    virtual int32 PerInstanceDataPassedToRenderThreadSize() const override
+    {
+        return 0;
+    }
+
+private:
+    // Render thread
+    void UploadEnvelope(const TArray<float>& InEnvelope);
+
+    FAudioWaveformEnvelopePtr Envelope;
+    FCriticalSection EnvelopeLock;
+
+    // Game thread, GFrameCounter of the last UpdateEnvelope
+    uint64 LastUpdateFrame;
+
+    // Render thread only
+    FReadBuffer GPUEnvelopeBuffer;
+    int32 GPUNumPoints;
+};
+
+// Per system instance: keeps the capture running while the system lives
+struct FNDIAudioWaveformInstanceData {
+    bool bCaptureAcquired = false;
+};
+
+/** Data Interface giving access to the envelope of the captured waveform. */
+UCLASS(EditInlineNew, Category = "Audio", meta = (DisplayName = "Audio Capture Waveform"))
+class WINDOWSAUDIOCAPTURE_API UNiagaraDataInterfaceAudioWaveform final : public UNiagaraDataInterface {
+    GENERATED_UCLASS_BODY()
+public:
+    DECLARE_NIAGARA_DI_PARAMETER();
+
+    // Length of audio spread over the points
+    UPROPERTY(EditAnywhere, Category = "Waveform", meta = (ClampMin = "0.001", ClampMax = "2.5"))
+    float WindowSeconds = 0.05f;
+
+    // Number of points across the window
+    UPROPERTY(EditAnywhere, Category = "Waveform", meta = (ClampMin = "2", ClampMax = "4096"))
+    int32 Resolution = 256;
+
+    //VM function overrides:
+    void SampleWaveform(FVectorVMContext& Context);
+    void GetWaveformResolution(FVectorVMContext& Context);
+
+    virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+    virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData,
+        FVMExternalFunction& OutFunc) override;
+
+    virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override
+    {
+        return true;
+    }
+
+    virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+    virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+    virtual int32 PerInstanceDataSize() const override { return sizeof(FNDIAudioWaveformInstanceData); }
+    virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+
+    virtual bool GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
+        const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo, int FunctionInstanceIndex,
+        FString& OutHLSL) override;
+    virtual void
+    GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+
+    virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+
+    virtual void PostInitProperties() override;
+
+protected:
+    virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+};
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "AudioCompactSpectrum.h"
+#include "WindowsAudioCaptureMemory.h"
 #include "AudioDevice.h"
 #include "AudioDeviceManager.h"
 #include "CoreMinimal.h"
@@ -37,6 +39,12 @@ struct FNiagaraDataInterfaceProxyDynamicCurve final : public FNiagaraDataInterfa
     // Called when the Submix property changes.
     void OnUpdateFloatCurve(UCurveFloat* Curve);
 
+    // Called when FloatCurve or bReadCaptureDirectly change. Reading the capture directly ignores the curve.
+    void OnUpdateSource(UCurveFloat* Curve, bool bInReadCaptureDirectly);
+
+    // Game thread, latest compact spectrum when reading the capture directly
+    void OnUpdateCompactSpectrum(const FAudioCompactSpectrumPtr& Compact);
+
     // This function enqueues a render thread command to decimate the pop audio off of the SubmixListener, downsample it, and post it to the GPUAudioBuffer.
     void PostAudioToGPU();
     FReadBuffer& ComputeAndPostSRV();
@@ -52,6 +60,11 @@ struct FNiagaraDataInterfaceProxyDynamicCurve final : public FNiagaraDataInterfa
 private:
     UCurveFloat* CurveFloatRegisteredTo;
 
+    // Decode the compact spectrum instead of reading the curve, see UNiagaraDataInterfaceDynamicCurve::bReadCaptureDirectly
+    bool bReadCaptureDirectly;
+    FAudioCompactSpectrumPtr CompactSpectrum;
+    uint64 DecodedFrameIndex;
+
     // The buffer we downsample PoppedBuffer to based on the Resolution property.
     Audio::AlignedFloatBuffer DownsampledBuffer;
 
@@ -63,6 +76,15 @@ private:
     Audio::AlignedFloatBuffer VectorVMReadBuffer;
 
     FCriticalSection DownsampleBufferLock;
+
+    // Counts both buffers as EWACMemory::Niagara, call under DownsampleBufferLock after resizing them
+    void UpdateMemory();
+    FWACMemoryCounter Memory;
+};
+
+// Per system instance: reading the capture directly keeps it running while the system lives
+struct FNDIDynamicCurveInstanceData {
+    bool bCaptureAcquired = false;
 };
 
 /** Data Interface allowing curve data access. */
@@ -75,6 +97,15 @@ public:
     UPROPERTY(EditAnywhere, Category = "Curve")
     UCurveFloat* FloatCurve = nullptr; // ptr to a curve
 
+    // Read the spectrum from the capture as a compact (log-quantized) spectrum instead of going through
+    // FloatCurve and an actor that fills it. Uses the default GetFrequencyArray scaling and the first
+    // MaxBufferResolution bins.
+    UPROPERTY(EditAnywhere, Category = "Curve")
+    bool bReadCaptureDirectly = false;
+
+    UPROPERTY(EditAnywhere, Category = "Curve", meta = (EditCondition = "bReadCaptureDirectly"))
+    EAudioCompactPrecision CompactPrecision = EAudioCompactPrecision::Bits8;
+
     static const int32 MaxBufferResolution = 255;
 
     //VM function overrides:
@@ -92,6 +123,11 @@ public:
 
     virtual bool RequiresDistanceFieldData() const override { return false; }
 
+    virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+    virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+    virtual int32 PerInstanceDataSize() const override { return sizeof(FNDIDynamicCurveInstanceData); }
+    virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+
     virtual bool GetFunctionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo,
         const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo, int FunctionInstanceIndex,
         FString& OutHLSL) override;
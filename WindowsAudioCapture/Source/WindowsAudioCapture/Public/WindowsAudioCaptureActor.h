@@ -5,17 +5,22 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include <Curves/RichCurve.h>
+#include "AudioCompactSpectrum.h"
+#include "AudioSpectrumFrame.h"
 
 #include "WindowsAudioCaptureActor.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWinAudioCaptureEvent, const TArray<float>&, AudioCaptureData);
 DECLARE_MULTICAST_DELEGATE_OneParam(FWinAudioCaptureNativeEvent, const TArray<float>&);
+DECLARE_MULTICAST_DELEGATE_OneParam(FWinAudioCaptureCompactEvent, const FAudioCompactSpectrumPtr&);
 
 ///<summary>
-// WindowsAudioCaptureComponent is great but it can't be used by multiple clients, because once a
-// client read the audio data, another client can't have access to the same data.
-// AWindowsAudioCaptureActor provides a way to capture audio and to broadcast (multi-cast) audio data
-// to the clients. Mandatory for a VFX usage.
+// Reading the capture is not destructive any more: any number of WindowsAudioCaptureComponents can
+// read the same published frame, and raw packets go through a broadcast ring where every consumer
+// keeps its own cursor (see AudioSink).
+// AWindowsAudioCaptureActor still provides a way to capture audio and to broadcast (multi-cast) audio
+// data to the clients, which is what the VFX setups bind to. It broadcasts when the worker publishes
+// new frames (at most once per game thread frame) instead of polling on a timer.
 // Multi-cast delegate support Native and BP binding.
 ///</summary>
 UCLASS()
@@ -25,7 +30,6 @@ class WINDOWSAUDIOCAPTURE_API AWindowsAudioCaptureActor : public AActor {
 public:
     // Sets default values for this actor's properties
     AWindowsAudioCaptureActor();
-    ~AWindowsAudioCaptureActor();
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WindowsAudioCapture | Default Values")
     float defaultFreqLogBase = 10.0;
@@ -39,6 +43,12 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WindowsAudioCapture | Default Values")
     float defaultFreqOffset = 0.0;
 
+    // Send every bin as 0 to 1 between its own recent floor and ceiling instead of scaling with the
+    // default values above, so quiet and loud sources both fill the range without retuning
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WindowsAudioCapture | Default Values")
+    bool bAdaptiveNormalization = false;
+
+    // Minimum time between two broadcasts, 0 broadcasts every game thread frame that has new data
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WindowsAudioCapture | Timer Values")
     float defaultTimerTime = 0.01;
 
@@ -53,6 +63,16 @@ public:
 
     FWinAudioCaptureNativeEvent OnAudioCaptureNativeEvent;
 
+    // Precision of the spectra sent to OnAudioCaptureCompactEvent
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WindowsAudioCapture | Compact")
+    EAudioCompactPrecision compactPrecision = EAudioCompactPrecision::Bits8;
+
+    // Native clients that fan the data out further or keep a history of it. Gets the whole spectrum
+    // (maxNumberOfData does not apply) log-quantized, shared with every other reader of the frame and
+    // never modified, so it can be kept without copying. Decode(Out, 0, maxNumberOfData) gives the
+    // values OnAudioCaptureNativeEvent sends.
+    FWinAudioCaptureCompactEvent OnAudioCaptureCompactEvent;
+
 #if WITH_EDITOR
     virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif // WITH_EDITOR
@@ -110,14 +130,27 @@ protected:
 protected:
     // Called when the game starts or when spawned
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
     UFUNCTION()
     void onCaptureData();
 
+    // Frame listener registered with the worker, game thread
+    void onFramePublished(const FAudioSpectrumFramePtr& frame);
+
 public:
     // Called every frame
     virtual void Tick(float DeltaTime) override;
 
 private:
-    FTimerHandle CaptureDataTimerHandler;
+    FDelegateHandle FramePublishedHandle;
+
+    // FPlatformTime::Seconds() of the last broadcast, for defaultTimerTime
+    double LastBroadcastSeconds = 0.0;
+
+    // Did BeginPlay acquire the shared capture? Released again in EndPlay
+    bool bCaptureAcquired = false;
+
+    // Index of the last frame sent to OnAudioCaptureEvent
+    uint64 LastBroadcastFrameIndex = 0;
 };
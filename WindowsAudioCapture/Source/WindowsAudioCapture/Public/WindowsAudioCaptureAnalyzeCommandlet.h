@@ -0,0 +1,26 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "WindowsAudioCaptureAnalyzeCommandlet.generated.h"
+
+///<summary>
+// Pre-analyses known tracks into feature files (see FAudioFeatureFileWriter) for UAudioFeatureTrackComponent.
+//   UE4Editor-Cmd.exe Project.uproject -run=WindowsAudioCaptureAnalyze -Input=<file.wav or folder> [-Output=<file or folder>] [-Hop=480]
+// A folder input analyses every .wav in it. Without -Output each feature file is written next to its
+// source with the .wacf extension.
+///</summary>
+UCLASS()
+class WINDOWSAUDIOCAPTURE_API UWindowsAudioCaptureAnalyzeCommandlet : public UCommandlet {
+    GENERATED_BODY()
+
+public:
+    UWindowsAudioCaptureAnalyzeCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+
+    // Extension of the files written by the commandlet
+    static const TCHAR* FeatureFileExtension;
+};
@@ -6,6 +6,7 @@
 #endif
 
 #include "Components/ActorComponent.h"
+#include "Engine/LatentActionManager.h"
 #include "AudioCaptureWorker.h"
 #include "WindowsAudioCaptureComponent.generated.h"
 
@@ -23,9 +24,6 @@ public:
 	// Sets default values for this component's properties
 	UWindowsAudioCaptureComponent();
 
-	// Cleans up stuff
-	~UWindowsAudioCaptureComponent();
-
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
@@ -49,6 +47,283 @@ public:
 		);
 
 
+	/**
+	* This function will return the Frequency Array of one channel of the captured audio. Channels follow the
+	* Windows speaker order: 0 Front Left, 1 Front Right, 2 Center, 3 LFE, 4 Back Left, 5 Back Right, 6 Side Left, 7 Side Right.
+	*
+	* @param	InChannel				Channel index, up to 7 on a 7.1 device. Returns an empty array past the last channel.
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Channel Frequency Array", Keywords = "Get Channel Frequency Array Left Right Surround"), Category = "WindowsAudioCapture | Frequency Array")
+		static TArray<float> BP_GetChannelFrequencyArray
+		(
+			int32 InChannel = 0,
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will return the stereo image of the captured audio. Surround layouts count their back and side
+	* pairs with the front left/right channels.
+	*
+	* @param	OutNumChannels			Number of channels of the capture device.
+	* @param	OutStereoWidth			0 mono, about 0.5 for unrelated left/right, 1 fully out of phase.
+	* @param	OutBalance				-1 left only, 0 centered, 1 right only.
+	* @param	OutBandPan				Balance per band: 20-60, 60-150, 150-400, 400-1000, 1000-2500, 2500-6000, 6000-12000 and 12000-20000hz.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Stereo Image", Keywords = "Get Stereo Image Width Balance Pan"), Category = "WindowsAudioCapture | Spatial")
+		static void BP_GetStereoImage(int32& OutNumChannels, float& OutStereoWidth, float& OutBalance, TArray<float>& OutBandPan);
+
+
+	/**
+	* This function will return the envelope of the captured waveform for an oscilloscope: the lowest, the highest and
+	* the RMS sample value of every point, oldest point first. Samples are the channels mixed down to mono, from -1 to 1.
+	* Any zoom level costs the same, the envelope is kept as a min/max/RMS mip chain while this function is being called.
+	*
+	* @param	OutMin					Lowest sample of every point.
+	* @param	OutMax					Highest sample of every point.
+	* @param	OutRms					RMS of every point.
+	* @param	InWindowSeconds			Length of audio shown, up to about 2.7 seconds at 48khz.	Default: 0.05
+	* @param	InNumPoints				Number of points.									Default: 256
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Waveform Envelope", Keywords = "Get Waveform Envelope Oscilloscope Scope Min Max RMS"), Category = "WindowsAudioCapture | Waveform")
+		static void BP_GetWaveformEnvelope
+		(
+			TArray<float>& OutMin,
+			TArray<float>& OutMax,
+			TArray<float>& OutRms,
+			float InWindowSeconds = 0.05,
+			int32 InNumPoints = 256
+		);
+
+
+	/**
+	* This function will return the harmony and the lead note of the captured audio.
+	*
+	* @param	OutChroma				12 values, C to B, strongest pitch class at 1.
+	* @param	OutPitchHz				Dominant pitch in Hz, 0 when nothing periodic is playing.
+	* @param	OutPitchConfidence		0 to 1, how periodic the signal is at that pitch.
+	* @param	OutMidiNote				Pitch as a fractional MIDI note number (69 = A4), 0 when there is no pitch.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Music Features", Keywords = "Get Music Features Chroma Pitch Note"), Category = "WindowsAudioCapture | Music")
+		static void BP_GetMusicFeatures(TArray<float>& OutChroma, float& OutPitchHz, float& OutPitchConfidence, float& OutMidiNote);
+
+
+	/**
+	* This function will split the captured audio into its harmonic (sustained notes, pads, vocals) and percussive
+	* (drums, clicks, transients) parts and return the energy of both per band. The values are scaled like "Get Frequency Array".
+	*
+	* @param	OutHarmonic				Harmonic energy per band: 20-60, 60-150, 150-400, 400-1000, 1000-2500, 2500-6000, 6000-12000 and 12000-20000hz.
+	* @param	OutPercussive			Percussive energy per band, same bands.
+	* @param	OutPercussiveRatio		0 to 1, percussive share of the energy over all bands.
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Harmonic Percussive", Keywords = "Get Harmonic Percussive Drums Tonal HPSS"), Category = "WindowsAudioCapture | Music")
+		static void BP_GetHarmonicPercussive
+		(
+			TArray<float>& OutHarmonic,
+			TArray<float>& OutPercussive,
+			float& OutPercussiveRatio,
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will return a constant-Q spectrum: the same number of bins in every octave, so with 12 bins per
+	* octave every bin is one semitone. The values are scaled like "Get Frequency Array".
+	*
+	* @param	OutBinValues			One value per bin, lowest bin first. Empty for a frame or two after the layout changes.
+	* @param	OutBinFrequencies		Centre frequency of every bin in Hz.
+	* @param	InBinsPerOctave			Bins per octave.					Default: 12
+	* @param	InMinFrequency			Centre of the first bin in Hz.		Default: 32.7 (C1)
+	* @param	InMaxFrequency			Highest bin centre in Hz.			Default: 16744 (C10)
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Constant Q Spectrum", Keywords = "Get Constant Q Spectrum Note Octave"), Category = "WindowsAudioCapture | Frequency Array")
+		static void BP_GetConstantQSpectrum
+		(
+			TArray<float>& OutBinValues,
+			TArray<float>& OutBinFrequencies,
+			int32 InBinsPerOctave = 12,
+			float InMinFrequency = 32.7032,
+			float InMaxFrequency = 16744.04,
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will return a log-frequency spectrum from 20 to 20000hz. Bass comes from a long window on
+	* decimated audio (fine frequency resolution), highs from a short window at the full rate (fast response).
+	* The values are scaled like "Get Frequency Array".
+	*
+	* @param	OutBandValues			One value per band, lowest band first.
+	* @param	OutBandFrequencies		Centre frequency of every band in Hz.
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Band Spectrum", Keywords = "Get Band Spectrum Log Frequency Multi Resolution"), Category = "WindowsAudioCapture | Frequency Array")
+		static void BP_GetBandSpectrum
+		(
+			TArray<float>& OutBandValues,
+			TArray<float>& OutBandFrequencies,
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will return the Frequency Array with every frequency mapped to 0 to 1 between its own recent floor
+	* and ceiling, so it fills the range at any volume without tuning the scaling values of "Get Frequency Array".
+	* Follows a change of volume in about 2 seconds (WAC.NormalizeAdaptFrames).
+	*
+	* @param	OutFrequencyValues		Same layout as "Get Frequency Array", 0 while silent.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Normalized Frequency Array", Keywords = "Get Normalized Frequency Array Adaptive Auto Gain"), Category = "WindowsAudioCapture | Frequency Array")
+		static void BP_GetNormalizedFrequencyArray
+		(
+			TArray<float>& OutFrequencyValues
+		);
+
+
+	/**
+	* This function will return the band spectrum of "Get Band Spectrum" normalized like "Get Normalized Frequency Array".
+	*
+	* @param	OutBandValues			One value per band from 0 to 1, lowest band first.
+	* @param	OutBandFrequencies		Centre frequency of every band in Hz.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Normalized Band Spectrum", Keywords = "Get Normalized Band Spectrum Adaptive Auto Gain"), Category = "WindowsAudioCapture | Frequency Array")
+		static void BP_GetNormalizedBandSpectrum
+		(
+			TArray<float>& OutBandValues,
+			TArray<float>& OutBandFrequencies
+		);
+
+
+	/**
+	* This function will return the value of each requested frequency, scaled like "Get Frequency Array".
+	* While only a few frequencies are requested (WAC.MaxTargetFrequencies) and nothing calls "Get Frequency Array",
+	* the capture evaluates just these frequencies instead of running the full FFT.
+	*
+	* @param	InFrequencies			Frequencies in Hz, from 0 to 22000.
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	* @param	OutFrequencyValues		One value per requested frequency.
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Get Target Frequency Values", Keywords = "Get Target Frequency Values Goertzel"), Category = "WindowsAudioCapture | Frequency Values")
+		static void BP_GetTargetFrequencyValues
+		(
+			const TArray<int32>& InFrequencies,
+			TArray<float>& OutFrequencyValues,
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will return the levels of the captured audio, measured on the samples without an FFT.
+	* Linear values are 1.0 at full scale, the highest channel is reported.
+	*
+	* @param	OutRms				RMS level since the previous capture frame.
+	* @param	OutPeak				Sample peak since the previous capture frame.
+	* @param	OutTruePeak			Inter-sample peak (4x oversampled).
+	* @param	OutCrestFactorDb	Peak to RMS ratio in dB.
+	* @param	OutMomentaryLufs	K-weighted loudness over the last 400ms. -70 when silent.
+	* @param	OutShortTermLufs	K-weighted loudness over the last 3s. -70 when silent.
+	*
+	*/
+	UFUNCTION(BlueprintPure, meta = (DisplayName = "Get Audio Levels", Keywords = "Get Audio Levels RMS Peak Loudness LUFS"), Category = "WindowsAudioCapture | Levels")
+		static void BP_GetAudioLevels
+		(
+			float& OutRms,
+			float& OutPeak,
+			float& OutTruePeak,
+			float& OutCrestFactorDb,
+			float& OutMomentaryLufs,
+			float& OutShortTermLufs
+		);
+
+
+	/**
+	* This function will wait until the capture publishes a new spectrum and return it, like "Get Frequency Array".
+	* Use it in a loop instead of calling "Get Frequency Array" on tick or on a timer: it only continues when there is
+	* something new to read. Does not continue while no capture is running.
+	*
+	* @param	OutFrequencies			The new spectrum, empty if the capture shut down while waiting.
+	* @param	inFreqLogBase			Log Base of the Result Frequency.	Default: 10
+	* @param	inFreqMultiplier		Multiplier of the Result Frequency.	Default: 0.25
+	* @param	inFreqPower				Power of the Result Frequency.		Default: 6
+	* @param	inFreqOffset			Offset of the Result Frequency.		Default: 0.0
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject", DisplayName = "Wait For Next Spectrum", Keywords = "Wait For Next Spectrum Frequency Array Latent"), Category = "WindowsAudioCapture | Events")
+		static void BP_WaitForNextSpectrum
+		(
+			UObject* WorldContextObject,
+			FLatentActionInfo LatentInfo,
+			TArray<float>& OutFrequencies,
+			float inFreqLogBase = 10.0,
+			float inFreqMultiplier = 0.25,
+			float inFreqPower = 6.0,
+			float inFreqOffset = 0.0
+		);
+
+
+	/**
+	* This function will wait until the capture detects an onset (a kick, a snare, a note attack) and continue.
+	* Does not continue while no capture is running.
+	*
+	* @param	OutBand					Band of the onset: 0 bass (20-150hz), 1 low mids (150-1000hz), 2 high mids (1000-6000hz), 3 treble (6000-20000hz). -1 if the capture shut down while waiting.
+	* @param	OutStrength				Log spectral flux of the onset in that band.
+	* @param	InBand					Only continue for onsets in this band, -1 for any band.	Default: -1
+	*
+	*/
+	UFUNCTION(BlueprintCallable, meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject", DisplayName = "Wait For Onset", Keywords = "Wait For Onset Beat Kick Transient Latent"), Category = "WindowsAudioCapture | Events")
+		static void BP_WaitForOnset
+		(
+			UObject* WorldContextObject,
+			FLatentActionInfo LatentInfo,
+			int32& OutBand,
+			float& OutStrength,
+			int32 InBand = -1
+		);
+
+
 	/**
 	* This function will return the value of a specific frequency. It's needs a Frequency Array from the "Get Frequency Array" function.
 	*
@@ -109,4 +384,6 @@ protected:
 
 private:
 
+	// Did BeginPlay acquire the shared capture? Released again in EndPlay
+	bool bCaptureAcquired = false;
 };
@@ -0,0 +1,140 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ThirdParty/Kiss_FFT/kiss_fft129/kiss_fft.h"
+#include "ThirdParty/Kiss_FFT/kiss_fft129/tools/kiss_fftr.h"
+#include <atomic>
+
+// LLM project tag of the plugin ("stat LLMFULL" with -llm), registered by the module. Projects that
+// already use this slot can define another one in their Target.cs
+#ifndef WAC_LLM_TAG
+#define WAC_LLM_TAG ((int32)ELLMTag::ProjectTagStart + 12)
+#endif
+
+// Everything allocated in the enclosing scope goes to the plugin's LLM tag
+#define WAC_LLM_SCOPE() LLM_SCOPE((ELLMTag)WAC_LLM_TAG)
+
+// Where the memory of the plugin goes, WAC.Memory lists them
+enum class EWACMemory : uint8 {
+    // Captured audio in the sink broadcast ring
+    CaptureHistory,
+    // Waveform envelope pyramid
+    WaveformHistory,
+    // Packets and frames waiting for the recorder's writer thread
+    RecorderQueue,
+    // Kiss FFT plans of the analyzers
+    FftPlans,
+    // Buffers of the Niagara data interface proxies
+    Niagara,
+
+    Num
+};
+
+struct FWACMemoryCategoryStats {
+    const TCHAR* Name = TEXT("");
+
+    // Counts against WAC.MemoryBudgetMB
+    bool bBudgeted = false;
+
+    int64 LiveBytes = 0;
+    int64 PeakBytes = 0;
+
+    // Allocations the budget refused, the owner made do with less or dropped the data
+    uint64 DeniedAllocations = 0;
+};
+
+struct FWACMemoryStats {
+    // 0 for no budget
+    int64 BudgetBytes = 0;
+
+    // Live bytes of the budgeted categories
+    int64 BudgetedBytes = 0;
+
+    FWACMemoryCategoryStats Categories[(int32)EWACMemory::Num];
+
+    int64 GetTotalLiveBytes() const {
+        int64 Total = 0;
+        for (const FWACMemoryCategoryStats& Category : Categories) {
+            Total += Category.LiveBytes;
+        }
+        return Total;
+    }
+};
+
+///<summary>
+// Accounting of the plugin's memory. Every allocation of the plugin is made under WAC_LLM_SCOPE, so
+// LLM shows the total, and the large buffers are also counted here by category, which LLM cannot split.
+// The history and queue buffers (CaptureHistory, WaveformHistory, RecorderQueue) share one hard
+// budget, WAC.MemoryBudgetMB: TryAllocate refuses what would go past it and the owner degrades, the
+// rings get shorter and the recorder drops, instead of the process growing. Counters are atomics,
+// any thread may allocate or read.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FWindowsAudioCaptureMemory {
+public:
+    // Counts Bytes in Category. Budgeted categories return false and count nothing when it would go
+    // past the budget; unbudgeted ones always succeed
+    static bool TryAllocate(EWACMemory Category, int64 Bytes);
+
+    // Counts Bytes whatever the budget says, for memory the plugin cannot do without
+    static void Allocate(EWACMemory Category, int64 Bytes);
+
+    static void Free(EWACMemory Category, int64 Bytes);
+
+    // Heap block counted in Category and tagged for LLM, freed with FreeBlock
+    static void* MallocBlock(EWACMemory Category, SIZE_T Bytes);
+    static void FreeBlock(void* Block);
+
+    // Kiss FFT plan in a counted block, free with FreeFftr. Kiss would malloc() it where neither LLM
+    // nor the counters see it
+    static kiss_fftr_cfg AllocFftr(int32 Size, bool bInverse);
+    static void FreeFftr(kiss_fftr_cfg Config);
+
+    // WAC.MemoryBudgetMB in bytes, 0 for none
+    static int64 GetBudgetBytes();
+
+    static FWACMemoryStats GetStats();
+
+    // Registers the LLM tag, called by the module
+    static void RegisterLLMTag();
+};
+
+///<summary>
+// Bytes one container holds in a category, kept in step with Set / TrySet after every resize and
+// given back on destruction. A copy starts at 0, the copied container has to be set again.
+///</summary>
+class WINDOWSAUDIOCAPTURE_API FWACMemoryCounter {
+public:
+    explicit FWACMemoryCounter(EWACMemory InCategory)
+        : Category(InCategory)
+        , Bytes(0)
+    {
+    }
+
+    FWACMemoryCounter(const FWACMemoryCounter& Other)
+        : Category(Other.Category)
+        , Bytes(0)
+    {
+    }
+
+    FWACMemoryCounter& operator=(const FWACMemoryCounter&) {
+        return *this;
+    }
+
+    ~FWACMemoryCounter() {
+        Set(0);
+    }
+
+    // Counts the new size whatever the budget says
+    void Set(int64 NewBytes);
+
+    // Counts the new size if the budget allows the growth, otherwise keeps the old one and returns false
+    bool TrySet(int64 NewBytes);
+
+    int64 Get() const { return Bytes; }
+
+private:
+    const EWACMemory Category;
+    int64 Bytes;
+};
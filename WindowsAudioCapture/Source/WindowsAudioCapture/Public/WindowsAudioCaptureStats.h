@@ -0,0 +1,8 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// "stat WindowsAudioCapture" in the console
+DECLARE_STATS_GROUP(TEXT("WindowsAudioCapture"), STATGROUP_WindowsAudioCapture, STATCAT_Advanced);
@@ -0,0 +1,84 @@
+//Windows Audio Capture (WAC) by KwstasG (Kostas Giannakakis)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+
+#include "WindowsAudioCaptureSubsystem.generated.h"
+
+class FAudioCaptureWorker;
+
+///<summary>
+// Owns the one and only FAudioCaptureWorker for the process.
+// Components and actors Acquire the capture in BeginPlay and Release it in EndPlay. When the last
+// client releases, the capture thread is parked but the WASAPI device stays initialized, so the
+// next PIE session resumes capturing without COM activation. The worker is only torn down when
+// the engine shuts the subsystem down.
+///</summary>
+UCLASS()
+class WINDOWSAUDIOCAPTURE_API UWindowsAudioCaptureSubsystem : public UEngineSubsystem {
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // Returns the engine subsystem, or nullptr before the engine is up / after it is gone.
+    static UWindowsAudioCaptureSubsystem* Get();
+
+    // Game thread only. Creates the worker on first use and resumes capture when the count goes 0 -> 1.
+    void AcquireCapture();
+
+    // Game thread only. Parks the capture when the count goes 1 -> 0.
+    void ReleaseCapture();
+
+    int32 GetCaptureRefCount() const { return CaptureRefCount; }
+
+    // The worker, or nullptr if nobody acquired the capture yet.
+    FAudioCaptureWorker* GetWorker() const { return Worker.Get(); }
+
+    // WAC.Stats console command
+    static void DumpStats();
+
+    // WAC.Deadlines console command
+    static void DumpDeadlines(const TArray<FString>& Args);
+
+    // WAC.Memory console command
+    static void DumpMemory();
+
+    // WAC.BenchmarkTargets console command
+    static void BenchmarkTargets(const TArray<FString>& Args);
+
+    // WAC.BenchmarkCompact console command
+    static void BenchmarkCompact(const TArray<FString>& Args);
+
+    // WAC.BenchmarkKernels console command
+    static void BenchmarkKernels(const TArray<FString>& Args);
+
+    // WAC.BenchmarkHarmonicPercussive console command
+    static void BenchmarkHarmonicPercussive(const TArray<FString>& Args);
+
+    // WAC.BenchmarkSilenceGate console command
+    static void BenchmarkSilenceGate(const TArray<FString>& Args);
+
+    // WAC.Record / WAC.StopRecord console commands
+    static void StartRecording(const TArray<FString>& Args);
+    static void StopRecording();
+
+    // WAC.Replay / WAC.StopReplay console commands
+    static void StartReplay(const TArray<FString>& Args);
+    static void StopReplay();
+
+    // WAC.ShareSpectrum / WAC.StopShareSpectrum console commands
+    static void StartSharedSpectrum(const TArray<FString>& Args);
+    static void StopSharedSpectrum();
+
+private:
+    TUniquePtr<FAudioCaptureWorker> Worker;
+
+    int32 CaptureRefCount = 0;
+
+    // The shared ring holds a capture reference of its own, its readers live in other processes
+    bool bSharingSpectrum = false;
+};
@@ -1,3 +1,4 @@
+using System.IO;
 using UnrealBuildTool;
 
 public class WindowsAudioCapture : ModuleRules
@@ -20,6 +21,8 @@ public class WindowsAudioCapture : ModuleRules
 				//"WindowsAudioCapture/Private",
 				// ... add other private include paths required here ...
 //                 "../Plugins/FX/Niagara/Source/Niagara/Public"
+                // Shared spectrum layout, also used by the out-of-process reader library
+                Path.Combine(ModuleDirectory, "..", "..", "Extras", "SharedSpectrumReader")
             }
             );
 
@@ -67,6 +70,8 @@ public class WindowsAudioCapture : ModuleRules
 			}
             );
 
+        // MMCSS registration of the capture thread (AvSetMmThreadCharacteristics)
+        PublicSystemLibraries.Add("Avrt.lib");
 
     }
 }